@@ -0,0 +1,467 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""End-to-end benchmark of representative Relax models on the Relax VM.
+
+Each model is compiled with the default Relax pipeline, then measured with the convergence-driven
+benchmark evaluator. The report records the compile time, the latency statistics, the throughput
+and the peak memory of each model, in a JSON schema stable across commits. Passing the report of
+a previous commit as the baseline flags the latency regressions.
+
+.. code-block:: bash
+
+    python3 relax_e2e_bench.py --output report.json
+    python3 relax_e2e_bench.py --baseline report.json
+"""
+import argparse
+import gc
+import json
+import sys
+import time
+
+import numpy as np
+
+import tvm
+from tvm import relax
+from tvm.script import tir as T
+
+
+REPORT_SCHEMA_VERSION = 1
+
+
+def _tensor(shape, dtype="float32"):
+    return relax.TensorStructInfo(shape, dtype)
+
+
+def _call_packed(func_name, *args):
+    return relax.Call(
+        relax.ExternFunc(func_name), list(args), sinfo_args=[relax.ObjectStructInfo()]
+    )
+
+
+def _random_params(params):
+    arrays = []
+    for param in params:
+        shape = [int(x) for x in param.struct_info.shape]
+        arrays.append(tvm.nd.array(np.random.uniform(-0.1, 0.1, shape).astype("float32")))
+    return arrays
+
+
+def get_mlp(batch_size):
+    """A three-layer perceptron on flattened 28x28 images."""
+    bb = relax.BlockBuilder()
+    x = relax.Var("x", _tensor((batch_size, 784)))
+    dims = [784, 1024, 1024, 10]
+    weights = []
+    for i in range(len(dims) - 1):
+        weights.append(relax.Var(f"w{i}", _tensor((dims[i], dims[i + 1]))))
+        weights.append(relax.Var(f"b{i}", _tensor((dims[i + 1],))))
+    with bb.function("main", [x] + weights):
+        with bb.dataflow():
+            out = x
+            for i in range(len(dims) - 1):
+                out = bb.emit(relax.op.matmul(out, weights[2 * i]))
+                out = bb.emit(relax.op.add(out, weights[2 * i + 1]))
+                if i != len(dims) - 2:
+                    out = bb.emit(relax.op.nn.relu(out))
+            gv = bb.emit_output(out)
+        bb.emit_func_output(gv)
+    inputs = [tvm.nd.array(np.random.uniform(size=(batch_size, 784)).astype("float32"))]
+    return bb.get(), inputs + _random_params(weights), batch_size
+
+
+def get_conv_net(batch_size):
+    """A small convolutional classifier on 64x64 images."""
+    bb = relax.BlockBuilder()
+    x = relax.Var("x", _tensor((batch_size, 3, 64, 64)))
+    channels = [3, 32, 64, 128]
+    weights = [
+        relax.Var(f"conv{i}", _tensor((channels[i + 1], channels[i], 3, 3)))
+        for i in range(len(channels) - 1)
+    ]
+    weights.append(relax.Var("fc", _tensor((channels[-1], 10))))
+    with bb.function("main", [x] + weights):
+        with bb.dataflow():
+            out = x
+            for i in range(len(channels) - 1):
+                out = bb.emit(relax.op.nn.conv2d(out, weights[i], padding=(1, 1)))
+                out = bb.emit(relax.op.nn.relu(out))
+                out = bb.emit(relax.op.nn.max_pool2d(out, pool_size=(2, 2), strides=(2, 2)))
+            out = bb.emit(relax.op.nn.adaptive_avg_pool2d(out, output_size=(1, 1)))
+            out = bb.emit(relax.op.reshape(out, (batch_size, channels[-1])))
+            gv = bb.emit_output(relax.op.matmul(out, weights[-1]))
+        bb.emit_func_output(gv)
+    inputs = [tvm.nd.array(np.random.uniform(size=(batch_size, 3, 64, 64)).astype("float32"))]
+    return bb.get(), inputs + _random_params(weights), batch_size
+
+
+# fmt: off
+@T.prim_func
+def kv_cache_transpose_append(
+    var_pages: T.handle,
+    var_k_data: T.handle,
+    var_v_data: T.handle,
+    var_page_table_indptr: T.handle,
+    var_page_table_values: T.handle,
+    var_last_page_offset: T.handle,
+    var_append_length_indptr: T.handle,
+    var_pos2seqidx: T.handle,
+    layer_id: T.int32,
+):
+    nseq = T.int32()
+    ntoken = T.int32()
+    nhead = T.int32()
+    nfeat = T.int32()
+    nlayer = T.int32()
+    npage = T.int32()
+    page_size = T.int32()
+    num_pages = T.int32()
+
+    pages = T.match_buffer(var_pages, (num_pages, nlayer, 2, nhead, page_size, nfeat), "float32")
+    k_data = T.match_buffer(var_k_data, (ntoken, nhead, nfeat), "float32")
+    v_data = T.match_buffer(var_v_data, (ntoken, nhead, nfeat), "float32")
+    last_page_offset = T.match_buffer(var_last_page_offset, (nseq,), "int32")
+    page_table_indptr = T.match_buffer(var_page_table_indptr, (nseq + 1,), "int32")
+    page_table_values = T.match_buffer(var_page_table_values, (npage,), "int32")
+    append_length_indptr = T.match_buffer(var_append_length_indptr, (nseq + 1,), "int32")
+    pos2seqidx = T.match_buffer(var_pos2seqidx, (ntoken,), "int32")
+
+    for global_pos, h, f in T.grid(ntoken, nhead, nfeat):
+        with T.block("k_transpose_append"):
+            vgpos, vh, vf = T.axis.remap("SSS", [global_pos, h, f])
+            seq_idx = pos2seqidx[vgpos]
+            seqlen: T.int32 = (page_table_indptr[seq_idx + 1] - page_table_indptr[seq_idx] - 1) * page_size + last_page_offset[seq_idx]
+            pages[
+                page_table_values[page_table_indptr[seq_idx] + T.floordiv(seqlen - (append_length_indptr[seq_idx + 1] - vgpos), page_size)],
+                layer_id,
+                0,
+                vh,
+                T.floormod(seqlen - (append_length_indptr[seq_idx + 1] - vgpos), page_size),
+                vf,
+            ] = k_data[vgpos, vh, vf]
+        with T.block("v_transpose_append"):
+            vgpos, vh, vf = T.axis.remap("SSS", [global_pos, h, f])
+            seq_idx = pos2seqidx[vgpos]
+            seqlen: T.int32 = (page_table_indptr[seq_idx + 1] - page_table_indptr[seq_idx] - 1) * page_size + last_page_offset[seq_idx]
+            pages[
+                page_table_values[page_table_indptr[seq_idx] + T.floordiv(seqlen - (append_length_indptr[seq_idx + 1] - vgpos), page_size)],
+                layer_id,
+                1,
+                vh,
+                T.floormod(seqlen - (append_length_indptr[seq_idx + 1] - vgpos), page_size),
+                vf,
+            ] = v_data[vgpos, vh, vf]
+
+
+@T.prim_func
+def attention_decode(
+    var_q: T.handle,
+    var_pages: T.handle,
+    var_page_table_indptr: T.handle,
+    var_page_table_values: T.handle,
+    var_last_page_offset: T.handle,
+    var_append_length_indptr: T.handle,
+    layer_id: T.int32,
+    var_tmp: T.handle,
+    var_output: T.handle,
+    apply_rotary: T.int32,
+    rotary_scale: T.float32,
+    rotary_theta: T.float32,
+):
+    nseq = T.int32()
+    nhead = T.int32()
+    nfeat = T.int32()
+    nlayer = T.int32()
+    npage = T.int32()
+    page_size = T.int32()
+    num_pages = T.int32()
+    ntmp = T.int32()
+
+    q = T.match_buffer(var_q, (nseq, 1, nhead, nfeat), "float32")
+    pages = T.match_buffer(var_pages, (num_pages, nlayer, 2, nhead, page_size, nfeat), "float32")
+    page_table_indptr = T.match_buffer(var_page_table_indptr, (nseq + 1,), "int32")
+    page_table_values = T.match_buffer(var_page_table_values, (npage,), "int32")
+    last_page_offset = T.match_buffer(var_last_page_offset, (nseq,), "int32")
+    append_length_indptr = T.match_buffer(var_append_length_indptr, (nseq + 1,), "int32")
+    tmp = T.match_buffer(var_tmp, (ntmp,), "float32")
+    output = T.match_buffer(var_output, (nseq, 1, nhead, nfeat), "float32")
+
+    # Naive softmax attention of each query over the cached keys and values of its sequence.
+    # tmp holds the running max, the softmax denominator and the current score of each head.
+    for b, h in T.grid(nseq, nhead):
+        seqlen: T.int32 = (page_table_indptr[b + 1] - page_table_indptr[b] - 1) * page_size + last_page_offset[b]
+        base: T.int32 = (b * nhead + h) * 3
+        scale: T.float32 = T.float32(1) / T.sqrt(T.Cast("float32", nfeat))
+        tmp[base] = T.float32(-3.4e38)
+        for t in range(seqlen):
+            page: T.int32 = page_table_values[page_table_indptr[b] + T.floordiv(t, page_size)]
+            tmp[base + 2] = T.float32(0)
+            for f in range(nfeat):
+                tmp[base + 2] = tmp[base + 2] + q[b, 0, h, f] * pages[page, layer_id, 0, h, T.floormod(t, page_size), f]
+            tmp[base] = T.max(tmp[base], tmp[base + 2] * scale)
+        tmp[base + 1] = T.float32(0)
+        for f in range(nfeat):
+            output[b, 0, h, f] = T.float32(0)
+        for t in range(seqlen):
+            page: T.int32 = page_table_values[page_table_indptr[b] + T.floordiv(t, page_size)]
+            tmp[base + 2] = T.float32(0)
+            for f in range(nfeat):
+                tmp[base + 2] = tmp[base + 2] + q[b, 0, h, f] * pages[page, layer_id, 0, h, T.floormod(t, page_size), f]
+            tmp[base + 2] = T.exp(tmp[base + 2] * scale - tmp[base])
+            tmp[base + 1] = tmp[base + 1] + tmp[base + 2]
+            for f in range(nfeat):
+                output[b, 0, h, f] = output[b, 0, h, f] + tmp[base + 2] * pages[page, layer_id, 1, h, T.floormod(t, page_size), f]
+        for f in range(nfeat):
+            output[b, 0, h, f] = output[b, 0, h, f] / tmp[base + 1]
+# fmt: on
+
+
+def get_transformer_decoder(
+    batch_size, context_length=128, num_layers=2, num_heads=8, head_dim=64, page_size=16
+):
+    """One decoding step of a transformer decoder with the paged KV cache.
+
+    Each step appends one token to every sequence and attends to its whole context, then pops
+    the token back, so that every measured step runs at the same context length.
+    """
+    hidden = num_heads * head_dim
+    bb = relax.BlockBuilder()
+    f_append = bb.add_func(
+        kv_cache_transpose_append.with_attr("global_symbol", "kv_cache_transpose_append"),
+        "kv_cache_transpose_append",
+    )
+    f_attention = bb.add_func(
+        attention_decode.with_attr("global_symbol", "attention_decode"), "attention_decode"
+    )
+    x = relax.Var("x", _tensor((batch_size, hidden)))
+    cache = relax.Var("cache", relax.ObjectStructInfo())
+    weights = []
+    for i in range(num_layers):
+        weights += [
+            relax.Var(f"ln0_gamma{i}", _tensor((hidden,))),
+            relax.Var(f"ln0_beta{i}", _tensor((hidden,))),
+            relax.Var(f"w_qkv{i}", _tensor((hidden, 3 * hidden))),
+            relax.Var(f"w_o{i}", _tensor((hidden, hidden))),
+            relax.Var(f"ln1_gamma{i}", _tensor((hidden,))),
+            relax.Var(f"ln1_beta{i}", _tensor((hidden,))),
+            relax.Var(f"w_up{i}", _tensor((hidden, 4 * hidden))),
+            relax.Var(f"w_down{i}", _tensor((4 * hidden, hidden))),
+        ]
+
+    with bb.function("main", [x, cache] + weights, attrs={"relax.force_pure": True}):
+        bb.emit(_call_packed("vm.builtin.paged_attention_kv_cache_reset_append_lengths", cache))
+        for seq_id in range(batch_size):
+            bb.emit(
+                _call_packed(
+                    "vm.builtin.paged_attention_kv_cache_reserve_extra_length_for_append",
+                    cache,
+                    relax.PrimValue(seq_id),
+                    relax.PrimValue(1),
+                )
+            )
+        bb.emit(_call_packed("vm.builtin.paged_attention_kv_cache_sync_aux_array_to_device", cache))
+
+        for i in range(num_layers):
+            ln0_gamma, ln0_beta, w_qkv, w_o, ln1_gamma, ln1_beta, w_up, w_down = weights[
+                8 * i : 8 * i + 8
+            ]
+            with bb.dataflow():
+                h = bb.emit(relax.op.nn.layer_norm(x, ln0_gamma, ln0_beta, axes=[-1]))
+                qkv = bb.emit(relax.op.matmul(h, w_qkv))
+                qkv = bb.emit(relax.op.reshape(qkv, (batch_size, 1, 3 * num_heads, head_dim)))
+                qkv = bb.emit(relax.op.split(qkv, 3, axis=2))
+                q, k, v = [bb.emit_output(relax.TupleGetItem(qkv, j)) for j in range(3)]
+            bb.emit(
+                _call_packed(
+                    "vm.builtin.paged_attention_kv_cache_append",
+                    cache,
+                    f_append,
+                    k,
+                    v,
+                    relax.PrimValue(i),
+                )
+            )
+            attn = bb.emit(
+                relax.op.call_dps_packed(
+                    "vm.builtin.paged_attention_kv_cache_attention",
+                    [cache, f_attention, q, relax.PrimValue(i)],
+                    out_sinfo=_tensor((batch_size, 1, num_heads, head_dim)),
+                )
+            )
+            with bb.dataflow():
+                attn = bb.emit(relax.op.reshape(attn, (batch_size, hidden)))
+                x = bb.emit(relax.op.add(x, relax.op.matmul(attn, w_o)))
+                h = bb.emit(relax.op.nn.layer_norm(x, ln1_gamma, ln1_beta, axes=[-1]))
+                h = bb.emit(relax.op.nn.relu(relax.op.matmul(h, w_up)))
+                x = bb.emit_output(relax.op.add(x, relax.op.matmul(h, w_down)))
+
+        for seq_id in range(batch_size):
+            bb.emit(
+                _call_packed(
+                    "vm.builtin.paged_attention_kv_cache_popn",
+                    cache,
+                    relax.PrimValue(seq_id),
+                    relax.PrimValue(1),
+                )
+            )
+        bb.emit_func_output(x)
+
+    # Prefill the cache with random keys and values.
+    num_pages_per_seq = (context_length + 1 + page_size - 1) // page_size
+    kv_cache = tvm.get_global_func("vm.builtin.paged_attention_kv_cache_create")(
+        tvm.runtime.ShapeTuple([batch_size, batch_size * num_pages_per_seq * page_size, page_size]),
+        num_layers,
+        num_heads,
+        head_dim,
+        tvm.nd.empty((), "float32"),
+    )
+    f_transpose_append = tvm.build(
+        kv_cache_transpose_append.with_attr("global_symbol", "kv_cache_transpose_append"), "llvm"
+    )["kv_cache_transpose_append"]
+    tvm.get_global_func("vm.builtin.paged_attention_kv_cache_reset_append_lengths")(kv_cache)
+    for seq_id in range(batch_size):
+        tvm.get_global_func("vm.builtin.paged_attention_kv_cache_add_sequence")(kv_cache)
+        tvm.get_global_func("vm.builtin.paged_attention_kv_cache_reserve_extra_length_for_append")(
+            kv_cache, seq_id, context_length
+        )
+    tvm.get_global_func("vm.builtin.paged_attention_kv_cache_sync_aux_array_to_device")(kv_cache)
+    for layer_id in range(num_layers):
+        shape = (1, batch_size * context_length, num_heads, head_dim)
+        k, v = [tvm.nd.array(np.random.uniform(size=shape).astype("float32")) for _ in range(2)]
+        tvm.get_global_func("vm.builtin.paged_attention_kv_cache_append")(
+            kv_cache, f_transpose_append, k, v, layer_id
+        )
+
+    x_data = tvm.nd.array(np.random.uniform(size=(batch_size, hidden)).astype("float32"))
+    return bb.get(), [x_data, kv_cache] + _random_params(weights), batch_size
+
+
+MODELS = {
+    "mlp": (get_mlp, "samples/s"),
+    "conv_net": (get_conv_net, "images/s"),
+    "transformer_decoder": (get_transformer_decoder, "tokens/s"),
+}
+
+
+def run_model(name, batch_size, target, dev, bench_args):
+    """Compile and measure one model."""
+    get_model, throughput_unit = MODELS[name]
+    mod, inputs, items_per_call = get_model(batch_size)
+
+    # Release the memory pool of the previous model, so that its footprint is measured alone.
+    tvm.get_global_func("vm.builtin.memory_manager.clear")()
+
+    begin = time.perf_counter()
+    with tvm.transform.PassContext(opt_level=3):
+        mod = relax.get_pipeline("zero")(mod)
+        ex = relax.build(mod, target)
+    compile_time = time.perf_counter() - begin
+
+    vm = relax.VirtualMachine(ex, dev)
+    result = vm.module.benchmark_evaluator("main", dev, **bench_args)(*inputs)
+    pool_bytes = tvm.get_global_func("vm.builtin.memory_manager.used_memory")(dev)
+    input_bytes = sum(arr.numpy().nbytes for arr in inputs if isinstance(arr, tvm.nd.NDArray))
+
+    latency_keys = ["mean", "median", "p90", "p99", "min", "max", "std", "ci95", "noise"]
+    return {
+        "batch_size": batch_size,
+        "compile_time_s": compile_time,
+        "latency_s": {key: result[key] for key in latency_keys},
+        "converged": result["converged"],
+        "num_samples": result["num_samples"],
+        "throughput": items_per_call / result["median"],
+        "throughput_unit": throughput_unit,
+        # The pooled allocator keeps every buffer it has allocated, so its size is the peak
+        # footprint of the intermediate tensors.
+        "peak_memory_bytes": pool_bytes + input_bytes,
+        "intermediate_memory_bytes": pool_bytes,
+    }
+
+
+def compare(report, baseline, threshold):
+    """Print the latency changes against the baseline, and return the regressed models."""
+    regressions = []
+    print(f"{'model':<24}{'baseline (ms)':>16}{'current (ms)':>16}{'change':>10}")
+    for name, current in report["models"].items():
+        if name not in baseline["models"]:
+            continue
+        base = baseline["models"][name]["latency_s"]
+        cur = current["latency_s"]
+        change = cur["median"] / base["median"] - 1
+        # Only flag the slowdowns beyond both the threshold and the measurement uncertainty.
+        uncertainty = cur["ci95"] + base["ci95"]
+        regressed = change > threshold and cur["median"] - base["median"] > uncertainty
+        if regressed:
+            regressions.append(name)
+        print(
+            f"{name:<24}{base['median'] * 1e3:>16.4f}{cur['median'] * 1e3:>16.4f}"
+            f"{change * 100:>9.1f}%{'  REGRESSION' if regressed else ''}"
+        )
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n", maxsplit=1)[0])
+    parser.add_argument("--models", type=str, default=",".join(MODELS), help="Comma separated.")
+    parser.add_argument("--batch-size", type=int, default=8)
+    parser.add_argument("--target", type=str, default="llvm")
+    parser.add_argument("--target-rel-ci", type=float, default=0.01)
+    parser.add_argument("--max-time-ms", type=int, default=10000)
+    parser.add_argument("--pin-threads", action="store_true")
+    parser.add_argument("--output", type=str, help="The file to write the report to.")
+    parser.add_argument("--baseline", type=str, help="The report to compare against.")
+    parser.add_argument(
+        "--threshold", type=float, default=0.05, help="The relative slowdown of a regression."
+    )
+    args = parser.parse_args()
+
+    target = tvm.target.Target(args.target)
+    dev = tvm.device(target.kind.name, 0)
+    bench_args = {
+        "target_rel_ci": args.target_rel_ci,
+        "max_time_ms": args.max_time_ms,
+        "pin_threads": args.pin_threads,
+    }
+    report = {
+        "schema_version": REPORT_SCHEMA_VERSION,
+        "tvm_version": tvm.__version__,
+        "git_commit": tvm.support.libinfo().get("GIT_COMMIT_HASH", ""),
+        "target": str(target),
+        "models": {},
+    }
+    for name in args.models.split(","):
+        report["models"][name] = run_model(name, args.batch_size, target, dev, bench_args)
+        gc.collect()
+        stats = report["models"][name]
+        print(
+            f"{name}: median {stats['latency_s']['median'] * 1e3:.4f} ms, "
+            f"{stats['throughput']:.1f} {stats['throughput_unit']}, "
+            f"peak memory {stats['peak_memory_bytes'] / 2**20:.1f} MiB, "
+            f"compile {stats['compile_time_s']:.1f} s"
+        )
+
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            json.dump(report, f, indent=2)
+    if args.baseline:
+        with open(args.baseline, "r", encoding="utf-8") as f:
+            baseline = json.load(f)
+        if compare(report, baseline, args.threshold):
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -244,6 +244,27 @@ class SHashHandlerDefault : public SHashReducer::Handler {
   Impl* impl;
 };
 
+/*!
+ * \brief RAII scope that memoizes the content hash of NDArray data by object identity.
+ *
+ *  While at least one scope is alive, the hash of the raw data of an NDArray is
+ *  computed once and reused by every later structural hash that visits the same
+ *  NDArray object, so repeated hashing of modules that share large constants no
+ *  longer rescans their data. The cache keeps a reference to each memoized NDArray,
+ *  so an identity cannot be reused by another array while the scope is alive.
+ *  The cache is dropped when the outermost scope exits.
+ *
+ * \note NDArrays are treated as immutable inside the scope. Mutating the data of an
+ *  NDArray in place after it has been hashed yields a stale hash value.
+ */
+class NDArrayHashCacheScope {
+ public:
+  NDArrayHashCacheScope();
+  ~NDArrayHashCacheScope();
+  NDArrayHashCacheScope(const NDArrayHashCacheScope&) = delete;
+  NDArrayHashCacheScope& operator=(const NDArrayHashCacheScope&) = delete;
+};
+
 class SEqualReducer;
 struct NDArrayContainerTrait {
   static constexpr const std::nullptr_t VisitAttrs = nullptr;
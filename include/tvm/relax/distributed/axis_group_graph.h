@@ -223,6 +223,38 @@ class AxisGroupGraph {
     }
   }
 
+  /*!
+   * \brief Get the groups of connected tensor axes. A sharding spec of an axis propagates to its
+   * whole group, unless cut. The device mesh axes (dim -1) are not included.
+   *
+   * \return The axis groups, in no particular order.
+   */
+  std::vector<AxisGroup> GetAxisGroups() const {
+    std::vector<AxisGroup> groups;
+    AxisGroup visited;
+    for (const auto& pr : graph_) {
+      if (pr.first.dim == -1 || visited.count(pr.first)) {
+        continue;
+      }
+      AxisGroup group;
+      std::vector<Axis> stack{pr.first};
+      visited.insert(pr.first);
+      while (!stack.empty()) {
+        Axis axis = stack.back();
+        stack.pop_back();
+        group.insert(axis);
+        for (const AxisGraphEdge& edge : graph_.at(axis)) {
+          if (edge.dst.dim != -1 && !visited.count(edge.dst)) {
+            visited.insert(edge.dst);
+            stack.push_back(edge.dst);
+          }
+        }
+      }
+      groups.push_back(std::move(group));
+    }
+    return groups;
+  }
+
  private:
   void AddEdge(Axis src, Axis dst, EdgeType type) {
     if (!graph_.count(src)) {
@@ -26,6 +26,7 @@
 
 #include <tvm/ir/transform.h>
 #include <tvm/relax/dataflow_pattern.h>
+#include <tvm/relax/distributed/global_info.h>
 #include <tvm/relax/expr.h>
 #include <tvm/relax/transform.h>
 #include <tvm/tir/function.h>
@@ -48,6 +49,34 @@ using DataflowBlock = tvm::relax::DataflowBlock;
  */
 TVM_DLL Pass PropagateSharding();
 
+/*!
+ * \brief Search the sharding of the tensors which are not annotated, and propagate it.
+ *
+ * Each group of tensor axes connected by the operators is either replicated or sharded on an axis
+ * of the device mesh. The plan is chosen greedily to minimize the estimated step time, including
+ * the allreduce of the sharded reductions and the scatter/gather of the function inputs and
+ * outputs, with the memory per device under the cap. The existing annotations are kept.
+ *
+ * \param device_mesh The device mesh to shard the tensors on.
+ * \param memory_cap The memory cap per device in bytes.
+ * \param flops_per_byte The cost of communicating one byte, relative to one flop.
+ * \return The Pass.
+ */
+TVM_DLL Pass AutoSharding(DeviceMesh device_mesh, int64_t memory_cap, double flops_per_byte = 100);
+
+/*!
+ * \brief Partition a function into pipeline stages balanced by their estimated cost.
+ *
+ * The stage `i` is added as the function `{func_name}_stage{i}`, which takes the activations live
+ * into the stage followed by the weights used by the stage. Each stage but the last returns a tuple
+ * of the activations taken by the next stage. The original function is kept.
+ *
+ * \param num_stages The number of pipeline stages.
+ * \param func_name The name of the function to partition.
+ * \return The Pass.
+ */
+TVM_DLL Pass PartitionPipelineStages(int num_stages, String func_name = "main");
+
 }  // namespace transform
 }  // namespace distributed
 }  // namespace relax
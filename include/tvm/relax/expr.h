@@ -1010,6 +1010,12 @@ constexpr const char* kForcePure = "relax.force_pure";
  * arguments are assumed to be weights that are fixed across invocations.
  */
 constexpr const char* kNumInput = "num_input";
+
+/*!
+ * \brief The number of independent call_tir bindings that were fused horizontally into a
+ * primitive function. FuseTIR forwards it to the fused PrimFunc as `tir.horizontal_fusion`.
+ */
+constexpr const char* kHorizontalFusion = "relax.horizontal_fusion";
 }  // namespace attr
 
 /*! \brief The extern function, which can represent packed function. */
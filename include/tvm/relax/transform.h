@@ -211,6 +211,14 @@ TVM_DLL Pass BindSymbolicVars(Map<ObjectRef, PrimExpr> binding_map,
  */
 TVM_DLL Pass FoldConstant();
 
+/*!
+ * \brief Share the constants of the same data and struct info across all the Relax functions of
+ * the IRModule, so that a single NDArray is kept for them.
+ *
+ * \return The Pass.
+ */
+TVM_DLL Pass DeduplicateConstants();
+
 /*!
  * \brief Legalize high-level operator calls in Relax functions to call_tir
  * with corresponding low-level TIR PrimFuncs.
@@ -282,6 +290,9 @@ TVM_DLL Pass AnnotateTIROpPattern();
  * function being manipulated into function calls to the new grouped function.
  *
  * A follow-up pass named "FuseTIR" will generate a TIR PrimFunc for each grouped function.
+ * With the pass config `relax.FuseOps.cost_model`, a fusion is only made when the estimated bytes
+ * of memory traffic saved outweigh the FLOPs recomputed by the consumers, weighted by
+ * `relax.FuseOps.flops_per_byte`.
  * \param fuse_opt_level The level of fuse optimization.
  *        -1 indicates that the level will be inferred from pass context.
  * \return The Pass.
@@ -425,6 +436,24 @@ class PatternCheckContext : public ObjectRef {
 TVM_DLL Pass Gradient(String func_name, Optional<Array<Var>> require_grads = NullOpt,
                       int target_index = 0);
 
+/*!
+ * \brief Choose the activations of a function to rematerialize in the backward pass under a memory
+ * budget, and mark them with start_checkpoint and end_checkpoint for the Gradient pass.
+ *
+ * The activations used by the backward pass are live at the end of the forward pass. The pass
+ * drops activations greedily, by the ratio of the memory freed to the estimated cost of
+ * recomputing them, until the kept activations fit the budget. The function must have no
+ * checkpoint yet.
+ *
+ * \param func_name The name of the specified function.
+ * \param memory_budget The budget in bytes for the activations kept for the backward pass.
+ * \param require_grads The relax variables whose adjoints are needed, as in Gradient.
+ * \param target_index The index of the differentiation target, as in Gradient.
+ * \return The Pass.
+ */
+TVM_DLL Pass AutoCheckpoint(String func_name, int64_t memory_budget,
+                            Optional<Array<Var>> require_grads = NullOpt, int target_index = 0);
+
 /*!
  * \brief Apply pattern matching to each function in the given module, and group matched
  * expressions into a new function. The end result is similar to FuseOps, but fusion is driven
@@ -461,6 +490,19 @@ TVM_DLL Pass MergeCompositeFunctions();
  */
 TVM_DLL Pass FuseTIR();
 
+/*!
+ * \brief Group the independent small `call_tir` bindings of a dataflow block with the same op
+ * pattern into grouped functions, which a following FuseTIR turns into single PrimFuncs, so that
+ * the VM calls them once instead of one by one.
+ * \note The grouped functions are marked with `relax.horizontal_fusion`, which FuseTIR forwards to
+ * the fused PrimFunc. On GPU targets, tir::transform::HorizontalFuseKernels then dispatches the
+ * members over a shared blockIdx.x dimension, so that they are launched as a single kernel.
+ * \param max_group_size The maximum number of kernels fused into one.
+ * \param max_num_elements The maximum number of output elements of a kernel to be fused.
+ * \return The Pass.
+ */
+TVM_DLL Pass HorizontalFuseOps(int max_group_size = 8, int64_t max_num_elements = 65536);
+
 /*!
  * \brief Run codegen.
  * \param target_options pairs of target name and compilation options
@@ -544,6 +586,88 @@ TVM_DLL Pass ToMixedPrecision(const DataType& out_dtype,
  */
 TVM_DLL Pass RewriteCUDAGraph();
 
+/*!
+ * \brief Hoist the statically planned storages of the entry functions into a persistent
+ * workspace, which the VM allocates once on initialization and reuses across invocations.
+ * The entry functions that never run concurrently share the same workspace. As the workspace
+ * belongs to the VM, the invocations of one VM must be ordered on the device, and must not run
+ * concurrently from several threads. The pass only takes effect when the pass config
+ * "relax.backend.use_persistent_workspace" is set.
+ * \return The Pass.
+ */
+TVM_DLL Pass PlanPersistentWorkspace();
+
+/*!
+ * \brief Specialize a dynamic-shape function for a set of values of one of its symbolic
+ * variables. A copy of the function is added for each value, with static shapes, along with a
+ * generic copy. The function becomes a dispatcher that calls the copy matching the value at run
+ * time, and the generic copy otherwise.
+ * \param func_name The name of the function to specialize.
+ * \param var_name The name of the symbolic variable, defined by the function parameters.
+ * \param buckets The values of the variable to specialize for.
+ * \param pad Whether to dispatch to the smallest bucket not smaller than the value, padding the
+ * inputs with zeros and slicing the outputs along the dimensions equal to the variable.
+ * \return The Pass.
+ */
+TVM_DLL Pass SpecializeShapeBuckets(String func_name, String var_name, Array<IntImm> buckets,
+                                    bool pad = false);
+
+/*!
+ * \brief Rewrite the call_tir bindings of dataflow blocks into call_tir_inplace, when an input
+ * allocated in the same block is dead after the call and can hold an output. The PrimFunc must
+ * write each element of the output from the same element of the input, as elementwise kernels
+ * do. A copy of the PrimFunc writing the output to the input is added to the module.
+ *
+ * \note The pass should run after FuseTIR and before CallTIRRewrite.
+ * \return The Pass.
+ */
+TVM_DLL Pass DataflowUseInplaceCalls();
+
+/*!
+ * \brief Quantize the weights of matmul and embedding lookups to group-wise int8 or int4. The
+ * weights are the constants, and the parameters after the first `num_input` ones of the functions
+ * with the `num_input` attribute. The quantization is emitted on the weights, to be lifted by
+ * LiftTransformParams, and the uses of the weights become primitive functions that FuseTIR fuses
+ * with the dequantization.
+ * \param bits The number of bits of the quantized values, 4 or 8.
+ * \param group_size The number of consecutive elements along the reduction axis sharing a scale.
+ * \return The Pass.
+ */
+TVM_DLL Pass WeightOnlyQuantize(int bits = 4, int group_size = 32);
+
+/*!
+ * \brief Add a copy of a function, named `{func_name}_calibrate`, which also returns the
+ * activations of its quantizable operators, to calibrate their scales for QuantizeActivations.
+ * The quantizable operators are the matmuls by a 2-D weight and the NCHW conv2ds by a weight in
+ * the top-level blocks of the function, and their activation is their data operand. The copy
+ * returns a tuple of the original result and of the activations, in binding order.
+ * \param func_name The name of the function.
+ * \return The Pass.
+ */
+TVM_DLL Pass InstrumentActivations(String func_name);
+
+/*!
+ * \brief Quantize the quantizable operators of a function, as defined by InstrumentActivations,
+ * to int8. The activations are quantized symmetrically with the given scales, and the weights
+ * with a scale per output channel.
+ * \param func_name The name of the function.
+ * \param scales The scales of the activations, in binding order. The operators with a scale not
+ * greater than zero are left in float.
+ * \param fold Whether to fold the quantization into int8 operators accumulating in int32,
+ * instead of computing on the dequantized operands.
+ * \return The Pass.
+ */
+TVM_DLL Pass QuantizeActivations(String func_name, Array<FloatImm> scales, bool fold = true);
+
+/*!
+ * \brief Split the allreduces in dataflow blocks into an asynchronous start and a wait on its
+ * result, and defer each wait until no other binding of the block is ready, so that the
+ * independent computation overlaps with the communication.
+ * \note The pass should run before LegalizeOps.
+ * \return The Pass.
+ */
+TVM_DLL Pass OverlapAllReduce();
+
 /*!
  * \brief The pass is designed for few shot tuning for static shape PrimFuncs. It examines all the
  *  blocks within the PrimFunc and conducts loop fusion, splitting, and other transformations based
@@ -326,6 +326,18 @@ class MetricCollector : public ObjectRef {
   TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(MetricCollector, ObjectRef, MetricCollectorNode);
 };
 
+/*! \brief Construct a metric collector that reads the CPU performance counters
+ * through the Linux `perf_event_open` interface, without extra dependencies.
+ *
+ * \param metrics The names of the events to collect, following the `perf` tool
+ * (e.g. "cycles", "instructions", "cache-misses", "branch-misses",
+ * "context-switches", "task-clock"). When empty, cycles, instructions, cache
+ * misses, branch misses and context switches are collected. Hardware events
+ * that cannot be opened are replaced by the "task-clock" and "page-faults"
+ * software events.
+ */
+TVM_DLL MetricCollector CreatePerfEventMetricCollector(Array<String> metrics);
+
 /*! Information about a single function or operator call. */
 struct CallFrame {
   /*! Device on which the call was made */
@@ -589,6 +601,52 @@ PackedFunc WrapTimeEvaluator(PackedFunc f, Device dev, int number, int repeat, i
                              int repeats_to_cooldown, int cache_flush_bytes = 0,
                              PackedFunc f_preproc = nullptr);
 
+/*!
+ * \brief Wrap a benchmark function that measures a packed function until its timing converges.
+ *
+ * Unlike `WrapTimeEvaluator`, which runs a fixed number of repeats, the benchmark keeps taking
+ * samples until the 95% confidence interval of the mean is narrow enough, so that the cost of a
+ * measurement adapts to the noise of the machine.
+ *
+ * Approximate implementation:
+ * \code{.py}
+ * f() // warmup
+ * while elapsed < warmup_ms:
+ *   f()
+ * number = ceil(min_repeat_ms / time_per_call)
+ * while True:
+ *   f_preproc()
+ *   samples.append(time(f() for j in range(number)) / number)
+ *   inliers = samples within 3 scaled MADs of the median
+ *   if len(samples) >= min_repeat and ci95(inliers) / mean(inliers) <= target_rel_ci:
+ *     break
+ *   if len(samples) >= max_repeat or elapsed >= max_time_ms:
+ *     break
+ * \endcode
+ *
+ * \param f The function argument.
+ * \param dev The device.
+ * \param min_repeat_ms The minimum duration of one sample in milliseconds, which determines the
+ *        number of calls averaged in each sample.
+ * \param warmup_ms The minimum duration of the warmup in milliseconds. The function is called at
+ *        least once before measuring.
+ * \param min_repeat The minimum number of samples.
+ * \param max_repeat The maximum number of samples.
+ * \param max_time_ms The time budget of the measurement in milliseconds, 0 for no limit.
+ * \param target_rel_ci The target half-width of the 95% confidence interval of the mean,
+ *        relative to the mean.
+ * \param pin_threads Whether to pin the threads of the runtime thread pool to the big cores
+ *        before measuring, only effective on CPU.
+ * \param cache_flush_bytes The number of bytes to flush from cache before each sample.
+ * \param f_preproc The function to be executed before each sample.
+ * \return f_benchmark A benchmark function returning a JSON string with the schema
+ *         documented by `tvm.runtime.Module.benchmark_evaluator`.
+ */
+PackedFunc WrapBenchmarkEvaluator(PackedFunc f, Device dev, int min_repeat_ms, int warmup_ms,
+                                  int min_repeat, int max_repeat, int max_time_ms,
+                                  double target_rel_ci, bool pin_threads,
+                                  int cache_flush_bytes = 0, PackedFunc f_preproc = nullptr);
+
 }  // namespace profiling
 }  // namespace runtime
 }  // namespace tvm
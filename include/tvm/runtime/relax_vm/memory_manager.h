@@ -82,6 +82,10 @@ class Allocator {
    *  \param buffer The buffer to free.
    */
   virtual void Free(const Buffer& buffer) = 0;
+  /*! \brief The amount of memory currently held by the allocator.
+   *  \return The amount of memory in bytes, including the cached memory of a pooled allocator.
+   */
+  virtual size_t UsedMemory() const = 0;
 
  private:
   AllocatorType type_;
@@ -107,6 +111,13 @@ class MemoryManager {
   /*! \brief Clear the allocators. */
   static void Clear();
 
+  /*!
+   * \brief Get the amount of memory held by the allocator of a device.
+   * \param dev The TVM device
+   * \return The amount of memory in bytes, 0 if the device has no allocator.
+   */
+  static size_t UsedMemory(Device dev);
+
  private:
   MemoryManager() {}
 
@@ -39,6 +39,14 @@ namespace tvm {
 namespace runtime {
 namespace relax_vm {
 
+/*!
+ * \brief The name of the function allocating the persistent workspace, which the VM
+ * invokes once on initialization when the executable contains it. The function is not
+ * exposed to the users of the VM.
+ * \sa relax::transform::PlanPersistentWorkspace
+ */
+constexpr const char* kPersistentWorkspaceAllocFunc = "vm_persistent_workspace_alloc";
+
 /*!
  * \brief Possible instrument actions.
  */
@@ -178,6 +186,12 @@ class VirtualMachine : public runtime::ModuleNode {
   std::vector<Allocator*> allocators;
   /*! \brief Runtime physical device list. */
   std::vector<Device> devices;
+  /*!
+   * \brief The storages of the persistent workspace, allocated on initialization and
+   * shared by the entry functions across invocations, which must therefore be ordered on
+   * the device.
+   */
+  Array<ObjectRef> persistent_workspace;
 };
 
 }  // namespace relax_vm
@@ -359,6 +359,15 @@ constexpr const char* kIsHostFunc = "tir.is_host_func";
  */
 constexpr const char* kIsScheduled = "tir.is_scheduled";
 
+/*!
+ * \brief The number of independent kernels that were fused horizontally into the function.
+ *
+ * The kernels do not depend on each other, so they may be dispatched as one kernel.
+ *
+ * Type: Integer
+ */
+constexpr const char* kHorizontalFusion = "tir.horizontal_fusion";
+
 }  // namespace attr
 }  // namespace tir
 }  // namespace tvm
@@ -51,12 +51,17 @@ using tvm::transform::Sequential;
  * \param opt_level The optimization level of the function pass.
  * \param name The name of the function pass.
  * \param required The list of the passes that the function pass is dependent on.
+ * \param traceable Whether the pass is traceable.
+ * \param thread_safe Whether pass_func can run on different PrimFuncs concurrently.
+ *        When set, the PrimFuncs of a module are processed by
+ *        "tir.num_prim_func_pass_threads" threads.
  *
  * \return The created function pass.
  */
 TVM_DLL Pass CreatePrimFuncPass(
     const runtime::TypedPackedFunc<PrimFunc(PrimFunc, IRModule, PassContext)>& pass_func,
-    int opt_level, String name, tvm::Array<String> required, bool traceable = false);
+    int opt_level, String name, tvm::Array<String> required, bool traceable = false,
+    bool thread_safe = false);
 
 /*!
  * \brief Inject prefetch instructions into stmt.
@@ -825,6 +830,17 @@ TVM_DLL Pass InstrumentProfileIntrinsics();
  */
 TVM_DLL Pass DefaultGPUSchedule();
 
+/*!
+ * \brief Merge the independent kernels of a horizontally fused PrimFunc into a single kernel.
+ *
+ *  Only applies to PrimFuncs with the `tir.horizontal_fusion` attribute, whose body launches
+ *  exactly that many kernels, each over one blockIdx.x and one threadIdx.x dimension. The merged
+ *  kernel launches the sum of the blocks of the kernels and the maximum of their threads, and
+ *  branches on the block index to the kernel that owns the block.
+ * \return The Pass.
+ */
+TVM_DLL Pass HorizontalFuseKernels();
+
 }  // namespace transform
 }  // namespace tir
 }  // namespace tvm
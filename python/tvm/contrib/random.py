@@ -112,4 +112,45 @@ def normal(loc, scale, size):
     )
 
 
+def bernoulli(prob, size, dtype="float32"):
+    """Draw samples from a Bernoulli distribution.
+
+    Each element is 1 with probability prob, and 0 otherwise.
+
+    Parameters
+    ----------
+    prob : float
+        The probability of drawing 1.
+    size : tuple of ints
+        Output shape.
+    dtype : str
+        The output dtype, one of float32, int32/uint32, int8/uint8 or bool.
+
+    Returns
+    ------
+    out : Tensor
+        A tensor with specified size and dtype
+    """
+    return te.extern(
+        size,
+        [],
+        lambda ins, outs: tvm.tir.call_packed("tvm.contrib.random.bernoulli", float(prob), outs[0]),
+        dtype=dtype,
+    )
+
+
+def seed(value):
+    """Seed the random engine of the calling thread.
+
+    The samples of uniform, normal and bernoulli only depend on the seed and
+    on the number of samples drawn since seeding, not on the number of threads.
+
+    Parameters
+    ----------
+    value : int
+        The seed.
+    """
+    tvm.get_global_func("tvm.contrib.random.seed")(int(value))
+
+
 tvm._ffi._init_api("tvm.contrib.random")
@@ -22,6 +22,7 @@ from .affine_type import TensorAffineType, TupleAffineType
 from .attrs import Attrs, DictAttrs, make_node
 from .base import (
     EnvFunc,
+    NDArrayHashCache,
     Node,
     SourceName,
     Span,
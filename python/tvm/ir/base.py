@@ -301,6 +301,32 @@ def structural_hash(node, map_free_vars=False):
     return _ffi_node_api.StructuralHash(node, map_free_vars)  # type: ignore # pylint: disable=no-member
 
 
+class NDArrayHashCache:
+    """Scope that memoizes the structural hash of NDArray data by object identity.
+
+    Inside the scope, the raw data of each NDArray is hashed at most once and the
+    result is reused whenever the same NDArray object is visited again, e.g. when
+    repeatedly hashing modules that share large constants. NDArrays must not be
+    mutated in place while the scope is active.
+
+    Examples
+    --------
+    .. code-block:: python
+
+        with tvm.ir.NDArrayHashCache():
+            h0 = tvm.ir.structural_hash(mod)
+            # reuses the hash of every constant in mod
+            h1 = tvm.ir.structural_hash(mod)
+    """
+
+    def __enter__(self):
+        _ffi_node_api.NDArrayHashCacheEnter()  # type: ignore # pylint: disable=no-member
+        return self
+
+    def __exit__(self, ptype, value, trace):
+        _ffi_node_api.NDArrayHashCacheExit()  # type: ignore # pylint: disable=no-member
+
+
 def deprecated(
     method_name: str,
     new_method_name: str,
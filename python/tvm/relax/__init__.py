@@ -104,4 +104,6 @@ from . import frontend
 # VM
 from .vm_build import build, Executable
 
+from . import quantize
+
 from .binding_rewrite import DataflowBlockRewrite
@@ -19,6 +19,7 @@
 
 import tvm.ir
 from . import _ffi_api
+from ..global_info import DeviceMesh
 
 
 def PropagateSharding() -> tvm.ir.transform.Pass:
@@ -30,3 +31,59 @@ def PropagateSharding() -> tvm.ir.transform.Pass:
         The registered pass
     """
     return _ffi_api.PropagateSharding()  # type: ignore
+
+
+def AutoSharding(
+    device_mesh: DeviceMesh, memory_cap: int, flops_per_byte: float = 100.0
+) -> tvm.ir.transform.Pass:
+    """Search the sharding of the tensors which are not annotated, and propagate it.
+
+    Each group of tensor axes connected by the operators is either replicated or sharded on an
+    axis of the device mesh. The plan is chosen greedily to minimize the estimated step time,
+    including the allreduce of the sharded reductions and the scatter/gather of the function
+    inputs and outputs, with the memory per device under the cap. The parameters are annotated
+    with their placements, and the sharding is then propagated with `PropagateSharding`.
+
+    Parameters
+    ----------
+    device_mesh : DeviceMesh
+        The device mesh to shard the tensors on.
+
+    memory_cap : int
+        The memory cap per device in bytes.
+
+    flops_per_byte : float
+        The cost of communicating one byte, relative to one flop.
+
+    Returns
+    -------
+    ret : tvm.transform.Pass
+        The registered pass
+    """
+    return _ffi_api.AutoSharding(device_mesh, memory_cap, flops_per_byte)  # type: ignore
+
+
+def PartitionPipelineStages(num_stages: int, func_name: str = "main") -> tvm.ir.transform.Pass:
+    """Partition a function into pipeline stages balanced by their estimated cost.
+
+    The bindings of the function are split into `num_stages` consecutive stages, minimizing the
+    estimated cost of the most expensive one. The stage `i` is added as the function
+    `{func_name}_stage{i}`, which takes the activations live into the stage followed by the
+    weights used by the stage. Each stage but the last returns a tuple of the activations taken
+    by the next stage, so that the stages can be chained by `Session.run_pipeline`. The first
+    stage takes all the inputs of the function, and the original function is kept.
+
+    Parameters
+    ----------
+    num_stages : int
+        The number of pipeline stages.
+
+    func_name : str
+        The name of the function to partition.
+
+    Returns
+    -------
+    ret : tvm.transform.Pass
+        The registered pass
+    """
+    return _ffi_api.PartitionPipelineStages(num_stages, func_name)  # type: ignore
@@ -0,0 +1,185 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Calibration of the activation scales for static quantization."""
+from typing import Iterable, List, Sequence, Union
+
+import numpy as np  # type: ignore
+
+import tvm
+from tvm.ir import IRModule
+from tvm.runtime.relax_vm import VirtualMachine
+
+from .. import transform
+from ..vm_build import build
+
+
+class MinMaxObserver:
+    """Observe the largest absolute value of an activation."""
+
+    def __init__(self):
+        self.max = 0.0
+
+    def update(self, value: np.ndarray):
+        """Update the statistics with a value of the activation."""
+        if value.size:
+            self.max = max(self.max, float(np.abs(value).max()))
+
+    def absmax(self) -> float:
+        """Return the largest absolute value to represent."""
+        return self.max
+
+
+class HistogramObserver:
+    """Observe the histogram of the absolute values of an activation, and clip the outliers
+    above a percentile.
+
+    The histogram spans from zero to the largest absolute value seen so far. When a value is
+    out of range, the range is doubled until it is covered, by merging the bins pairwise.
+
+    Parameters
+    ----------
+    num_bins : int
+        The number of bins of the histogram. It must be even.
+
+    percentile : float
+        The percentile, in percent, of the absolute values to represent.
+    """
+
+    def __init__(self, num_bins: int = 2048, percentile: float = 99.99):
+        assert num_bins % 2 == 0, "The number of bins must be even"
+        self.num_bins = num_bins
+        self.percentile = percentile
+        self.hist = np.zeros(num_bins, dtype="int64")
+        self.range = 0.0
+        self.max = 0.0
+
+    def update(self, value: np.ndarray):
+        """Update the statistics with a value of the activation."""
+        value = np.abs(value).ravel().astype("float64")
+        if not value.size:
+            return
+        self.max = max(self.max, float(value.max()))
+        if self.range == 0.0:
+            # The values seen so far were all zero, and are in the first bin of any range.
+            self.range = self.max
+        while self.max > self.range:
+            merged = self.hist.reshape(-1, 2).sum(axis=1)
+            self.hist = np.concatenate([merged, np.zeros_like(merged)])
+            self.range *= 2
+        if self.range == 0.0:
+            self.hist[0] += value.size
+        else:
+            hist, _ = np.histogram(value, bins=self.num_bins, range=(0.0, self.range))
+            self.hist += hist
+
+    def absmax(self) -> float:
+        """Return the largest absolute value to represent."""
+        total = self.hist.sum()
+        if total == 0 or self.range == 0.0:
+            return 0.0
+        cumsum = np.cumsum(self.hist)
+        index = int(np.searchsorted(cumsum, total * self.percentile / 100.0))
+        return min(self.max, (index + 1) * self.range / self.num_bins)
+
+
+def calibrate(
+    mod: IRModule,
+    dataset: Iterable[Sequence[Union[np.ndarray, tvm.nd.NDArray]]],
+    target: Union[str, tvm.target.Target] = "llvm",
+    device: tvm.runtime.Device = tvm.cpu(),
+    func_name: str = "main",
+    observer: str = "minmax",
+) -> List[float]:
+    """Calibrate the scales of the activations of the quantizable operators of a function.
+
+    The function is instrumented by :py:func:`tvm.relax.transform.InstrumentActivations`,
+    built and run on the dataset. Each activation is quantized symmetrically to int8, with
+    the scale mapping the largest absolute value to represent to 127.
+
+    Parameters
+    ----------
+    mod : IRModule
+        The module to calibrate, before legalization.
+
+    dataset : Iterable[Sequence[Union[np.ndarray, tvm.nd.NDArray]]]
+        The samples, each being the arguments of the function, including the weights after
+        the first `num_input` arguments if any.
+
+    target : Union[str, tvm.target.Target]
+        The target to run the calibration on.
+
+    device : tvm.runtime.Device
+        The device to run the calibration on.
+
+    func_name : str
+        The name of the function.
+
+    observer : str
+        The statistics of the activations, "minmax" for their largest absolute value, or
+        "histogram" to clip the outliers above the 99.99th percentile.
+
+    Returns
+    -------
+    scales : List[float]
+        The scales of the activations, to pass to :py:func:`quantize`.
+    """
+    observers = {"minmax": MinMaxObserver, "histogram": HistogramObserver}
+    if observer not in observers:
+        raise ValueError(f"Unknown observer {observer}, expected one of {list(observers)}")
+
+    mod = transform.InstrumentActivations(func_name)(mod)
+    vm = VirtualMachine(build(mod, target), device)
+    stats = None
+    for sample in dataset:
+        args = [x if isinstance(x, tvm.nd.NDArray) else tvm.nd.array(x, device) for x in sample]
+        activations = vm[func_name + "_calibrate"](*args)[1]
+        if stats is None:
+            stats = [observers[observer]() for _ in range(len(activations))]
+        for stat, activation in zip(stats, activations):
+            stat.update(activation.numpy())
+    if stats is None:
+        raise ValueError("The calibration dataset is empty")
+    return [stat.absmax() / 127.0 for stat in stats]
+
+
+def quantize(
+    mod: IRModule, scales: List[float], func_name: str = "main", fold: bool = True
+) -> IRModule:
+    """Quantize the activations and weights of the quantizable operators of a function to
+    int8, with the activation scales from :py:func:`calibrate`.
+
+    Parameters
+    ----------
+    mod : IRModule
+        The module to quantize, before legalization.
+
+    scales : List[float]
+        The scales of the activations.
+
+    func_name : str
+        The name of the function.
+
+    fold : bool
+        Whether to fold the quantization into int8 operators accumulating in int32, instead
+        of computing on the dequantized operands.
+
+    Returns
+    -------
+    mod : IRModule
+        The quantized module.
+    """
+    return transform.QuantizeActivations(func_name, scales, fold)(mod)
@@ -21,6 +21,7 @@ from .transform import (
     AlterOpImpl,
     AnnotateTIROpPattern,
     AttachGlobalSymbol,
+    AutoCheckpoint,
     BindParams,
     BindSymbolicVars,
     BundleModelParams,
@@ -29,9 +30,11 @@ from .transform import (
     CombineParallelMatmul,
     ConvertLayout,
     DataflowBlockPass,
+    DataflowUseInplaceCalls,
     DeadCodeElimination,
     DecomposeOpsForInference,
     DecomposeOpsForTraining,
+    DeduplicateConstants,
     EliminateCommonSubexpr,
     FewShotTuning,
     FoldConstant,
@@ -41,6 +44,8 @@ from .transform import (
     FuseTIR,
     FusionPattern,
     Gradient,
+    HorizontalFuseOps,
+    InstrumentActivations,
     KillAfterLastUse,
     LambdaLift,
     LegalizeOps,
@@ -51,12 +56,16 @@ from .transform import (
     MetaScheduleTuneIRMod,
     MetaScheduleTuneTIR,
     Normalize,
+    OverlapAllReduce,
     PatternCheckContext,
+    PlanPersistentWorkspace,
+    QuantizeActivations,
     RealizeVDevice,
     RemovePurityChecking,
     RewriteCUDAGraph,
     RewriteDataflowReshape,
     RunCodegen,
+    SpecializeShapeBuckets,
     SplitCallTIRByPattern,
     StaticPlanBlockMemory,
     ToMixedPrecision,
@@ -64,6 +73,7 @@ from .transform import (
     UpdateVDevice,
     VMBuiltinLower,
     VMShapeLower,
+    WeightOnlyQuantize,
     dataflowblock_pass,
     function_pass,
 )
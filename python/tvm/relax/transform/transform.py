@@ -223,6 +223,50 @@ def Gradient(
     return _ffi_api.Gradient(func_name, require_grads, target_index)  # type: ignore
 
 
+def AutoCheckpoint(
+    func_name: str,
+    memory_budget: int,
+    require_grads: Optional[Union[Var, List[Var]]] = None,
+    target_index: int = 0,
+) -> tvm.ir.transform.Pass:
+    """Choose the activations of a function to rematerialize in the backward pass under a memory
+    budget, and mark them with checkpoints for :py:func:`Gradient`.
+
+    Without checkpoints, every activation used by the backward pass is kept from the forward
+    pass. This pass drops activations greedily, by the ratio of the memory freed to the
+    estimated cost of recomputing them, until the kept activations fit the budget. A dropped
+    activation keeps alive the activations it is recomputed from. The dropped activations are
+    marked with :py:func:`tvm.relax.op.grad.start_checkpoint` and
+    :py:func:`tvm.relax.op.grad.end_checkpoint`, so that Gradient recomputes them. The
+    function must have no checkpoint yet.
+
+    Parameters
+    ----------
+    func_name : str
+        The name of the specific function.
+
+    memory_budget : int
+        The budget in bytes for the activations kept for the backward pass.
+
+    require_grads : Optional[Union[relax.Var, List[relax.Var]]]
+        The relax variables whose adjoints are needed, as in :py:func:`Gradient`.
+
+    target_index : int
+        The index of the differentiation target, as in :py:func:`Gradient`.
+
+    Returns
+    -------
+    ret : tvm.ir.transform.Pass
+        The Pass.
+    """
+    if require_grads is not None and not isinstance(require_grads, list):
+        require_grads = [require_grads]
+
+    return _ffi_api.AutoCheckpoint(  # type: ignore
+        func_name, memory_budget, require_grads, target_index
+    )
+
+
 def ToNonDataflow() -> tvm.ir.transform.Pass:
     """Transform all dataflow structure to non-dataflow version.
 
@@ -371,6 +415,13 @@ def StaticPlanBlockMemory() -> tvm.ir.transform.Pass:
     signature will have upper bound 1024. And we will use 1024 as its value
     during memory planning.
 
+    When the pass config :code:`"relax.StaticPlanBlockMemory.arena_planning"` is
+    set to True, the pass instead packs the tensors of each binding block into a
+    single arena according to their liveness intervals. In this mode, tensor sizes
+    that depend only on the TIR variables in the function signature stay symbolic,
+    so that the arena size and the tensor offsets are computed from the actual
+    shape values at runtime rather than from the upper bounds.
+
     Returns
     -------
     ret : tvm.ir.transform.Pass
@@ -543,6 +594,17 @@ def FoldConstant() -> tvm.ir.transform.Pass:
     return _ffi_api.FoldConstant()  # type: ignore
 
 
+def DeduplicateConstants() -> tvm.ir.transform.Pass:
+    """Share the constants of the same data and struct info across all the Relax functions of the
+    IRModule, so that a single NDArray is kept for tied weights or identical folded constants.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+    """
+    return _ffi_api.DeduplicateConstants()  # type: ignore
+
+
 def AnnotateTIROpPattern() -> tvm.ir.transform.Pass:
     """Annotate Op Pattern Kind for TIR functions
 
@@ -561,6 +623,11 @@ def FuseOps(fuse_opt_level=-1) -> tvm.ir.transform.Pass:
 
     A follow-up pass named "FuseTIR" will generate a TIR PrimFunc for each grouped function.
 
+    With the pass config "relax.FuseOps.cost_model" set, the fusions allowed by the op patterns
+    are only made when the estimated bytes of memory traffic saved outweigh the FLOPs recomputed
+    by the consumers reading an element of the fused output more than once. The FLOPs worth one
+    byte are given by "relax.FuseOps.flops_per_byte".
+
     Parameters
     ----------
     fuse_opt_level : int
@@ -586,6 +653,39 @@ def FuseTIR() -> tvm.ir.transform.Pass:
     return _ffi_api.FuseTIR()  # type: ignore
 
 
+def HorizontalFuseOps(
+    max_group_size: int = 8, max_num_elements: int = 65536
+) -> tvm.ir.transform.Pass:
+    """Fuse the independent small kernels of a dataflow block horizontally, so that the VM calls
+    them once instead of one by one.
+
+    The `call_tir` bindings of the same depth in the dataflow graph of a block, whose PrimFuncs
+    have the same op pattern, are grouped into a grouped function, which a following FuseTIR pass
+    turns into a single PrimFunc. It is expected to run after AnnotateTIROpPattern, e.g. after
+    FuseTIR followed by AnnotateTIROpPattern.
+
+    The grouped functions are marked with ``relax.horizontal_fusion``, which FuseTIR forwards to
+    the fused PrimFunc. On GPU targets, once the members are scheduled and lowered,
+    ``tvm.tir.transform.HorizontalFuseKernels`` dispatches them over a shared blockIdx.x
+    dimension, so that they are launched as a single kernel.
+
+    Parameters
+    ----------
+    max_group_size : int
+        The maximum number of kernels fused into one.
+
+    max_num_elements : int
+        The maximum number of output elements of a kernel to be fused. Larger kernels keep the
+        device busy on their own.
+
+    Returns
+    -------
+    ret : tvm.transform.Pass
+        The registered pass for horizontal fusion.
+    """
+    return _ffi_api.HorizontalFuseOps(max_group_size, max_num_elements)  # type: ignore
+
+
 @tvm._ffi.register_object("relax.transform.PatternCheckContext")
 class PatternCheckContext(Object):
     """
@@ -1185,6 +1285,198 @@ def RewriteCUDAGraph() -> tvm.ir.transform.Pass:
     return _ffi_api.RewriteCUDAGraph()  # type: ignore
 
 
+def PlanPersistentWorkspace() -> tvm.ir.transform.Pass:
+    """Hoist the statically planned storages into a persistent workspace.
+
+    The storages allocated with constant sizes by :code:`R.memory.alloc_storage` are
+    replaced with slots of a workspace, which the VM allocates once on initialization
+    and reuses across invocations, so that running a function no longer allocates them.
+    The workspace is shared by all the functions exposed by the module that neither call
+    nor are called by another Relax function. Such functions must not run concurrently
+    on the same VM, e.g. the prefill and decode functions of a language model.
+
+    As the workspace belongs to the VM rather than to an invocation, the invocations of
+    one VM must be ordered on the device. This holds for the synchronous calls and for the
+    pipelined invocations of :code:`invoke_async`, which run on the same stream, but not
+    for invocations made concurrently from several threads or on different streams.
+    The function allocating the workspace is internal to the VM and cannot be called by
+    the users.
+
+    The pass only takes effect when the pass config
+    :code:`"relax.backend.use_persistent_workspace"` is set to True.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+        The registered pass for planning the persistent workspace.
+    """
+    return _ffi_api.PlanPersistentWorkspace()  # type: ignore
+
+
+def SpecializeShapeBuckets(
+    func_name: str, var_name: str, buckets: List[int], pad: bool = False
+) -> tvm.ir.transform.Pass:
+    """Specialize a dynamic-shape function for the hot values of one symbolic variable.
+
+    For each bucket, a copy of the function is added with the variable bound to the
+    bucket value, so that the kernels it lowers to have static shapes and can be tuned for
+    them. A copy of the generic function is also added. The function is replaced with a
+    dispatcher calling the copy whose bucket matches the value of the variable at run time,
+    or the generic copy if none does.
+
+    With `pad` set, the dispatcher calls the smallest bucket not smaller than the value.
+    The input dimensions equal to the variable are padded with zeros, and the output
+    dimensions equal to the variable are sliced back. This is only correct when the padded
+    entries do not change the others, e.g. for a batch dimension, which the pass cannot
+    check.
+
+    The pass should run before the operators are legalized.
+
+    Parameters
+    ----------
+    func_name : str
+        The name of the function to specialize.
+
+    var_name : str
+        The name of the symbolic variable, which must be defined by the function parameters.
+
+    buckets : List[int]
+        The values of the variable to specialize for.
+
+    pad : bool
+        Whether to dispatch to the smallest covering bucket with padding, instead of an
+        exact match.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+    """
+    buckets = [tvm.tir.IntImm("int64", value) for value in buckets]
+    return _ffi_api.SpecializeShapeBuckets(func_name, var_name, buckets, pad)  # type: ignore
+
+
+def DataflowUseInplaceCalls() -> tvm.ir.transform.Pass:
+    """Rewrite the call_tir bindings in dataflow blocks into call_tir_inplace where an
+    output can reuse the storage of an input.
+
+    An input is reused when it is allocated by a call_tir in the same dataflow block, is not
+    aliased, is not used after the call, and has the shape and dtype of the output. The
+    PrimFunc must only read each element of the input to compute the same element of the
+    output, as elementwise kernels and their fusions do. A copy of the PrimFunc writing the
+    output to the input is added to the module.
+
+    The pass should run after FuseTIR and before CallTIRRewrite.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+    """
+    return _ffi_api.DataflowUseInplaceCalls()  # type: ignore
+
+
+def WeightOnlyQuantize(bits: int = 4, group_size: int = 32) -> tvm.ir.transform.Pass:
+    """Quantize the weights of matmuls and embedding lookups to group-wise int8 or int4.
+
+    The weights are the constants, and the parameters after the first `num_input` ones of
+    the functions with the `num_input` attribute. A weight is quantized along its reduction
+    axis in groups of `group_size` elements, each with a scale. Int4 values are packed by
+    two into uint8.
+
+    The quantization is emitted on the weights, so that LiftTransformParams moves it to the
+    parameter transformation function. Each matmul by a quantized weight, or lookup into a
+    quantized embedding table, becomes a call to a primitive function that FuseTIR fuses
+    with the dequantization after LegalizeOps.
+
+    The pass should run before LiftTransformParams and LegalizeOps.
+
+    Parameters
+    ----------
+    bits : int
+        The number of bits of the quantized values, 4 or 8.
+
+    group_size : int
+        The number of consecutive elements along the reduction axis sharing a scale.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+    """
+    return _ffi_api.WeightOnlyQuantize(bits, group_size)  # type: ignore
+
+
+def InstrumentActivations(func_name: str = "main") -> tvm.ir.transform.Pass:
+    """Add a copy of a function, named `{func_name}_calibrate`, which also returns the
+    activations of its quantizable operators, to calibrate their scales.
+
+    The quantizable operators are the matmuls by a 2-D weight and the NCHW conv2ds by a
+    weight in the top-level blocks of the function, where a weight is a constant or a
+    parameter after the first `num_input` ones. Their activation is their data operand.
+    The copy returns a tuple of the original result and of the activations, in binding
+    order, and takes all the parameters of the function.
+
+    Parameters
+    ----------
+    func_name : str
+        The name of the function.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+    """
+    return _ffi_api.InstrumentActivations(func_name)  # type: ignore
+
+
+def QuantizeActivations(
+    func_name: str, scales: List[float], fold: bool = True
+) -> tvm.ir.transform.Pass:
+    """Quantize the quantizable operators of a function, as defined by InstrumentActivations,
+    to int8.
+
+    The activations are quantized symmetrically with the given scales, and the weights with
+    a scale per output channel. With `fold`, the operators compute on the int8 operands,
+    accumulate in int32 and rescale the result to the original dtype. Otherwise, they
+    compute on the dequantized operands.
+
+    Parameters
+    ----------
+    func_name : str
+        The name of the function.
+
+    scales : List[float]
+        The scales of the activations, in binding order, e.g. from
+        :py:func:`tvm.relax.quantize.calibrate`. The operators with a scale not greater than
+        zero are left in float.
+
+    fold : bool
+        Whether to fold the quantization into int8 operators.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+    """
+    scales = [tvm.tir.FloatImm("float64", float(s)) for s in scales]
+    return _ffi_api.QuantizeActivations(func_name, scales, fold)  # type: ignore
+
+
+def OverlapAllReduce() -> tvm.ir.transform.Pass:
+    """Overlap the allreduces with the computation independent of them.
+
+    Each `R.ccl.allreduce` in a dataflow block is split into `runtime.disco.allreduce_start`,
+    which launches the allreduce on a separate communication stream into a receive buffer
+    allocated by the memory planning, and `runtime.disco.allreduce_wait`, which makes the
+    following computation wait for the receive buffer and returns it.
+    The bindings of the block are reordered so that each wait is deferred until no other
+    binding is ready, and the independent computation runs while the allreduce is in flight.
+
+    The pass should run before LegalizeOps.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+    """
+    return _ffi_api.OverlapAllReduce()  # type: ignore
+
+
 def AllocateWorkspace() -> tvm.ir.transform.Pass:
     """Allocate a workspace, represented by a tensor of size big enough for all external
     functions that require a temporary storage, and append it to the arguments of external
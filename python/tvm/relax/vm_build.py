@@ -314,6 +314,7 @@ def build(
             relax.transform.CallTIRRewrite(),
             relax.transform.StaticPlanBlockMemory(),
             relax.transform.RewriteCUDAGraph(),
+            relax.transform.PlanPersistentWorkspace(),
             relax.transform.LowerAllocTensor(),
             relax.transform.KillAfterLastUse(),
             relax.transform.VMBuiltinLower(),
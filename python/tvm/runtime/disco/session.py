@@ -343,6 +343,40 @@ class Session(Object):
         func = self._get_cached_method("runtime.disco.allgather")
         func(src, dst)
 
+    def run_pipeline(
+        self,
+        vm: DModule,
+        func_name: str,
+        microbatches: DRef,
+        params: DRef,
+        num_microbatches: int,
+    ) -> DRef:
+        """Run the pipeline stages of a function partitioned by `PartitionPipelineStages`.
+
+        The worker `i` runs the stage `{func_name}_stage{i}`. Each micro-batch is streamed from
+        worker-0 to the last worker, so that the stages of consecutive micro-batches overlap.
+
+        Parameters
+        ----------
+        vm : DModule
+            The VM module containing the pipeline stages.
+        func_name : str
+            The name of the partitioned function.
+        microbatches : DRef
+            An array of the inputs of each micro-batch. Only used by worker-0.
+        params : DRef
+            An array of the weights of the stage of each worker.
+        num_microbatches : int
+            The number of micro-batches.
+
+        Returns
+        -------
+        outputs : DRef
+            An array of the outputs of each micro-batch on the last worker.
+        """
+        func = self._get_cached_method("runtime.disco.run_pipeline")
+        return func(vm, func_name, microbatches, params, ShapeTuple([num_microbatches]))
+
 
 @register_object("runtime.disco.ThreadedSession")
 class ThreadedSession(Session):
@@ -19,6 +19,7 @@
 """Runtime Module namespace."""
 import os
 import ctypes
+import json
 import struct
 from typing import Sequence
 import numpy as np
@@ -407,6 +408,107 @@ class Module(object):
         except NameError:
             raise NameError("time_evaluator is only supported when RPC is enabled")
 
+    def benchmark_evaluator(
+        self,
+        func_name,
+        dev,
+        min_repeat_ms=1,
+        warmup_ms=100,
+        min_repeat=10,
+        max_repeat=1000,
+        max_time_ms=10000,
+        target_rel_ci=0.01,
+        pin_threads=False,
+        cache_flush_bytes=0,
+        f_preproc="",
+    ):
+        """Get an evaluator that measures the function until its timing converges.
+
+        Unlike :py:meth:`time_evaluator`, which takes a fixed number of samples, the evaluator
+        keeps sampling until the 95% confidence interval of the mean is within `target_rel_ci`
+        of the mean, or until the budget of samples or time is exhausted. Samples further than
+        3 scaled median absolute deviations from the median are treated as outliers and excluded
+        from the mean and its confidence interval.
+
+        Parameters
+        ----------
+        func_name: str
+            The name of the function in the module.
+
+        dev: Device
+            The device we should run this function on.
+
+        min_repeat_ms: int, optional
+            The minimum duration of one sample in milliseconds. The number of calls averaged in
+            one sample is chosen from the time per call measured during the warmup.
+
+        warmup_ms: int, optional
+            The minimum duration of the warmup in milliseconds. The function is called at least
+            once before measuring.
+
+        min_repeat: int, optional
+            The minimum number of samples, at least 2.
+
+        max_repeat: int, optional
+            The maximum number of samples.
+
+        max_time_ms: int, optional
+            The time budget of the measurement in milliseconds, 0 for no limit.
+
+        target_rel_ci: float, optional
+            The target half-width of the 95% confidence interval, relative to the mean.
+
+        pin_threads: bool, optional
+            Whether to pin the threads of the runtime thread pool to the big cores before
+            measuring. Only effective on CPU, and the thread pool stays pinned afterwards.
+
+        cache_flush_bytes: int, optional
+            The number of bytes to flush from the cache before each sample.
+
+        f_preproc: str, optional
+            The preprocess function name we want to execute before each sample.
+
+        Returns
+        -------
+        fbenchmark : function
+            The function that takes same argument as func and returns a dict with the stable
+            schema below, where all the times are in seconds.
+
+            - schema_version: The version of the schema, currently 1.
+            - device, config: The device and the parameters of the measurement.
+            - number: The number of calls averaged in each sample.
+            - num_samples, num_outliers: The number of samples, and of outliers among them.
+            - converged: Whether the target confidence interval was reached.
+            - mean, std: The mean and standard deviation of the samples except the outliers.
+            - median, p90, p99, min, max: The order statistics of all the samples.
+            - ci95, rel_ci95: The half-width of the 95% confidence interval of the mean,
+              absolute and relative to the mean.
+            - noise: The scaled median absolute deviation relative to the median, a robust
+              estimate of the noise of the machine.
+            - samples: The raw samples.
+        """
+        fbenchmark = _ffi_api.BenchmarkEvaluator(
+            self,
+            func_name,
+            dev.device_type,
+            dev.device_id,
+            min_repeat_ms,
+            warmup_ms,
+            min_repeat,
+            max_repeat,
+            max_time_ms,
+            target_rel_ci,
+            pin_threads,
+            cache_flush_bytes,
+            f_preproc,
+        )
+
+        def evaluator(*args):
+            """Internal wrapped evaluator."""
+            return json.loads(fbenchmark(*args))
+
+        return evaluator
+
     def _collect_from_import_tree(self, filter_func):
         """Helper function to collect modules from the tree matching a filter_func, then return it.
 
@@ -269,6 +269,34 @@ def profile_function(mod, dev, collectors, func_name=None, warmup_iters=10):
     )
 
 
+# The perf_event collector is only built on Linux
+if (
+    _ffi.get_global_func("runtime.profiling.PerfEventMetricCollector", allow_missing=True)
+    is not None
+):
+
+    @_ffi.register_object("runtime.profiling.PerfEventMetricCollector")
+    class PerfEventMetricCollector(MetricCollector):
+        """Collects CPU performance counters through the Linux perf_event
+        interface. Only available on Linux.
+        """
+
+        def __init__(self, metric_names: Optional[Sequence[str]] = None):
+            """
+            Parameters
+            ----------
+            metric_names : Optional[Sequence[str]]
+                Names of the events to collect, following the `perf` tool, e.g.
+                "cycles", "instructions", "cache-misses", "branch-misses",
+                "context-switches", "task-clock" or "page-faults". Collects
+                cycles, instructions, cache misses, branch misses and context
+                switches by default. Unavailable hardware events are replaced
+                by software events.
+            """
+            metric_names = [] if metric_names is None else list(metric_names)
+            self.__init_handle_by_constructor__(_ffi_api.PerfEventMetricCollector, metric_names)
+
+
 # We only enable this class when TVM is build with PAPI support
 if _ffi.get_global_func("runtime.profiling.PAPIMetricCollector", allow_missing=True) is not None:
 
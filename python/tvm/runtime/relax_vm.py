@@ -18,6 +18,8 @@
 """The Relax virtual machine."""
 from typing import Callable, List, Optional, Union, Dict, Tuple, Any
 from enum import IntEnum
+import ctypes
+import json
 import numpy as np  # type: ignore
 
 import tvm
@@ -35,6 +37,120 @@ class VMInstrumentReturnKind(IntEnum):
     SKIP_RUN = 1
 
 
+@tvm._ffi.register_object("relax.vm.InvokeFuture")
+class InvokeFuture(Object):
+    """The result of an invocation queued by :py:meth:`VirtualMachine.invoke_async`."""
+
+    def poll(self) -> bool:
+        """Check whether the invocation has completed, without blocking."""
+        return tvm.get_global_func("vm.builtin.invoke_future_poll")(self)
+
+    def wait(self, timeout: Optional[float] = None) -> bool:
+        """Wait for the invocation to complete.
+
+        Parameters
+        ----------
+        timeout : Optional[float]
+            The maximum time to wait in seconds. Wait without limit if None.
+
+        Returns
+        -------
+        done : bool
+            Whether the invocation has completed.
+        """
+        timeout_ms = -1 if timeout is None else int(timeout * 1000)
+        return tvm.get_global_func("vm.builtin.invoke_future_wait")(self, timeout_ms)
+
+    def result(self, timeout: Optional[float] = None) -> Any:
+        """Wait for the invocation to complete and get its result.
+
+        Parameters
+        ----------
+        timeout : Optional[float]
+            The maximum time to wait in seconds. Wait without limit if None.
+
+        Returns
+        -------
+        result : Any
+            The result of the invocation. The error raised by the invocation, if any, is
+            raised again here.
+        """
+        if not self.wait(timeout):
+            raise TimeoutError("The invocation did not complete in time")
+        return tvm.get_global_func("vm.builtin.invoke_future_get")(self)
+
+
+@tvm._ffi.register_object("relax.vm.RequestBatcher")
+class RequestBatcher(Object):
+    """Dynamic batching of the requests to a function of a Relax VM.
+
+    The requests are queued, and a worker thread runs them in batches. A batch is run once the
+    queued requests fill the largest batch bucket, or the oldest request has waited for
+    `max_latency_us`. The batched inputs of the requests are concatenated along their batch
+    axis and padded to the smallest bucket that fits by repeating the last sample. The outputs
+    are split back along their batch axis. Only requests whose inputs agree on all the other
+    dimensions are batched together.
+
+    The VM must not be used by other threads while the batcher is alive.
+
+    Parameters
+    ----------
+    vm : VirtualMachine
+        The VM.
+    func_name : str
+        The name of the function, which must accept every batch size in `batch_buckets`.
+    batch_buckets : List[int]
+        The batch sizes the function is compiled for, in increasing order.
+    input_batch_axes : List[int]
+        The batch axis of each input, or -1 for the inputs shared by all the requests. Only the
+        requests passing the same arrays as the shared inputs are batched together, so the
+        shared inputs should be passed as the same `tvm.runtime.NDArray` by every request.
+    output_batch_axes : Optional[List[int]]
+        The batch axis of each output, or -1 for the outputs returned to every request as is.
+        Defaults to 0 for a function returning a single tensor.
+    max_latency_us : int
+        The maximum time a request waits for the batch to fill, in microseconds.
+    """
+
+    def __init__(
+        self,
+        vm: "VirtualMachine",
+        func_name: str,
+        batch_buckets: List[int],
+        input_batch_axes: List[int],
+        output_batch_axes: Optional[List[int]] = None,
+        max_latency_us: int = 1000,
+    ) -> None:
+        if output_batch_axes is None:
+            output_batch_axes = [0]
+        self.__init_handle_by_constructor__(
+            tvm.get_global_func("vm.builtin.request_batcher_create"),
+            vm.module,
+            func_name,
+            tvm.runtime.ShapeTuple(batch_buckets),
+            tvm.runtime.ShapeTuple(input_batch_axes),
+            tvm.runtime.ShapeTuple(output_batch_axes),
+            max_latency_us,
+        )
+
+    def submit(self, *args: Any) -> InvokeFuture:
+        """Queue a request.
+
+        Parameters
+        ----------
+        args : List[Union[tvm.runtime.NDArray, np.ndarray]]
+            The inputs of the request.
+
+        Returns
+        -------
+        future : InvokeFuture
+            The future of the outputs of the request. Its result is a tensor, or a tuple of
+            tensors if the function returns a tuple.
+        """
+        cargs = [tvm.nd.array(arg) if isinstance(arg, np.ndarray) else arg for arg in args]
+        return tvm.get_global_func("vm.builtin.request_batcher_submit")(self, *cargs)
+
+
 class VirtualMachine(object):
     """Relax VM runtime."""
 
@@ -307,6 +423,123 @@ class VirtualMachine(object):
         """
         self._invoke_stateful(func_name)
 
+    def enable_async(self, max_in_flight: int = 4) -> None:
+        """Configure the executor of :py:meth:`invoke_async`.
+
+        The invocations that were already queued are completed first.
+
+        Parameters
+        ----------
+        max_in_flight : int
+            The maximum number of invocations that are queued or not completed.
+            `invoke_async` blocks when the bound is reached. It is also the number of
+            invocations that can be launched on the device before waiting for the first one.
+        """
+        self.module["init_async"](max_in_flight)
+
+    def invoke_async(self, func_name: str, *args: Any) -> InvokeFuture:
+        """Queue an invocation of a function and return without waiting for it.
+
+        The invocations are run in order by a worker thread owned by the VM, so that the
+        caller can prepare the next invocation while the current one runs. Successive
+        invocations are pipelined on the device. The NDArray arguments must not be modified
+        until the invocation has completed. Synchronous calls to the VM must not be made while
+        asynchronous invocations are pending.
+
+        Parameters
+        ----------
+        func_name : str
+            The name of the function.
+        args : List[Any]
+            The arguments to the function.
+
+        Returns
+        -------
+        future : InvokeFuture
+            The future of the result.
+        """
+        cargs: List[Any] = []
+        for arg in args:
+            self._convert(arg, cargs)
+        return self.module["invoke_async"](func_name, *cargs)
+
+    def bind_input(self, func_name: str, index: int, tensor: Any) -> None:
+        """Bind a caller-owned buffer to an input of a function.
+
+        Unlike `set_input`, the buffer is not copied when it is bound. It is read by each
+        `invoke_stateful` call, so the caller can update its content in place between calls.
+        The buffer is passed to the function directly if it is on the device of the VM and
+        aligned; otherwise it is copied before each call into a staging buffer that is
+        allocated once at binding time. This also holds for numpy arrays and DLPack tensors
+        that are not aligned. The caller must keep the buffer alive while it is bound.
+        All the inputs of the function must be bound or set before it is invoked.
+
+        Parameters
+        ----------
+        func_name : str
+            The name of the function.
+        index : int
+            The index of the input.
+        tensor : Union[tvm.runtime.NDArray, np.ndarray, Any]
+            The buffer. It can be an NDArray, a C-contiguous numpy array, or any tensor
+            supporting the DLPack protocol.
+        """
+        if isinstance(tensor, np.ndarray):
+            if not tensor.flags["C_CONTIGUOUS"]:
+                raise ValueError("A bound numpy array must be C-contiguous")
+            self.module["bind_input"](
+                func_name,
+                index,
+                ctypes.c_void_p(tensor.ctypes.data),
+                tvm.runtime.ShapeTuple(tensor.shape),
+                str(tensor.dtype),
+                tvm.cpu(0),
+            )
+        elif isinstance(tensor, tvm.runtime.NDArray):
+            self.module["bind_input"](func_name, index, tensor)
+        else:
+            # View the DLTensor of the capsule instead of converting it with `from_dlpack`,
+            # which requires the data to be aligned. The capsule is not consumed, and the
+            # caller keeps the data alive while it is bound.
+            capsule = tensor.__dlpack__() if hasattr(tensor, "__dlpack__") else tensor
+            ctypes.pythonapi.PyCapsule_GetPointer.restype = ctypes.c_void_p
+            ptr = ctypes.pythonapi.PyCapsule_GetPointer(ctypes.py_object(capsule), b"dltensor")
+            view = tvm.runtime.ndarray._make_array(  # pylint: disable=protected-access
+                ptr, True, False
+            )
+            self.module["bind_input"](func_name, index, view)
+
+    def bind_output_copy(self, func_name: str, index: int, tensor: tvm.runtime.NDArray) -> None:
+        """Bind a caller-owned buffer that an output of a function is copied to.
+
+        After each `invoke_stateful` call, the output is copied into the buffer. The output is
+        still allocated by the function, so unlike `bind_input` this is not zero-copy; it only
+        saves the separate copy call. The results remain available through `get_outputs`.
+
+        Parameters
+        ----------
+        func_name : str
+            The name of the function.
+        index : int
+            The index of the output in the returned tuple, or 0 if the function returns a
+            single tensor.
+        tensor : tvm.runtime.NDArray
+            The buffer to copy the output into.
+        """
+        if not isinstance(tensor, tvm.runtime.NDArray):
+            tensor = tvm.nd.from_dlpack(tensor)
+        self.module["bind_output_copy"](func_name, index, tensor)
+
+    def clear_bindings(self, func_name: str) -> None:
+        """Remove the buffers bound to the inputs and outputs of a function.
+
+        Parameters
+        ----------
+        func_name : str
+            The name of the function.
+        """
+        self.module["clear_bindings"](func_name)
+
     def get_outputs(self, func_name: str) -> Union[tvm.Object, Tuple[Any]]:
         """
         Get the value output by the function by the given name
@@ -510,3 +743,75 @@ class VirtualMachine(object):
 
         report_json = self.module["profile"](func_name, *cargs)
         return Report.from_json(report_json)
+
+    def enable_sampling_profiler(
+        self,
+        sample_interval: int = 100,
+        sample_invocations: bool = False,
+        trace_capacity: int = 4096,
+    ) -> None:
+        """Enable the low-overhead sampling profiler.
+
+        Unlike :py:meth:`profile`, which times every call of one invocation, the sampling
+        profiler only times one in every `sample_interval` calls, and is cheap enough to stay
+        enabled while serving. The latencies are accumulated into per-function histograms, and
+        the most recent sampled calls are kept in a per-thread ring buffer of trace events.
+
+        Enabling the profiler again discards the previously collected measurements.
+
+        Parameters
+        ----------
+        sample_interval : int
+            Sample one in every `sample_interval` calls, or invocations if `sample_invocations`
+            is set.
+
+        sample_invocations : bool
+            Whether to sample whole invocations of the VM functions. When set, every call in a
+            sampled invocation is timed, along with the invocation itself.
+
+        trace_capacity : int
+            The number of trace events kept per thread.
+        """
+        self.module["enable_sampling_profiler"](sample_interval, sample_invocations, trace_capacity)
+
+    def disable_sampling_profiler(self) -> None:
+        """Disable the sampling profiler and discard its measurements."""
+        self.module["disable_sampling_profiler"]()
+
+    def sampling_profiler_snapshot(self, reset: bool = False) -> Dict[str, Any]:
+        """Get the statistics collected by the sampling profiler.
+
+        Parameters
+        ----------
+        reset : bool
+            Whether to clear the statistics after reading them.
+
+        Returns
+        -------
+        snapshot : Dict[str, Any]
+            The statistics of each sampled function under the key "functions", including the
+            sample count, the mean, p50, p90, p99 and max latencies in microseconds, and the
+            non-empty histogram buckets as `[lower_ns, upper_ns, count]`.
+        """
+        return json.loads(self.module["sampling_profiler_snapshot"](reset))
+
+    def export_chrome_trace(self, path: Optional[str] = None) -> str:
+        """Export the recent calls sampled by the sampling profiler as a Chrome trace.
+
+        The trace can be loaded by chrome://tracing or Perfetto.
+
+        Parameters
+        ----------
+        path : Optional[str]
+            If given, the file to write the trace to.
+
+        Returns
+        -------
+        trace : str
+            The trace in JSON.
+        """
+        trace = self.module["sampling_profiler_export_chrome_trace"]()
+        if path is not None:
+            with open(path, "w", encoding="utf-8") as f:
+                f.write(trace)
+        return trace
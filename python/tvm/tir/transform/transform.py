@@ -1174,3 +1174,19 @@ def DefaultGPUSchedule():
     ret: tvm.transform.Pass
     """
     return _ffi_api.DefaultGPUSchedule()  # type: ignore
+
+
+def HorizontalFuseKernels():
+    """Merge the independent kernels of a horizontally fused PrimFunc into a single kernel.
+
+    Only applies to PrimFuncs with the ``tir.horizontal_fusion`` attribute, whose body launches
+    exactly that many kernels, each over one blockIdx.x and one threadIdx.x dimension. The merged
+    kernel launches the sum of the blocks of the kernels and the maximum of their threads, and
+    branches on the block index to the kernel that owns the block.
+
+    Returns
+    -------
+    fpass : tvm.transform.Pass
+        The result pass
+    """
+    return _ffi_api.HorizontalFuseKernels()  # type: ignore
@@ -576,6 +576,9 @@ transform::Sequential MixedModulePassManager(IRModule mixed_mod, Target target)
 
   mixed_pass_list.push_back(tir::transform::AnnotateEntryFunc());
 
+  // Merge horizontally fused kernels before the thread synchronizations are inserted.
+  mixed_pass_list.push_back(tir::transform::HorizontalFuseKernels());
+
   bool detect_global_barrier =
       pass_ctx->GetConfig<Bool>("tir.detect_global_barrier", Bool(false)).value();
   if (detect_global_barrier) {
@@ -31,6 +31,8 @@
 #include <tvm/target/codegen.h>
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 
 #include "../support/base64.h"
@@ -387,6 +389,82 @@ TVM_REGISTER_REFLECTION_VTABLE(runtime::ModuleNode, ModuleNodeTrait)
       return codegen::SerializeModuleToBytes(GetRef<runtime::Module>(rtmod), /*export_dso*/ false);
     });
 
+/*!
+ * \brief Process-wide memo of NDArray content hashes, active inside NDArrayHashCacheScope.
+ */
+class NDArrayHashCache {
+ public:
+  static NDArrayHashCache* Global() {
+    static NDArrayHashCache* inst = new NDArrayHashCache();
+    return inst;
+  }
+
+  void Enter() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++num_scopes_;
+  }
+
+  void Exit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ICHECK_GT(num_scopes_.load(), 0) << "NDArrayHashCacheScope exited more times than entered";
+    if (--num_scopes_ == 0) {
+      memo_.clear();
+    }
+  }
+
+  /*!
+   * \brief Get the hash of the raw data of the array, computing it at most once per scope.
+   * \param arr The array to be hashed.
+   * \return The hash of the array data.
+   */
+  uint64_t HashData(const runtime::NDArray::Container* arr) {
+    size_t nbytes = runtime::GetDataSize(arr->dl_tensor);
+    // Small arrays are cheaper to rehash than to look up under the lock.
+    if (nbytes < kMinCachedBytes || num_scopes_.load(std::memory_order_relaxed) == 0) {
+      return HashBytes(arr, nbytes);
+    }
+    runtime::NDArray key = GetRef<runtime::NDArray>(arr);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = memo_.find(key);
+      if (it != memo_.end()) return it->second;
+    }
+    // Hash outside of the lock so that concurrent hashing of distinct arrays does not serialize.
+    uint64_t value = HashBytes(arr, nbytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (num_scopes_.load() != 0) {
+      memo_.emplace(std::move(key), value);
+    }
+    return value;
+  }
+
+ private:
+  static uint64_t HashBytes(const runtime::NDArray::Container* arr, size_t nbytes) {
+    return runtime::String::StableHashBytes(static_cast<const char*>(arr->dl_tensor.data),
+                                            nbytes);
+  }
+
+  /*! \brief Arrays smaller than this are always rehashed. */
+  static constexpr size_t kMinCachedBytes = 4096;
+  /*! \brief Number of live NDArrayHashCacheScope. */
+  std::atomic<int> num_scopes_{0};
+  /*! \brief The memoized hashes, keyed by array identity. */
+  std::unordered_map<runtime::NDArray, uint64_t, ObjectPtrHash, ObjectPtrEqual> memo_;
+  std::mutex mutex_;
+};
+
+NDArrayHashCacheScope::NDArrayHashCacheScope() { NDArrayHashCache::Global()->Enter(); }
+
+NDArrayHashCacheScope::~NDArrayHashCacheScope() { NDArrayHashCache::Global()->Exit(); }
+
+TVM_REGISTER_GLOBAL("node.NDArrayHashCacheEnter").set_body_typed([]() {
+  NDArrayHashCache::Global()->Enter();
+});
+
+TVM_REGISTER_GLOBAL("node.NDArrayHashCacheExit").set_body_typed([]() {
+  NDArrayHashCache::Global()->Exit();
+});
+
 void NDArrayHash(const runtime::NDArray::Container* arr, SHashReducer* hash_reduce,
                  bool hash_data) {
   ICHECK_EQ(arr->dl_tensor.device.device_type, kDLCPU) << "can only compare CPU tensor";
@@ -397,9 +475,7 @@ void NDArrayHash(const runtime::NDArray::Container* arr, SHashReducer* hash_redu
     (*hash_reduce)(arr->dl_tensor.shape[i]);
   }
   if (hash_data) {
-    (*hash_reduce)
-        ->SHashReduceHashedValue(runtime::String::StableHashBytes(
-            static_cast<const char*>(arr->dl_tensor.data), runtime::GetDataSize(arr->dl_tensor)));
+    (*hash_reduce)->SHashReduceHashedValue(NDArrayHashCache::Global()->HashData(arr));
   }
 }
 
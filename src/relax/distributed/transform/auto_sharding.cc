@@ -0,0 +1,562 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/relax/distributed/transform/auto_sharding.cc
+ * \brief Pass for choosing the sharding of the tensors which are not annotated.
+ *
+ * A sharding spec of a tensor axis propagates to the whole axis group of the axis, so a sharding
+ * plan assigns each axis group to a device mesh axis, or replicates it. The plan is scored by a
+ * cost model of the step time and of the memory per device:
+ *
+ * - An operator is computed in parallel over the mesh axes its output axis groups and its reduced
+ *   axis groups are sharded on.
+ * - Reducing over a sharded axis group, e.g. the reduction axis of a matmul, needs an allreduce of
+ *   the output.
+ * - Sharding the inputs of the function (the parameters before `num_input`) needs a scatter, and
+ *   sharding its outputs needs a gather.
+ * - A tensor takes its size divided by the number of its shards on each device.
+ *
+ * The plan minimizing the step time with the memory per device under the cap is searched greedily,
+ * one axis group at a time. The parameters are then annotated with their placements, and
+ * PropagateSharding propagates them and inserts the redistributions.
+ */
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/attrs/distributed.h>
+#include <tvm/relax/distributed/axis_group_graph.h>
+#include <tvm/relax/distributed/transform.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/tir/analysis.h>
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../../op/distributed/distributed.h"
+#include "../../op/op_common.h"
+#include "utils.h"
+
+namespace tvm {
+namespace relax {
+namespace distributed {
+
+double EstimateCallFlops(const Call& call, const IRModule& mod) {
+  static const Op& matmul_op = Op::Get("relax.matmul");
+  static const Op& call_tir_op = Op::Get("relax.call_tir");
+  double num_elements = 0;
+  if (const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(call)) {
+    if (const auto* shape = sinfo->shape.as<ShapeExprNode>()) {
+      num_elements = 1;
+      for (const PrimExpr& dim : shape->values) {
+        const auto* int_dim = dim.as<IntImmNode>();
+        num_elements *= int_dim ? int_dim->value : 0;
+      }
+    }
+  }
+  if (call->op.same_as(matmul_op)) {
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(call->args[0]);
+    const auto* shape = sinfo ? sinfo->shape.as<ShapeExprNode>() : nullptr;
+    if (shape && !shape->values.empty()) {
+      if (const auto* k = shape->values.back().as<IntImmNode>()) {
+        return 2 * num_elements * k->value;
+      }
+    }
+  } else if (call->op.same_as(call_tir_op)) {
+    Optional<BaseFunc> func = mod->functions.Get(Downcast<GlobalVar>(call->args[0]));
+    if (const auto* prim_func = func.as<tir::PrimFuncNode>()) {
+      return tir::EstimateTIRFlops(prim_func->body);
+    }
+  }
+  return num_elements;
+}
+
+/*!
+ * \brief Search the sharding plan of the axis groups of a function.
+ */
+class ShardingPlanner {
+ public:
+  /*!
+   * \brief Plan the sharding of a function.
+   * \return The placements of the tensor parameters which are not annotated.
+   */
+  static Map<Var, Placement> Plan(const Function& func, const IRModule& mod,
+                                  const DeviceMesh& device_mesh, int64_t memory_cap,
+                                  double flops_per_byte) {
+    ShardingPlanner planner(mod, device_mesh, flops_per_byte);
+    planner.CollectTensors(func);
+    planner.CollectAxisGroups(func, mod);
+    planner.Search(memory_cap);
+    return planner.GetParamPlacements(func);
+  }
+
+ private:
+  struct TensorInfo {
+    const ExprNode* expr;
+    /*! \brief The static shape, empty if the shape is not static. */
+    std::vector<int64_t> shape;
+    /*! \brief The number of elements and the size in bytes, 0 if the shape is not static. */
+    double num_elements{0};
+    double bytes{0};
+    bool is_constant{false};
+    /*! \brief Whether it is an input or an output of the function, communicated with the host. */
+    bool is_io{false};
+    /*! \brief The axis groups of the axes. */
+    std::vector<int> groups;
+  };
+
+  struct OpInfo {
+    int output;
+    std::vector<int> inputs;
+    double flops;
+    /*! \brief Whether the op can reduce over a sharded axis, followed by an allreduce. */
+    bool allows_sharded_reduction;
+    /*! \brief The axis groups of the output, and the axis groups reduced by the op. */
+    std::vector<int> output_groups;
+    std::vector<int> reduced_groups;
+  };
+
+  struct AxisGroupInfo {
+    std::vector<Axis> axes;
+    /*! \brief Whether the group can be sharded on each mesh axis. */
+    std::vector<bool> shardable;
+    /*! \brief The mesh axis the group is annotated on, -2 if it is not annotated. */
+    int annotated{-2};
+  };
+
+  /*! \brief The memory per device in bytes, and the step time in flops. */
+  using Cost = std::pair<double, double>;
+
+  ShardingPlanner(const IRModule& mod, const DeviceMesh& device_mesh, double flops_per_byte)
+      : mod_(mod), device_mesh_(device_mesh), flops_per_byte_(flops_per_byte) {}
+
+  int AddTensor(const Expr& expr) {
+    auto it = tensor_index_.find(expr.get());
+    if (it != tensor_index_.end()) {
+      return it->second;
+    }
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(expr);
+    if (sinfo == nullptr) {
+      return -1;
+    }
+    TensorInfo tensor;
+    tensor.expr = expr.get();
+    tensor.is_constant = expr->IsInstance<ConstantNode>();
+    if (const auto* shape = sinfo->shape.as<ShapeExprNode>()) {
+      double num_elements = 1;
+      for (const PrimExpr& dim : shape->values) {
+        const auto* int_dim = dim.as<IntImmNode>();
+        if (int_dim == nullptr) {
+          tensor.shape.clear();
+          num_elements = 0;
+          break;
+        }
+        tensor.shape.push_back(int_dim->value);
+        num_elements *= int_dim->value;
+      }
+      tensor.num_elements = num_elements;
+      tensor.bytes = num_elements * ((sinfo->dtype.bits() * sinfo->dtype.lanes() + 7) / 8);
+    }
+    tensor_index_[expr.get()] = tensors_.size();
+    tensors_.push_back(std::move(tensor));
+    return tensors_.size() - 1;
+  }
+
+  void CollectTensors(const Function& func) {
+    static const Op& annotate_sharding_op = Op::Get("relax.dist.annotate_sharding");
+    static const Op& matmul_op = Op::Get("relax.matmul");
+    static const Op& sum_op = Op::Get("relax.sum");
+    size_t num_input = func->params.size();
+    if (auto opt_num_input = func->GetAttr<Integer>(attr::kNumInput)) {
+      num_input = opt_num_input.value()->value;
+    } else {
+      // Without `num_input`, all the parameters are weights resident on the devices.
+      num_input = 0;
+    }
+    for (size_t i = 0; i < func->params.size(); ++i) {
+      param_set_.insert(func->params[i].get());
+      int index = AddTensor(func->params[i]);
+      if (index >= 0) {
+        tensors_[index].is_io = i < num_input;
+      }
+    }
+
+    const auto* seq = func->body.as<SeqExprNode>();
+    ICHECK(seq) << "The body of the function must be SeqExpr";
+    for (const BindingBlock& block : seq->blocks) {
+      for (const Binding& binding : block->bindings) {
+        const auto* var_binding = binding.as<VarBindingNode>();
+        if (var_binding == nullptr) {
+          continue;
+        }
+        int output = AddTensor(var_binding->var);
+        const auto* call = var_binding->value.as<CallNode>();
+        if (output < 0 || call == nullptr) {
+          continue;
+        }
+        Call call_ref = GetRef<Call>(call);
+        if (call->op.same_as(annotate_sharding_op)) {
+          const auto* attrs = call->attrs.as<DistributionAttrs>();
+          for (int j = 0; j < static_cast<int>(attrs->placement->dim_specs.size()); j++) {
+            const PlacementSpec& spec = attrs->placement->dim_specs[j];
+            if (spec->kind == PlacementSpecKind::kSharding) {
+              annotated_axes_.emplace(Axis(var_binding->var.get(), spec->axis), j);
+            }
+          }
+          if (const auto* input = call->args[0].as<VarNode>()) {
+            annotated_vars_.insert(input);
+          }
+        }
+        OpInfo op;
+        op.output = output;
+        for (const Expr& arg : GetCallArgs(call_ref)) {
+          int input = AddTensor(arg);
+          if (input >= 0) {
+            op.inputs.push_back(input);
+          }
+        }
+        op.flops = EstimateCallFlops(call_ref, mod_);
+        op.allows_sharded_reduction = call->op.same_as(matmul_op) || call->op.same_as(sum_op);
+        ops_.push_back(std::move(op));
+      }
+    }
+
+    std::function<void(const Expr&)> mark_output = [&](const Expr& expr) {
+      if (const auto* tuple = expr.as<TupleNode>()) {
+        for (const Expr& field : tuple->fields) mark_output(field);
+      } else if (tensor_index_.count(expr.get())) {
+        tensors_[tensor_index_[expr.get()]].is_io = true;
+      }
+    };
+    mark_output(seq->body);
+  }
+
+  void CollectAxisGroups(const Function& func, const IRModule& mod) {
+    AxisGroupGraph axis_group_graph;
+    BuildAxisGroupGraph(&axis_group_graph, func, mod);
+    // Order the groups by their first axis, to make the search deterministic.
+    std::vector<std::vector<Axis>> groups;
+    for (const AxisGroup& group : axis_group_graph.GetAxisGroups()) {
+      std::vector<Axis> axes;
+      for (const Axis& axis : group) {
+        if (tensor_index_.count(axis.tensor)) {
+          axes.push_back(axis);
+        }
+      }
+      auto axis_less = [&](const Axis& lhs, const Axis& rhs) {
+        return std::make_pair(tensor_index_.at(lhs.tensor), lhs.dim) <
+               std::make_pair(tensor_index_.at(rhs.tensor), rhs.dim);
+      };
+      std::sort(axes.begin(), axes.end(), axis_less);
+      if (!axes.empty()) {
+        groups.push_back(std::move(axes));
+      }
+    }
+    std::sort(groups.begin(), groups.end(), [&](const auto& lhs, const auto& rhs) {
+      return std::make_pair(tensor_index_.at(lhs[0].tensor), lhs[0].dim) <
+             std::make_pair(tensor_index_.at(rhs[0].tensor), rhs[0].dim);
+    });
+
+    int num_mesh_axes = device_mesh_->shape.size();
+    for (auto& axes : groups) {
+      AxisGroupInfo group;
+      group.shardable.assign(num_mesh_axes, true);
+      std::unordered_set<int> tensors;
+      bool has_param = false;
+      for (const Axis& axis : axes) {
+        int index = tensor_index_.at(axis.tensor);
+        const TensorInfo& tensor = tensors_[index];
+        axis_group_[axis] = groups_.size();
+        tensors_[index].groups.push_back(groups_.size());
+        has_param |= param_set_.count(tensor.expr) > 0;
+        auto it = annotated_axes_.find(axis);
+        if (it != annotated_axes_.end() && group.annotated == -2) {
+          group.annotated = it->second;
+        }
+        // A constant cannot be sharded, and two axes of a tensor cannot be sharded on the same
+        // mesh axis.
+        bool shardable =
+            !tensor.is_constant && !tensor.shape.empty() && tensors.insert(index).second;
+        for (int i = 0; i < num_mesh_axes; ++i) {
+          group.shardable[i] = group.shardable[i] && shardable &&
+                               tensor.shape[axis.dim] % device_mesh_->shape[i] == 0;
+        }
+      }
+      if (!has_param) {
+        // Only the parameters are annotated, which the group would be sharded from.
+        group.shardable.assign(num_mesh_axes, false);
+      }
+      group.axes = std::move(axes);
+      groups_.push_back(std::move(group));
+    }
+
+    for (OpInfo& op : ops_) {
+      std::unordered_set<int> output_groups(tensors_[op.output].groups.begin(),
+                                            tensors_[op.output].groups.end());
+      std::unordered_set<int> reduced_groups;
+      for (int input : op.inputs) {
+        for (int group : tensors_[input].groups) {
+          if (!output_groups.count(group) && reduced_groups.insert(group).second) {
+            op.reduced_groups.push_back(group);
+            if (!op.allows_sharded_reduction) {
+              groups_[group].shardable.assign(num_mesh_axes, false);
+            }
+          }
+        }
+      }
+      op.output_groups.assign(output_groups.begin(), output_groups.end());
+    }
+  }
+
+  /*! \brief The number of devices the groups are sharded on. */
+  double NumShards(const std::vector<int>& groups) const {
+    double num_shards = 1;
+    std::vector<bool> mesh_axes(device_mesh_->shape.size(), false);
+    for (int group : groups) {
+      int mesh_axis = assignment_[group];
+      if (mesh_axis >= 0 && !mesh_axes[mesh_axis]) {
+        mesh_axes[mesh_axis] = true;
+        num_shards *= device_mesh_->shape[mesh_axis];
+      }
+    }
+    return num_shards;
+  }
+
+  Cost Evaluate() const {
+    double memory = 0;
+    double time = 0;
+    for (const TensorInfo& tensor : tensors_) {
+      double num_shards = NumShards(tensor.groups);
+      memory += tensor.bytes / num_shards;
+      if (tensor.is_io) {
+        time += tensor.bytes * (1 - 1 / num_shards) * flops_per_byte_;
+      }
+    }
+    for (const OpInfo& op : ops_) {
+      std::vector<int> groups = op.output_groups;
+      groups.insert(groups.end(), op.reduced_groups.begin(), op.reduced_groups.end());
+      time += op.flops / NumShards(groups);
+      // Each partial result is allreduced across the devices of the reduced mesh axes.
+      double num_partials = NumShards(op.reduced_groups);
+      if (num_partials > 1) {
+        double output_bytes = tensors_[op.output].bytes / NumShards(op.output_groups);
+        time += 2 * (num_partials - 1) / num_partials * output_bytes * flops_per_byte_;
+      }
+    }
+    return {memory, time};
+  }
+
+  /*! \brief Whether a group can be sharded on a mesh axis, given the other groups. */
+  bool IsValid(int group, int mesh_axis) const {
+    if (mesh_axis < 0) {
+      return true;
+    }
+    if (!groups_[group].shardable[mesh_axis]) {
+      return false;
+    }
+    for (const Axis& axis : groups_[group].axes) {
+      for (int other : tensors_[tensor_index_.at(axis.tensor)].groups) {
+        if (other != group && assignment_[other] == mesh_axis) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool IsBetter(const Cost& lhs, const Cost& rhs, int64_t memory_cap) const {
+    double lhs_excess = std::max(lhs.first - memory_cap, 0.0);
+    double rhs_excess = std::max(rhs.first - memory_cap, 0.0);
+    if (lhs_excess != rhs_excess) {
+      return lhs_excess < rhs_excess;
+    }
+    return lhs.second < rhs.second * (1 - 1e-9);
+  }
+
+  void Search(int64_t memory_cap) {
+    assignment_.assign(groups_.size(), -1);
+    for (size_t i = 0; i < groups_.size(); ++i) {
+      if (groups_[i].annotated >= 0) {
+        assignment_[i] = groups_[i].annotated;
+      }
+    }
+    Cost cost = Evaluate();
+    int num_mesh_axes = device_mesh_->shape.size();
+    while (true) {
+      int best_group = -1;
+      int best_mesh_axis = -1;
+      Cost best_cost = cost;
+      for (size_t i = 0; i < groups_.size(); ++i) {
+        if (groups_[i].annotated != -2) {
+          continue;
+        }
+        int current = assignment_[i];
+        for (int mesh_axis = -1; mesh_axis < num_mesh_axes; ++mesh_axis) {
+          if (mesh_axis == current || !IsValid(i, mesh_axis)) {
+            continue;
+          }
+          assignment_[i] = mesh_axis;
+          Cost new_cost = Evaluate();
+          if (IsBetter(new_cost, best_cost, memory_cap)) {
+            best_group = i;
+            best_mesh_axis = mesh_axis;
+            best_cost = new_cost;
+          }
+        }
+        assignment_[i] = current;
+      }
+      if (best_group < 0) {
+        break;
+      }
+      assignment_[best_group] = best_mesh_axis;
+      cost = best_cost;
+    }
+    if (cost.first > memory_cap) {
+      LOG(WARNING) << "No sharding plan fits the memory cap of " << memory_cap
+                   << " bytes per device. The chosen plan takes " << cost.first << " bytes";
+    }
+  }
+
+  Map<Var, Placement> GetParamPlacements(const Function& func) const {
+    Map<Var, Placement> placements;
+    for (const Var& param : func->params) {
+      auto it = tensor_index_.find(param.get());
+      if (it == tensor_index_.end() || annotated_vars_.count(param.get())) {
+        continue;
+      }
+      Array<PlacementSpec> specs(
+          std::vector<PlacementSpec>(device_mesh_->shape.size(), PlacementSpec::Replica()));
+      for (int i = 0; i < static_cast<int>(tensors_[it->second].shape.size()); ++i) {
+        auto group = axis_group_.find(Axis(param.get(), i));
+        if (group != axis_group_.end() && assignment_[group->second] >= 0) {
+          specs.Set(assignment_[group->second], PlacementSpec::Sharding(i));
+        }
+      }
+      placements.Set(param, Placement(specs));
+    }
+    return placements;
+  }
+
+  IRModule mod_;
+  DeviceMesh device_mesh_;
+  double flops_per_byte_;
+  std::vector<TensorInfo> tensors_;
+  std::unordered_map<const ExprNode*, int> tensor_index_;
+  std::unordered_set<const ExprNode*> param_set_;
+  std::vector<OpInfo> ops_;
+  std::vector<AxisGroupInfo> groups_;
+  std::unordered_map<Axis, int, AxisHash> axis_group_;
+  /*! \brief The axes annotated by annotate_sharding, and their mesh axes. */
+  std::unordered_map<Axis, int, AxisHash> annotated_axes_;
+  /*! \brief The vars annotated by annotate_sharding. */
+  std::unordered_set<const VarNode*> annotated_vars_;
+  /*! \brief The mesh axis of each group, -1 for replication. */
+  std::vector<int> assignment_;
+};
+
+/*!
+ * \brief Annotate the parameters of the functions with the placements of their sharding plans.
+ */
+class ShardingPlanAnnotator : public ExprMutator {
+ public:
+  ShardingPlanAnnotator(const IRModule& mod, DeviceMesh device_mesh, int64_t memory_cap,
+                        double flops_per_byte)
+      : ExprMutator(mod),
+        device_mesh_(device_mesh),
+        memory_cap_(memory_cap),
+        flops_per_byte_(flops_per_byte) {}
+
+  IRModule Annotate() {
+    IRModule mod = builder_->GetContextIRModule();
+    for (const auto& [gv, base_func] : mod->functions) {
+      const auto* func = base_func.as<FunctionNode>();
+      if (func == nullptr || !func->body->IsInstance<SeqExprNode>()) {
+        continue;
+      }
+      placements_ = ShardingPlanner::Plan(GetRef<Function>(func), mod, device_mesh_, memory_cap_,
+                                          flops_per_byte_);
+      if (placements_.empty()) {
+        continue;
+      }
+      annotated_ = false;
+      builder_->UpdateFunction(gv, Downcast<Function>(VisitExpr(GetRef<Function>(func))));
+    }
+    return builder_->GetContextIRModule();
+  }
+
+ private:
+  using ExprMutator::VisitBindingBlock_;
+
+  void EmitAnnotations(bool is_dataflow) {
+    if (annotated_) {
+      return;
+    }
+    annotated_ = true;
+    for (const auto& [param, placement] : placements_) {
+      // The parameters may be used after the dataflow block, so the annotations are its outputs.
+      Expr annotation = annotate_sharding(param, device_mesh_, placement);
+      String name = param->name_hint() + "_annot";
+      var_remap_[param->vid] =
+          is_dataflow ? builder_->EmitOutput(annotation, name) : builder_->Emit(annotation, name);
+    }
+  }
+
+  BindingBlock VisitBindingBlock_(const BindingBlockNode* block) final {
+    builder_->BeginBindingBlock();
+    EmitAnnotations(false);
+    for (const Binding& binding : block->bindings) {
+      VisitBinding(binding);
+    }
+    return builder_->EndBlock();
+  }
+
+  BindingBlock VisitBindingBlock_(const DataflowBlockNode* block) final {
+    builder_->BeginDataflowBlock();
+    EmitAnnotations(true);
+    for (const Binding& binding : block->bindings) {
+      VisitBinding(binding);
+    }
+    return builder_->EndBlock();
+  }
+
+  DeviceMesh device_mesh_;
+  int64_t memory_cap_;
+  double flops_per_byte_;
+  Map<Var, Placement> placements_;
+  bool annotated_{false};
+};
+
+namespace transform {
+
+Pass AutoSharding(DeviceMesh device_mesh, int64_t memory_cap, double flops_per_byte) {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule m, PassContext pc) {
+        return ShardingPlanAnnotator(m, device_mesh, memory_cap, flops_per_byte).Annotate();
+      };
+  Pass annotate = CreateModulePass(pass_func, 0, "AnnotateShardingPlan", {});
+  return tvm::transform::Sequential({annotate, PropagateSharding()}, "AutoSharding");
+}
+TVM_REGISTER_GLOBAL("relax.distributed.transform.AutoSharding").set_body_typed(AutoSharding);
+}  // namespace transform
+
+}  // namespace distributed
+}  // namespace relax
+}  // namespace tvm
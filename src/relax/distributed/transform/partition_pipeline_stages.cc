@@ -0,0 +1,356 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/relax/distributed/transform/partition_pipeline_stages.cc
+ * \brief Pass for partitioning a function into pipeline stages.
+ *
+ * The bindings of the function are split into consecutive stages minimizing the estimated cost of
+ * the most expensive stage. The stage `i` becomes the function `{func}_stage{i}`, whose parameters
+ * are the activations live into the stage, followed by the weights used by the stage. Every stage
+ * but the last returns a tuple of the activations live out of it, in the same order as the
+ * activation parameters of the next stage, which the pipeline runtime of Disco relies on. The
+ * inputs of the function are activations of the first stage, and are forwarded to the stages that
+ * use them. Since the pipeline runtime only sends tensors between stages, the bindings are never
+ * split where a value of another type (e.g. a tuple) is live.
+ */
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/distributed/struct_info.h>
+#include <tvm/relax/distributed/transform.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/utils.h>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "utils.h"
+
+namespace tvm {
+namespace relax {
+namespace distributed {
+
+class PipelineStagePartitioner : public ExprMutator {
+ public:
+  static IRModule Partition(IRModule mod, const String& func_name, int num_stages) {
+    CHECK_GE(num_stages, 1)
+        << "ValueError: The number of pipeline stages must be positive, but got " << num_stages;
+    Optional<BaseFunc> base_func = mod->functions.Get(mod->GetGlobalVar(func_name));
+    const auto* func = base_func.as<FunctionNode>();
+    CHECK(func) << "ValueError: The function to partition must be a Relax function, but `"
+                << func_name << "` is " << base_func;
+    const auto* seq = func->body.as<SeqExprNode>();
+    ICHECK(seq) << "The body of the function must be SeqExpr";
+
+    PipelineStagePartitioner partitioner(mod, GetRef<Function>(func));
+    partitioner.AssignStages(num_stages);
+    partitioner.ComputeLiveness(num_stages);
+    for (int i = 0; i < num_stages; ++i) {
+      String name = func_name + "_stage" + std::to_string(i);
+      Function stage = partitioner.BuildStage(i, num_stages);
+      if (func->GetAttr<String>(tvm::attr::kGlobalSymbol)) {
+        stage = WithAttr(stage, tvm::attr::kGlobalSymbol, name);
+      }
+      partitioner.builder_->AddFunction(CopyWithNewVars(stage), name);
+    }
+    return partitioner.builder_->GetContextIRModule();
+  }
+
+ private:
+  PipelineStagePartitioner(IRModule mod, Function func)
+      : ExprMutator(mod), mod_(mod), func_(func), seq_(Downcast<SeqExpr>(func->body)) {
+    num_input_ = func->params.size();
+    if (auto opt_num_input = func->GetAttr<Integer>(attr::kNumInput)) {
+      num_input_ = opt_num_input.value()->value;
+    }
+    for (const BindingBlock& block : seq_->blocks) {
+      for (const Binding& binding : block->bindings) {
+        bindings_.push_back(binding);
+      }
+    }
+  }
+
+  /*! \brief Split the bindings into consecutive stages minimizing the maximum stage cost. */
+  void AssignStages(int num_stages) {
+    int num_bindings = bindings_.size();
+    CHECK_LE(num_stages, num_bindings)
+        << "ValueError: Cannot partition a function of " << num_bindings << " bindings into "
+        << num_stages << " pipeline stages";
+    std::vector<double> prefix_cost(num_bindings + 1, 0);
+    for (int i = 0; i < num_bindings; ++i) {
+      double cost = 0;
+      if (const auto* var_binding = bindings_[i].as<VarBindingNode>()) {
+        if (const auto* call = var_binding->value.as<CallNode>()) {
+          cost = EstimateCallFlops(GetRef<Call>(call), mod_);
+        }
+      }
+      prefix_cost[i + 1] = prefix_cost[i] + cost;
+    }
+    std::vector<bool> can_split = GetValidSplits();
+
+    // best[s][i]: the minimum maximum stage cost of splitting the first i bindings into s stages.
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<std::vector<double>> best(num_stages + 1,
+                                          std::vector<double>(num_bindings + 1, inf));
+    std::vector<std::vector<int>> split(num_stages + 1, std::vector<int>(num_bindings + 1, 0));
+    best[0][0] = 0;
+    for (int s = 1; s <= num_stages; ++s) {
+      for (int i = s; i <= num_bindings - (num_stages - s); ++i) {
+        for (int j = i - 1; j >= s - 1; --j) {
+          double stage_cost = prefix_cost[i] - prefix_cost[j];
+          if (stage_cost > best[s][i]) {
+            // The cost of the last stage only grows as it extends to the front.
+            break;
+          }
+          if (!can_split[j]) {
+            continue;
+          }
+          double cost = std::max(best[s - 1][j], stage_cost);
+          if (cost < best[s][i]) {
+            best[s][i] = cost;
+            split[s][i] = j;
+          }
+        }
+      }
+    }
+
+    CHECK(best[num_stages][num_bindings] < inf)
+        << "ValueError: Cannot partition the function into " << num_stages
+        << " pipeline stages without passing a value other than a tensor between stages";
+
+    stage_begin_.assign(num_stages + 1, num_bindings);
+    for (int s = num_stages, i = num_bindings; s > 0; --s) {
+      stage_begin_[s] = i;
+      i = split[s][i];
+    }
+    stage_begin_[0] = 0;
+    for (int s = 0; s < num_stages; ++s) {
+      for (int i = stage_begin_[s]; i < stage_begin_[s + 1]; ++i) {
+        def_stage_[bindings_[i]->var.get()] = s;
+      }
+    }
+  }
+
+  /*!
+   * \brief Whether the bindings can be split before each binding, i.e. no value other than a
+   * tensor is live across the split.
+   */
+  std::vector<bool> GetValidSplits() const {
+    int num_bindings = bindings_.size();
+    std::unordered_map<const VarNode*, int> def_index;
+    for (int64_t i = 0; i < num_input_; ++i) {
+      def_index[func_->params[i].get()] = -1;
+    }
+    for (int i = 0; i < num_bindings; ++i) {
+      def_index[bindings_[i]->var.get()] = i;
+    }
+    // The change of the number of non-tensor values live across the split before each binding.
+    std::vector<int> live_delta(num_bindings + 2, 0);
+    auto add_uses = [&](const Expr& expr, int use_index) {
+      for (const Var& var : FreeVars(expr)) {
+        auto it = def_index.find(var.get());
+        const StructInfo& sinfo = GetStructInfo(var);
+        if (it == def_index.end() || sinfo->IsInstance<TensorStructInfoNode>() ||
+            sinfo->IsInstance<DTensorStructInfoNode>()) {
+          continue;
+        }
+        // The value is live across the splits before the bindings in (def, use].
+        ++live_delta[it->second + 1];
+        --live_delta[use_index + 1];
+      }
+    };
+    for (int i = 0; i < num_bindings; ++i) {
+      if (const auto* var_binding = bindings_[i].as<VarBindingNode>()) {
+        add_uses(var_binding->value, i);
+      } else {
+        add_uses(Downcast<MatchCast>(bindings_[i])->value, i);
+      }
+    }
+    add_uses(seq_->body, num_bindings);
+
+    std::vector<bool> can_split(num_bindings + 1, true);
+    int num_live = 0;
+    for (int i = 0; i <= num_bindings; ++i) {
+      num_live += live_delta[i];
+      // The first stage always begins with the first binding.
+      can_split[i] = i == 0 || num_live == 0;
+    }
+    return can_split;
+  }
+
+  void AddUse(const Var& var, int stage) {
+    auto it = weight_index_.find(var.get());
+    if (it != weight_index_.end()) {
+      weight_used_[stage][it->second] = true;
+    } else if (def_stage_.count(var.get())) {
+      last_use_[var.get()] = std::max(last_use_[var.get()], stage);
+    }
+  }
+
+  void ComputeLiveness(int num_stages) {
+    // The inputs are defined before the first stage, while the weights are passed to each stage.
+    for (size_t i = 0; i < func_->params.size(); ++i) {
+      const Var& param = func_->params[i];
+      if (static_cast<int64_t>(i) < num_input_) {
+        // The first stage takes all the inputs, so that it has the signature of the function.
+        def_stage_[param.get()] = -1;
+        last_use_[param.get()] = 0;
+        activations_.push_back(param);
+      } else {
+        weight_index_[param.get()] = i - num_input_;
+      }
+    }
+    for (const Binding& binding : bindings_) {
+      activations_.push_back(binding->var);
+    }
+    weight_used_.assign(num_stages, std::vector<bool>(weight_index_.size(), false));
+    for (int s = 0; s < num_stages; ++s) {
+      for (int i = stage_begin_[s]; i < stage_begin_[s + 1]; ++i) {
+        Expr value;
+        if (const auto* var_binding = bindings_[i].as<VarBindingNode>()) {
+          value = var_binding->value;
+        } else {
+          value = Downcast<MatchCast>(bindings_[i])->value;
+        }
+        for (const Var& var : FreeVars(value)) {
+          AddUse(var, s);
+        }
+      }
+    }
+    for (const Var& var : FreeVars(seq_->body)) {
+      AddUse(var, num_stages - 1);
+    }
+  }
+
+  /*! \brief The activations defined before a stage and used by it or the stages after it. */
+  Array<Var> GetLiveIn(int stage) const {
+    Array<Var> live_in;
+    for (const Var& var : activations_) {
+      auto it = last_use_.find(var.get());
+      if (def_stage_.at(var.get()) < stage && it != last_use_.end() && it->second >= stage) {
+        live_in.push_back(var);
+      }
+    }
+    return live_in;
+  }
+
+  Function BuildStage(int stage, int num_stages) {
+    Array<Var> params;
+    for (const Var& var : GetLiveIn(stage)) {
+      Var param(var->name_hint(), GetStructInfo(var));
+      var_remap_[var->vid] = param;
+      params.push_back(param);
+    }
+    int num_activations = params.size();
+    for (size_t i = num_input_; i < func_->params.size(); ++i) {
+      const Var& weight = func_->params[i];
+      if (weight_used_[stage][i - num_input_]) {
+        Var param(weight->name_hint(), GetStructInfo(weight));
+        var_remap_[weight->vid] = param;
+        params.push_back(param);
+      }
+    }
+    Array<Var> live_out = stage + 1 < num_stages ? GetLiveIn(stage + 1) : Array<Var>();
+    std::unordered_set<const VarNode*> live_out_set;
+    for (const Var& var : live_out) {
+      live_out_set.insert(var.get());
+    }
+
+    // Re-emit the bindings of the stage in blocks of the same kinds as the original ones.
+    Array<BindingBlock> blocks;
+    std::unordered_map<const VarNode*, Var> outputs;
+    int index = 0;
+    for (const BindingBlock& block : seq_->blocks) {
+      int begin = std::max(index, stage_begin_[stage]);
+      int end = std::min(index + static_cast<int>(block->bindings.size()), stage_begin_[stage + 1]);
+      index += block->bindings.size();
+      if (begin >= end) {
+        continue;
+      }
+      bool is_dataflow = block->IsInstance<DataflowBlockNode>();
+      if (is_dataflow) {
+        builder_->BeginDataflowBlock();
+      } else {
+        builder_->BeginBindingBlock();
+      }
+      for (int i = begin; i < end; ++i) {
+        VisitBinding(bindings_[i]);
+      }
+      // The live-out dataflow vars are used outside the block by the return value.
+      for (int i = begin; i < end && is_dataflow; ++i) {
+        const Var& var = bindings_[i]->var;
+        if (var->IsInstance<DataflowVarNode>() && live_out_set.count(var.get())) {
+          outputs[var.get()] = builder_->EmitOutput(VisitExpr(var), var->name_hint());
+        }
+      }
+      blocks.push_back(builder_->EndBlock());
+    }
+
+    Expr ret;
+    if (stage + 1 < num_stages) {
+      Array<Expr> fields;
+      for (const Var& var : live_out) {
+        auto it = outputs.find(var.get());
+        fields.push_back(it != outputs.end() ? it->second : VisitExpr(var));
+      }
+      ret = Tuple(fields);
+    } else {
+      ret = VisitExpr(seq_->body);
+    }
+    Expr body = VisitWithNewScope(SeqExpr(blocks, ret), params);
+    Function func(params, body, /*ret_struct_info=*/NullOpt, func_->is_pure, func_->attrs);
+    return WithAttr(func, attr::kNumInput, Integer(num_activations));
+  }
+
+  IRModule mod_;
+  Function func_;
+  SeqExpr seq_;
+  int64_t num_input_;
+  Array<Binding> bindings_;
+  /*! \brief The first binding of each stage, followed by the number of bindings. */
+  std::vector<int> stage_begin_;
+  /*! \brief The stage defining each activation, -1 for the inputs of the function. */
+  std::unordered_map<const VarNode*, int> def_stage_;
+  /*! \brief The last stage using each activation. */
+  std::unordered_map<const VarNode*, int> last_use_;
+  /*! \brief The inputs of the function and the binding vars, in the order of definition. */
+  Array<Var> activations_;
+  std::unordered_map<const VarNode*, int> weight_index_;
+  std::vector<std::vector<bool>> weight_used_;
+};
+
+namespace transform {
+
+Pass PartitionPipelineStages(int num_stages, String func_name) {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule m, PassContext pc) {
+        return PipelineStagePartitioner::Partition(m, func_name, num_stages);
+      };
+  return CreateModulePass(pass_func, 0, "PartitionPipelineStages", {});
+}
+TVM_REGISTER_GLOBAL("relax.distributed.transform.PartitionPipelineStages")
+    .set_body_typed(PartitionPipelineStages);
+}  // namespace transform
+
+}  // namespace distributed
+}  // namespace relax
+}  // namespace tvm
@@ -34,6 +34,7 @@
 
 #include "../../op/distributed/distributed.h"
 #include "../../op/distributed/utils.h"
+#include "utils.h"
 
 namespace tvm {
 namespace relax {
@@ -176,6 +177,11 @@ class AxisGroupGraphBuilder : public ExprVisitor {
   IRModule mod_;
 };
 
+void BuildAxisGroupGraph(AxisGroupGraph* axis_group_graph, const Function& func,
+                         const IRModule& mod) {
+  AxisGroupGraphBuilder::BuildAxisGroupGraph(axis_group_graph, func, mod);
+}
+
 /*!
  * \brief Collect the sharding annotations and add source sharding spec in axis group graph.
  */
@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/relax/distributed/transform/utils.h
+ * \brief Utilities shared by the relax distributed passes.
+ */
+#ifndef TVM_RELAX_DISTRIBUTED_TRANSFORM_UTILS_H_
+#define TVM_RELAX_DISTRIBUTED_TRANSFORM_UTILS_H_
+
+#include <tvm/ir/module.h>
+#include <tvm/relax/distributed/axis_group_graph.h>
+#include <tvm/relax/expr.h>
+
+namespace tvm {
+namespace relax {
+namespace distributed {
+
+/*!
+ * \brief Build the axis group graph of the tensors of a function.
+ * \param axis_group_graph The graph to add the axes and edges to.
+ * \param func The function.
+ * \param mod The module containing the PrimFuncs called by the function.
+ */
+void BuildAxisGroupGraph(AxisGroupGraph* axis_group_graph, const Function& func,
+                         const IRModule& mod);
+
+/*!
+ * \brief Estimate the flops of a call. A matmul takes two flops per multiply-add, a call_tir takes
+ * the flops of its PrimFunc, and the other calls take one flop per output element.
+ * \param call The call.
+ * \param mod The module containing the PrimFuncs called by the call.
+ * \return The estimated flops, 0 if unknown.
+ */
+double EstimateCallFlops(const Call& call, const IRModule& mod);
+
+}  // namespace distributed
+}  // namespace relax
+}  // namespace tvm
+
+#endif  // TVM_RELAX_DISTRIBUTED_TRANSFORM_UTILS_H_
@@ -39,6 +39,20 @@ namespace relax {
  */
 Expr no_grad(Expr input);
 
+/*!
+ * \brief Mark the start of a checkpoint stage.
+ * \param input The var used as an input of the checkpoint stage.
+ * \return The marked var.
+ */
+Expr start_checkpoint(Expr input);
+
+/*!
+ * \brief Mark the end of a checkpoint stage.
+ * \param input The var output by the checkpoint stage.
+ * \return The marked var.
+ */
+Expr end_checkpoint(Expr input);
+
 /*! \brief Backward operator of relax.nll_loss. All parameters except output_grad is the same as
  * relax.nll_loss. Returns the gradient w.r.t. predictions. */
 Expr nll_loss_backward(Expr output_grad, Expr predictions, Expr targets, Optional<Expr> weights,
@@ -0,0 +1,527 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relax/transform/dataflow_use_inplace_calls.cc
+ * \brief Rewrite call_tir bindings in dataflow blocks into call_tir_inplace, so that an output
+ * reuses the storage of an input that is dead after the call.
+ *
+ * An input can hold an output when:
+ *  - The input is a dataflow var bound by a call_tir earlier in the same dataflow block, so that
+ *    its storage is owned by the block and not by the caller.
+ *  - The input is not aliased: all its uses are arguments of call_tir, which only read them.
+ *  - The call is the last use of the input, which appears only once in the arguments.
+ *  - The input and the output have the same shape, dtype and virtual device.
+ *  - The PrimFunc writes each element of the output exactly once, from a block with only
+ *    data-parallel iterators indexing the output directly, and only reads the input at the same
+ *    index in that block, or in blocks running before it. This holds for elementwise kernels and
+ *    their fusions, e.g. a residual add or an activation.
+ *
+ * A copy of the PrimFunc with the output buffer replaced by the input buffer is added to the
+ * module for each set of in-place outputs, and the original PrimFunc is kept.
+ */
+
+#include <tvm/arith/analyzer.h>
+#include <tvm/arith/iter_affine_map.h>
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/attrs/op.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+#include <tvm/tir/analysis.h>
+#include <tvm/tir/stmt_functor.h>
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../../tir/schedule/transform.h"
+
+namespace tvm {
+namespace relax {
+
+/*!
+ * \brief Check whether a PrimFunc stays correct when an output buffer is replaced by an input
+ * buffer.
+ */
+class InplaceSafetyChecker : public tir::StmtExprVisitor {
+ public:
+  static bool Check(const tir::PrimFunc& func, const tir::Buffer& input,
+                    const tir::Buffer& output) {
+    if (input->dtype != output->dtype || !StructuralEqual()(input->shape, output->shape)) {
+      return false;
+    }
+    const auto* root = func->body.as<tir::BlockRealizeNode>();
+    if (root == nullptr) {
+      return false;
+    }
+    InplaceSafetyChecker checker(input, output);
+    checker.CheckMatchBuffers(root->block->match_buffers);
+    // The statements of the root block run one after the other.
+    Array<tir::Stmt> stmts;
+    if (const auto* seq = root->block->body.as<tir::SeqStmtNode>()) {
+      stmts = seq->seq;
+    } else {
+      stmts.push_back(root->block->body);
+    }
+    for (size_t i = 0; i < stmts.size(); ++i) {
+      checker.top_index_ = i;
+      checker(stmts[i]);
+    }
+    return checker.IsSafe();
+  }
+
+ private:
+  struct Access {
+    const tir::BlockNode* block{nullptr};
+    size_t top_index{0};
+    Array<PrimExpr> indices;
+    /*! \brief Whether the access is in the value stored to the output. */
+    bool in_output_store{false};
+  };
+
+  InplaceSafetyChecker(const tir::Buffer& input, const tir::Buffer& output)
+      : input_(input->data.get()), output_(output->data.get()) {}
+
+  bool IsSafe() const {
+    if (!safe_ || num_stores_ != 1) {
+      return false;
+    }
+    for (const Access& load : input_loads_) {
+      if (load.block == store_.block) {
+        // An element of the input is only read right before the output overwrites it.
+        if (!load.in_output_store) {
+          return false;
+        }
+        for (size_t i = 0; i < load.indices.size(); ++i) {
+          if (!tir::ExprDeepEqual()(load.indices[i], store_.indices[i])) {
+            return false;
+          }
+        }
+      } else if (load.top_index >= store_.top_index) {
+        return false;
+      }
+    }
+    for (const Access& load : output_loads_) {
+      if (load.top_index <= store_.top_index) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void CheckMatchBuffers(const Array<tir::MatchBufferRegion>& match_buffers) {
+    for (const tir::MatchBufferRegion& match_buffer : match_buffers) {
+      const tir::VarNode* source = match_buffer->source->buffer->data.get();
+      if (source == input_ || source == output_) {
+        safe_ = false;
+      }
+    }
+  }
+
+  const tir::BlockNode* CurrentBlock() const {
+    return blocks_.empty() ? nullptr : blocks_.back();
+  }
+
+  void VisitStmt_(const tir::ForNode* op) final {
+    loop_ranges_.Set(op->loop_var, Range::FromMinExtent(op->min, op->extent));
+    tir::StmtExprVisitor::VisitStmt_(op);
+    loop_ranges_.erase(op->loop_var);
+  }
+
+  void VisitStmt_(const tir::BlockRealizeNode* op) final {
+    realizes_.push_back(op);
+    tir::StmtExprVisitor::VisitStmt_(op);
+    realizes_.pop_back();
+  }
+
+  void VisitStmt_(const tir::BlockNode* op) final {
+    CheckMatchBuffers(op->match_buffers);
+    blocks_.push_back(op);
+    tir::StmtExprVisitor::VisitStmt_(op);
+    blocks_.pop_back();
+  }
+
+  void VisitStmt_(const tir::BufferStoreNode* op) final {
+    const tir::VarNode* data = op->buffer->data.get();
+    if (data == input_) {
+      safe_ = false;
+    } else if (data == output_) {
+      ++num_stores_;
+      store_ = Access{CurrentBlock(), top_index_, op->indices};
+      if (!IsDataParallelStore(op)) {
+        safe_ = false;
+      }
+      in_output_store_ = true;
+      tir::StmtExprVisitor::VisitStmt_(op);
+      in_output_store_ = false;
+      return;
+    }
+    tir::StmtExprVisitor::VisitStmt_(op);
+  }
+
+  void VisitExpr_(const tir::BufferLoadNode* op) final {
+    const tir::VarNode* data = op->buffer->data.get();
+    if (data == input_) {
+      input_loads_.push_back(Access{CurrentBlock(), top_index_, op->indices, in_output_store_});
+    } else if (data == output_) {
+      output_loads_.push_back(Access{CurrentBlock(), top_index_, op->indices});
+    }
+    tir::StmtExprVisitor::VisitExpr_(op);
+  }
+
+  void VisitExpr_(const tir::VarNode* op) final {
+    // The buffers are accessed other than by loads and stores, e.g. by an extern call.
+    if (op == input_ || op == output_) {
+      safe_ = false;
+    }
+  }
+
+  /*!
+   * \brief Whether each instance of the block writes a distinct element, i.e. the indices are
+   * exactly the data-parallel iterators of a block without reduction, and the block is bound
+   * bijectively to the enclosing loops, so that each iteration runs a distinct instance.
+   */
+  bool IsDataParallelStore(const tir::BufferStoreNode* store) {
+    const tir::BlockNode* block = CurrentBlock();
+    if (block == nullptr || block->init.defined() ||
+        store->indices.size() != block->iter_vars.size()) {
+      return false;
+    }
+    const tir::BlockRealizeNode* realize = realizes_.back();
+    ICHECK(realize->block.get() == block);
+    if (!realize->iter_values.empty()) {
+      arith::IterMapResult res = arith::DetectIterMap(
+          /*indices=*/realize->iter_values,
+          /*input_iters=*/loop_ranges_,
+          /*predicate=*/realize->predicate,
+          /*check_level=*/arith::IterMapLevel::Bijective,
+          /*analyzer=*/&analyzer_,
+          /*simplify_trivial_iterators=*/false);
+      if (res->indices.empty()) {
+        return false;
+      }
+    }
+    std::unordered_set<const tir::VarNode*> seen;
+    for (const PrimExpr& index : store->indices) {
+      const auto* var = index.as<tir::VarNode>();
+      if (var == nullptr || !seen.insert(var).second) {
+        return false;
+      }
+      bool is_iter_var = false;
+      for (const tir::IterVar& iter_var : block->iter_vars) {
+        if (iter_var->var.get() == var) {
+          is_iter_var = iter_var->iter_type == tir::IterVarType::kDataPar;
+        }
+      }
+      if (!is_iter_var) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const tir::VarNode* input_;
+  const tir::VarNode* output_;
+  size_t top_index_{0};
+  bool in_output_store_{false};
+  std::vector<const tir::BlockNode*> blocks_;
+  std::vector<const tir::BlockRealizeNode*> realizes_;
+  /*! \brief The ranges of the loops enclosing the visited statement. */
+  Map<tir::Var, Range> loop_ranges_;
+  arith::Analyzer analyzer_;
+  bool safe_{true};
+  int num_stores_{0};
+  Access store_;
+  std::vector<Access> input_loads_;
+  std::vector<Access> output_loads_;
+};
+
+class InplaceCallRewriter : public ExprMutator {
+ public:
+  static IRModule Rewrite(IRModule mod) {
+    InplaceCallRewriter rewriter(mod);
+    for (const auto& [gv, func] : mod->functions) {
+      if (const auto* relax_func = func.as<FunctionNode>()) {
+        Function updated = Downcast<Function>(rewriter.VisitExpr(GetRef<Function>(relax_func)));
+        if (!updated.same_as(func)) {
+          rewriter.builder_->UpdateFunction(gv, updated);
+        }
+      }
+    }
+    return rewriter.builder_->GetContextIRModule();
+  }
+
+ private:
+  /*! \brief The liveness and alias information of the current dataflow block. */
+  struct BlockInfo {
+    bool in_dataflow_block{false};
+    /*! \brief The index of the binding being visited. */
+    size_t binding_index{0};
+    /*! \brief The index of the last binding using each var. */
+    std::unordered_map<const VarNode*, size_t> last_use;
+    /*! \brief The vars whose storage is allocated by the block. */
+    std::unordered_set<const VarNode*> owned;
+    /*! \brief The vars which may share their storage with another var. */
+    std::unordered_set<const VarNode*> aliased;
+  };
+
+  explicit InplaceCallRewriter(IRModule mod) : ExprMutator(mod) {}
+
+  using ExprMutator::VisitBinding_;
+  using ExprMutator::VisitExpr_;
+
+  BindingBlock VisitBindingBlock_(const DataflowBlockNode* block) final {
+    // The blocks of nested functions are analyzed on their own.
+    BlockInfo outer = std::move(info_);
+    info_ = AnalyzeBlock(block);
+    BindingBlock result = ExprMutator::VisitBindingBlock_(block);
+    info_ = std::move(outer);
+    return result;
+  }
+
+  BindingBlock VisitBindingBlock_(const BindingBlockNode* block) final {
+    BlockInfo outer = std::move(info_);
+    info_ = BlockInfo();
+    BindingBlock result = ExprMutator::VisitBindingBlock_(block);
+    info_ = std::move(outer);
+    return result;
+  }
+
+  /*! \brief Collect the last use of the vars in a dataflow block, and whether they are aliased. */
+  static BlockInfo AnalyzeBlock(const DataflowBlockNode* block) {
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    BlockInfo info;
+    info.in_dataflow_block = true;
+    for (size_t i = 0; i < block->bindings.size(); ++i) {
+      const Binding& binding = block->bindings[i];
+      Expr value = GetBoundValue(binding);
+      Array<Var> used_vars = FreeVars(value);
+      for (const Var& var : used_vars) {
+        info.last_use[var.get()] = i;
+      }
+      const auto* call = value.as<CallNode>();
+      if (binding->IsInstance<VarBindingNode>() && call != nullptr &&
+          call->op.same_as(call_tir_op) && call->args[1]->IsInstance<TupleNode>()) {
+        if (binding->var->IsInstance<DataflowVarNode>() &&
+            GetStructInfo(binding->var)->IsInstance<TensorStructInfoNode>()) {
+          info.owned.insert(binding->var.get());
+        }
+        // The arguments of call_tir are only read.
+        continue;
+      }
+      for (const Var& var : used_vars) {
+        info.aliased.insert(var.get());
+      }
+    }
+    return info;
+  }
+
+  void VisitBinding_(const VarBindingNode* binding) final {
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    size_t index = info_.binding_index++;
+    const auto* call = binding->value.as<CallNode>();
+    if (info_.in_dataflow_block && call != nullptr && call->op.same_as(call_tir_op)) {
+      if (auto inplace_call = MakeInplaceCall(GetRef<Call>(call), index)) {
+        ReEmitBinding(binding, VisitExpr(inplace_call.value()));
+        return;
+      }
+    }
+    ExprMutator::VisitBinding_(binding);
+  }
+
+  void VisitBinding_(const MatchCastNode* binding) final {
+    ++info_.binding_index;
+    ExprMutator::VisitBinding_(binding);
+  }
+
+  /*! \brief Whether the struct info of an input and an output allow them to share storage. */
+  bool IsCompatible(const StructInfo& input, const StructInfo& output) {
+    const auto* input_sinfo = input.as<TensorStructInfoNode>();
+    const auto* output_sinfo = output.as<TensorStructInfoNode>();
+    if (input_sinfo == nullptr || output_sinfo == nullptr || input_sinfo->IsUnknownDtype() ||
+        input_sinfo->dtype != output_sinfo->dtype ||
+        !StructuralEqual()(input_sinfo->vdevice, output_sinfo->vdevice)) {
+      return false;
+    }
+    auto input_shape = input_sinfo->GetShape();
+    auto output_shape = output_sinfo->GetShape();
+    if (!input_shape.defined() || !output_shape.defined() ||
+        input_shape.value().size() != output_shape.value().size()) {
+      return false;
+    }
+    for (size_t i = 0; i < input_shape.value().size(); ++i) {
+      if (!analyzer_.CanProveEqual(input_shape.value()[i], output_shape.value()[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /*! \brief Whether an argument is dead after the call and owned by the dataflow block. */
+  bool IsDeadAfter(const Expr& arg, const Array<Expr>& args, size_t index) const {
+    const auto* var = arg.as<VarNode>();
+    if (var == nullptr || !info_.owned.count(var) || info_.aliased.count(var)) {
+      return false;
+    }
+    auto it = info_.last_use.find(var);
+    if (it == info_.last_use.end() || it->second != index) {
+      return false;
+    }
+    return std::count_if(args.begin(), args.end(),
+                         [var](const Expr& other) { return other.get() == var; }) == 1;
+  }
+
+  Optional<Call> MakeInplaceCall(const Call& call, size_t index) {
+    const auto* gv = call->args[0].as<GlobalVarNode>();
+    const auto* arg_tuple = call->args[1].as<TupleNode>();
+    if (gv == nullptr || arg_tuple == nullptr) {
+      return NullOpt;
+    }
+    auto opt_prim_func = builder_->GetContextIRModule()->Lookup(GetRef<GlobalVar>(gv))
+                             .as<tir::PrimFunc>();
+    if (!opt_prim_func) {
+      return NullOpt;
+    }
+    tir::PrimFunc prim_func = opt_prim_func.value();
+    Array<Expr> args = arg_tuple->fields;
+
+    Array<StructInfo> outputs;
+    if (const auto* tuple = call->sinfo_args[0].as<TupleStructInfoNode>()) {
+      outputs = tuple->fields;
+    } else {
+      outputs.push_back(call->sinfo_args[0]);
+    }
+    if (prim_func->params.size() < args.size() + outputs.size()) {
+      return NullOpt;
+    }
+    auto get_buffer = [&prim_func](size_t param_index) -> Optional<tir::Buffer> {
+      return prim_func->buffer_map.Get(prim_func->params[param_index]);
+    };
+
+    std::vector<int64_t> inplace_indices(outputs.size(), -1);
+    std::unordered_set<size_t> used_args;
+    bool any_inplace = false;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      Optional<tir::Buffer> output_buffer = get_buffer(args.size() + i);
+      if (!output_buffer.defined()) {
+        continue;
+      }
+      for (size_t j = 0; j < args.size(); ++j) {
+        if (used_args.count(j) || !IsDeadAfter(args[j], args, index) ||
+            !IsCompatible(GetStructInfo(args[j]), outputs[i])) {
+          continue;
+        }
+        Optional<tir::Buffer> input_buffer = get_buffer(j);
+        if (input_buffer.defined() &&
+            InplaceSafetyChecker::Check(prim_func, input_buffer.value(), output_buffer.value())) {
+          inplace_indices[i] = j;
+          used_args.insert(j);
+          any_inplace = true;
+          break;
+        }
+      }
+    }
+    if (!any_inplace) {
+      return NullOpt;
+    }
+
+    static const Op& call_tir_inplace_op = Op::Get("relax.call_tir_inplace");
+    ObjectPtr<CallTIRInplaceAttrs> attrs = make_object<CallTIRInplaceAttrs>();
+    attrs->inplace_indices = Array<Integer>(inplace_indices.begin(), inplace_indices.end());
+    Array<Expr> call_args = {GetInplacePrimFunc(GetRef<GlobalVar>(gv), prim_func, args.size(),
+                                                inplace_indices),
+                             call->args[1]};
+    if (call->args.size() > 2) {
+      call_args.push_back(call->args[2]);
+    }
+    return Call(call_tir_inplace_op, call_args, Attrs(attrs), call->sinfo_args, call->span);
+  }
+
+  /*!
+   * \brief Get the copy of a PrimFunc writing its in-place outputs to the inputs, whose output
+   * parameters are removed.
+   */
+  GlobalVar GetInplacePrimFunc(const GlobalVar& gv, const tir::PrimFunc& func, size_t num_args,
+                               const std::vector<int64_t>& inplace_indices) {
+    auto key = std::make_pair(gv.get(), inplace_indices);
+    auto it = inplace_funcs_.find(key);
+    if (it != inplace_funcs_.end()) {
+      return it->second;
+    }
+
+    Map<tir::Buffer, tir::Buffer> buffer_replacement;
+    std::unordered_set<size_t> removed_params;
+    for (size_t i = 0; i < inplace_indices.size(); ++i) {
+      if (inplace_indices[i] != -1) {
+        const tir::Var& output_param = func->params[num_args + i];
+        const tir::Var& input_param = func->params[inplace_indices[i]];
+        buffer_replacement.Set(func->buffer_map.at(output_param),
+                               func->buffer_map.at(input_param));
+        removed_params.insert(num_args + i);
+      }
+    }
+    Array<tir::Var> params;
+    Map<tir::Var, tir::Buffer> buffer_map;
+    for (size_t i = 0; i < func->params.size(); ++i) {
+      if (removed_params.count(i)) {
+        continue;
+      }
+      const tir::Var& param = func->params[i];
+      params.push_back(param);
+      if (auto buffer = func->buffer_map.Get(param)) {
+        buffer_map.Set(param, buffer.value());
+      }
+    }
+    tir::Stmt body = tir::ReplaceBufferMutator(buffer_replacement, nullptr)(func->body);
+    tir::PrimFunc inplace_func(params, body, func->ret_type, buffer_map, func->attrs, func->span);
+
+    bool has_symbol = func->GetAttr<String>(tvm::attr::kGlobalSymbol).defined();
+    inplace_func = WithoutAttr(std::move(inplace_func), tvm::attr::kGlobalSymbol);
+    GlobalVar inplace_gv = builder_->AddFunction(inplace_func, gv->name_hint + "_inplace");
+    if (has_symbol) {
+      builder_->UpdateFunction(
+          inplace_gv, WithAttr(std::move(inplace_func), tvm::attr::kGlobalSymbol,
+                               String(inplace_gv->name_hint)));
+    }
+    inplace_funcs_.emplace(key, inplace_gv);
+    return inplace_gv;
+  }
+
+  BlockInfo info_;
+  arith::Analyzer analyzer_;
+  std::map<std::pair<const GlobalVarNode*, std::vector<int64_t>>, GlobalVar> inplace_funcs_;
+};
+
+namespace transform {
+
+Pass DataflowUseInplaceCalls() {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule mod, PassContext pc) { return InplaceCallRewriter::Rewrite(mod); };
+  return CreateModulePass(pass_func, 0, "DataflowUseInplaceCalls", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.DataflowUseInplaceCalls")
+    .set_body_typed(DataflowUseInplaceCalls);
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
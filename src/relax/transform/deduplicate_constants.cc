@@ -0,0 +1,87 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/relax/transform/deduplicate_constants.cc
+ * \brief Pass for sharing the constants of identical contents across the IRModule.
+ *
+ * Tied weights, repeated adapters and the results of constant folding often produce constants
+ * with the same data held by different NDArrays. This pass replaces all the constants of the Relax
+ * functions in the IRModule by the first constant of the same data and struct info, so that a
+ * single NDArray is kept for all of them. The constant pool of the VM executable already stores
+ * the structurally equal constants once.
+ */
+#include <tvm/node/structural_equal.h>
+#include <tvm/node/structural_hash.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+
+#include <unordered_map>
+
+namespace tvm {
+namespace relax {
+
+class ConstantDeduplicator : public ExprMutator {
+ public:
+  using ExprMutator::VisitExpr_;
+
+  Expr VisitExpr_(const ConstantNode* op) final {
+    Constant constant = GetRef<Constant>(op);
+    auto it = canonical_constants_.find(constant);
+    if (it != canonical_constants_.end()) {
+      return it->second;
+    }
+    canonical_constants_.emplace(constant, constant);
+    return constant;
+  }
+
+ private:
+  /*! \brief The first constant of each data and struct info. */
+  std::unordered_map<Constant, Constant, StructuralHash, StructuralEqual> canonical_constants_;
+};
+
+namespace transform {
+
+Pass DeduplicateConstants() {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule mod, PassContext pc) {
+        // The contents of the large constants are hashed once, however many times they appear.
+        NDArrayHashCacheScope hash_cache_scope;
+        ConstantDeduplicator deduplicator;
+        IRModuleNode* new_module = mod.CopyOnWrite();
+        Map<GlobalVar, BaseFunc> functions = mod->functions;
+        for (const auto& [gvar, base_func] : functions) {
+          if (const auto* func = base_func.as<FunctionNode>()) {
+            Function new_func = Downcast<Function>(deduplicator.VisitExpr(GetRef<Function>(func)));
+            if (!new_func.same_as(base_func)) {
+              new_module->Update(gvar, new_func);
+            }
+          }
+        }
+        return GetRef<IRModule>(new_module);
+      };
+  return CreateModulePass(pass_func, 0, "DeduplicateConstants", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.DeduplicateConstants").set_body_typed(DeduplicateConstants);
+
+}  // namespace transform
+
+}  // namespace relax
+}  // namespace tvm
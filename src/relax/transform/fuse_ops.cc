@@ -33,11 +33,16 @@
 #include <tvm/relax/expr_functor.h>
 #include <tvm/relax/struct_info.h>
 #include <tvm/relax/transform.h>
+#include <tvm/tir/analysis.h>
 #include <tvm/tir/expr_functor.h>
 #include <tvm/tir/function.h>
+#include <tvm/tir/stmt_functor.h>
 
+#include <algorithm>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "../../relay/analysis/graph_partitioner.h"
 #include "../../support/arena.h"
@@ -93,8 +98,12 @@ using relay::OpPatternKind;
 using support::LinkNode;
 
 constexpr uint32_t kMaxFusedOps = 256;
+/*! \brief The default FLOPs worth one byte of memory traffic in the fusion cost model. */
+constexpr int64_t kFusionFlopsPerByte = 8;
 
 TVM_REGISTER_PASS_CONFIG_OPTION("relax.FuseOps.max_depth", Integer);
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.FuseOps.cost_model", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.FuseOps.flops_per_byte", Integer);
 
 class GraphCreator : public ExprVisitor {
  public:
@@ -1001,15 +1010,237 @@ class OperatorFusor : public ExprMutator {
   bool lift_constants_{true};
 };
 
-IRModule FuseOps(IRModule mod, int opt_level, size_t max_fuse_depth) {
+/*!
+ * \brief The number of elements of a TIR buffer read by a PrimFunc, counting every read of the
+ * loop nests. Returns -1 if the extent of an enclosing loop is not a constant.
+ */
+class BufferReadCounter : public tir::StmtExprVisitor {
+ public:
+  static double Count(const tir::PrimFunc& func, const tir::Buffer& buffer) {
+    BufferReadCounter counter(buffer);
+    counter.VisitStmt(func->body);
+    return counter.is_static_ ? counter.num_reads_ : -1;
+  }
+
+ private:
+  explicit BufferReadCounter(tir::Buffer buffer) : buffer_(std::move(buffer)) {}
+
+  void VisitStmt_(const tir::ForNode* loop) final {
+    const auto* extent = loop->extent.as<IntImmNode>();
+    if (extent == nullptr) {
+      is_static_ = false;
+      return;
+    }
+    double outer_iterations = num_iterations_;
+    num_iterations_ *= extent->value;
+    tir::StmtExprVisitor::VisitStmt_(loop);
+    num_iterations_ = outer_iterations;
+  }
+
+  void VisitExpr_(const tir::BufferLoadNode* load) final {
+    if (load->buffer->data.same_as(buffer_->data)) {
+      num_reads_ += num_iterations_;
+    }
+    tir::StmtExprVisitor::VisitExpr_(load);
+  }
+
+  tir::Buffer buffer_;
+  double num_iterations_{1};
+  double num_reads_{0};
+  bool is_static_{true};
+};
+
+/*!
+ * \brief The cost model deciding whether fusing a group into its post-dominator is profitable.
+ *
+ * Fusing a group saves writing its output to the global memory and reading it back. However, the
+ * group is inlined into its consumers, and is recomputed each time a consumer reads an element of
+ * its output more than once, as the reductions of softmax or the broadcasts do. The fusion is
+ * refused when the FLOPs recomputed exceed the bytes saved times the FLOPs worth one byte.
+ * The fusions whose costs cannot be estimated, e.g. due to dynamic shapes, are always accepted.
+ */
+class FusionCostModel {
+ public:
+  using Group = GraphPartitioner::Group;
+
+  explicit FusionCostModel(IRModule mod, const IndexedForwardGraph& graph, double flops_per_byte)
+      : mod_(mod), flops_per_byte_(flops_per_byte) {
+    for (const auto& it : mod->functions) {
+      const auto* func = it.second.as<FunctionNode>();
+      if (func == nullptr || func->HasNonzeroAttr(attr::kPrimitive)) {
+        continue;
+      }
+      PostOrderVisit(func->body, [this](const Expr& expr) {
+        if (const auto* seq = expr.as<SeqExprNode>()) {
+          for (const BindingBlock& block : seq->blocks) {
+            for (const Binding& binding : block->bindings) {
+              if (const auto* var_binding = binding.as<VarBindingNode>()) {
+                values_[var_binding->var.get()] = var_binding->value;
+              }
+            }
+          }
+        }
+      });
+    }
+    producers_.resize(graph.post_dfs_order.size());
+    for (IndexedForwardGraph::Node* node : graph.post_dfs_order) {
+      for (auto* link = node->outputs.head; link != nullptr; link = link->next) {
+        producers_[link->value.node->index].push_back(node);
+      }
+    }
+  }
+
+  bool operator()(const IndexedForwardGraph::Node* src, const IndexedForwardGraph::Node* sink,
+                  const std::vector<Group*>& groups) {
+    // The number of times each element of the output is computed after the fusion.
+    double num_computes = 0;
+    std::unordered_set<const IndexedForwardGraph::Node*> consumers;
+    for (auto* link = src->outputs.head; link != nullptr; link = link->next) {
+      if (consumers.insert(link->value.node).second) {
+        num_computes += GetReadsPerElement(src, link->value.node);
+      }
+    }
+    if (num_computes <= 1) {
+      return true;
+    }
+    double bytes_saved = 2 * GetOutputBytes(src);
+    if (bytes_saved <= 0) {
+      return true;
+    }
+    return GetGroupFlops(src, groups) * (num_computes - 1) <= flops_per_byte_ * bytes_saved;
+  }
+
+ private:
+  /*! \brief The bytes of the output of a node, or -1 if it is not static. */
+  static double GetOutputBytes(const IndexedForwardGraph::Node* node) {
+    const auto* var = node->ref->as<VarNode>();
+    if (var == nullptr) {
+      return -1;
+    }
+    double bytes = 0;
+    for (const TensorStructInfo& sinfo : GetTensorStructInfos(GetStructInfo(GetRef<Var>(var)))) {
+      const auto* shape = sinfo->shape.as<ShapeExprNode>();
+      if (shape == nullptr || sinfo->IsUnknownDtype()) {
+        return -1;
+      }
+      double num_elements = 1;
+      for (const PrimExpr& dim : shape->values) {
+        const auto* int_dim = dim.as<IntImmNode>();
+        if (int_dim == nullptr) {
+          return -1;
+        }
+        num_elements *= int_dim->value;
+      }
+      bytes += num_elements * sinfo->dtype.bytes() * sinfo->dtype.lanes();
+    }
+    return bytes;
+  }
+
+  static Array<TensorStructInfo> GetTensorStructInfos(const StructInfo& sinfo) {
+    Array<TensorStructInfo> result;
+    if (const auto* tensor = sinfo.as<TensorStructInfoNode>()) {
+      result.push_back(GetRef<TensorStructInfo>(tensor));
+    } else if (const auto* tuple = sinfo.as<TupleStructInfoNode>()) {
+      for (const StructInfo& field : tuple->fields) {
+        for (const TensorStructInfo& tensor : GetTensorStructInfos(field)) {
+          result.push_back(tensor);
+        }
+      }
+    }
+    return result;
+  }
+
+  /*!
+   * \brief The number of times the consumer reads each element of the output of the producer,
+   * which is 1 unless the consumer is a PrimFunc reading the elements repeatedly.
+   */
+  double GetReadsPerElement(const IndexedForwardGraph::Node* producer,
+                            const IndexedForwardGraph::Node* consumer) {
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    auto it = values_.find(consumer->ref);
+    const auto* call = it != values_.end() ? it->second.as<CallNode>() : nullptr;
+    if (call == nullptr || !call->op.same_as(call_tir_op)) {
+      return 1;
+    }
+    const auto* func = mod_->Lookup(Downcast<GlobalVar>(call->args[0])).as<tir::PrimFuncNode>();
+    const auto* args = call->args[1].as<TupleNode>();
+    if (func == nullptr || args == nullptr) {
+      return 1;
+    }
+    double num_reads = 0;
+    for (size_t i = 0; i < args->fields.size() && i < func->params.size(); ++i) {
+      if (args->fields[i].get() != producer->ref) {
+        continue;
+      }
+      Optional<tir::Buffer> buffer = func->buffer_map.Get(func->params[i]);
+      if (!buffer.defined()) {
+        return 1;
+      }
+      double num_elements = 1;
+      for (const PrimExpr& dim : buffer.value()->shape) {
+        const auto* int_dim = dim.as<IntImmNode>();
+        num_elements *= int_dim ? int_dim->value : 0;
+      }
+      double buffer_reads = BufferReadCounter::Count(GetRef<tir::PrimFunc>(func), buffer.value());
+      if (num_elements <= 0 || buffer_reads < 0) {
+        return 1;
+      }
+      num_reads += buffer_reads / num_elements;
+    }
+    return std::max(num_reads, 1.0);
+  }
+
+  /*! \brief The FLOPs of the group of a node, which consists of the node and its producers. */
+  double GetGroupFlops(const IndexedForwardGraph::Node* node, const std::vector<Group*>& groups) {
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    Group* root = groups[node->index]->FindRoot();
+    double flops = 0;
+    std::unordered_set<const IndexedForwardGraph::Node*> visited{node};
+    std::vector<const IndexedForwardGraph::Node*> stack{node};
+    while (!stack.empty()) {
+      const IndexedForwardGraph::Node* member = stack.back();
+      stack.pop_back();
+      auto it = values_.find(member->ref);
+      const auto* call = it != values_.end() ? it->second.as<CallNode>() : nullptr;
+      if (call != nullptr && call->op.same_as(call_tir_op)) {
+        const auto* func = mod_->Lookup(Downcast<GlobalVar>(call->args[0])).as<tir::PrimFuncNode>();
+        if (func != nullptr) {
+          flops += tir::EstimateTIRFlops(func->body);
+        }
+      }
+      for (const IndexedForwardGraph::Node* producer : producers_[member->index]) {
+        if (groups[producer->index]->FindRoot() == root && visited.insert(producer).second) {
+          stack.push_back(producer);
+        }
+      }
+    }
+    return flops;
+  }
+
+  IRModule mod_;
+  double flops_per_byte_;
+  /*! \brief The values bound to the binding vars. */
+  std::unordered_map<const Object*, Expr> values_;
+  /*! \brief The producers of each node, indexed by the node index. */
+  std::vector<std::vector<const IndexedForwardGraph::Node*>> producers_;
+};
+
+IRModule FuseOps(IRModule mod, int opt_level, size_t max_fuse_depth, bool use_cost_model = false,
+                 int64_t flops_per_byte = kFusionFlopsPerByte) {
   support::Arena arena;
 
   // Step 1. Create the indexed-forward graph according to the input IRModule.
   IndexedForwardGraph graph = GraphCreator::Create(mod, &arena);
 
-  // Step 2. Partition the graph by applying the fusion algorithm.
+  // Step 2. Partition the graph by applying the fusion algorithm, optionally refusing the fusions
+  // found unprofitable by the cost model.
+  GraphPartitioner::FCheckFuse fcheck_fuse = nullptr;
+  if (use_cost_model) {
+    fcheck_fuse = FusionCostModel(mod, graph, flops_per_byte);
+  }
   std::vector<GraphPartitioner::Group*> groups =
-      GraphPartitioner(&arena, opt_level, max_fuse_depth, /*max_function_args=*/0).Partition(graph);
+      GraphPartitioner(&arena, opt_level, max_fuse_depth, /*max_function_args=*/0, fcheck_fuse)
+          .Partition(graph);
 
   // Step 3. Transform the IRModule by fusing the operators in accordance with the graph partition
   // results.
@@ -1308,7 +1539,11 @@ Pass FuseOps(int fuse_opt_level) {
       [=](IRModule m, PassContext pc) {
         int opt_level = fuse_opt_level == -1 ? pc->opt_level : fuse_opt_level;
         auto max_fuse_depth = pc->GetConfig("relax.FuseOps.max_depth", Integer(kMaxFusedOps));
-        return relax::FuseOps(m, opt_level, max_fuse_depth.value().IntValue());
+        bool use_cost_model = pc->GetConfig<Bool>("relax.FuseOps.cost_model", Bool(false)).value();
+        auto flops_per_byte =
+            pc->GetConfig("relax.FuseOps.flops_per_byte", Integer(kFusionFlopsPerByte));
+        return relax::FuseOps(m, opt_level, max_fuse_depth.value().IntValue(), use_cost_model,
+                              flops_per_byte.value().IntValue());
       };
   return CreateModulePass(/*pass_function=*/pass_func,  //
                           /*opt_level=*/0,              //
@@ -340,6 +340,10 @@ class FusedTIRConstructor : public ExprVisitor {
     CHECK(f->HasNonzeroAttr(relax::attr::kPrimitive))
         << "Expected a function with attr `kPrimitive`";
     visitor(Downcast<relax::Function>(f));
+    if (Optional<Integer> num_kernels = f->GetAttr<Integer>(relax::attr::kHorizontalFusion)) {
+      return WithAttr(std::move(visitor.fused_tir_), tir::attr::kHorizontalFusion,
+                      num_kernels.value());
+    }
     return visitor.fused_tir_;
   }
 
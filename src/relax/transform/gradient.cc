@@ -26,16 +26,23 @@
  */
 
 #include <tvm/relax/analysis.h>
+#include <tvm/relax/attrs/nn.h>
 #include <tvm/relax/attrs/op.h>
 #include <tvm/relax/expr_functor.h>
 #include <tvm/relax/nested_msg.h>
 #include <tvm/relax/op_attr_types.h>
 #include <tvm/relax/transform.h>
+#include <tvm/tir/analysis.h>
 
+#include <algorithm>
+#include <optional>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "../op/tensor/binary.h"
 #include "../op/tensor/create.h"
+#include "../op/tensor/grad.h"
 #include "utils.h"
 
 namespace tvm {
@@ -663,7 +670,7 @@ class GradientMutator : private ExprMutator {
 
     // the return value should be a VarNode, and a scalar
     orig_return_expr_ = seq_expr->body;
-    CheckAndSetTarget(seq_expr->body, target_index_);
+    target_var_ = CheckAndGetTarget(seq_expr->body, target_index_);
 
     BindingBlock new_block = this->VisitBindingBlock(seq_expr->blocks[0]);
     return SeqExpr({new_block}, return_expr_);
@@ -684,6 +691,7 @@ class GradientMutator : private ExprMutator {
     return builder_->EndBlock();
   }
 
+ public:
   static bool IsFloatTensorSInfo(const StructInfo& sinfo) {
     auto* tensor_sinfo = sinfo.as<TensorStructInfoNode>();
     return tensor_sinfo && tensor_sinfo->dtype.is_float();
@@ -692,12 +700,13 @@ class GradientMutator : private ExprMutator {
   // When the return value is a Var, it is the target;
   // when the return value is a Tuple, the target is the target_index-th field of the return value
   // Check that the target should be a Var of scalar tensor struct_info
-  void CheckAndSetTarget(const Expr& e, int target_index) {
+  static Var CheckAndGetTarget(const Expr& e, int target_index) {
+    Var target_var;
     if (auto* var = e.as<VarNode>()) {
       CHECK_EQ(target_index, 0) << "When the function has only one return value, target_index can "
                                    "only be 0. But the target_index specified is "
                                 << target_index;
-      target_var_ = GetRef<Var>(var);
+      target_var = GetRef<Var>(var);
     } else if (auto* tuple = e.as<TupleNode>()) {
       CHECK(target_index >= 0 && target_index < static_cast<int>(tuple->fields.size()))
           << "target_index should be in the range of the number of return values of the function. "
@@ -706,17 +715,18 @@ class GradientMutator : private ExprMutator {
       auto* var = tuple->fields[target_index].as<VarNode>();
       CHECK(var) << "Target must be a Var, but the specified target is "
                  << tuple->fields[target_index];
-      target_var_ = GetRef<Var>(var);
+      target_var = GetRef<Var>(var);
     } else {
       LOG(FATAL) << "The return value of the function must be Var or Tuple. However, the return "
                     "value of the given function is "
                  << e;
     }
-    auto target_sinfo = GetStructInfo(target_var_);
+    auto target_sinfo = GetStructInfo(target_var);
     CHECK(IsScalarTensor(target_sinfo) && IsFloatTensorSInfo(target_sinfo))
         << "The differentiation target must be a float scalar (0-dim Tensor), but the StructInfo "
            "of the given target "
-        << target_var_ << " is " << GetStructInfo(target_var_);
+        << target_var << " is " << GetStructInfo(target_var);
+    return target_var;
   }
 
   // Check every Var in require_grads:
@@ -741,6 +751,7 @@ class GradientMutator : private ExprMutator {
     }
   }
 
+ private:
   // differentiation sources
   Array<Var> require_grads_;
   // checkpoint
@@ -754,6 +765,311 @@ class GradientMutator : private ExprMutator {
   Expr return_expr_;
 };
 
+/*!
+ * \brief Choose the activations to rematerialize in the backward pass under a memory budget, and
+ * mark them with start_checkpoint and end_checkpoint for Gradient.
+ *
+ * All the activations used by the backward pass are live at the end of the forward pass, which is
+ * the peak of the memory of the activations. Dropping an activation frees its memory, but keeps
+ * alive the activations it is recomputed from. The activations are dropped greedily by the ratio of
+ * the memory freed to the estimated cost of recomputing them, until the kept ones fit the budget.
+ */
+class RematerializationPlanner : private ExprMutator {
+ public:
+  static Function Plan(const IRModule& mod, const Function& func, const String& func_name,
+                       int64_t memory_budget, Optional<Array<Var>> require_grads,
+                       int target_index) {
+    const auto* seq = func->body.as<SeqExprNode>();
+    CHECK(seq) << "The body of the function must be SeqExpr.";
+    CHECK(seq->blocks.size() == 1 && seq->blocks[0]->IsInstance<DataflowBlockNode>())
+        << "now only support one dataflow block";
+    DataflowBlock block = Downcast<DataflowBlock>(seq->blocks[0]);
+    if (require_grads) {
+      GradientMutator::CheckRequireGrads(require_grads.value(), func->params, func_name);
+    }
+
+    RematerializationPlanner planner(mod);
+    planner.CollectActivations(block, seq->body);
+    planner.CollectBackwardUses(block, require_grads.value_or(func->params),
+                                GradientMutator::CheckAndGetTarget(seq->body, target_index),
+                                func->params, seq->body);
+    planner.ChooseDropped(memory_budget);
+    if (planner.dropped_.empty()) {
+      return func;
+    }
+    return Downcast<Function>(planner.VisitExpr(func));
+  }
+
+ private:
+  /*! \brief A binding of the forward pass. */
+  struct Activation {
+    /*! \brief The activations the value is computed from. */
+    std::vector<const VarNode*> inputs;
+    /*! \brief The size in bytes, if static. */
+    std::optional<int64_t> bytes;
+    /*! \brief The estimated cost of recomputing the value. */
+    double cost;
+    /*! \brief Whether the activation can be recomputed in the backward pass. */
+    bool droppable;
+  };
+
+  using ExprMutator::VisitExpr_;
+
+  explicit RematerializationPlanner(const IRModule& mod) : ExprMutator(mod), mod_(mod) {}
+
+  void CollectActivations(const DataflowBlock& block, const Expr& return_value) {
+    static const auto s_cp = Op::Get("relax.grad.start_checkpoint");
+    static const auto e_cp = Op::Get("relax.grad.end_checkpoint");
+    std::unordered_set<const VarNode*> outputs;
+    PostOrderVisit(return_value, [&](const Expr& expr) {
+      if (const auto* var = expr.as<VarNode>()) outputs.insert(var);
+    });
+
+    for (const Binding& binding : block->bindings) {
+      const auto* var_binding = binding.as<VarBindingNode>();
+      CHECK(var_binding) << "Now only support VarBindingNode";
+      const auto* call = var_binding->value.as<CallNode>();
+      CHECK(!call || (call->op != s_cp && call->op != e_cp))
+          << "The function already has checkpoints. The activations to rematerialize are only "
+             "chosen for the functions without start_checkpoint and end_checkpoint";
+
+      Activation activation;
+      bool uses_var = false;
+      PostOrderVisit(var_binding->value, [&](const Expr& expr) {
+        if (const auto* var = expr.as<VarNode>()) {
+          uses_var = true;
+          if (activations_.count(var)) activation.inputs.push_back(var);
+        }
+      });
+      activation.bytes = StaticBytes(GetStructInfo(var_binding->var));
+      activation.cost = EstimateCost(var_binding->value);
+      // An activation using no var cannot be marked as recomputed, since it depends on no
+      // checkpointed var.
+      activation.droppable = call && call->op->IsInstance<OpNode>() && activation.bytes &&
+                             uses_var && var_binding->var->IsInstance<DataflowVarNode>() &&
+                             !outputs.count(var_binding->var.get()) &&
+                             !ContainsImpureCall(var_binding->value);
+      activations_.emplace(var_binding->var.get(), std::move(activation));
+      order_.push_back(var_binding->var);
+    }
+    outputs_ = std::move(outputs);
+  }
+
+  /*!
+   * \brief Generate the backward pass with all the activations checkpointed, and collect the
+   * activations it uses.
+   */
+  void CollectBackwardUses(const DataflowBlock& block, const Array<Var>& require_grads,
+                           const Var& target, const Array<Var>& params,
+                           const Expr& return_value) {
+    BlockBuilder builder = BlockBuilder::Create(mod_);
+    builder->BeginDataflowBlock();
+    VarIdSet checkpoints;
+    for (const Var& param : params) {
+      checkpoints.insert(param->vid);
+    }
+    for (const Binding& binding : block->bindings) {
+      builder->EmitNormalized(binding);
+      checkpoints.insert(binding->var->vid);
+    }
+    Expr ret = BackwardBindingGenerator::Generate(builder, block, require_grads, target, params,
+                                                  return_value, checkpoints);
+    BindingBlock backward = builder->EndBlock();
+
+    // Only the live backward bindings use the activations.
+    std::unordered_set<const VarNode*> live;
+    auto mark_live = [&](const Expr& expr) {
+      PostOrderVisit(expr, [&](const Expr& e) {
+        if (const auto* var = e.as<VarNode>()) live.insert(var);
+      });
+    };
+    mark_live(ret);
+    for (auto it = backward->bindings.rbegin(); it != backward->bindings.rend(); ++it) {
+      const auto* var_binding = (*it).as<VarBindingNode>();
+      if (!var_binding || activations_.count(var_binding->var.get()) ||
+          !live.count(var_binding->var.get())) {
+        continue;
+      }
+      PostOrderVisit(var_binding->value, [&](const Expr& e) {
+        if (const auto* var = e.as<VarNode>()) {
+          live.insert(var);
+          if (activations_.count(var)) backward_uses_.insert(var);
+        }
+      });
+    }
+  }
+
+  /*! \brief The memory of the kept activations, and the cost of the recomputed ones. */
+  std::pair<int64_t, double> Evaluate(const std::unordered_set<const VarNode*>& dropped) const {
+    int64_t memory = 0;
+    double cost = 0;
+    std::unordered_set<const VarNode*> visited;
+    std::vector<const VarNode*> stack(backward_uses_.begin(), backward_uses_.end());
+    while (!stack.empty()) {
+      const VarNode* var = stack.back();
+      stack.pop_back();
+      if (!visited.insert(var).second) continue;
+      const Activation& activation = activations_.at(var);
+      if (!dropped.count(var)) {
+        // The outputs are live at the end of the function anyway.
+        if (!outputs_.count(var)) memory += activation.bytes.value_or(0);
+        continue;
+      }
+      cost += activation.cost;
+      stack.insert(stack.end(), activation.inputs.begin(), activation.inputs.end());
+    }
+    return {memory, cost};
+  }
+
+  void ChooseDropped(int64_t memory_budget) {
+    auto [memory, cost] = Evaluate(dropped_);
+    while (memory > memory_budget) {
+      const VarNode* best = nullptr;
+      double best_ratio = 0;
+      std::pair<int64_t, double> best_result;
+      for (const Var& var : order_) {
+        if (!activations_.at(var.get()).droppable || dropped_.count(var.get())) continue;
+        dropped_.insert(var.get());
+        auto result = Evaluate(dropped_);
+        dropped_.erase(var.get());
+        int64_t freed = memory - result.first;
+        if (freed <= 0) continue;
+        double ratio = freed / std::max(result.second - cost, 1.0);
+        if (ratio > best_ratio) {
+          best = var.get();
+          best_ratio = ratio;
+          best_result = result;
+        }
+      }
+      if (best == nullptr) {
+        LOG(WARNING) << "The activations cannot fit the memory budget of " << memory_budget
+                     << " bytes by rematerialization. The remaining activations take " << memory
+                     << " bytes";
+        break;
+      }
+      dropped_.insert(best);
+      std::tie(memory, cost) = best_result;
+    }
+  }
+
+  static std::optional<int64_t> StaticBytes(const StructInfo& sinfo) {
+    if (const auto* tensor = sinfo.as<TensorStructInfoNode>()) {
+      auto shape = tensor->GetShape();
+      if (!shape || tensor->IsUnknownDtype()) return std::nullopt;
+      int64_t bytes = (tensor->dtype.bits() * tensor->dtype.lanes() + 7) / 8;
+      for (const PrimExpr& dim : shape.value()) {
+        const auto* int_dim = dim.as<IntImmNode>();
+        if (!int_dim) return std::nullopt;
+        bytes *= int_dim->value;
+      }
+      return bytes;
+    } else if (const auto* tuple = sinfo.as<TupleStructInfoNode>()) {
+      int64_t bytes = 0;
+      for (const StructInfo& field : tuple->fields) {
+        auto field_bytes = StaticBytes(field);
+        if (!field_bytes) return std::nullopt;
+        bytes += field_bytes.value();
+      }
+      return bytes;
+    }
+    return std::nullopt;
+  }
+
+  /*! \brief Estimate the number of operations to compute a value. */
+  double EstimateCost(const Expr& value) const {
+    static const Op& matmul_op = Op::Get("relax.matmul");
+    static const Op& conv2d_op = Op::Get("relax.nn.conv2d");
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    static const Op& call_tir_with_grad_op = Op::Get("relax.call_tir_with_grad");
+    const auto* tensor = GetStructInfoAs<TensorStructInfoNode>(value);
+    auto bytes = StaticBytes(GetStructInfo(value));
+    double num_elements =
+        tensor && bytes ? bytes.value() * 8.0 / (tensor->dtype.bits() * tensor->dtype.lanes()) : 1;
+    const auto* call = value.as<CallNode>();
+    if (!call) return 0;
+
+    auto static_dim = [](const Expr& expr, int axis) -> double {
+      const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(expr);
+      if (!sinfo || !sinfo->GetShape()) return 1;
+      Array<PrimExpr> shape = sinfo->GetShape().value();
+      if (axis < 0) axis += shape.size();
+      const auto* dim = shape[axis].as<IntImmNode>();
+      return dim ? dim->value : 1;
+    };
+    if (call->op.same_as(matmul_op)) {
+      // Each output element is reduced over the last axis of the first operand.
+      return num_elements * static_dim(call->args[0], -1);
+    } else if (call->op.same_as(conv2d_op) &&
+               call->attrs.as<Conv2DAttrs>()->kernel_layout == "OIHW") {
+      return num_elements * static_dim(call->args[1], 1) * static_dim(call->args[1], 2) *
+             static_dim(call->args[1], 3);
+    } else if (call->op.same_as(call_tir_op) || call->op.same_as(call_tir_with_grad_op)) {
+      if (auto func = mod_->functions.Get(Downcast<GlobalVar>(call->args[0]))) {
+        if (const auto* prim_func = func.value().as<tir::PrimFuncNode>()) {
+          return tir::EstimateTIRFlops(prim_func->body);
+        }
+      }
+    }
+    return num_elements;
+  }
+
+  void VisitBinding_(const VarBindingNode* binding) final {
+    const VarNode* var = binding->var.get();
+    if (activations_.count(var)) {
+      marking_dropped_ = dropped_.count(var);
+      marking_ = true;
+    }
+    ExprMutator::VisitBinding_(binding);
+    marking_ = false;
+  }
+
+  Expr VisitExpr_(const VarNode* var) final { return MarkUse(GetRef<Var>(var)); }
+
+  Expr VisitExpr_(const DataflowVarNode* var) final { return MarkUse(GetRef<Var>(var)); }
+
+  /*!
+   * \brief Mark the use of a var in the value of an activation. A dropped activation is marked as
+   * recomputed by using the kept vars through start_checkpoint, and the kept activations use the
+   * dropped ones through end_checkpoint.
+   */
+  Expr MarkUse(const Var& var) {
+    Expr new_var = ExprMutator::VisitExpr_(var.get());
+    if (!marking_) return new_var;
+    bool is_dropped = dropped_.count(var.get());
+    if (marking_dropped_ && !is_dropped) {
+      return GetMarker(&start_markers_, new_var, start_checkpoint, "_scp");
+    } else if (!marking_dropped_ && is_dropped) {
+      return GetMarker(&end_markers_, new_var, end_checkpoint, "_ecp");
+    }
+    return new_var;
+  }
+
+  Var GetMarker(std::unordered_map<const Object*, Var>* markers, const Expr& var,
+                Expr (*marker)(Expr), const char* suffix) {
+    auto it = markers->find(var.get());
+    if (it != markers->end()) return it->second;
+    Var marked = builder_->Emit(marker(var), Downcast<Var>(var)->name_hint() + suffix);
+    markers->emplace(var.get(), marked);
+    return marked;
+  }
+
+  IRModule mod_;
+  /*! \brief The activations, i.e. the bindings of the forward pass, and their order. */
+  std::unordered_map<const VarNode*, Activation> activations_;
+  Array<Var> order_;
+  /*! \brief The vars returned by the function. */
+  std::unordered_set<const VarNode*> outputs_;
+  /*! \brief The activations used by the backward pass. */
+  std::unordered_set<const VarNode*> backward_uses_;
+  /*! \brief The activations to recompute in the backward pass. */
+  std::unordered_set<const VarNode*> dropped_;
+  /*! \brief The checkpoint markers emitted for each var. */
+  std::unordered_map<const Object*, Var> start_markers_;
+  std::unordered_map<const Object*, Var> end_markers_;
+  bool marking_{false};
+  bool marking_dropped_{false};
+};
+
 namespace transform {
 
 Pass Gradient(String func_name, Optional<Array<Var>> require_grads, int target_index) {
@@ -769,6 +1085,28 @@ Pass Gradient(String func_name, Optional<Array<Var>> require_grads, int target_i
 
 TVM_REGISTER_GLOBAL("relax.transform.Gradient").set_body_typed(Gradient);
 
+Pass AutoCheckpoint(String func_name, int64_t memory_budget, Optional<Array<Var>> require_grads,
+                    int target_index) {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func = [=](IRModule mod,
+                                                                            PassContext pc) {
+    GlobalVar gv = mod->GetGlobalVar(func_name);
+    auto func = mod->Lookup(gv).as<Function>();
+    CHECK(func) << func_name << "is not a Relax Function";
+    Function new_func = relax::RematerializationPlanner::Plan(
+        mod, func.value(), func_name, memory_budget, require_grads, target_index);
+    if (!new_func.same_as(func.value())) {
+      mod.CopyOnWrite()->Update(gv, new_func);
+    }
+    return mod;
+  };
+  return CreateModulePass(/*pass_function=*/pass_func,
+                          /*opt_level=*/0,
+                          /*pass_name=*/"AutoCheckpoint",
+                          /*required=*/{});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.AutoCheckpoint").set_body_typed(AutoCheckpoint);
+
 }  // namespace transform
 
 }  // namespace relax
@@ -0,0 +1,226 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/relax/transform/horizontal_fuse_ops.cc
+ * \brief Pass for fusing the independent small kernels of a dataflow block horizontally.
+ *
+ * The `call_tir` bindings of a dataflow block are grouped by their depth in the dataflow graph of
+ * the block and by the op pattern of the called PrimFunc. Each group of small kernels becomes a
+ * grouped function, which the following FuseTIR pass turns into a single PrimFunc. Since a binding
+ * only depends on bindings of smaller depths, the bindings of a group never depend on each other,
+ * and the grouped functions never introduce cyclic dependencies.
+ *
+ * Each grouped function is marked with the number of its members. FuseTIR forwards the mark to the
+ * fused PrimFunc, and once the PrimFunc is scheduled and lowered for a GPU target, the
+ * tir.HorizontalFuseKernels pass dispatches the kernels of the members over a shared blockIdx.x
+ * dimension, branching on the block index to the member that owns the block. A group whose
+ * members do not lower to one kernel each keeps running them one after another, which still saves
+ * the per-call overhead of the VM.
+ */
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/struct_info.h>
+#include <tvm/relax/transform.h>
+#include <tvm/tir/function.h>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../relay/analysis/graph_partitioner.h"
+#include "../../support/arena.h"
+#include "utils.h"
+
+namespace tvm {
+namespace relax {
+
+using relay::GraphPartitioner;
+using relay::OpPatternKind;
+
+class HorizontalFusionPartitioner : public ExprVisitor {
+ public:
+  using Group = GraphPartitioner::Group;
+  using GroupMap = std::unordered_map<const Object*, Group*>;
+
+  static GroupMap Run(const IRModule& mod, int max_group_size, int64_t max_num_elements,
+                      support::Arena* arena) {
+    HorizontalFusionPartitioner partitioner(mod, max_group_size, max_num_elements, arena);
+    for (const auto& [gv, func] : mod->functions) {
+      // Only visit Relax function without attr kPrimitive, as OperatorFusor does.
+      if (func->IsInstance<FunctionNode>() && !func->HasNonzeroAttr(attr::kPrimitive)) {
+        partitioner.VisitExpr(func);
+      }
+    }
+    return partitioner.group_map_;
+  }
+
+ private:
+  explicit HorizontalFusionPartitioner(IRModule mod, int max_group_size, int64_t max_num_elements,
+                                       support::Arena* arena)
+      : mod_(std::move(mod)),
+        max_group_size_(max_group_size),
+        max_num_elements_(max_num_elements),
+        arena_(arena) {}
+
+  void VisitVarDef(const Var& var) final { group_map_[var.get()] = arena_->make<Group>(); }
+
+  void VisitExpr_(const ConstantNode* op) final { group_map_[op] = arena_->make<Group>(); }
+
+  void VisitBindingBlock_(const DataflowBlockNode* block) final {
+    ExprVisitor::VisitBindingBlock_(block);
+
+    // The candidates of each depth and op pattern, in the order of the bindings.
+    std::map<std::pair<int, int>, std::vector<const VarNode*>> candidates;
+    std::unordered_map<const VarNode*, int> depth;
+    for (const Binding& binding : block->bindings) {
+      Expr value = binding.as<VarBindingNode>() ? Downcast<VarBinding>(binding)->value
+                                                : Downcast<MatchCast>(binding)->value;
+      int binding_depth = 0;
+      for (const Var& var : FreeVars(value)) {
+        auto it = depth.find(var.get());
+        if (it != depth.end()) {
+          binding_depth = std::max(binding_depth, it->second + 1);
+        }
+      }
+      depth[binding->var.get()] = binding_depth;
+      if (std::optional<OpPatternKind> pattern = GetFusiblePattern(binding)) {
+        candidates[{binding_depth, static_cast<int>(pattern.value())}].push_back(
+            binding->var.get());
+      }
+    }
+
+    for (const auto& [key, vars] : candidates) {
+      for (size_t begin = 0; begin + 1 < vars.size(); begin += max_group_size_) {
+        size_t end = std::min(vars.size(), begin + max_group_size_);
+        Group* group = group_map_[vars[begin]];
+        for (size_t i = begin + 1; i < end; ++i) {
+          Group* member = group_map_[vars[i]];
+          member->parent = group;
+          --member->num_nodes;
+          ++group->num_nodes;
+        }
+      }
+    }
+  }
+
+  /*!
+   * \brief The op pattern of the PrimFunc called by the binding, if it is a small kernel that can
+   * be fused horizontally.
+   */
+  std::optional<OpPatternKind> GetFusiblePattern(const Binding& binding) const {
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    const auto* var_binding = binding.as<VarBindingNode>();
+    if (var_binding == nullptr || !var_binding->var->IsInstance<DataflowVarNode>()) {
+      // The output vars of the block cannot be remapped to the fields of a tuple.
+      return std::nullopt;
+    }
+    const auto* call = var_binding->value.as<CallNode>();
+    if (call == nullptr || !call->op.same_as(call_tir_op) || call->args.size() != 2) {
+      return std::nullopt;
+    }
+    Optional<BaseFunc> func = mod_->functions.Get(Downcast<GlobalVar>(call->args[0]));
+    if (!func.defined() || !func.value()->IsInstance<tir::PrimFuncNode>()) {
+      return std::nullopt;
+    }
+    Optional<Integer> pattern = func.value()->GetAttr<Integer>("op_pattern");
+    if (!pattern.defined() || pattern.value()->value >= relay::kOpaque) {
+      return std::nullopt;
+    }
+
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(var_binding->var);
+    const auto* shape = sinfo ? sinfo->shape.as<ShapeExprNode>() : nullptr;
+    if (shape == nullptr) {
+      return std::nullopt;
+    }
+    int64_t num_elements = 1;
+    for (const PrimExpr& dim : shape->values) {
+      const auto* int_dim = dim.as<IntImmNode>();
+      if (int_dim == nullptr) {
+        return std::nullopt;
+      }
+      num_elements *= int_dim->value;
+    }
+    if (num_elements > max_num_elements_) {
+      return std::nullopt;
+    }
+    return static_cast<OpPatternKind>(pattern.value()->value);
+  }
+
+  IRModule mod_;
+  int max_group_size_;
+  int64_t max_num_elements_;
+  support::Arena* arena_;
+  GroupMap group_map_;
+};
+
+/*!
+ * \brief Mark the grouped functions created from the module with the number of their members.
+ * \param orig The module before grouping.
+ * \param mod The module after grouping.
+ * \return The module with the grouped functions marked.
+ */
+IRModule MarkHorizontalFusion(const IRModule& orig, IRModule mod) {
+  static const Op& call_tir_op = Op::Get("relax.call_tir");
+  std::vector<std::pair<GlobalVar, Function>> marked;
+  for (const auto& [gv, base_func] : mod->functions) {
+    const auto* func = base_func.as<FunctionNode>();
+    if (func == nullptr || !func->HasNonzeroAttr(attr::kPrimitive) || orig->functions.count(gv)) {
+      continue;
+    }
+    int num_kernels = 0;
+    PostOrderVisit(func->body, [&num_kernels](const Expr& e) {
+      if (const auto* call = e.as<CallNode>(); call && call->op.same_as(call_tir_op)) {
+        ++num_kernels;
+      }
+    });
+    marked.emplace_back(gv, WithAttr(GetRef<Function>(func), attr::kHorizontalFusion,
+                                     Integer(num_kernels)));
+  }
+  for (const auto& [gv, func] : marked) {
+    mod.CopyOnWrite()->Update(gv, func);
+  }
+  return mod;
+}
+
+namespace transform {
+
+Pass HorizontalFuseOps(int max_group_size, int64_t max_num_elements) {
+  CHECK_GE(max_group_size, 2) << "ValueError: The maximum group size must be at least 2, but got "
+                              << max_group_size;
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule m, PassContext pc) {
+        support::Arena arena;
+        auto partition =
+            HorizontalFusionPartitioner::Run(m, max_group_size, max_num_elements, &arena);
+        IRModule fused = MakeGroupedFunctions(m, partition, /*lift_constants=*/true);
+        return MarkHorizontalFusion(m, fused);
+      };
+  return CreateModulePass(pass_func, 0, "HorizontalFuseOps", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.HorizontalFuseOps").set_body_typed(HorizontalFuseOps);
+
+}  // namespace transform
+
+}  // namespace relax
+}  // namespace tvm
@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/relax/transform/overlap_allreduce.cc
+ * \brief Pass for overlapping the allreduces with the independent computation.
+ *
+ * Each `relax.ccl.allreduce` in a dataflow block is split into `runtime.disco.allreduce_start`,
+ * which launches the allreduce on a separate communication stream into a receive buffer passed in
+ * destination-passing style, and `runtime.disco.allreduce_wait`, which makes the following
+ * computation wait for the receive buffer and returns it. The receive buffer is allocated by the
+ * memory planning of the VM, which keeps it alive while the result of the wait is used.
+ * The bindings of the block are then list-scheduled in their original order, except that a wait
+ * is only scheduled when no other binding is ready, so that the computation independent of the
+ * allreduce runs while it is in flight.
+ *
+ * Since all the workers run the same program, the allreduces are started in the same order on all
+ * of them, as the collective communication library requires.
+ */
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/attrs/ccl.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tvm {
+namespace relax {
+
+class AllReduceOverlapper : public ExprMutator {
+ public:
+  explicit AllReduceOverlapper(IRModule mod) : ExprMutator(mod) {}
+
+  using ExprMutator::VisitBindingBlock_;
+
+  BindingBlock VisitBindingBlock_(const DataflowBlockNode* block) final {
+    static const Op& allreduce_op = Op::Get("relax.ccl.allreduce");
+    static const Op& call_pure_packed_op = Op::Get("relax.call_pure_packed");
+    static const Op& call_dps_packed_op = Op::Get("relax.call_dps_packed");
+    DataflowBlock visited = Downcast<DataflowBlock>(ExprMutator::VisitBindingBlock_(block));
+
+    // Split the allreduces into a start and a wait.
+    std::vector<Binding> nodes;
+    std::vector<bool> is_wait;
+    for (const Binding& binding : visited->bindings) {
+      const auto* var_binding = binding.as<VarBindingNode>();
+      const auto* call = var_binding ? var_binding->value.as<CallNode>() : nullptr;
+      const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(binding->var);
+      if (call == nullptr || !call->op.same_as(allreduce_op) || sinfo == nullptr ||
+          !sinfo->shape.as<ShapeExprNode>()) {
+        // The receive buffer can only be planned when its shape is known.
+        nodes.push_back(binding);
+        is_wait.push_back(false);
+        continue;
+      }
+      const auto* attrs = call->attrs.as<AllReduceAttrs>();
+      Expr start = builder_->Normalize(
+          Call(call_dps_packed_op,
+               {ExternFunc("runtime.disco.allreduce_start"),
+                Tuple({call->args[0],
+                       ShapeExpr({IntImm(DataType::Int(64), GetReduceKind(attrs->op_type))})})},
+               {}, {GetRef<TensorStructInfo>(sinfo)}));
+      DataflowVar recv(binding->var->name_hint() + "_recv", GetRef<TensorStructInfo>(sinfo));
+      Expr wait = builder_->Normalize(Call(
+          call_pure_packed_op, {ExternFunc("runtime.disco.allreduce_wait"), recv, call->args[0]},
+          {}, {GetRef<TensorStructInfo>(sinfo)}));
+      nodes.push_back(VarBinding(recv, start));
+      is_wait.push_back(false);
+      nodes.push_back(VarBinding(binding->var, wait));
+      is_wait.push_back(true);
+    }
+    if (nodes.size() == visited->bindings.size()) {
+      return visited;
+    }
+
+    // The dependencies of each binding on the previous ones.
+    std::unordered_map<const VarNode*, int> def_index;
+    std::vector<std::vector<int>> deps(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      Expr value = nodes[i].as<VarBindingNode>() ? Downcast<VarBinding>(nodes[i])->value
+                                                 : Downcast<MatchCast>(nodes[i])->value;
+      for (const Var& var : FreeVars(value)) {
+        auto it = def_index.find(var.get());
+        if (it != def_index.end()) {
+          deps[i].push_back(it->second);
+        }
+      }
+      def_index[nodes[i]->var.get()] = i;
+    }
+
+    // Schedule the bindings in order, deferring the waits until nothing else is ready.
+    std::vector<bool> scheduled(nodes.size(), false);
+    Array<Binding> bindings;
+    auto is_ready = [&](size_t i) {
+      if (scheduled[i]) return false;
+      for (int dep : deps[i]) {
+        if (!scheduled[dep]) return false;
+      }
+      return true;
+    };
+    while (bindings.size() < nodes.size()) {
+      int next = -1;
+      for (size_t i = 0; i < nodes.size() && next < 0; ++i) {
+        if (!is_wait[i] && is_ready(i)) next = i;
+      }
+      for (size_t i = 0; i < nodes.size() && next < 0; ++i) {
+        if (is_ready(i)) next = i;
+      }
+      ICHECK_GE(next, 0) << "The bindings of a dataflow block must not have cyclic dependencies";
+      scheduled[next] = true;
+      bindings.push_back(nodes[next]);
+    }
+    return DataflowBlock(bindings);
+  }
+
+ private:
+  static int GetReduceKind(const String& op_type) {
+    static const std::unordered_map<std::string, int> kinds = {
+        {"sum", 0}, {"prod", 1}, {"min", 2}, {"max", 3}, {"avg", 4}};
+    auto it = kinds.find(op_type);
+    CHECK(it != kinds.end()) << "ValueError: Unsupported reduction operation: " << op_type;
+    return it->second;
+  }
+};
+
+namespace transform {
+
+Pass OverlapAllReduce() {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        return Downcast<Function>(AllReduceOverlapper(m).VisitExpr(f));
+      };
+  return CreateFunctionPass(pass_func, 0, "OverlapAllReduce", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.OverlapAllReduce").set_body_typed(OverlapAllReduce);
+
+}  // namespace transform
+
+}  // namespace relax
+}  // namespace tvm
@@ -0,0 +1,288 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relax/transform/plan_persistent_workspace.cc
+ * \brief Hoist the statically planned storages into a workspace that is allocated once per VM.
+ *
+ * After `StaticPlanBlockMemory`, the tensors that can be statically planned are allocated from
+ * `R.memory.alloc_storage` with constant sizes. Each invocation of a function allocates these
+ * storages again. This pass hoists them into a persistent workspace:
+ *
+ * 1. For each eligible function, the static storages are grouped by their device index and
+ * storage scope, and sorted by size in decreasing order within each group.
+ *
+ * 2. The workspace has one slot per position in each group, whose size is the maximum over all
+ * the eligible functions. As the eligible functions never run concurrently, all of them share the
+ * same slots, and each function uses distinct slots for its own storages.
+ *
+ * 3. A new private function `kPersistentWorkspaceAllocFunc` allocating all the slots is added to
+ * the module. The VM invokes it once on initialization, and does not expose it to the users. Each
+ * `R.memory.alloc_storage` of the eligible functions is replaced with a lookup of its slot via
+ * `vm.builtin.get_persistent_workspace`.
+ *
+ * A function is eligible if it is exposed by the module, does not reference any other Relax
+ * function and is not referenced by any other Relax function, so that no two users of the
+ * workspace can be live at the same time within one invocation.
+ *
+ * The workspace belongs to the VM rather than to an invocation. The invocations of one VM must
+ * therefore be ordered on the device, as the synchronous calls and the pipelined invocations of
+ * `invoke_async` are, which run on the same stream. Invocations running concurrently on one VM,
+ * from several threads or on different streams, would overwrite the storages of each other.
+ */
+
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+#include <tvm/runtime/relax_vm/vm.h>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tvm {
+namespace relax {
+
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.backend.use_persistent_workspace", Bool);
+
+/*! \brief A static storage allocation of an eligible function. */
+struct StaticStorage {
+  /*! \brief The binding var of the `R.memory.alloc_storage`. */
+  const VarNode* var;
+  /*! \brief The size of the storage in bytes. */
+  int64_t bytes;
+};
+
+/*! \brief The group of storages that can share workspace slots. */
+using StorageGroupKey = std::pair<int64_t, std::string>;
+
+/*! \brief Collect the static storages of a function, grouped by device index and scope. */
+class StaticStorageCollector : public ExprVisitor {
+ public:
+  static std::map<StorageGroupKey, std::vector<StaticStorage>> Collect(const Function& func) {
+    StaticStorageCollector collector;
+    collector(func);
+    for (auto& [key, storages] : collector.groups_) {
+      std::stable_sort(storages.begin(), storages.end(),
+                       [](const StaticStorage& lhs, const StaticStorage& rhs) {
+                         return lhs.bytes > rhs.bytes;
+                       });
+    }
+    return std::move(collector.groups_);
+  }
+
+ private:
+  void VisitBinding_(const VarBindingNode* binding, const CallNode* call) final {
+    static const Op& mem_alloc_storage_op = Op::Get("relax.memory.alloc_storage");
+    if (call->op.same_as(mem_alloc_storage_op)) {
+      const auto* shape = call->args[0].as<ShapeExprNode>();
+      const auto* device_index = Downcast<PrimValue>(call->args[1])->value.as<IntImmNode>();
+      const auto* storage_scope = call->args[2].as<StringImmNode>();
+      if (shape != nullptr && shape->values.size() == 1 && device_index != nullptr &&
+          storage_scope != nullptr) {
+        if (const auto* bytes = shape->values[0].as<IntImmNode>()) {
+          groups_[{device_index->value, storage_scope->value}].push_back(
+              {binding->var.get(), bytes->value});
+        }
+      }
+    }
+    ExprVisitor::VisitBinding_(binding, call);
+  }
+
+  std::map<StorageGroupKey, std::vector<StaticStorage>> groups_;
+};
+
+/*! \brief Replace the static storages of a function with the persistent workspace slots. */
+class PersistentWorkspaceRewriter : public ExprMutator {
+ public:
+  static Function Rewrite(const Function& func,
+                          std::unordered_map<const VarNode*, int64_t> var2slot) {
+    PersistentWorkspaceRewriter rewriter(std::move(var2slot));
+    return Downcast<Function>(rewriter(func));
+  }
+
+ private:
+  explicit PersistentWorkspaceRewriter(std::unordered_map<const VarNode*, int64_t> var2slot)
+      : var2slot_(std::move(var2slot)) {}
+
+  void VisitBinding_(const VarBindingNode* binding, const CallNode* call) final {
+    static const Op& call_builtin_with_ctx_op = Op::Get("relax.call_builtin_with_ctx");
+    static const ExternFunc builtin_get_workspace("vm.builtin.get_persistent_workspace");
+    auto it = var2slot_.find(binding->var.get());
+    if (it == var2slot_.end()) {
+      ExprMutator::VisitBinding_(binding, call);
+      return;
+    }
+    Call get_slot(call_builtin_with_ctx_op,
+                  {builtin_get_workspace, Tuple({PrimValue::Int64(it->second)})}, Attrs(),
+                  {ObjectStructInfo()});
+    ReEmitBinding(binding, builder_->Normalize(get_slot));
+  }
+
+  std::unordered_map<const VarNode*, int64_t> var2slot_;
+};
+
+/*!
+ * \brief Get the Relax functions that can share the persistent workspace.
+ * \param mod The IRModule.
+ * \return The eligible functions.
+ */
+std::vector<GlobalVar> GetEligibleFunctions(const IRModule& mod) {
+  std::unordered_set<const GlobalVarNode*> relax_funcs;
+  for (const auto& [gv, func] : mod->functions) {
+    if (func->IsInstance<FunctionNode>()) {
+      relax_funcs.insert(gv.get());
+    }
+  }
+  // Functions that reference, or are referenced by, another Relax function may be live
+  // together with it, and cannot share the workspace.
+  std::unordered_set<const GlobalVarNode*> excluded;
+  for (const auto& [gv, func] : mod->functions) {
+    if (!func->IsInstance<FunctionNode>()) {
+      continue;
+    }
+    for (const GlobalVar& callee : AllGlobalVars(Downcast<Function>(func))) {
+      if (relax_funcs.count(callee.get())) {
+        excluded.insert(gv.get());
+        excluded.insert(callee.get());
+      }
+    }
+  }
+
+  std::vector<GlobalVar> eligible;
+  for (const auto& [gv, func] : mod->functions) {
+    if (!func->IsInstance<FunctionNode>() || excluded.count(gv.get()) ||
+        gv->name_hint == runtime::relax_vm::kPersistentWorkspaceAllocFunc ||
+        !func->GetAttr<String>(tvm::attr::kGlobalSymbol).defined()) {
+      continue;
+    }
+    eligible.push_back(gv);
+  }
+  // Sort for a deterministic slot assignment.
+  std::sort(eligible.begin(), eligible.end(), [](const GlobalVar& lhs, const GlobalVar& rhs) {
+    return lhs->name_hint < rhs->name_hint;
+  });
+  return eligible;
+}
+
+IRModule PlanPersistentWorkspace(IRModule mod) {
+  std::vector<GlobalVar> eligible = GetEligibleFunctions(mod);
+
+  // Step 1. Collect the static storages and assign them to slots.
+  // The slot sizes of each group, in decreasing order.
+  std::map<StorageGroupKey, std::vector<int64_t>> group2slot_bytes;
+  std::vector<std::pair<GlobalVar, std::map<StorageGroupKey, std::vector<StaticStorage>>>>
+      func_storages;
+  for (const GlobalVar& gv : eligible) {
+    auto groups = StaticStorageCollector::Collect(Downcast<Function>(mod->Lookup(gv)));
+    for (const auto& [key, storages] : groups) {
+      std::vector<int64_t>& slot_bytes = group2slot_bytes[key];
+      slot_bytes.resize(std::max(slot_bytes.size(), storages.size()), 0);
+      for (size_t i = 0; i < storages.size(); ++i) {
+        slot_bytes[i] = std::max(slot_bytes[i], storages[i].bytes);
+      }
+    }
+    func_storages.emplace_back(gv, std::move(groups));
+  }
+  if (group2slot_bytes.empty()) {
+    return mod;
+  }
+  CHECK(!mod->ContainGlobalVar(runtime::relax_vm::kPersistentWorkspaceAllocFunc))
+      << "ValueError: The function name " << runtime::relax_vm::kPersistentWorkspaceAllocFunc
+      << " is reserved for the persistent workspace";
+
+  // The index of the first slot of each group in the workspace.
+  std::map<StorageGroupKey, int64_t> group2slot_begin;
+  int64_t num_slots = 0;
+  for (const auto& [key, slot_bytes] : group2slot_bytes) {
+    group2slot_begin[key] = num_slots;
+    num_slots += slot_bytes.size();
+  }
+
+  // Step 2. Rewrite the eligible functions to use the workspace slots.
+  IRModule updates;
+  for (const auto& [gv, groups] : func_storages) {
+    std::unordered_map<const VarNode*, int64_t> var2slot;
+    for (const auto& [key, storages] : groups) {
+      for (size_t i = 0; i < storages.size(); ++i) {
+        var2slot[storages[i].var] = group2slot_begin[key] + i;
+      }
+    }
+    if (!var2slot.empty()) {
+      updates->Add(gv, PersistentWorkspaceRewriter::Rewrite(Downcast<Function>(mod->Lookup(gv)),
+                                                            std::move(var2slot)));
+    }
+  }
+
+  // Step 3. Add the function allocating the workspace.
+  static const Op& mem_alloc_storage_op = Op::Get("relax.memory.alloc_storage");
+  BlockBuilder builder = BlockBuilder::Create(NullOpt);
+  builder->BeginBindingBlock();
+  Array<Expr> slots;
+  for (const auto& [key, slot_bytes] : group2slot_bytes) {
+    const auto& [device_index, storage_scope] = key;
+    for (int64_t bytes : slot_bytes) {
+      Call alloc_storage(mem_alloc_storage_op,
+                         {ShapeExpr({IntImm(DataType::Int(64), bytes)}),
+                          PrimValue::Int64(device_index), StringImm(storage_scope),
+                          DataTypeImm(DataType::UInt(8))},
+                         Attrs());
+      slots.push_back(builder->Emit(alloc_storage, "workspace"));
+    }
+  }
+  Var output = builder->Emit(Tuple(slots));
+  BindingBlock block = builder->EndBlock();
+  Expr body = builder->Normalize(SeqExpr({block}, output));
+  Map<String, ObjectRef> attrs;
+  attrs.Set(relax::attr::kForcePure, Bool(true));
+  Function alloc_func(/*params=*/{}, body, GetStructInfo(output), /*is_pure=*/true,
+                      DictAttrs(attrs));
+
+  mod.CopyOnWrite();
+  mod->Update(updates);
+  mod->Add(GlobalVar(runtime::relax_vm::kPersistentWorkspaceAllocFunc), alloc_func);
+  return mod;
+}
+
+namespace transform {
+
+Pass PlanPersistentWorkspace() {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =  //
+      [=](IRModule mod, PassContext pc) {
+        bool use_persistent_workspace =
+            pc->GetConfig<Bool>("relax.backend.use_persistent_workspace")
+                .value_or(Bool(false))
+                ->value;
+        if (use_persistent_workspace) {
+          mod = ::tvm::relax::PlanPersistentWorkspace(std::move(mod));
+        }
+        return mod;
+      };
+  return CreateModulePass(pass_func, 0, "PlanPersistentWorkspace", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.PlanPersistentWorkspace")
+    .set_body_typed(PlanPersistentWorkspace);
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
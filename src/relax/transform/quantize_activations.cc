@@ -0,0 +1,317 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relax/transform/quantize_activations.cc
+ * \brief Post-training static quantization of the activations of matmul and conv2d to int8.
+ *
+ * The quantizable operators are the matmuls by a 2-D weight and the NCHW/OIHW conv2ds by a
+ * weight, in the top-level blocks of a function. Their activation, i.e. the data operand, is
+ * quantized symmetrically with a per-tensor scale found by calibration, and their weight with a
+ * per-output-channel scale computed from the weight itself.
+ *
+ * - InstrumentActivations adds a copy of the function which also returns the activations of the
+ *   quantizable operators, in binding order, to calibrate their scales.
+ * - QuantizeActivations rewrites the quantizable operators given the scales of their
+ *   activations, in the same order. The operators either compute on the quantize/dequantize
+ *   pairs of their operands, or are folded into the int8 operator with int32 accumulation,
+ *   rescaled to the original dtype.
+ */
+
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/attrs/linear_algebra.h>
+#include <tvm/relax/attrs/nn.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "../op/nn/convolution.h"
+#include "../op/tensor/binary.h"
+#include "../op/tensor/datatype.h"
+#include "../op/tensor/linear_algebra.h"
+#include "../op/tensor/manipulate.h"
+#include "../op/tensor/qdq.h"
+#include "../op/tensor/statistical.h"
+#include "../op/tensor/unary.h"
+#include "utils.h"
+
+namespace tvm {
+namespace relax {
+
+/*! \brief Visit the quantizable operators of a function in binding order. */
+class QuantizableOpMutator : public ExprMutator {
+ protected:
+  explicit QuantizableOpMutator(Optional<IRModule> mod) : ExprMutator(mod) {}
+
+  /*!
+   * \brief Rewrite a quantizable operator.
+   * \param binding The binding of the operator.
+   * \param call The call to the operator, with visited arguments.
+   * \param index The index of the operator in the function.
+   */
+  virtual void RewriteQuantizableOp(const VarBindingNode* binding, const Call& call,
+                                    int index) = 0;
+
+  Expr VisitExpr_(const FunctionNode* func) override {
+    // Only the top-level function is quantized, and the local functions are left as is.
+    if (seq_depth_ == 0) {
+      if (auto num_input = func->GetAttr<Integer>(attr::kNumInput)) {
+        for (size_t i = num_input.value()->value; i < func->params.size(); ++i) {
+          weights_.insert(func->params[i].get());
+        }
+      }
+    }
+    return ExprMutator::VisitExpr_(func);
+  }
+
+  Expr VisitExpr_(const SeqExprNode* seq) override {
+    ++seq_depth_;
+    Expr result = ExprMutator::VisitExpr_(seq);
+    --seq_depth_;
+    return result;
+  }
+
+  void VisitBinding_(const VarBindingNode* binding) override {
+    const auto* call = binding->value.as<CallNode>();
+    // The operators in nested blocks, e.g. the branches of an If, are left in float.
+    if (seq_depth_ != 1 || call == nullptr || !IsQuantizable(call)) {
+      ExprMutator::VisitBinding_(binding);
+      return;
+    }
+    Call visited = Downcast<Call>(VisitExpr(binding->value));
+    RewriteQuantizableOp(binding, visited, num_ops_++);
+  }
+
+  bool IsWeight(const Expr& expr) const {
+    return expr->IsInstance<ConstantNode>() || weights_.count(expr.as<VarNode>());
+  }
+
+  bool IsQuantizable(const CallNode* call) const {
+    static const Op& matmul_op = Op::Get("relax.matmul");
+    static const Op& conv2d_op = Op::Get("relax.nn.conv2d");
+    if (!call->op.same_as(matmul_op) && !call->op.same_as(conv2d_op)) {
+      return false;
+    }
+    const auto* data_sinfo = GetStructInfoAs<TensorStructInfoNode>(call->args[0]);
+    const auto* weight_sinfo = GetStructInfoAs<TensorStructInfoNode>(call->args[1]);
+    const auto* out_sinfo = GetStructInfoAs<TensorStructInfoNode>(GetRef<Call>(call));
+    if (!call->args[0]->IsInstance<VarNode>() || !IsWeight(call->args[1]) ||
+        data_sinfo == nullptr || weight_sinfo == nullptr || out_sinfo == nullptr ||
+        !weight_sinfo->GetShape().defined()) {
+      return false;
+    }
+    // The quantize op only takes float16 and float32.
+    DataType dtype = data_sinfo->dtype;
+    if ((dtype != DataType::Float(16) && dtype != DataType::Float(32)) ||
+        weight_sinfo->dtype != dtype || out_sinfo->dtype != dtype) {
+      return false;
+    }
+    if (call->op.same_as(matmul_op)) {
+      return weight_sinfo->ndim == 2;
+    }
+    const auto* attrs = call->attrs.as<Conv2DAttrs>();
+    return attrs->data_layout == "NCHW" && attrs->kernel_layout == "OIHW" &&
+           attrs->out_layout == "NCHW";
+  }
+
+  /*! \brief The weight parameters of the current function. */
+  std::unordered_set<const VarNode*> weights_;
+  int num_ops_{0};
+  int seq_depth_{0};
+};
+
+class ActivationInstrumenter : public QuantizableOpMutator {
+ public:
+  static IRModule Instrument(IRModule mod, const String& func_name) {
+    auto opt_func = mod->Lookup(func_name).as<Function>();
+    CHECK(opt_func) << "ValueError: " << func_name << " is not a Relax function";
+
+    ActivationInstrumenter instrumenter(mod);
+    Function func =
+        Downcast<Function>(instrumenter.VisitExpr(CopyWithNewVars(opt_func.value())));
+    SeqExpr seq = Downcast<SeqExpr>(func->body);
+    Expr ret =
+        instrumenter.builder_->Normalize(Tuple({seq->body, Tuple(instrumenter.activations_)}));
+    String name = func_name + "_calibrate";
+    // The copy is called with all the parameters, so that the weights are not lifted.
+    Function calibrate(func->params, SeqExpr(seq->blocks, ret), GetStructInfo(ret), func->is_pure,
+                       WithAttr(func->attrs, tvm::attr::kGlobalSymbol, name));
+    calibrate = WithoutAttr(std::move(calibrate), attr::kNumInput);
+
+    IRModule result = instrumenter.builder_->GetContextIRModule();
+    result->Add(GlobalVar(name), calibrate);
+    return result;
+  }
+
+ private:
+  explicit ActivationInstrumenter(IRModule mod) : QuantizableOpMutator(mod) {}
+
+  void RewriteQuantizableOp(const VarBindingNode* binding, const Call& call, int index) final {
+    Expr activation = call->args[0];
+    if (builder_->CurrentBlockIsDataFlow()) {
+      // Make the activation visible outside of the dataflow block.
+      activation = builder_->EmitOutput(activation);
+    }
+    activations_.push_back(activation);
+    ReEmitBinding(binding, call);
+  }
+
+  /*! \brief The activations of the quantizable operators, in binding order. */
+  Array<Expr> activations_;
+};
+
+class ActivationQuantizer : public QuantizableOpMutator {
+ public:
+  static IRModule Quantize(IRModule mod, const String& func_name, const Array<FloatImm>& scales,
+                           bool fold) {
+    GlobalVar gv = mod->GetGlobalVar(func_name);
+    auto opt_func = mod->Lookup(gv).as<Function>();
+    CHECK(opt_func) << "ValueError: " << func_name << " is not a Relax function";
+    ActivationQuantizer quantizer(mod, scales, fold);
+    Function func = Downcast<Function>(quantizer.VisitExpr(opt_func.value()));
+    CHECK_EQ(quantizer.num_ops_, static_cast<int>(scales.size()))
+        << "ValueError: " << func_name << " has " << quantizer.num_ops_
+        << " quantizable operators, but got " << scales.size() << " activation scales";
+    IRModule result = quantizer.builder_->GetContextIRModule();
+    result->Update(gv, func);
+    return result;
+  }
+
+ private:
+  ActivationQuantizer(IRModule mod, Array<FloatImm> scales, bool fold)
+      : QuantizableOpMutator(mod), scales_(std::move(scales)), fold_(fold) {}
+
+  BindingBlock VisitBindingBlock(const BindingBlock& block) final {
+    // The quantized weights are only visible in the block they are emitted in.
+    auto outer_weights = std::move(quantized_weights_);
+    quantized_weights_.clear();
+    BindingBlock result = ExprMutator::VisitBindingBlock(block);
+    quantized_weights_ = std::move(outer_weights);
+    return result;
+  }
+
+  /*!
+   * \brief Quantize a weight symmetrically to int8 with a scale per output channel.
+   * \return The quantized weight and its scales.
+   */
+  std::pair<Expr, Expr> QuantizeWeight(const Expr& weight, int channel_axis) {
+    auto it = quantized_weights_.find(weight.get());
+    if (it != quantized_weights_.end()) {
+      return it->second;
+    }
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(weight);
+    Array<Integer> reduce_axes;
+    for (int i = 0; i < sinfo->ndim; ++i) {
+      if (i != channel_axis) {
+        reduce_axes.push_back(i);
+      }
+    }
+    Expr absmax = builder_->Emit(relax::max(relax::abs(weight), reduce_axes, /*keepdims=*/false));
+    // Keep the scale of an all-zero channel positive.
+    absmax = builder_->Emit(maximum(absmax, MakeConstantScalar(1e-5, sinfo->dtype)));
+    Expr scale = builder_->Emit(divide(absmax, MakeConstantScalar(127, sinfo->dtype)));
+    Expr quantized = builder_->Emit(quantize(weight, scale, MakeConstantScalar(0, DataType::Int(8)),
+                                             channel_axis, DataType::Int(8)));
+    std::pair<Expr, Expr> result{quantized, scale};
+    quantized_weights_.emplace(weight.get(), result);
+    return result;
+  }
+
+  void RewriteQuantizableOp(const VarBindingNode* binding, const Call& call, int index) final {
+    static const Op& matmul_op = Op::Get("relax.matmul");
+    CHECK_LT(index, static_cast<int>(scales_.size()))
+        << "ValueError: got " << scales_.size()
+        << " activation scales, but there are more quantizable operators";
+    double activation_scale = scales_[index]->value;
+    if (activation_scale <= 0) {
+      // The activation was always zero during calibration.
+      ReEmitBinding(binding, call);
+      return;
+    }
+    bool is_matmul = call->op.same_as(matmul_op);
+    DataType dtype = GetStructInfoAs<TensorStructInfoNode>(call->args[0])->dtype;
+    Expr zero_point = MakeConstantScalar(0, DataType::Int(8));
+    Expr data_scale = MakeConstantScalar(activation_scale, dtype);
+    int channel_axis = is_matmul ? 1 : 0;
+
+    Expr data = builder_->Emit(
+        quantize(call->args[0], data_scale, zero_point, /*axis=*/-1, DataType::Int(8)));
+    auto [weight, weight_scale] = QuantizeWeight(call->args[1], channel_axis);
+
+    Expr result;
+    if (!fold_) {
+      data = builder_->Emit(dequantize(data, data_scale, zero_point, /*axis=*/-1, dtype));
+      weight = builder_->Emit(dequantize(weight, weight_scale, zero_point, channel_axis, dtype));
+      result = Call(call->op, {data, weight}, call->attrs, call->sinfo_args, call->span);
+    } else {
+      // Accumulate in int32, and rescale by the product of the scales of the operands.
+      Expr accumulated;
+      Expr scale = builder_->Emit(multiply(weight_scale, data_scale));
+      if (is_matmul) {
+        accumulated = builder_->Emit(matmul(data, weight, DataType::Int(32)));
+      } else {
+        auto attrs = make_object<Conv2DAttrs>(*call->attrs.as<Conv2DAttrs>());
+        attrs->out_dtype = DataType::Int(32);
+        accumulated = builder_->Emit(Call(call->op, {data, weight}, Attrs(attrs)));
+        // The output channels are the second axis of NCHW.
+        PrimExpr num_channels =
+            GetStructInfoAs<TensorStructInfoNode>(weight)->GetShape().value()[0];
+        PrimExpr one = IntImm(DataType::Int(64), 1);
+        scale = builder_->Emit(reshape(scale, Array<PrimExpr>{one, num_channels, one, one}));
+      }
+      result = multiply(builder_->Emit(astype(accumulated, dtype)), scale);
+    }
+    ReEmitBinding(binding, builder_->Normalize(result));
+  }
+
+  Array<FloatImm> scales_;
+  bool fold_;
+  /*! \brief The quantized weights and their scales in the current block. */
+  std::unordered_map<const Object*, std::pair<Expr, Expr>> quantized_weights_;
+};
+
+namespace transform {
+
+Pass InstrumentActivations(String func_name) {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule mod, PassContext pc) {
+        return ActivationInstrumenter::Instrument(mod, func_name);
+      };
+  return CreateModulePass(pass_func, 0, "InstrumentActivations", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.InstrumentActivations")
+    .set_body_typed(InstrumentActivations);
+
+Pass QuantizeActivations(String func_name, Array<FloatImm> scales, bool fold) {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule mod, PassContext pc) {
+        return ActivationQuantizer::Quantize(mod, func_name, scales, fold);
+      };
+  return CreateModulePass(pass_func, 0, "QuantizeActivations", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.QuantizeActivations").set_body_typed(QuantizeActivations);
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
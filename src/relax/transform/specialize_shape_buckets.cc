@@ -0,0 +1,294 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relax/transform/specialize_shape_buckets.cc
+ * \brief Specialize a dynamic-shape function for a set of values of one symbolic variable.
+ *
+ * For each bucket value, a copy of the function with the symbolic variable bound to the value is
+ * added to the module, along with a copy of the generic function. The function itself is replaced
+ * with a dispatcher which, at call time, selects the specialized copy matching the value of the
+ * variable, and falls back to the generic copy otherwise. As the specialized copies only have
+ * static shapes, the kernels they lower to can be scheduled and tuned for their exact shape.
+ *
+ * With padding enabled, the dispatcher selects the smallest bucket covering the value instead of
+ * an exact match. The input dimensions equal to the variable are padded with zeros up to the
+ * bucket value, and the output dimensions equal to the variable are sliced back. This is only
+ * correct when the padded entries do not change the others, e.g. when the variable is a batch
+ * dimension, which the pass cannot check.
+ */
+
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+#include <tvm/relax/utils.h>
+#include <tvm/tir/analysis.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../op/tensor/create.h"
+#include "../op/tensor/index.h"
+#include "../op/tensor/manipulate.h"
+
+namespace tvm {
+namespace relax {
+
+class ShapeBucketSpecializer {
+ public:
+  static IRModule Specialize(IRModule mod, const String& func_name, const String& var_name,
+                             const Array<IntImm>& buckets, bool pad) {
+    GlobalVar gv = mod->GetGlobalVar(func_name);
+    auto opt_func = mod->Lookup(gv).as<Function>();
+    CHECK(opt_func) << "ValueError: " << func_name << " is not a Relax function";
+    Function func = opt_func.value();
+
+    // Find the symbolic variable defined by the parameters.
+    Optional<tir::Var> opt_var;
+    for (const Var& param : func->params) {
+      for (const tir::Var& var : DefinableTIRVarsInStructInfo(GetStructInfo(param))) {
+        if (var->name_hint == var_name) {
+          CHECK(!opt_var.defined() || opt_var.same_as(var))
+              << "ValueError: " << func_name << " has multiple symbolic variables named "
+              << var_name;
+          opt_var = var;
+        }
+      }
+    }
+    CHECK(opt_var.defined()) << "ValueError: The parameters of " << func_name
+                             << " do not define a symbolic variable named " << var_name;
+    tir::Var var = opt_var.value();
+
+    std::vector<int64_t> values;
+    for (const IntImm& bucket : buckets) {
+      CHECK_GT(bucket->value, 0) << "ValueError: The shape buckets must be positive";
+      values.push_back(bucket->value);
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    ShapeBucketSpecializer specializer(mod, func, var, pad);
+    if (pad) {
+      specializer.CheckPaddable();
+    }
+    // The generic and specialized copies are only called by the dispatcher.
+    Function generic = WithoutAttr(CopyWithNewVars(func), tvm::attr::kGlobalSymbol);
+    specializer.generic_ = specializer.AddFunction(func_name + "_generic", generic);
+    for (int64_t value : values) {
+      Function specialized = Downcast<Function>(
+          Bind(CopyWithNewVars(func), {}, {{var, IntImm(var->dtype, value)}}));
+      specialized = WithoutAttr(std::move(specialized), tvm::attr::kGlobalSymbol);
+      std::string name = std::string(func_name) + "_" + std::string(var_name) +
+                         std::to_string(value);
+      specializer.specialized_.emplace_back(value, specializer.AddFunction(name, specialized));
+    }
+
+    Function dispatcher = specializer.MakeDispatcher();
+    IRModule result = specializer.builder_->GetContextIRModule();
+    result->Update(gv, dispatcher);
+    return result;
+  }
+
+ private:
+  ShapeBucketSpecializer(IRModule mod, Function func, tir::Var var, bool pad)
+      : builder_(BlockBuilder::Create(mod)),
+        func_(std::move(func)),
+        var_(std::move(var)),
+        pad_(pad) {}
+
+  /*! \brief Whether a shape value is exactly the symbolic variable. */
+  bool IsVar(const PrimExpr& value) const { return value.same_as(var_); }
+
+  /*! \brief Whether a shape value uses the symbolic variable. */
+  bool UsesVar(const PrimExpr& value) const {
+    return tir::UsesVar(value, [this](const tir::VarNode* v) { return v == var_.get(); });
+  }
+
+  /*!
+   * \brief Check that the variable only appears as whole dimensions of the tensor parameters and
+   * outputs, so that they can be padded and sliced.
+   */
+  void CheckPaddable() const {
+    auto check_tensor = [this](const StructInfo& sinfo, const char* kind) {
+      if (const auto* tensor = sinfo.as<TensorStructInfoNode>()) {
+        if (auto shape = tensor->GetShape()) {
+          for (const PrimExpr& dim : shape.value()) {
+            CHECK(IsVar(dim) || !UsesVar(dim))
+                << "ValueError: Cannot pad " << kind << " with shape " << shape.value()
+                << ", as the dimension " << dim << " is not exactly " << var_->name_hint;
+          }
+          return;
+        }
+      }
+      for (const tir::Var& v : TIRVarsInStructInfo(sinfo)) {
+        CHECK(!v.same_as(var_)) << "ValueError: Cannot pad " << kind << " of struct info "
+                                << sinfo << ", which uses " << var_->name_hint;
+      }
+    };
+    for (const Var& param : func_->params) {
+      check_tensor(GetStructInfo(param), "the parameter");
+    }
+    if (const auto* tuple = func_->ret_struct_info.as<TupleStructInfoNode>()) {
+      for (const StructInfo& field : tuple->fields) {
+        check_tensor(field, "the output");
+      }
+    } else {
+      check_tensor(func_->ret_struct_info, "the output");
+    }
+  }
+
+  GlobalVar AddFunction(const std::string& name, const Function& func) {
+    GlobalVar gv(name);
+    UpdateStructInfo(gv, GetStructInfo(func));
+    builder_->UpdateFunction(gv, func);
+    return gv;
+  }
+
+  /*! \brief Pad the dimensions of a tensor equal to the variable to `value`, with zeros. */
+  Expr Pad(Expr tensor, int64_t value) {
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(tensor);
+    if (sinfo == nullptr || !sinfo->GetShape().defined()) {
+      return tensor;
+    }
+    Array<PrimExpr> shape = sinfo->GetShape().value();
+    PrimExpr bucket = IntImm(var_->dtype, value);
+    for (size_t axis = 0; axis < shape.size(); ++axis) {
+      if (!IsVar(shape[axis])) {
+        continue;
+      }
+      Array<PrimExpr> pad_shape = shape;
+      pad_shape.Set(axis, bucket - var_);
+      Expr zeros = builder_->Emit(relax::zeros(ShapeExpr(pad_shape), sinfo->dtype));
+      tensor = builder_->Emit(concat(Tuple({tensor, zeros}), Integer(axis)));
+      shape.Set(axis, bucket);
+    }
+    return tensor;
+  }
+
+  /*! \brief Slice the dimensions of an output equal to the variable back from `value`. */
+  Expr Slice(Expr output, const StructInfo& generic_sinfo) {
+    const auto* sinfo = generic_sinfo.as<TensorStructInfoNode>();
+    if (sinfo == nullptr || !sinfo->GetShape().defined()) {
+      return output;
+    }
+    Array<PrimExpr> shape = sinfo->GetShape().value();
+    for (size_t axis = 0; axis < shape.size(); ++axis) {
+      if (IsVar(shape[axis])) {
+        output = builder_->Emit(strided_slice(output, {Integer(axis)},
+                                              {IntImm(var_->dtype, 0)}, {var_}, NullOpt,
+                                              /*assume_inbound=*/true));
+      }
+    }
+    return output;
+  }
+
+  /*! \brief Call the specialized copy of the function for a bucket. */
+  Expr CallSpecialized(int64_t value, const GlobalVar& gv) {
+    auto callee = Downcast<Function>(builder_->GetContextIRModule()->Lookup(gv));
+    Array<Expr> args;
+    for (size_t i = 0; i < func_->params.size(); ++i) {
+      Expr arg = func_->params[i];
+      if (pad_) {
+        arg = Pad(arg, value);
+      }
+      // Recover the static shapes, which the branch condition guarantees.
+      StructInfo param_sinfo = GetStructInfo(callee->params[i]);
+      if (!StructuralEqual()(GetStructInfo(arg), param_sinfo)) {
+        arg = builder_->EmitMatchCast(arg, param_sinfo);
+      }
+      args.push_back(arg);
+    }
+    Expr output = builder_->Emit(Call(gv, args));
+    if (!pad_) {
+      return output;
+    }
+    if (const auto* tuple = func_->ret_struct_info.as<TupleStructInfoNode>()) {
+      Array<Expr> fields;
+      for (size_t i = 0; i < tuple->fields.size(); ++i) {
+        Expr field = builder_->Emit(TupleGetItem(output, i));
+        fields.push_back(Slice(field, tuple->fields[i]));
+      }
+      return builder_->Emit(Tuple(fields));
+    }
+    return Slice(output, func_->ret_struct_info);
+  }
+
+  /*! \brief Make the branch of the dispatcher selecting between the buckets from `index`. */
+  SeqExpr MakeBranch(size_t index) {
+    builder_->BeginBindingBlock();
+    Expr output;
+    if (index == specialized_.size()) {
+      output = builder_->Emit(
+          Call(generic_, Array<Expr>(func_->params.begin(), func_->params.end())));
+    } else {
+      auto [value, gv] = specialized_[index];
+      PrimExpr bucket = IntImm(var_->dtype, value);
+      PrimExpr cond = pad_ ? (var_ <= bucket) : (var_ == bucket);
+      SeqExpr then_branch = MakeSpecializedBranch(value, gv);
+      SeqExpr else_branch = MakeBranch(index + 1);
+      output = builder_->Emit(
+          If(PrimValue(tir::Cast(DataType::Int(64), cond)), then_branch, else_branch));
+    }
+    BindingBlock block = builder_->EndBlock();
+    return SeqExpr({block}, output);
+  }
+
+  SeqExpr MakeSpecializedBranch(int64_t value, const GlobalVar& gv) {
+    builder_->BeginBindingBlock();
+    Expr output = CallSpecialized(value, gv);
+    if (!output->IsInstance<VarNode>()) {
+      output = builder_->Emit(output);
+    }
+    BindingBlock block = builder_->EndBlock();
+    return SeqExpr({block}, output);
+  }
+
+  Function MakeDispatcher() {
+    builder_->BeginScope(func_->params);
+    SeqExpr body = MakeBranch(0);
+    builder_->EndScope();
+    Function dispatcher(func_->params, body, func_->ret_struct_info, func_->is_pure, func_->attrs,
+                        func_->span);
+    return Downcast<Function>(builder_->Normalize(dispatcher));
+  }
+
+  BlockBuilder builder_;
+  Function func_;
+  tir::Var var_;
+  bool pad_;
+  GlobalVar generic_;
+  std::vector<std::pair<int64_t, GlobalVar>> specialized_;
+};
+
+namespace transform {
+
+Pass SpecializeShapeBuckets(String func_name, String var_name, Array<IntImm> buckets, bool pad) {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule mod, PassContext pc) {
+        return ShapeBucketSpecializer::Specialize(mod, func_name, var_name, buckets, pad);
+      };
+  return CreateModulePass(pass_func, 0, "SpecializeShapeBuckets", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.SpecializeShapeBuckets")
+    .set_body_typed(SpecializeShapeBuckets);
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
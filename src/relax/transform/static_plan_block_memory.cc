@@ -64,16 +64,32 @@
  * It means the maximum value of variable that names "n" in the function
  * signature will have upper bound 1024. And we will use 1024 as its value
  * during memory planning.
+ *
+ * Alternatively, when the pass config "relax.StaticPlanBlockMemory.arena_planning"
+ * is set, the second stage is replaced by arena planning. Instead of reusing
+ * tokens greedily one alloc_tensor at a time, we compute the liveness interval
+ * of every token in a binding block and assign each token an offset into a
+ * single arena per block and device, using a best-fit-decreasing interval
+ * packing heuristic. In this mode, tensor sizes that only depend on the TIR
+ * variables in the function signature are kept symbolic, so that the arena and
+ * the offsets inside it are computed per call from the actual shape values
+ * rather than from the annotated upper bounds.
  */
 #include <tvm/arith/analyzer.h>
 #include <tvm/relax/analysis.h>
 #include <tvm/relax/expr_functor.h>
 #include <tvm/relax/nested_msg.h>
 #include <tvm/relax/transform.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/tir/analysis.h>
+#include <tvm/tir/op.h>
 #include <tvm/tir/stmt_functor.h>
 
+#include <algorithm>
 #include <map>
 #include <set>
+#include <tuple>
+#include <unordered_set>
 #include <vector>
 
 namespace tvm {
@@ -104,6 +120,12 @@ class StorageTokenNode : public Object {
   DataType dtype;
   /*! \brief The storage id, reserved for debug and demo use. */
   int storage_id{-1};
+  /*!
+   * \brief The number of bytes in terms of the TIR vars in the function signature.
+   * Only defined for tokens of dynamic size, which are created in arena planning mode.
+   * In such case, `bytes` is an estimation used for ordering, or -1 if unknown.
+   */
+  PrimExpr symbolic_bytes;
 
   static constexpr const char* _type_key = "relax.transform.StorageToken";
   TVM_DECLARE_BASE_OBJECT_INFO(StorageTokenNode, Object);
@@ -130,6 +152,14 @@ class StorageToken : public ObjectRef {
     data_ = std::move(n);
   }
 
+  explicit StorageToken(PrimExpr symbolic_bytes, int64_t estimated_bytes, DataType dtype) {
+    ObjectPtr<StorageTokenNode> n = make_object<StorageTokenNode>();
+    n->bytes = estimated_bytes;
+    n->symbolic_bytes = std::move(symbolic_bytes);
+    n->dtype = dtype;
+    data_ = std::move(n);
+  }
+
   TVM_DEFINE_MUTABLE_NOTNULLABLE_OBJECT_REF_METHODS(StorageToken, ObjectRef, StorageTokenNode);
 };
 
@@ -228,9 +258,149 @@ class TokenAllocator1D {
   std::vector<StorageToken> full_pool_;
 };
 
+/*!
+ * \brief Offset assignment of storage tokens into a single flattened 1d arena.
+ * \details Each token comes with its liveness interval, i.e., the indices of the
+ * first and the last binding that use it. Tokens are placed in decreasing order of
+ * size (best-fit-decreasing). When all the sizes are static, each token is put into
+ * the tightest gap between the already placed tokens whose lifetime overlaps with it.
+ * When some size is symbolic, gaps cannot be compared at compile time, and each token
+ * is stacked on top of all the already placed overlapping tokens instead, which keeps
+ * the placement valid for any value of the TIR vars.
+ */
+class TokenArenaPacker1D {
+ public:
+  /*!
+   * \brief Add a token to be placed in the arena.
+   * \param token The token.
+   * \param start The index of the binding where the token is allocated.
+   * \param end The index of the last binding using the token.
+   */
+  void Add(StorageToken token, int start, int end) {
+    items_.push_back({token, start, end, static_cast<int>(items_.size())});
+  }
+
+  /*!
+   * \brief Assign the offsets of all the added tokens.
+   * \param ana The arithmetic analyzer for simplifying symbolic offsets.
+   * \param offsets The mapping to which the offset of each token is written.
+   * \return The total number of bytes of the arena.
+   */
+  PrimExpr Pack(arith::Analyzer* ana,
+                std::unordered_map<const StorageTokenNode*, PrimExpr>* offsets) {
+    std::sort(items_.begin(), items_.end(), [](const Item& lhs, const Item& rhs) {
+      int64_t lhs_bytes = lhs.EstimatedBytes();
+      int64_t rhs_bytes = rhs.EstimatedBytes();
+      if (lhs_bytes != rhs_bytes) return lhs_bytes > rhs_bytes;
+      if (lhs.start != rhs.start) return lhs.start < rhs.start;
+      return lhs.order < rhs.order;
+    });
+    bool is_static = std::all_of(items_.begin(), items_.end(), [](const Item& item) {
+      return !item.token->symbolic_bytes.defined();
+    });
+    return is_static ? PackStatic(offsets) : PackSymbolic(ana, offsets);
+  }
+
+ private:
+  struct Item {
+    StorageToken token;
+    int start;
+    int end;
+    /*! \brief The order in which the token is added, for deterministic tie-breaking. */
+    int order;
+
+    int64_t EstimatedBytes() const {
+      return token->bytes < 0 ? std::numeric_limits<int64_t>::max() : token->bytes;
+    }
+
+    bool Overlaps(const Item& other) const { return start <= other.end && other.start <= end; }
+  };
+
+  static int64_t AlignUp(int64_t bytes) {
+    return (bytes + runtime::kAllocAlignment - 1) / runtime::kAllocAlignment *
+           runtime::kAllocAlignment;
+  }
+
+  static PrimExpr AlignUp(PrimExpr bytes) {
+    PrimExpr alignment = IntImm(DataType::Int(64), runtime::kAllocAlignment);
+    return floordiv(bytes + alignment - 1, alignment) * alignment;
+  }
+
+  PrimExpr PackStatic(std::unordered_map<const StorageTokenNode*, PrimExpr>* offsets) {
+    // The placed tokens, as tuples of (offset, aligned size, item).
+    std::vector<std::tuple<int64_t, int64_t, const Item*>> placed;
+    int64_t total_bytes = 0;
+    for (const Item& item : items_) {
+      int64_t size = AlignUp(item.token->bytes);
+      std::vector<std::pair<int64_t, int64_t>> conflicts;
+      for (const auto& [offset, placed_size, placed_item] : placed) {
+        if (item.Overlaps(*placed_item)) {
+          conflicts.emplace_back(offset, placed_size);
+        }
+      }
+      std::sort(conflicts.begin(), conflicts.end());
+      // Find the smallest gap between conflicting tokens that fits the token.
+      int64_t best_offset = -1;
+      int64_t best_gap = std::numeric_limits<int64_t>::max();
+      int64_t prev_end = 0;
+      for (const auto& [offset, conflict_size] : conflicts) {
+        int64_t gap = offset - prev_end;
+        if (gap >= size && gap < best_gap) {
+          best_offset = prev_end;
+          best_gap = gap;
+        }
+        prev_end = std::max(prev_end, offset + conflict_size);
+      }
+      if (best_offset == -1) {
+        best_offset = prev_end;
+      }
+      placed.emplace_back(best_offset, size, &item);
+      offsets->insert({item.token.get(), IntImm(DataType::Int(64), best_offset)});
+      total_bytes = std::max(total_bytes, best_offset + size);
+    }
+    return IntImm(DataType::Int(64), total_bytes);
+  }
+
+  PrimExpr PackSymbolic(arith::Analyzer* ana,
+                        std::unordered_map<const StorageTokenNode*, PrimExpr>* offsets) {
+    // The placed tokens, as pairs of (end of the token in the arena, item).
+    std::vector<std::pair<PrimExpr, const Item*>> placed;
+    PrimExpr total_bytes = IntImm(DataType::Int(64), 0);
+    for (const Item& item : items_) {
+      PrimExpr size = item.token->symbolic_bytes.defined()
+                          ? AlignUp(item.token->symbolic_bytes)
+                          : IntImm(DataType::Int(64), AlignUp(item.token->bytes));
+      PrimExpr offset = IntImm(DataType::Int(64), 0);
+      for (const auto& [placed_end, placed_item] : placed) {
+        if (item.Overlaps(*placed_item)) {
+          offset = max(offset, placed_end);
+        }
+      }
+      offset = ana->Simplify(offset);
+      PrimExpr end = ana->Simplify(offset + size);
+      placed.emplace_back(end, &item);
+      offsets->insert({item.token.get(), offset});
+      total_bytes = max(total_bytes, end);
+    }
+    return ana->Simplify(total_bytes);
+  }
+
+  /*! \brief The tokens to be placed. */
+  std::vector<Item> items_;
+};
+
 /*! \brief Check if the input op is "relax.reshape". */
 bool IsReshape(const Expr& op) { return op.same_as(Op::Get("relax.reshape")); }
 
+/*!
+ * \brief Check if the call waits for an asynchronous allreduce. The wait returns the receive
+ * buffer of the allreduce, which is its first argument.
+ */
+bool IsAllReduceWait(const CallNode* call) {
+  const auto* extern_func = call->op.as<ExternFuncNode>();
+  return extern_func != nullptr && extern_func->global_symbol == "runtime.disco.allreduce_wait";
+}
+
 /*! \brief The base class for the storage allocation visitor. */
 class StorageAllocatorBaseVisitor : public ExprVisitor {
  protected:
@@ -303,10 +473,13 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
   /*!
    * \brief The entry of the initialization.
    * \param mod The IRModule to be planned
+   * \param arena_planning Whether tokens are created for arena planning, in which
+   * case token sizes depending on the function signature are kept symbolic.
    * \return The mapping from each Expr to the token it uses.
    */
-  static std::unordered_map<const ExprNode*, Tokens> Initialize(const IRModule& mod) {
-    StorageAllocatorInit initializer(mod);
+  static std::unordered_map<const ExprNode*, Tokens> Initialize(const IRModule& mod,
+                                                                bool arena_planning) {
+    StorageAllocatorInit initializer(mod, arena_planning);
 
     for (auto it : mod->functions) {
       const auto* func = it.second.as<FunctionNode>();
@@ -321,7 +494,8 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
  private:
   using ExprVisitor::VisitExpr_;
 
-  explicit StorageAllocatorInit(const IRModule& ctx_mod) : ctx_mod_(ctx_mod) {}
+  explicit StorageAllocatorInit(const IRModule& ctx_mod, bool arena_planning)
+      : ctx_mod_(ctx_mod), arena_planning_(arena_planning) {}
 
   void VisitExpr_(const FunctionNode* func) final {
     // Use the attribute-annotated TIR var upper bounds as the TIR var values for
@@ -332,6 +506,7 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
         func->GetAttr<Map<String, IntImm>>("tir_var_upper_bound").value_or(Map<String, IntImm>());
     Array<tir::Var> var_in_signature = TIRVarsInStructInfo(GetStructInfo(GetRef<Function>(func)));
     var_upper_bound_.clear();
+    var_in_signature_ = {var_in_signature.begin(), var_in_signature.end()};
     for (const tir::Var& tir_var : var_in_signature) {
       auto it = var_upper_bound_attr.find(tir_var->name_hint);
       if (it != var_upper_bound_attr.end()) {
@@ -376,6 +551,10 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
         Tokens tokens = GetTokensWithAllocSiteCheck(arg, block_stack_.back());
         ForEachLeaf(tokens, [](StorageToken token) { token->ref_counter += 1; });
       }
+      if (IsAllReduceWait(call)) {
+        // The result of the wait uses the storage of the receive buffer.
+        SetTokens(call, GetTokens(call->args[0]));
+      }
     } else {
       for (const Expr& arg : call->args) {
         DiscardTokensIn(GetTokens(arg));
@@ -442,28 +621,30 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
     ICHECK(!token_map_.count(call));
 
     // Use the upper bounds of TIR vars as their values.
+    // In arena planning, the dimensions depending only on the TIR vars in the function
+    // signature are kept symbolic, as their values are known on function entry.
     Array<PrimExpr> upper_bounded_shape;
     upper_bounded_shape.reserve(shape->values.size());
+    bool is_static = true;
     for (const PrimExpr& dim_len : shape->values) {
       int64_t max_bound = ana_.const_int_bound(dim_len)->max_value;
-      if (max_bound == std::numeric_limits<int64_t>::max()) {
+      if (dim_len->IsInstance<IntImmNode>()) {
         upper_bounded_shape.push_back(dim_len);
-      } else {
-        upper_bounded_shape.push_back(tvm::IntImm(DataType::Int(64), max_bound));
-      }
-    }
-
-    // No support for TIR vars that are not bounded.
-    for (const PrimExpr& dim_len : upper_bounded_shape) {
-      const auto* int_len = dim_len.as<IntImmNode>();
-      if (!int_len) {
+      } else if (arena_planning_ && IsSignatureDependent(dim_len)) {
+        upper_bounded_shape.push_back(dim_len);
+        is_static = false;
+      } else if (max_bound == std::numeric_limits<int64_t>::max()) {
+        // No support for TIR vars that are not bounded.
         token_map_[call] = Tokens();
         return Tokens();
+      } else {
+        upper_bounded_shape.push_back(tvm::IntImm(DataType::Int(64), max_bound));
       }
     }
 
     // Create and set token.
-    StorageToken token(upper_bounded_shape, sinfo->dtype);
+    StorageToken token = is_static ? StorageToken(upper_bounded_shape, sinfo->dtype)
+                                   : CreateSymbolicToken(upper_bounded_shape, sinfo->dtype);
 
     Tokens tokens(token);
     SetTokens(call, tokens);
@@ -472,6 +653,34 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
     return tokens;
   }
 
+  /*! \brief Check if the input expression only depends on the TIR vars in the function signature. */
+  bool IsSignatureDependent(const PrimExpr& expr) {
+    for (const tir::Var& var : tir::UndefinedVars(expr)) {
+      if (!var_in_signature_.count(var)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /*!
+   * \brief Create a token whose size is symbolic in the TIR vars of the function signature.
+   * \param shape The tensor shape.
+   * \param dtype The tensor dtype.
+   * \return The created token.
+   */
+  StorageToken CreateSymbolicToken(const Array<PrimExpr>& shape, DataType dtype) {
+    PrimExpr bytes = IntImm(DataType::Int(64), dtype.bytes() * dtype.lanes());
+    for (const PrimExpr& dim_len : shape) {
+      bytes = bytes * cast(DataType::Int(64), dim_len);
+    }
+    bytes = ana_.Simplify(bytes);
+    // The upper bound of the size, if any, is used for ordering the tokens.
+    int64_t max_bound = ana_.const_int_bound(bytes)->max_value;
+    int64_t estimated_bytes = max_bound == std::numeric_limits<int64_t>::max() ? -1 : max_bound;
+    return StorageToken(bytes, estimated_bytes, dtype);
+  }
+
   /*!
    * \brief Override the token setter in the base visitor.
    * For each token, we keep record of all Expr that are using that token.
@@ -535,6 +744,10 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
    * a PrimFunc inside the IRModule.
    */
   const IRModule& ctx_mod_;
+  /*! \brief Whether the tokens are created for arena planning. */
+  bool arena_planning_;
+  /*! \brief The TIR vars in the signature of the function being visited. */
+  std::unordered_set<tir::Var, ObjectPtrHash, ObjectPtrEqual> var_in_signature_;
   /*! \brief The mapping from TIR variables to their respective upper bound values. */
   std::unordered_map<tir::Var, IntImm, ObjectPtrHash, ObjectPtrEqual> var_upper_bound_;
   /*! \brief The mapping from each token to the binding block where it is created. */
@@ -550,7 +763,8 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
  * initialization stage, we request a storage reuse or decide to allocate
  * storage for this token, depending on if there is appropriate available
  * token in the token pool we maintain.
- * - For each VM builtin reshape, we reuse the input's tokens.
+ * - For each VM builtin reshape and each wait of an asynchronous allreduce,
+ * we reuse the input's tokens.
  *
  * After the allocation planning, we know the token that each builtin
  * alloc_tensor plans to use. Compared with the initialization, here
@@ -644,6 +858,14 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
         this->CheckForRelease(token);
       });
     }
+    if (IsAllReduceWait(call)) {
+      Tokens tokens = GetTokens(call->args[0]);
+      if (tokens.IsLeaf() && tokens.LeafValue()->ref_counter > 0) {
+        // The receive buffer is still used through the result of the wait.
+        token2cur_tensor_[tokens.LeafValue().get()].push_back(binding->var);
+        SetTokens(call, tokens);
+      }
+    }
   }
 
   /*! \brief Request a storage reuse, or allocate storage if no appropriate storage is reusable. */
@@ -681,6 +903,169 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
   std::unordered_map<const StorageTokenNode*, std::vector<Var>> token2cur_tensor_;
 };
 
+/*!
+ * \brief The visitor class for arena planning, the alternative to StorageAllocator.
+ * \details
+ * - For each builtin alloc_tensor whose token is not discarded in the
+ * initialization stage, we record the index of its binding in the block as the
+ * start of the token liveness interval.
+ * - For each call using a token, we extend the liveness interval of the token
+ * to the index of the call binding. VM builtin reshape reuses the input's tokens.
+ *
+ * At the end of each binding block, the tokens created inside the block are
+ * packed into one arena per runtime device index, and each builtin alloc_tensor
+ * is assigned the arena token together with its offset inside the arena.
+ */
+class StorageArenaPlanner : public StorageAllocatorBaseVisitor {
+ public:
+  explicit StorageArenaPlanner(std::unordered_map<const ExprNode*, Tokens> token_map) {
+    this->token_map_ = std::move(token_map);
+  }
+
+  void Plan(const IRModule& mod) {
+    for (auto it : mod->functions) {
+      const auto* func = it.second.as<FunctionNode>();
+      if (func == nullptr) {
+        continue;
+      }
+      this->VisitExpr_(func);
+    }
+  }
+
+  /*!
+   * \brief The mapping from each `builtin.alloc_tensor` to the token of the arena
+   * that it is placed in.
+   */
+  std::unordered_map<const ExprNode*, StorageToken> alloc_tensor2token;
+  /*! \brief The mapping from each `builtin.alloc_tensor` to its offset in the arena. */
+  std::unordered_map<const ExprNode*, PrimExpr> alloc_tensor2offset;
+  /*! \brief The mapping from each binding block to the arena tokens that are create inside. */
+  std::unordered_map<const BindingBlockNode*, std::vector<const StorageTokenNode*>> block2tokens;
+
+ private:
+  using ExprVisitor::VisitBinding_;
+  using ExprVisitor::VisitExpr_;
+
+  /*! \brief The liveness of a token inside its binding block. */
+  struct TokenLiveness {
+    /*! \brief The builtin alloc_tensor creating the token. */
+    const CallNode* alloc_tensor;
+    /*! \brief The runtime device index of the allocation. */
+    int64_t device_index;
+    /*! \brief The index of the allocation binding. */
+    int start;
+    /*! \brief The index of the last binding using the token. */
+    int end;
+  };
+
+  /*! \brief The planning state of a binding block. */
+  struct BlockFrame {
+    /*! \brief The index of the binding being visited. */
+    int binding_index{0};
+    /*! \brief The tokens created in the block, in allocation order. */
+    std::vector<const StorageTokenNode*> tokens;
+  };
+
+  void VisitBindingBlock_(const BindingBlockNode* block) final {
+    frames_.emplace_back();
+    StorageAllocatorBaseVisitor::VisitBindingBlock_(block);
+    PlanBlock(block, frames_.back());
+    frames_.pop_back();
+  }
+
+  void VisitBinding_(const VarBindingNode* binding) final {
+    StorageAllocatorBaseVisitor::VisitBinding_(binding);
+    ICHECK(!frames_.empty());
+    ++frames_.back().binding_index;
+  }
+
+  void VisitBinding_(const VarBindingNode* binding, const CallNode* call) final {
+    static const Op& alloc_tensor_op = Op::Get("relax.builtin.alloc_tensor");
+    ICHECK(!frames_.empty());
+    BlockFrame& frame = frames_.back();
+    if (call->op == alloc_tensor_op) {
+      auto it = token_map_.find(call);
+      ICHECK(it != token_map_.end());
+      if (it->second.IsNull()) {
+        // The token was discarded, and this alloc_tensor is not considered by the planning.
+        return;
+      }
+      ICHECK(it->second.IsLeaf());
+      const StorageTokenNode* token = it->second.LeafValue().get();
+      const auto* device_index = Downcast<PrimValue>(call->args[2])->value.as<IntImmNode>();
+      ICHECK_NOTNULL(device_index);
+      token2liveness_[token] = {call, device_index->value, frame.binding_index,
+                                frame.binding_index};
+      frame.tokens.push_back(token);
+      return;
+    } else if (IsReshape(call->op)) {
+      Tokens tokens = GetTokens(call->args[0]);
+      ICHECK(!tokens.IsNested());
+      SetTokens(call, tokens);
+      return;
+    }
+
+    // Extend the liveness of each token that the arguments use to the current binding.
+    for (const Expr& arg : call->args) {
+      Tokens tokens = GetTokens(arg);
+      ForEachLeaf(tokens, [this, &frame](StorageToken token) {
+        auto it = token2liveness_.find(token.get());
+        ICHECK(it != token2liveness_.end());
+        it->second.end = std::max(it->second.end, frame.binding_index);
+      });
+    }
+    if (IsAllReduceWait(call)) {
+      SetTokens(call, GetTokens(call->args[0]));
+    }
+  }
+
+  /*!
+   * \brief Pack the tokens created in the block into one arena per runtime device index.
+   * \param block The binding block.
+   * \param frame The planning state of the block.
+   */
+  void PlanBlock(const BindingBlockNode* block, const BlockFrame& frame) {
+    std::map<int64_t, TokenArenaPacker1D> device2packer;
+    for (const StorageTokenNode* token : frame.tokens) {
+      const TokenLiveness& liveness = token2liveness_.at(token);
+      device2packer[liveness.device_index].Add(GetRef<StorageToken>(token), liveness.start,
+                                               liveness.end);
+    }
+    for (auto& [device_index, packer] : device2packer) {
+      std::unordered_map<const StorageTokenNode*, PrimExpr> offsets;
+      PrimExpr arena_bytes = packer.Pack(&ana_, &offsets);
+      StorageToken arena = CreateArenaToken(arena_bytes);
+      block2tokens[block].push_back(arena.get());
+      for (const auto& [token, offset] : offsets) {
+        const CallNode* alloc_tensor = token2liveness_.at(token).alloc_tensor;
+        alloc_tensor2token.insert({alloc_tensor, arena});
+        alloc_tensor2offset.insert({alloc_tensor, offset});
+      }
+    }
+  }
+
+  /*! \brief Create the byte-typed token of an arena with the given size. */
+  StorageToken CreateArenaToken(PrimExpr bytes) {
+    StorageToken arena = [&]() {
+      if (const auto* int_bytes = bytes.as<IntImmNode>()) {
+        return StorageToken(Array<PrimExpr>{GetRef<IntImm>(int_bytes)}, DataType::UInt(8));
+      }
+      return StorageToken(bytes, /*estimated_bytes=*/-1, DataType::UInt(8));
+    }();
+    arena->storage_id = n_storage_++;
+    return arena;
+  }
+
+  /*! \brief Number of planned arenas. */
+  int n_storage_{0};
+  /*! \brief The arithmetic analyzer for simplifying symbolic offsets. */
+  arith::Analyzer ana_;
+  /*! \brief The planning states of the binding blocks being visited. */
+  std::vector<BlockFrame> frames_;
+  /*! \brief The liveness of each token created by a builtin alloc_tensor. */
+  std::unordered_map<const StorageTokenNode*, TokenLiveness> token2liveness_;
+};
+
 /*!
  * \brief The rewriter class based on the token allocation planning.
  * \details
@@ -692,10 +1077,12 @@ class StorageAllocationRewriter : public ExprMutator {
   explicit StorageAllocationRewriter(
       IRModule mod, std::unordered_map<const ExprNode*, StorageToken> alloc_tensor2token,
       std::unordered_map<const BindingBlockNode*, std::vector<const StorageTokenNode*>>
-          block2tokens)
+          block2tokens,
+      std::unordered_map<const ExprNode*, PrimExpr> alloc_tensor2offset = {})
       : ExprMutator(std::move(mod)),
         alloc_tensor2token_(std::move(alloc_tensor2token)),
-        block2tokens_(std::move(block2tokens)) {}
+        block2tokens_(std::move(block2tokens)),
+        alloc_tensor2offset_(std::move(alloc_tensor2offset)) {}
 
   IRModule Rewrite() {
     const IRModule& mod = builder_->GetContextIRModule();
@@ -729,7 +1116,9 @@ class StorageAllocationRewriter : public ExprMutator {
       auto it_token = token2storage_var_.find(token.get());
       if (it_token == token2storage_var_.end()) {
         static const Op& mem_alloc_storage = Op::Get("relax.memory.alloc_storage");
-        ShapeExpr size({tir::make_const(DataType::Int(64), token->bytes)});
+        ShapeExpr size({token->symbolic_bytes.defined()
+                            ? token->symbolic_bytes
+                            : tir::make_const(DataType::Int(64), token->bytes)});
         PrimValue virtual_device_index = runtime_device_index;
         std::string storage_scope = "global";
         DataType dtype = token->dtype;
@@ -745,7 +1134,9 @@ class StorageAllocationRewriter : public ExprMutator {
 
       // And always create a `memory.alloc_tensor` for the old `builtin.alloc_tensor`.
       static const Op& mem_alloc_tensor = Op::Get("relax.memory.alloc_tensor");
-      PrimValue offset = PrimValue::Int64(0);
+      auto it_offset = alloc_tensor2offset_.find(call);
+      PrimValue offset = it_offset == alloc_tensor2offset_.end() ? PrimValue::Int64(0)
+                                                                 : PrimValue(it_offset->second);
       DataType dtype = sinfo->dtype;
       return Call(mem_alloc_tensor, {storage_var, offset, sinfo->shape.value(), DataTypeImm(dtype)},
                   Attrs());
@@ -761,13 +1152,30 @@ class StorageAllocationRewriter : public ExprMutator {
   std::unordered_map<const ExprNode*, StorageToken> alloc_tensor2token_;
   /*! \brief The mapping from each binding block to the storage tokens that are create inside. */
   std::unordered_map<const BindingBlockNode*, std::vector<const StorageTokenNode*>> block2tokens_;
+  /*!
+   * \brief The mapping from each memory-reusable `builtin.alloc_tensor` to its offset
+   * in the underlying storage. The offset is zero when absent.
+   */
+  std::unordered_map<const ExprNode*, PrimExpr> alloc_tensor2offset_;
   /*! \brief The mapping from each token to its corresponding storage var in each function. */
   std::unordered_map<const StorageTokenNode*, Var> token2storage_var_;
 };
 
-IRModule StaticPlanBlockMemory(IRModule mod) {
+IRModule StaticPlanBlockMemory(IRModule mod, bool arena_planning) {
   // Step 1. Initialize.
-  std::unordered_map<const ExprNode*, Tokens> token_map = StorageAllocatorInit::Initialize(mod);
+  std::unordered_map<const ExprNode*, Tokens> token_map =
+      StorageAllocatorInit::Initialize(mod, arena_planning);
+  if (arena_planning) {
+    // Step 2. Pack the tokens of each block into arenas.
+    StorageArenaPlanner planner(std::move(token_map));
+    planner.Plan(mod);
+    // Step 3. Rewrite the function.
+    StorageAllocationRewriter rewriter(std::move(mod),  //
+                                       std::move(planner.alloc_tensor2token),
+                                       std::move(planner.block2tokens),
+                                       std::move(planner.alloc_tensor2offset));
+    return rewriter.Rewrite();
+  }
   // Step 2. Collect the memory allocation info.
   StorageAllocator allocator(std::move(token_map));
   allocator.Allocate(mod);
@@ -780,9 +1188,16 @@ IRModule StaticPlanBlockMemory(IRModule mod) {
 
 namespace transform {
 
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.StaticPlanBlockMemory.arena_planning", Bool);
+
 Pass StaticPlanBlockMemory() {
   runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
-      [=](IRModule m, PassContext pc) { return relax::StaticPlanBlockMemory(std::move(m)); };
+      [=](IRModule m, PassContext pc) {
+        bool arena_planning =
+            pc->GetConfig<Bool>("relax.StaticPlanBlockMemory.arena_planning", Bool(false))
+                .value();
+        return relax::StaticPlanBlockMemory(std::move(m), arena_planning);
+      };
   return CreateModulePass(pass_func, /*opt_level=*/0, "StaticPlanBlockMemory", {});
 }
 
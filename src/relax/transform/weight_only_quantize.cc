@@ -0,0 +1,398 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relax/transform/weight_only_quantize.cc
+ * \brief Quantize the weights of matmul and embedding lookups to group-wise int8 or int4.
+ *
+ * A weight is split into groups of `group_size` consecutive elements along its reduction axis,
+ * i.e. the first axis of the right-hand side of a matmul, or the second axis of a transposed
+ * right-hand side or of an embedding table. Each group is scaled by its absolute maximum and
+ * rounded to a signed integer. Int8 values are stored as is, and int4 values are offset by 8 and
+ * packed by two into uint8, the even element in the low bits.
+ *
+ * The quantization of a weight is emitted as a call_tir on the weight, so that LiftTransformParams
+ * moves it to the parameter transformation function, and FoldConstant folds it for a constant
+ * weight. Each use of the weight is replaced by a call to a primitive function, which dequantizes
+ * the weight before the matmul, or dequantizes the rows gathered by the embedding lookup. After
+ * LegalizeOps, FuseTIR turns each of these functions into a single kernel.
+ */
+
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/attrs/index.h>
+#include <tvm/relax/attrs/linear_algebra.h>
+#include <tvm/relax/attrs/manipulate.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+#include <tvm/te/operation.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "../../te/operation/create_primfunc.h"
+#include "../op/tensor/index.h"
+#include "../op/tensor/linear_algebra.h"
+#include "../op/tensor/manipulate.h"
+#include "utils.h"
+
+namespace tvm {
+namespace relax {
+
+class WeightQuantizer : public ExprMutator {
+ public:
+  static IRModule Quantize(IRModule mod, int bits, int group_size) {
+    CHECK(bits == 4 || bits == 8) << "ValueError: Weights can only be quantized to 4 or 8 bits, "
+                                  << "but got " << bits;
+    CHECK_GT(group_size, 0) << "ValueError: The group size must be positive";
+    CHECK(bits != 4 || group_size % 2 == 0)
+        << "ValueError: The group size must be even to pack int4 values";
+    WeightQuantizer quantizer(mod, bits, group_size);
+    for (const auto& [gv, func] : mod->functions) {
+      if (const auto* relax_func = func.as<FunctionNode>()) {
+        if (relax_func->HasNonzeroAttr(attr::kPrimitive)) {
+          continue;
+        }
+        Function updated = Downcast<Function>(quantizer.VisitExpr(GetRef<Function>(relax_func)));
+        if (!updated.same_as(func)) {
+          // The original uses of the weights, e.g. their transposes, are now dead.
+          quantizer.builder_->UpdateFunction(gv, Downcast<Function>(RemoveAllUnused(updated)));
+        }
+      }
+    }
+    return quantizer.builder_->GetContextIRModule();
+  }
+
+ private:
+  WeightQuantizer(IRModule mod, int bits, int group_size)
+      : ExprMutator(mod), bits_(bits), group_size_(group_size) {}
+
+  using ExprMutator::VisitExpr_;
+
+  Expr VisitExpr_(const FunctionNode* func) final {
+    // The parameters after the model inputs are the weights.
+    std::unordered_set<const VarNode*> outer_weights = std::move(weights_);
+    weights_.clear();
+    if (auto num_input = func->GetAttr<Integer>(attr::kNumInput)) {
+      for (size_t i = num_input.value()->value; i < func->params.size(); ++i) {
+        weights_.insert(func->params[i].get());
+      }
+    }
+    Expr result = ExprMutator::VisitExpr_(func);
+    weights_ = std::move(outer_weights);
+    return result;
+  }
+
+  BindingBlock VisitBindingBlock(const BindingBlock& block) final {
+    // The quantized weights are only visible in the block they are emitted in.
+    auto outer_quantized = std::move(quantized_);
+    quantized_.clear();
+    BindingBlock result = ExprMutator::VisitBindingBlock(block);
+    quantized_ = std::move(outer_quantized);
+    return result;
+  }
+
+  Expr VisitExpr_(const CallNode* op) final {
+    static const Op& matmul_op = Op::Get("relax.matmul");
+    static const Op& take_op = Op::Get("relax.take");
+    Call call = Downcast<Call>(ExprMutator::VisitExpr_(op));
+    if (call->op.same_as(matmul_op)) {
+      return QuantizeMatmul(call);
+    } else if (call->op.same_as(take_op)) {
+      return QuantizeTake(call);
+    }
+    return call;
+  }
+
+  bool IsWeight(const Expr& expr) const {
+    return expr->IsInstance<ConstantNode>() || weights_.count(expr.as<VarNode>());
+  }
+
+  /*!
+   * \brief Whether a weight can be quantized along an axis: it is a 2-D float tensor of static
+   * shape, whose axis splits into groups.
+   */
+  bool IsQuantizable(const Expr& weight, int axis) const {
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(weight);
+    if (sinfo == nullptr || !sinfo->dtype.is_float() || sinfo->ndim != 2 ||
+        !sinfo->GetShape().defined()) {
+      return false;
+    }
+    for (const PrimExpr& dim : sinfo->GetShape().value()) {
+      if (!dim->IsInstance<IntImmNode>()) {
+        return false;
+      }
+    }
+    int64_t extent = Downcast<IntImm>(sinfo->GetShape().value()[axis])->value;
+    return extent % group_size_ == 0;
+  }
+
+  DataType StorageDType() const { return bits_ == 8 ? DataType::Int(8) : DataType::UInt(8); }
+
+  /*! \brief The shape of the quantized storage of a tensor, packed along the axis. */
+  Array<PrimExpr> StorageShape(Array<PrimExpr> shape, int axis) const {
+    shape.Set(axis, floordiv(shape[axis], 8 / bits_));
+    return shape;
+  }
+
+  /*! \brief The shape of the scales of a tensor, with one scale per group along the axis. */
+  Array<PrimExpr> ScaleShape(Array<PrimExpr> shape, int axis) const {
+    shape.Set(axis, floordiv(shape[axis], group_size_));
+    return shape;
+  }
+
+  GlobalVar AddPrimFunc(const tir::PrimFunc& func, const String& name) {
+    return builder_->AddFunction(WithoutAttr(func, tvm::attr::kGlobalSymbol), name);
+  }
+
+  /*! \brief Make the PrimFunc computing the quantized storage and the scales of a weight. */
+  tir::PrimFunc MakeQuantizeFunc(const Array<PrimExpr>& shape, DataType dtype, int axis) const {
+    DataType f32 = DataType::Float(32);
+    int qmax = (1 << (bits_ - 1)) - 1;
+    te::Tensor weight = te::placeholder(shape, dtype, "weight");
+    DataType index_dtype = shape[axis].dtype();
+    te::IterVar k = te::reduce_axis(
+        Range::FromMinExtent(IntImm(index_dtype, 0), IntImm(index_dtype, group_size_)), "k");
+    te::Tensor absmax = te::compute(
+        ScaleShape(shape, axis),
+        [&](const Array<tir::Var>& i) {
+          Array<PrimExpr> index(i.begin(), i.end());
+          index.Set(axis, i[axis] * group_size_ + k->var);
+          return tvm::max(tvm::abs(tvm::cast(f32, weight(index))), Array<tir::IterVar>{k});
+        },
+        "absmax");
+    te::Tensor scale = te::compute(
+        ScaleShape(shape, axis),
+        [&](const Array<tir::Var>& i) {
+          return tvm::cast(dtype, absmax(i) / FloatImm(f32, qmax));
+        },
+        "scale");
+    // The quantized value of an element, in [-qmax, qmax].
+    auto quantize = [&](const Array<PrimExpr>& index) -> PrimExpr {
+      Array<PrimExpr> scale_index = index;
+      scale_index.Set(axis, floordiv(index[axis], group_size_));
+      PrimExpr s = tvm::cast(f32, scale(scale_index));
+      PrimExpr value = tvm::round(tvm::cast(f32, weight(index)) / s);
+      value = tvm::min(tvm::max(value, FloatImm(f32, -qmax)), FloatImm(f32, qmax));
+      return tir::Select(s > FloatImm(f32, 0), tvm::cast(DataType::Int(32), value),
+                         IntImm(DataType::Int(32), 0));
+    };
+    te::Tensor quantized = te::compute(
+        StorageShape(shape, axis),
+        [&](const Array<tir::Var>& i) -> PrimExpr {
+          Array<PrimExpr> index(i.begin(), i.end());
+          if (bits_ == 8) {
+            return tvm::cast(StorageDType(), quantize(index));
+          }
+          index.Set(axis, i[axis] * 2);
+          PrimExpr low = quantize(index) + 8;
+          index.Set(axis, i[axis] * 2 + 1);
+          PrimExpr high = quantize(index) + 8;
+          return tvm::cast(StorageDType(), low | (high << 4));
+        },
+        "quantized_weight");
+    return tir::CreatePrimFunc({weight, quantized, scale});
+  }
+
+  /*! \brief Make the PrimFunc dequantizing a tensor from its quantized storage and scales. */
+  tir::PrimFunc MakeDequantizeFunc(const Array<PrimExpr>& shape, DataType dtype, int axis) const {
+    // The dynamic dimensions are defined by the inputs of the PrimFunc.
+    Array<PrimExpr> func_shape;
+    for (size_t i = 0; i < shape.size(); ++i) {
+      if (shape[i]->IsInstance<IntImmNode>()) {
+        func_shape.push_back(shape[i]);
+      } else {
+        func_shape.push_back(tir::Var("n" + std::to_string(i), shape[i].dtype()));
+      }
+    }
+    te::Tensor quantized =
+        te::placeholder(StorageShape(func_shape, axis), StorageDType(), "quantized_weight");
+    te::Tensor scale = te::placeholder(ScaleShape(func_shape, axis), dtype, "scale");
+    te::Tensor weight = te::compute(
+        func_shape,
+        [&](const Array<tir::Var>& i) {
+          Array<PrimExpr> index(i.begin(), i.end());
+          Array<PrimExpr> scale_index = index;
+          scale_index.Set(axis, floordiv(i[axis], group_size_));
+          PrimExpr value;
+          if (bits_ == 8) {
+            value = tvm::cast(dtype, quantized(index));
+          } else {
+            index.Set(axis, floordiv(i[axis], 2));
+            PrimExpr packed = tvm::cast(DataType::Int(32), quantized(index));
+            PrimExpr shift = tvm::cast(DataType::Int(32), floormod(i[axis], 2) * 4);
+            value = tvm::cast(dtype, ((packed >> shift) & 15) - 8);
+          }
+          return value * scale(scale_index);
+        },
+        "dequantized_weight");
+    return tir::CreatePrimFunc({quantized, scale, weight});
+  }
+
+  /*! \brief Emit the quantization of a weight along an axis, and get its storage and scales. */
+  std::pair<Expr, Expr> QuantizeWeight(const Expr& weight, int axis) {
+    auto key = std::make_pair(weight.get(), axis);
+    auto it = quantized_.find(key);
+    if (it != quantized_.end()) {
+      return it->second;
+    }
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(weight);
+    Array<PrimExpr> shape = sinfo->GetShape().value();
+    GlobalVar func = AddPrimFunc(MakeQuantizeFunc(shape, sinfo->dtype, axis), "quantize_weight");
+    VDevice vdevice = sinfo->vdevice.value_or(VDevice());
+    TensorStructInfo storage_sinfo(ShapeExpr(StorageShape(shape, axis)), StorageDType(), vdevice);
+    TensorStructInfo scale_sinfo(ShapeExpr(ScaleShape(shape, axis)), sinfo->dtype, vdevice);
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    Var quantized = builder_->Emit(Call(call_tir_op, {func, Tuple({weight})}, {},
+                                        {TupleStructInfo({storage_sinfo, scale_sinfo})}));
+    std::pair<Expr, Expr> result{builder_->Emit(TupleGetItem(quantized, 0)),
+                                 builder_->Emit(TupleGetItem(quantized, 1))};
+    quantized_.emplace(key, result);
+    return result;
+  }
+
+  /*! \brief Emit the dequantization of a tensor along an axis into `builder`. */
+  Expr EmitDequantize(const BlockBuilder& builder, const Expr& storage, const Expr& scale,
+                      const TensorStructInfo& sinfo, int axis) {
+    Array<PrimExpr> shape = sinfo->GetShape().value();
+    GlobalVar func =
+        AddPrimFunc(MakeDequantizeFunc(shape, sinfo->dtype, axis), "dequantize_weight");
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    return builder->Emit(Call(call_tir_op, {func, Tuple({storage, scale})}, {}, {sinfo}));
+  }
+
+  /*!
+   * \brief Add a primitive function computing its result from the quantized weight, so that
+   * FuseTIR fuses the dequantization into the consumer of the weight.
+   * \param args The arguments of the function.
+   * \param fbody Emit the body of the function from its parameters, and return its result.
+   * \param name The name of the function.
+   * \return The call to the function.
+   */
+  Call CallFusedFunction(const Array<Expr>& args,
+                         std::function<Expr(const BlockBuilder&, const Array<Var>&)> fbody,
+                         const String& name) {
+    Array<Var> params;
+    for (size_t i = 0; i < args.size(); ++i) {
+      params.push_back(Var("p" + std::to_string(i), GetStructInfo(args[i])));
+    }
+    BlockBuilder builder = BlockBuilder::Create(NullOpt);
+    builder->BeginScope(params);
+    builder->BeginDataflowBlock();
+    Var output = builder->EmitOutput(fbody(builder, params));
+    BindingBlock block = builder->EndBlock();
+    builder->EndScope();
+    Function func(params, builder->Normalize(SeqExpr({block}, output)), NullOpt, /*is_pure=*/true,
+                  DictAttrs({{attr::kPrimitive, Integer(1)}}));
+    GlobalVar gv = builder_->AddFunction(SymbolicVarRenewMutator::Renew(func), name);
+    return Call(gv, args);
+  }
+
+  Expr QuantizeMatmul(const Call& call) {
+    static const Op& permute_dims_op = Op::Get("relax.permute_dims");
+    Expr weight = call->args[1];
+    // A linear layer often multiplies by the transpose of a weight of shape (out, in).
+    bool transposed = false;
+    if (const auto* var = weight.as<VarNode>(); var != nullptr && !IsWeight(weight)) {
+      if (auto bound = builder_->LookupBinding(GetRef<Var>(var))) {
+        const auto* permute = bound.value().as<CallNode>();
+        if (permute != nullptr && permute->op.same_as(permute_dims_op)) {
+          const auto* attrs = permute->attrs.as<PermuteDimsAttrs>();
+          if (!attrs->axes.defined() || (attrs->axes.value().size() == 2 &&
+                                         attrs->axes.value()[0]->value == 1 &&
+                                         attrs->axes.value()[1]->value == 0)) {
+            weight = permute->args[0];
+            transposed = true;
+          }
+        }
+      }
+    }
+    int axis = transposed ? 1 : 0;
+    if (!IsWeight(weight) || !IsQuantizable(weight, axis)) {
+      return call;
+    }
+    auto [storage, scale] = QuantizeWeight(weight, axis);
+    DataType out_dtype = call->attrs.as<MatmulAttrs>()->out_dtype;
+    auto weight_sinfo = Downcast<TensorStructInfo>(GetStructInfo(weight));
+    return CallFusedFunction(
+        {call->args[0], storage, scale},
+        [&](const BlockBuilder& builder, const Array<Var>& params) -> Expr {
+          Expr dequantized = EmitDequantize(builder, params[1], params[2], weight_sinfo, axis);
+          if (transposed) {
+            dequantized = builder->Emit(permute_dims(dequantized, NullOpt));
+          }
+          return matmul(params[0], dequantized, out_dtype);
+        },
+        "fused_dequantize_matmul");
+  }
+
+  Expr QuantizeTake(const Call& call) {
+    Expr weight = call->args[0];
+    const auto* attrs = call->attrs.as<TakeAttrs>();
+    const auto* out_sinfo = GetStructInfoAs<TensorStructInfoNode>(call);
+    if (!IsWeight(weight) || !attrs->axis.defined() || attrs->axis.value()->value != 0 ||
+        !IsQuantizable(weight, /*axis=*/1) || out_sinfo == nullptr ||
+        !out_sinfo->GetShape().defined()) {
+      return call;
+    }
+    // Gather the quantized rows, and only dequantize them.
+    auto [storage, scale] = QuantizeWeight(weight, /*axis=*/1);
+    TensorStructInfo rows_sinfo = GetRef<TensorStructInfo>(out_sinfo);
+    return CallFusedFunction(
+        {call->args[1], storage, scale},
+        [&](const BlockBuilder& builder, const Array<Var>& params) -> Expr {
+          Expr storage_rows = builder->Emit(take(params[1], params[0], Integer(0)));
+          Expr scale_rows = builder->Emit(take(params[2], params[0], Integer(0)));
+          return EmitDequantize(builder, storage_rows, scale_rows, rows_sinfo,
+                                rows_sinfo->ndim - 1);
+        },
+        "fused_dequantize_take");
+  }
+
+  struct PairHash {
+    size_t operator()(const std::pair<const Object*, int>& key) const {
+      return std::hash<const Object*>()(key.first) ^ std::hash<int>()(key.second);
+    }
+  };
+
+  int bits_;
+  int group_size_;
+  /*! \brief The weight parameters of the current function. */
+  std::unordered_set<const VarNode*> weights_;
+  /*! \brief The storage and scales of the weights quantized in the current block, by axis. */
+  std::unordered_map<std::pair<const Object*, int>, std::pair<Expr, Expr>, PairHash> quantized_;
+};
+
+namespace transform {
+
+Pass WeightOnlyQuantize(int bits, int group_size) {
+  runtime::TypedPackedFunc<IRModule(IRModule, PassContext)> pass_func =
+      [=](IRModule mod, PassContext pc) {
+        return WeightQuantizer::Quantize(mod, bits, group_size);
+      };
+  return CreateModulePass(pass_func, 0, "WeightOnlyQuantize", {});
+}
+
+TVM_REGISTER_GLOBAL("relax.transform.WeightOnlyQuantize").set_body_typed(WeightOnlyQuantize);
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
@@ -155,6 +155,10 @@ bool GraphPartitioner::CheckPath(IndexedForwardGraph::Node* src, IndexedForwardG
   return true;
 }
 
+bool GraphPartitioner::CheckFuse(IndexedForwardGraph::Node* src, IndexedForwardGraph::Node* sink) {
+  return fcheck_fuse_ == nullptr || fcheck_fuse_(src, sink, groups_);
+}
+
 OpPatternKind CombinePattern(OpPatternKind lhs, OpPatternKind rhs) {
   if (lhs > relay::kBroadcast && rhs > relay::kBroadcast) {
     LOG(FATAL) << "Cannot merge two complex group together";
@@ -403,7 +407,8 @@ void GraphPartitioner::RunFuse(const IndexedForwardGraph& graph,    //
         auto fcond = [](OpPatternKind kind, bool is_sink) { return kind <= kInjective; };
         // dom_root_group can also be tuple, as in inception layers
         // CheckPath is needed to avoid fusing two intermediate tuples
-        if (CheckPath(graph_node, dom_node->parent->gnode, fcond)) {
+        if (CheckPath(graph_node, dom_node->parent->gnode, fcond) &&
+            CheckFuse(graph_node, dom_node->parent->gnode)) {
           CommitFuse(graph_node, dom_node->parent->gnode);
         }
       }
@@ -426,7 +431,8 @@ void GraphPartitioner::RunFuse(const IndexedForwardGraph& graph,    //
         ICHECK(dom_node->parent->gnode != nullptr);
         // The fuse can be executed if all the intermediate ops are still broadcast.
         auto fcond = [](OpPatternKind kind, bool is_sink) { return kind <= kBroadcast; };
-        if (CheckPath(graph_node, dom_node->parent->gnode, fcond)) {
+        if (CheckPath(graph_node, dom_node->parent->gnode, fcond) &&
+            CheckFuse(graph_node, dom_node->parent->gnode)) {
           CommitFuse(graph_node, dom_node->parent->gnode);
         }
       }
@@ -446,7 +452,8 @@ void GraphPartitioner::RunFuse(const IndexedForwardGraph& graph,    //
                     kind == kOutEWiseFusable);
           }
         };
-        if (CheckPath(graph_node, dom_node->parent->gnode, fcond)) {
+        if (CheckPath(graph_node, dom_node->parent->gnode, fcond) &&
+            CheckFuse(graph_node, dom_node->parent->gnode)) {
           CommitFuse(graph_node, dom_node->parent->gnode);
         }
       }
@@ -456,7 +463,8 @@ void GraphPartitioner::RunFuse(const IndexedForwardGraph& graph,    //
       if (phase != 1) continue;
       // Check if all path are injective.
       auto fcond = [](OpPatternKind kind, bool is_sink) { return kind <= kInjective; };
-      if (CheckPath(graph_node, dom_node->parent->gnode, fcond)) {
+      if (CheckPath(graph_node, dom_node->parent->gnode, fcond) &&
+          CheckFuse(graph_node, dom_node->parent->gnode)) {
         CommitFuse(graph_node, dom_node->parent->gnode);
       }
     } else {
@@ -27,6 +27,7 @@
 
 #include <tvm/relay/op_attr_types.h>
 
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -162,12 +163,23 @@ class DominatorTree {
  */
 class GraphPartitioner {
  public:
+  struct Group;
+  /*!
+   * \brief The check of whether fusing a node into its post-dominator is profitable. It is given
+   * the node, the post-dominator and the groups of all the nodes, and is only called for the
+   * fusions allowed by the op patterns.
+   */
+  using FCheckFuse =
+      std::function<bool(const IndexedForwardGraph::Node* src,
+                         const IndexedForwardGraph::Node* sink, const std::vector<Group*>& groups)>;
+
   explicit GraphPartitioner(support::Arena* arena, int opt_level, size_t max_fuse_depth,
-                            size_t max_function_args)
+                            size_t max_function_args, FCheckFuse fcheck_fuse = nullptr)
       : arena_(arena),
         opt_level_(opt_level),
         max_fuse_depth_(max_fuse_depth),
-        max_function_args_(max_function_args) {}
+        max_function_args_(max_function_args),
+        fcheck_fuse_(std::move(fcheck_fuse)) {}
   /*!
    * \brief Group as a union find data structure.
    */
@@ -215,6 +227,8 @@ class GraphPartitioner {
   size_t max_fuse_depth_;
   /*! \brief The maximum number of arguments in one fused function */
   size_t max_function_args_;
+  /*! \brief The optional profitability check of the fusions. */
+  FCheckFuse fcheck_fuse_;
   /*! \brief The internal groups. */
   std::vector<Group*> groups_;
   /*! \brief internal field used for deduplication */
@@ -247,6 +261,14 @@ class GraphPartitioner {
   template <typename F>
   bool CheckPath(IndexedForwardGraph::Node* src, IndexedForwardGraph::Node* sink, F fcond);
 
+  /*!
+   * \brief Check whether fusing src into its post-dominator sink is profitable.
+   * \param src The source node.
+   * \param sink The termination node.
+   * \return Whether to fuse, always true without the profitability check.
+   */
+  bool CheckFuse(IndexedForwardGraph::Node* src, IndexedForwardGraph::Node* sink);
+
   /*!
    * \brief Merge the child group to the parent.
    * \param child The child group.
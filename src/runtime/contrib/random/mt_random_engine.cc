@@ -20,6 +20,10 @@
 /*!
  * \file random/mt_random_engine.cc
  * \brief mt19937 random engine
+ *
+ * The sampling from distributions uses the counter-based Philox generator, which
+ * is parallelized over the runtime thread pool with results that do not depend on
+ * the number of threads.
  */
 #include <tvm/runtime/c_backend_api.h>
 #include <tvm/runtime/device_api.h>
@@ -28,11 +32,14 @@
 #include <tvm/runtime/threading_backend.h>
 
 #include <algorithm>
+#include <cmath>
 #include <ctime>
 #include <random>
 #include <thread>
+#include <type_traits>
 
 #include "../3rdparty/compiler-rt/builtin_fp16.h"
+#include "philox_random.h"
 
 namespace tvm {
 namespace contrib {
@@ -58,6 +65,7 @@ class RandomEngine {
   inline void Seed(unsigned seed) {
     rnd_engine_.seed(seed);
     this->rseed_ = static_cast<unsigned>(seed);
+    this->philox_offset_ = 0;
   }
 
   /*!
@@ -78,17 +86,20 @@ class RandomEngine {
     ICHECK(data->strides == nullptr);
 
     DLDataType dtype = data->dtype;
-    int64_t size = 1;
-    for (int i = 0; i < data->ndim; ++i) {
-      size *= data->shape[i];
-    }
+    int64_t size = GetSize(data);
 
     ICHECK(dtype.code == kDLFloat && dtype.bits == 32 && dtype.lanes == 1);
 
     if (data->device.device_type == kDLCPU) {
-      std::uniform_real_distribution<float> uniform_dist(low, high);
-      std::generate_n(static_cast<float*>(data->data), size,
-                      [&]() { return uniform_dist(rnd_engine_); });
+      float* out = static_cast<float*>(data->data);
+      // The largest value below high, as low + (high - low) * u may round up to high.
+      float max_value = std::nextafter(high, low);
+      SamplePhilox(size, [&](int64_t index, const PhiloxRandom::Block& block) {
+        for (int lane = 0; lane < 4 && index + lane < size; ++lane) {
+          float value = low + (high - low) * PhiloxRandom::ToUniform(block[lane]);
+          out[index + lane] = std::min(value, max_value);
+        }
+      });
     } else {
       LOG(FATAL) << "Do not support random.uniform on this device yet";
     }
@@ -102,22 +113,62 @@ class RandomEngine {
     ICHECK(data->strides == nullptr);
 
     DLDataType dtype = data->dtype;
-    int64_t size = 1;
-    for (int i = 0; i < data->ndim; ++i) {
-      size *= data->shape[i];
-    }
+    int64_t size = GetSize(data);
 
     ICHECK(dtype.code == kDLFloat && dtype.bits == 32 && dtype.lanes == 1);
 
     if (data->device.device_type == kDLCPU) {
-      std::normal_distribution<float> normal_dist(loc, scale);
-      std::generate_n(static_cast<float*>(data->data), size,
-                      [&]() { return normal_dist(rnd_engine_); });
+      float* out = static_cast<float*>(data->data);
+      constexpr float kTwoPi = 6.28318530717958647692f;
+      SamplePhilox(size, [&](int64_t index, const PhiloxRandom::Block& block) {
+        // Box-Muller transform, turning each pair of uniforms into two normals.
+        for (int lane = 0; lane < 4 && index + lane < size; lane += 2) {
+          float radius = std::sqrt(-2.0f * std::log(PhiloxRandom::ToUniformNonZero(block[lane])));
+          float theta = kTwoPi * PhiloxRandom::ToUniform(block[lane + 1]);
+          out[index + lane] = loc + scale * radius * std::cos(theta);
+          if (index + lane + 1 < size) {
+            out[index + lane + 1] = loc + scale * radius * std::sin(theta);
+          }
+        }
+      });
     } else {
       LOG(FATAL) << "Do not support random.normal on this device yet";
     }
   }
 
+  /*!
+   * \brief Fills a tensor with values drawn from Bernoulli(prob), as 0 or 1.
+   */
+  void SampleBernoulli(DLTensor* data, float prob) {
+    ICHECK(prob >= 0 && prob <= 1) << "probability must be in [0, 1]";
+    ICHECK(data->strides == nullptr);
+
+    DLDataType dtype = data->dtype;
+    int64_t size = GetSize(data);
+    ICHECK_EQ(dtype.lanes, 1);
+
+    auto fill = [&](auto* out) {
+      using T = std::remove_pointer_t<decltype(out)>;
+      SamplePhilox(size, [&](int64_t index, const PhiloxRandom::Block& block) {
+        for (int lane = 0; lane < 4 && index + lane < size; ++lane) {
+          out[index + lane] = static_cast<T>(PhiloxRandom::ToUniform(block[lane]) < prob);
+        }
+      });
+    };
+    if (data->device.device_type != kDLCPU) {
+      LOG(FATAL) << "Do not support random.bernoulli on this device yet";
+    } else if (dtype.code == kDLFloat && dtype.bits == 32) {
+      fill(static_cast<float*>(data->data));
+    } else if ((dtype.code == kDLInt || dtype.code == kDLUInt) && dtype.bits == 32) {
+      fill(static_cast<int32_t*>(data->data));
+    } else if ((dtype.code == kDLInt || dtype.code == kDLUInt) &&
+               (dtype.bits == 8 || dtype.bits == 1)) {
+      fill(static_cast<uint8_t*>(data->data));
+    } else {
+      LOG(FATAL) << "Doesn't support dtype code " << dtype.code << " dtype bits " << dtype.bits;
+    }
+  }
+
   void RandomFill(DLTensor* data) {
     if (data->device.device_type == kDLCPU) {
       FillData(data);
@@ -143,6 +194,61 @@ class RandomEngine {
   }
 
  private:
+  static int64_t GetSize(const DLTensor* tensor) {
+    int64_t size = 1;
+    for (int i = 0; i < tensor->ndim; ++i) {
+      size *= tensor->shape[i];
+    }
+    return size;
+  }
+
+  /*!
+   * \brief Generate the Philox blocks covering `size` elements, in parallel.
+   *
+   * The block of elements [4 * i, 4 * i + 4) is computed from the counter
+   * philox_offset_ + i, so the result does not depend on the number of threads.
+   * The offset is then advanced past the consumed counters.
+   *
+   * \param size The number of elements.
+   * \param f The function called as f(first_element_index, block) for each block.
+   */
+  template <typename F>
+  void SamplePhilox(int64_t size, const F& f) {
+    struct ParallelTask {
+      static int RunTask(int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+        ParallelTask* task = static_cast<ParallelTask*>(cdata);
+        task->Run(task_id, penv->num_task);
+        return 0;
+      }
+
+      void Run(int i, int num_tasks) {
+        int64_t chunk_size = (num_blocks + num_tasks - 1) / num_tasks;
+        int64_t st = std::min(i * chunk_size, num_blocks);
+        int64_t ed = std::min(st + chunk_size, num_blocks);
+        for (int64_t block_index = st; block_index < ed; ++block_index) {
+          (*f)(block_index * 4, (*philox)(offset + block_index));
+        }
+      }
+
+      const F* f;
+      const PhiloxRandom* philox;
+      uint64_t offset;
+      int64_t num_blocks;
+    };
+
+    PhiloxRandom philox(rseed_);
+    ParallelTask task{&f, &philox, philox_offset_, (size + 3) / 4};
+    // Small tensors are not worth the synchronization of the thread pool.
+    constexpr int64_t kMinParallelBlocks = 4096;
+    if (task.num_blocks < kMinParallelBlocks) {
+      task.Run(0, 1);
+    } else {
+      int res = TVMBackendParallelLaunch(ParallelTask::RunTask, &task, 0);
+      ICHECK_EQ(res, 0) << "SamplePhilox: TVMBackendParallelLaunch failed";
+    }
+    philox_offset_ += task.num_blocks;
+  }
+
   void FillDataImpl(void* data, int64_t st, int64_t ed, DLDataType dtype) {
     // Make the value be 1.0 - 10.0, not (0.0 - 1.0) so that we could satisfy
     // quantized dtype (uint8 / int8) data non-empty requirement
@@ -229,6 +335,8 @@ class RandomEngine {
  private:
   std::mt19937 rnd_engine_;
   unsigned rseed_;
+  /*! \brief The next unused counter of the Philox generator. */
+  uint64_t philox_offset_{0};
 };
 
 }  // namespace contrib
@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file random/philox_random.h
+ * \brief Counter-based Philox4x32-10 random number generator.
+ */
+#ifndef TVM_RUNTIME_CONTRIB_RANDOM_PHILOX_RANDOM_H_
+#define TVM_RUNTIME_CONTRIB_RANDOM_PHILOX_RANDOM_H_
+
+#include <array>
+#include <cstdint>
+
+namespace tvm {
+namespace contrib {
+
+/*!
+ * \brief The Philox4x32-10 generator from "Parallel Random Numbers: As Easy as 1, 2, 3"
+ *  (Salmon et al., SC'11).
+ *
+ * The block of four 32-bit outputs at counter i only depends on the key and on i, so the
+ * blocks can be generated in any order. Filling a tensor in parallel thus gives the same
+ * result regardless of how the blocks are split between the threads.
+ */
+class PhiloxRandom {
+ public:
+  /*! \brief The four outputs of one counter. */
+  using Block = std::array<uint32_t, 4>;
+
+  /*!
+   * \brief Creates a generator.
+   * \param seed The seed, used as the key of the generator.
+   */
+  explicit PhiloxRandom(uint64_t seed)
+      : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)} {}
+
+  /*!
+   * \brief Compute the block of outputs at a counter.
+   * \param counter The counter.
+   * \return The block of four random 32-bit integers.
+   */
+  Block operator()(uint64_t counter) const {
+    Block ctr = {static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), 0, 0};
+    uint32_t k0 = key_[0];
+    uint32_t k1 = key_[1];
+    for (int round = 0; round < kNumRounds; ++round) {
+      uint64_t p0 = static_cast<uint64_t>(kMultiplier0) * ctr[0];
+      uint64_t p1 = static_cast<uint64_t>(kMultiplier1) * ctr[2];
+      ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ k0, static_cast<uint32_t>(p1),
+             static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ k1, static_cast<uint32_t>(p0)};
+      k0 += kWeyl0;
+      k1 += kWeyl1;
+    }
+    return ctr;
+  }
+
+  /*!
+   * \brief Convert a random integer to a float uniformly distributed in [0, 1).
+   */
+  static float ToUniform(uint32_t x) { return (x >> 8) * (1.0f / 16777216.0f); }
+
+  /*!
+   * \brief Convert a random integer to a float uniformly distributed in (0, 1].
+   */
+  static float ToUniformNonZero(uint32_t x) { return ((x >> 8) + 1) * (1.0f / 16777216.0f); }
+
+ private:
+  static constexpr int kNumRounds = 10;
+  static constexpr uint32_t kMultiplier0 = 0xD2511F53;
+  static constexpr uint32_t kMultiplier1 = 0xCD9E8D57;
+  static constexpr uint32_t kWeyl0 = 0x9E3779B9;
+  static constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+  /*! \brief The key derived from the seed. */
+  std::array<uint32_t, 2> key_;
+};
+
+}  // namespace contrib
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_CONTRIB_RANDOM_PHILOX_RANDOM_H_
@@ -22,9 +22,13 @@
  */
 
 #include <dlpack/dlpack.h>
+#include <tvm/runtime/c_backend_api.h>
 #include <tvm/runtime/registry.h>
 
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
 #include <vector>
 
 #include "../../../../3rdparty/compiler-rt/builtin_fp16.h"
@@ -70,6 +74,136 @@ struct float16 {
   inline bool operator>=(const float16& rhs) const { return to_float() >= rhs.to_float(); }
 };
 
+/*!
+ * \brief Run a function over the rows to be sorted, split into contiguous ranges that are
+ *  processed in parallel on the runtime thread pool when the input is large enough.
+ * \param num_rows The number of rows.
+ * \param row_len The number of elements of each row.
+ * \param f The function called as f(row_begin, row_end) by each task. Buffers allocated in f
+ *  are reused over all the rows of the task.
+ */
+template <typename F>
+void ParallelForRows(int64_t num_rows, int64_t row_len, const F& f) {
+  // Below this size the thread pool synchronization costs more than the sort itself.
+  constexpr int64_t kMinParallelElements = 1 << 14;
+  if (num_rows < 2 || num_rows * row_len < kMinParallelElements) {
+    f(0, num_rows);
+    return;
+  }
+
+  struct ParallelTask {
+    static int RunTask(int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+      ParallelTask* task = static_cast<ParallelTask*>(cdata);
+      int64_t chunk_size = (task->num_rows + penv->num_task - 1) / penv->num_task;
+      int64_t begin = std::min(task_id * chunk_size, task->num_rows);
+      int64_t end = std::min(begin + chunk_size, task->num_rows);
+      if (begin < end) {
+        (*task->f)(begin, end);
+      }
+      return 0;
+    }
+
+    const F* f;
+    int64_t num_rows;
+  };
+
+  ParallelTask task{&f, num_rows};
+  int res = TVMBackendParallelLaunch(ParallelTask::RunTask, &task, 0);
+  ICHECK_EQ(res, 0) << "Sort: TVMBackendParallelLaunch failed";
+}
+
+/*!
+ * \brief Map the keys of a dtype to unsigned integers with the same order, used by radix sort.
+ *  Only enabled for the 32/64-bit integer and floating point types.
+ */
+template <typename DType>
+struct RadixKey {
+  static constexpr bool enabled = false;
+};
+
+template <>
+struct RadixKey<int32_t> {
+  static constexpr bool enabled = true;
+  using Type = uint32_t;
+  static Type Get(int32_t value) { return static_cast<uint32_t>(value) ^ 0x80000000U; }
+};
+
+template <>
+struct RadixKey<int64_t> {
+  static constexpr bool enabled = true;
+  using Type = uint64_t;
+  static Type Get(int64_t value) { return static_cast<uint64_t>(value) ^ 0x8000000000000000ULL; }
+};
+
+template <>
+struct RadixKey<float> {
+  static constexpr bool enabled = true;
+  using Type = uint32_t;
+  static Type Get(float value) {
+    // -0.0 and 0.0 compare equal, so they share the same key.
+    uint32_t bits = 0;
+    if (value != 0) {
+      std::memcpy(&bits, &value, sizeof(bits));
+    }
+    return (bits & 0x80000000U) ? ~bits : (bits | 0x80000000U);
+  }
+};
+
+template <>
+struct RadixKey<double> {
+  static constexpr bool enabled = true;
+  using Type = uint64_t;
+  static Type Get(double value) {
+    uint64_t bits = 0;
+    if (value != 0) {
+      std::memcpy(&bits, &value, sizeof(bits));
+    }
+    return (bits & 0x8000000000000000ULL) ? ~bits : (bits | 0x8000000000000000ULL);
+  }
+};
+
+/*! \brief Rows shorter than this are sorted by comparison instead of radix sort. */
+constexpr int64_t kMinRadixSortLength = 256;
+
+/*!
+ * \brief Stable LSD radix sort of (key, index) pairs, one byte per pass.
+ * \param items The items to be sorted, holding the result on return.
+ * \param scratch The scratch buffer, reused across calls.
+ */
+template <typename UKey>
+void RadixSortPairs(std::vector<std::pair<UKey, int64_t>>* items,
+                    std::vector<std::pair<UKey, int64_t>>* scratch) {
+  constexpr int kNumPasses = sizeof(UKey);
+  const int64_t n = static_cast<int64_t>(items->size());
+  if (n == 0) {
+    return;
+  }
+  std::array<std::array<int64_t, 256>, kNumPasses> histograms{};
+  for (const auto& item : *items) {
+    for (int pass = 0; pass < kNumPasses; ++pass) {
+      ++histograms[pass][(item.first >> (pass * 8)) & 0xFF];
+    }
+  }
+  scratch->resize(n);
+  for (int pass = 0; pass < kNumPasses; ++pass) {
+    std::array<int64_t, 256>& offsets = histograms[pass];
+    // Skip the pass when all the keys share the same digit.
+    if (offsets[(items->front().first >> (pass * 8)) & 0xFF] == n) {
+      continue;
+    }
+    int64_t offset = 0;
+    for (int64_t& count : offsets) {
+      int64_t bucket_size = count;
+      count = offset;
+      offset += bucket_size;
+    }
+    for (const auto& item : *items) {
+      (*scratch)[offsets[(item.first >> (pass * 8)) & 0xFF]++] = item;
+    }
+    items->swap(*scratch);
+  }
+}
+
 // Argsort implemented C library sort for nms.
 // Return indices of sorted tensor.
 // By default, the last axis will be used to sort.
@@ -87,7 +221,6 @@ TVM_REGISTER_GLOBAL("tvm.contrib.sort.argsort_nms").set_body([](TVMArgs args, TV
   auto dtype = input->dtype;
   auto data_ptr = static_cast<float*>(input->data);
   auto sort_num_ptr = static_cast<int32_t*>(sort_num->data);
-  std::vector<std::pair<int32_t, float>> sorter;
   int64_t axis_mul_before = 1;
   int64_t axis_mul_after = 1;
 
@@ -114,8 +247,12 @@ TVM_REGISTER_GLOBAL("tvm.contrib.sort.argsort_nms").set_body([](TVMArgs args, TV
     }
   }
 
-  for (int64_t i = 0; i < axis_mul_before; ++i) {
-    for (int64_t j = 0; j < axis_mul_after; ++j) {
+  ParallelForRows(axis_mul_before * axis_mul_after, input->shape[axis], [&](int64_t row_begin,
+                                                                            int64_t row_end) {
+    std::vector<std::pair<int32_t, float>> sorter;
+    for (int64_t row = row_begin; row < row_end; ++row) {
+      int64_t i = row / axis_mul_after;
+      int64_t j = row % axis_mul_after;
       sorter.clear();
       int32_t current_sort_num = *(sort_num_ptr + i * axis_mul_after + j);
       int64_t base_idx = i * input->shape[axis] * axis_mul_after + j;
@@ -149,7 +286,7 @@ TVM_REGISTER_GLOBAL("tvm.contrib.sort.argsort_nms").set_body([](TVMArgs args, TV
             k < static_cast<int32_t>(sorter.size()) ? sorter[k].first : k;
       }
     }
-  }
+  });
 });
 
 template <typename DataType, typename OutType>
@@ -158,10 +295,9 @@ void sort_impl(
     std::function<void(OutType*, size_t, const std::pair<int64_t, DataType>&)> epilogue) {
   auto data_ptr = static_cast<DataType*>(input->data);
   auto out_ptr = static_cast<OutType*>(output->data);
-  std::vector<std::pair<int64_t, DataType>> sorter;
 
-  int axis_mul_before = 1;
-  int axis_mul_after = 1;
+  int64_t axis_mul_before = 1;
+  int64_t axis_mul_after = 1;
   for (int i = 0; i < input->ndim; ++i) {
     if (i < axis) {
       axis_mul_before *= input->shape[i];
@@ -169,25 +305,51 @@ void sort_impl(
       axis_mul_after *= input->shape[i];
     }
   }
-
-  for (int i = 0; i < axis_mul_before; ++i) {
-    for (int j = 0; j < axis_mul_after; ++j) {
+  int64_t axis_len = input->shape[axis];
+
+  ParallelForRows(axis_mul_before * axis_mul_after, axis_len, [&](int64_t row_begin,
+                                                                  int64_t row_end) {
+    std::vector<std::pair<int64_t, DataType>> sorter;
+    sorter.reserve(axis_len);
+    for (int64_t row = row_begin; row < row_end; ++row) {
+      int64_t i = row / axis_mul_after;
+      int64_t j = row % axis_mul_after;
+      int64_t base_idx = i * axis_len * axis_mul_after + j;
       sorter.clear();
-      int64_t base_idx = i * input->shape[axis] * axis_mul_after + j;
-      for (int64_t k = 0; k < input->shape[axis]; ++k) {
-        int64_t full_idx = base_idx + k * axis_mul_after;
-        sorter.emplace_back(std::make_pair(k, data_ptr[full_idx]));
+      if constexpr (RadixKey<DataType>::enabled) {
+        if (axis_len >= kMinRadixSortLength) {
+          using UKey = typename RadixKey<DataType>::Type;
+          // Thread local so that the buffers are reused across calls on the same worker.
+          thread_local std::vector<std::pair<UKey, int64_t>> keys, scratch;
+          keys.clear();
+          for (int64_t k = 0; k < axis_len; ++k) {
+            UKey key = RadixKey<DataType>::Get(data_ptr[base_idx + k * axis_mul_after]);
+            // Flipping the keys keeps the sort stable for the descending order.
+            keys.emplace_back(is_ascend ? key : ~key, k);
+          }
+          RadixSortPairs(&keys, &scratch);
+          // Gather all the values before writing, as the output may alias the input.
+          for (const auto& key : keys) {
+            sorter.emplace_back(key.second, data_ptr[base_idx + key.second * axis_mul_after]);
+          }
+        }
       }
-      if (is_ascend) {
-        std::stable_sort(sorter.begin(), sorter.end(), CompareAscend<DataType>);
-      } else {
-        std::stable_sort(sorter.begin(), sorter.end(), CompareDescend<DataType>);
+      if (sorter.empty()) {
+        for (int64_t k = 0; k < axis_len; ++k) {
+          int64_t full_idx = base_idx + k * axis_mul_after;
+          sorter.emplace_back(std::make_pair(k, data_ptr[full_idx]));
+        }
+        if (is_ascend) {
+          std::stable_sort(sorter.begin(), sorter.end(), CompareAscend<DataType>);
+        } else {
+          std::stable_sort(sorter.begin(), sorter.end(), CompareDescend<DataType>);
+        }
       }
-      for (int64_t k = 0; k < input->shape[axis]; ++k) {
+      for (int64_t k = 0; k < axis_len; ++k) {
         epilogue(out_ptr, base_idx + k * axis_mul_after, sorter[k]);
       }
     }
-  }
+  });
 }
 
 template <typename DataType, typename OutType>
@@ -346,6 +508,49 @@ TVM_REGISTER_GLOBAL("tvm.contrib.sort.sort").set_body([](TVMArgs args, TVMRetVal
   }
 });
 
+/*!
+ * \brief Select the top-k elements of a row with the given total order, best first.
+ *
+ * A bounded heap is used when k is small compared to the row, otherwise the row is
+ * partitioned with nth_element and only the first k elements are sorted.
+ */
+template <typename DataType, typename Compare>
+void SelectTopK(const DataType* data_ptr, int64_t base_idx, int64_t stride, int64_t axis_len,
+                int64_t k, Compare compare, std::vector<std::pair<int64_t, DataType>>* result) {
+  result->clear();
+  if (k * 16 <= axis_len) {
+    // Maintain a min/max heap containing the top-k elements
+    int64_t cur_axis_index = 0;
+    for (; cur_axis_index < k; cur_axis_index++) {
+      result->emplace_back(cur_axis_index, data_ptr[base_idx + cur_axis_index * stride]);
+    }
+    std::make_heap(result->begin(), result->end(), compare);
+
+    // Iterate through all elements, replacing the top of the heap along the way
+    for (; cur_axis_index < axis_len; cur_axis_index++) {
+      std::pair<int64_t, DataType> cur_val = {cur_axis_index,
+                                              data_ptr[base_idx + cur_axis_index * stride]};
+      if (compare(cur_val, result->front())) {
+        std::pop_heap(result->begin(), result->end(), compare);
+        result->back() = cur_val;
+        std::push_heap(result->begin(), result->end(), compare);
+      }
+    }
+    std::sort(result->begin(), result->end(), compare);
+    return;
+  }
+
+  for (int64_t cur_axis_index = 0; cur_axis_index < axis_len; cur_axis_index++) {
+    result->emplace_back(cur_axis_index, data_ptr[base_idx + cur_axis_index * stride]);
+  }
+  if (k < axis_len) {
+    std::nth_element(result->begin(), result->begin() + k, result->end(), compare);
+    result->resize(k);
+  }
+  // The comparison breaks ties with the index, so the non-stable sort is deterministic.
+  std::sort(result->begin(), result->end(), compare);
+}
+
 template <typename DataType, typename IndicesType>
 void topk(DLTensor* input, DLTensor* out_values, DLTensor* out_indices, int k, int axis,
           bool is_ascend) {
@@ -355,14 +560,8 @@ void topk(DLTensor* input, DLTensor* out_values, DLTensor* out_indices, int k, i
   IndicesType* indices_ptr =
       (out_indices == nullptr) ? nullptr : static_cast<IndicesType*>(out_indices->data);
 
-  // Maintain a min/max containing the top-k elements
-  std::vector<std::pair<int64_t, DataType>> running_heap;
-
-  // Need +1 when inserting new element before maintaining heap invariant
-  running_heap.reserve(k + 1);
-
-  int axis_mul_before = 1;
-  int axis_mul_after = 1;
+  int64_t axis_mul_before = 1;
+  int64_t axis_mul_after = 1;
   for (int i = 0; i < input->ndim; ++i) {
     if (i < axis) {
       axis_mul_before *= input->shape[i];
@@ -370,66 +569,42 @@ void topk(DLTensor* input, DLTensor* out_values, DLTensor* out_indices, int k, i
       axis_mul_after *= input->shape[i];
     }
   }
+  int64_t axis_len = input->shape[axis];
   if (k < 1) {
-    k = input->shape[axis];
+    k = axis_len;
   }
 
-  for (int i = 0; i < axis_mul_before; ++i) {
-    for (int j = 0; j < axis_mul_after; ++j) {
-      running_heap.clear();
-      int64_t src_base_idx = i * input->shape[axis] * axis_mul_after + j;
+  ParallelForRows(axis_mul_before * axis_mul_after, axis_len, [&](int64_t row_begin,
+                                                                  int64_t row_end) {
+    std::vector<std::pair<int64_t, DataType>> top_elems;
+    top_elems.reserve(std::min<int64_t>(k, axis_len) + 1);
+    for (int64_t row = row_begin; row < row_end; ++row) {
+      int64_t i = row / axis_mul_after;
+      int64_t j = row % axis_mul_after;
+      int64_t src_base_idx = i * axis_len * axis_mul_after + j;
       int64_t dst_base_idx = i * k * axis_mul_after + j;
 
-      // Start by creating min/max heap with fixed-k elements
-      int cur_axis_index = 0;
-      for (; cur_axis_index < k && cur_axis_index < input->shape[axis]; cur_axis_index++) {
-        int64_t full_idx = src_base_idx + cur_axis_index * axis_mul_after;
-        running_heap.emplace_back(std::make_pair(cur_axis_index, data_ptr[full_idx]));
-      }
-      if (!is_ascend) {
-        std::make_heap(running_heap.begin(), running_heap.end(), CompareDescend<DataType, true>);
-      } else {
-        std::make_heap(running_heap.begin(), running_heap.end(), CompareAscend<DataType, true>);
-      }
-
-      // Iterate through all elements, adding to heap along the way
-      for (; cur_axis_index < input->shape[axis]; cur_axis_index++) {
-        int64_t full_idx = src_base_idx + cur_axis_index * axis_mul_after;
-        std::pair<int64_t, DataType> cur_val = {cur_axis_index, data_ptr[full_idx]};
-
-        // Eq. to cur_val.second > running_heap.second
-        if (!is_ascend && CompareDescend<DataType, true>(cur_val, running_heap[0])) {
-          running_heap.push_back(cur_val);
-          std::push_heap(running_heap.begin(), running_heap.end(), CompareDescend<DataType, true>);
-          std::pop_heap(running_heap.begin(), running_heap.end(), CompareDescend<DataType, true>);
-          running_heap.pop_back();
-        } else if (is_ascend && CompareAscend<DataType, true>(cur_val, running_heap[0])) {
-          running_heap.push_back(cur_val);
-          std::push_heap(running_heap.begin(), running_heap.end(), CompareAscend<DataType, true>);
-          std::pop_heap(running_heap.begin(), running_heap.end(), CompareAscend<DataType, true>);
-          running_heap.pop_back();
-        }
-      }
-
-      // finally sort heap and deliver results
+      int64_t num_selected = std::min<int64_t>(k, axis_len);
       if (is_ascend) {
-        std::stable_sort(running_heap.begin(), running_heap.end(), CompareAscend<DataType, true>);
+        SelectTopK(data_ptr, src_base_idx, axis_mul_after, axis_len, num_selected,
+                   CompareAscend<DataType, true>, &top_elems);
       } else {
-        std::stable_sort(running_heap.begin(), running_heap.end(), CompareDescend<DataType, true>);
+        SelectTopK(data_ptr, src_base_idx, axis_mul_after, axis_len, num_selected,
+                   CompareDescend<DataType, true>, &top_elems);
       }
 
-      for (uint32_t kk = 0; kk < running_heap.size(); ++kk) {
+      for (size_t kk = 0; kk < top_elems.size(); ++kk) {
         if (indices_ptr != nullptr) {
           indices_ptr[dst_base_idx + kk * axis_mul_after] =
-              static_cast<IndicesType>(running_heap[kk].first);
+              static_cast<IndicesType>(top_elems[kk].first);
         }
         if (values_ptr != nullptr) {
           values_ptr[dst_base_idx + kk * axis_mul_after] =
-              static_cast<DataType>(running_heap[kk].second);
+              static_cast<DataType>(top_elems[kk].second);
         }
       }
     }
-  }
+  });
 }
 
 // Argsort implemented C library sort.
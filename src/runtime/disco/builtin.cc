@@ -84,6 +84,12 @@ void AllReduce(NDArray send, ReduceKind reduce_kind, NDArray recv) {
   GetCCLFunc("allreduce")(send, static_cast<int>(reduce_kind), recv);
 }
 
+void AllReduceStart(NDArray send, ReduceKind reduce_kind, NDArray recv) {
+  GetCCLFunc("allreduce_start")(send, static_cast<int>(reduce_kind), recv);
+}
+
+NDArray AllReduceWait(NDArray recv) { return GetCCLFunc("allreduce_wait")(recv); }
+
 void AllGather(NDArray send, NDArray recv) { GetCCLFunc("allgather")(send, recv); }
 
 void BroadcastFromWorker0(NDArray send, NDArray recv) {
@@ -100,6 +106,22 @@ void GatherToWorker0(NDArray send, Optional<NDArray> recv) {
 
 void RecvFromWorker0(NDArray buffer) { GetCCLFunc("recv_from_worker0")(buffer); }
 
+void SendToWorker(NDArray buffer, int receiver_id) {
+  GetCCLFunc("send_to_worker")(buffer, receiver_id);
+}
+
+void RecvFromWorker(NDArray buffer, int sender_id) {
+  GetCCLFunc("recv_from_worker")(buffer, sender_id);
+}
+
+void SendToWorkerFromHost(NDArray host_buffer, NDArray buffer, int receiver_id) {
+  GetCCLFunc("send_to_worker_from_host")(host_buffer, buffer, receiver_id);
+}
+
+void RecvFromWorkerToHost(NDArray buffer, int sender_id, NDArray host_buffer) {
+  GetCCLFunc("recv_from_worker_to_host")(buffer, sender_id, host_buffer);
+}
+
 int WorkerId() { return DiscoWorker::ThreadLocal()->worker_id; }
 
 void SyncWorker() {
@@ -116,11 +138,29 @@ TVM_REGISTER_GLOBAL("runtime.disco.allreduce")
       CHECK(0 <= kind && kind <= 4) << "ValueError: Unknown ReduceKind: " << kind;
       AllReduce(send, static_cast<ReduceKind>(kind), recv);
     });
+TVM_REGISTER_GLOBAL("runtime.disco.allreduce_start")
+    .set_body_typed([](NDArray send, ShapeTuple reduce_kind, NDArray recv) {
+      int kind = IntegerFromShapeTuple(reduce_kind);
+      CHECK(0 <= kind && kind <= 4) << "ValueError: Unknown ReduceKind: " << kind;
+      AllReduceStart(send, static_cast<ReduceKind>(kind), recv);
+    });
+// The input of the allreduce is taken as well, so that the memory planning of the VM keeps it
+// alive until the allreduce completes.
+TVM_REGISTER_GLOBAL("runtime.disco.allreduce_wait")
+    .set_body_typed([](NDArray recv, NDArray send) { return AllReduceWait(recv); });
 TVM_REGISTER_GLOBAL("runtime.disco.allgather").set_body_typed(AllGather);
 TVM_REGISTER_GLOBAL("runtime.disco.broadcast_from_worker0").set_body_typed(BroadcastFromWorker0);
 TVM_REGISTER_GLOBAL("runtime.disco.scatter_from_worker0").set_body_typed(ScatterFromWorker0);
 TVM_REGISTER_GLOBAL("runtime.disco.gather_to_worker0").set_body_typed(GatherToWorker0);
 TVM_REGISTER_GLOBAL("runtime.disco.recv_from_worker0").set_body_typed(RecvFromWorker0);
+TVM_REGISTER_GLOBAL("runtime.disco.send_to_worker")
+    .set_body_typed([](NDArray buffer, ShapeTuple receiver_id) {
+      SendToWorker(buffer, IntegerFromShapeTuple(receiver_id));
+    });
+TVM_REGISTER_GLOBAL("runtime.disco.recv_from_worker")
+    .set_body_typed([](NDArray buffer, ShapeTuple sender_id) {
+      RecvFromWorker(buffer, IntegerFromShapeTuple(sender_id));
+    });
 TVM_REGISTER_GLOBAL("runtime.disco.worker_id").set_body_typed([]() -> ShapeTuple {
   return ShapeTuple({WorkerId()});
 });
@@ -19,6 +19,8 @@
 #ifndef TVM_RUNTIME_DISCO_BUILTIN_H_
 #define TVM_RUNTIME_DISCO_BUILTIN_H_
 
+#include <tvm/runtime/container/array.h>
+#include <tvm/runtime/container/optional.h>
 #include <tvm/runtime/data_type.h>
 #include <tvm/runtime/module.h>
 #include <tvm/runtime/ndarray.h>
@@ -52,6 +54,19 @@ NDArray DiscoEmptyNDArray(ShapeTuple shape, DataType dtype, Device device);
  * \return The outcome of allreduce
  */
 void AllReduce(NDArray send, ReduceKind reduce_kind, NDArray recv);
+/*!
+ * \brief Start an allreduce operation without blocking the computation that follows it.
+ * \param send The array send to perform allreduce on
+ * \param reduce_kind The kind of reduction operation (e.g. sum, avg, min, max)
+ * \param recv The receive buffer, which holds the outcome once AllReduceWait is called on it
+ */
+void AllReduceStart(NDArray send, ReduceKind reduce_kind, NDArray recv);
+/*!
+ * \brief Make the computation that follows wait for an allreduce started by AllReduceStart
+ * \param recv The receive buffer of the allreduce
+ * \return The receive buffer, holding the outcome of allreduce
+ */
+NDArray AllReduceWait(NDArray recv);
 /*!
  * \brief Perform an allgather operation using the underlying communication library
  * \param send The array send to perform allgather on
@@ -83,6 +98,47 @@ void GatherToWorker0(NDArray send, Optional<NDArray> recv);
  * \param buffer The buffer to be received
  */
 void RecvFromWorker0(NDArray buffer);
+/*!
+ * \brief Send a buffer to another worker.
+ * \param buffer The buffer to be sent
+ * \param receiver_id The id of the receiving worker
+ */
+void SendToWorker(NDArray buffer, int receiver_id);
+/*!
+ * \brief Receive a buffer from another worker.
+ * \param buffer The buffer to be received
+ * \param sender_id The id of the sending worker
+ */
+void RecvFromWorker(NDArray buffer, int sender_id);
+/*!
+ * \brief Copy a host buffer to a device buffer, and send it to another worker.
+ * \param host_buffer The host buffer to be sent
+ * \param buffer The device buffer of the same size, which the host buffer is copied to
+ * \param receiver_id The id of the receiving worker
+ */
+void SendToWorkerFromHost(NDArray host_buffer, NDArray buffer, int receiver_id);
+/*!
+ * \brief Receive a buffer from another worker, and copy it to a host buffer. Only the receive is
+ * waited for, rather than all the work of the worker.
+ * \param buffer The device buffer to be received
+ * \param sender_id The id of the sending worker
+ * \param host_buffer The host buffer of the same size, which the received buffer is copied to
+ */
+void RecvFromWorkerToHost(NDArray buffer, int sender_id, NDArray host_buffer);
+/*!
+ * \brief Run the stage of the current worker in a pipeline, streaming micro-batches from the
+ * previous stage to the next one. Worker `i` runs the function `{func_name}_stage{i}` of the VM.
+ * \param vm_module The RelaxVM
+ * \param func_name The name of the partitioned function
+ * \param microbatches The inputs of each micro-batch to the first stage, only used by worker-0
+ * and None on the others
+ * \param params The parameters of the stage of the current worker
+ * \param num_microbatches The number of micro-batches
+ * \return The outputs of each micro-batch on the last worker, and an empty array on the others
+ */
+Array<ObjectRef> RunPipeline(Module vm_module, String func_name,
+                             Optional<Array<ObjectRef>> microbatches, Array<ObjectRef> params,
+                             int num_microbatches);
 /*! \brief Get the local worker id */
 int WorkerId();
 /*!
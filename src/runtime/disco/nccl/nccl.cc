@@ -25,6 +25,7 @@
 #include <cstring>
 #include <mutex>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 #include "../../../support/process_id.h"
@@ -62,11 +63,31 @@ namespace nccl {
 #define TVM_DISCO_CCL_NAME "nccl"
 
 using deviceStream_t = cudaStream_t;
+using deviceEvent_t = cudaEvent_t;
 const constexpr DLDeviceType TVM_DISCO_DEVICE_TYPE = DLDeviceType::kDLCUDA;
 inline void SetDevice(int device_id) { CUDA_CALL(cudaSetDevice(device_id)); }
 inline void StreamSynchronize(deviceStream_t stream) { CUDA_CALL(cudaStreamSynchronize(stream)); }
 inline void StreamCreate(deviceStream_t* stream) { CUDA_CALL(cudaStreamCreate(stream)); }
+inline void StreamCreateNonBlocking(deviceStream_t* stream) {
+  CUDA_CALL(cudaStreamCreateWithFlags(stream, cudaStreamNonBlocking));
+}
 inline void StreamDestroy(deviceStream_t stream) { CUDA_CALL(cudaStreamDestroy(stream)); }
+inline void EventCreate(deviceEvent_t* event) {
+  CUDA_CALL(cudaEventCreateWithFlags(event, cudaEventDisableTiming));
+}
+inline void EventDestroy(deviceEvent_t event) { CUDA_CALL(cudaEventDestroy(event)); }
+inline void EventRecord(deviceEvent_t event, deviceStream_t stream) {
+  CUDA_CALL(cudaEventRecord(event, stream));
+}
+inline void StreamWaitEvent(deviceStream_t stream, deviceEvent_t event) {
+  CUDA_CALL(cudaStreamWaitEvent(stream, event, 0));
+}
+inline void EventSynchronize(deviceEvent_t event) { CUDA_CALL(cudaEventSynchronize(event)); }
+inline void MemcpyAsync(void* dst, const void* src, size_t size, bool to_host,
+                        deviceStream_t stream) {
+  cudaMemcpyKind kind = to_host ? cudaMemcpyDeviceToHost : cudaMemcpyHostToDevice;
+  CUDA_CALL(cudaMemcpyAsync(dst, src, size, kind, stream));
+}
 
 #else
 
@@ -74,11 +95,31 @@ inline void StreamDestroy(deviceStream_t stream) { CUDA_CALL(cudaStreamDestroy(s
 #define TVM_DISCO_CCL_NAME "rccl"
 
 using deviceStream_t = hipStream_t;
+using deviceEvent_t = hipEvent_t;
 const constexpr DLDeviceType TVM_DISCO_DEVICE_TYPE = DLDeviceType::kDLROCM;
 inline void SetDevice(int device_id) { ROCM_CALL(hipSetDevice(device_id)); }
 inline void StreamSynchronize(deviceStream_t stream) { ROCM_CALL(hipStreamSynchronize(stream)); }
 inline void StreamCreate(deviceStream_t* stream) { ROCM_CALL(hipStreamCreate(stream)); }
+inline void StreamCreateNonBlocking(deviceStream_t* stream) {
+  ROCM_CALL(hipStreamCreateWithFlags(stream, hipStreamNonBlocking));
+}
 inline void StreamDestroy(deviceStream_t stream) { ROCM_CALL(hipStreamDestroy(stream)); }
+inline void EventCreate(deviceEvent_t* event) {
+  ROCM_CALL(hipEventCreateWithFlags(event, hipEventDisableTiming));
+}
+inline void EventDestroy(deviceEvent_t event) { ROCM_CALL(hipEventDestroy(event)); }
+inline void EventRecord(deviceEvent_t event, deviceStream_t stream) {
+  ROCM_CALL(hipEventRecord(event, stream));
+}
+inline void StreamWaitEvent(deviceStream_t stream, deviceEvent_t event) {
+  ROCM_CALL(hipStreamWaitEvent(stream, event, 0));
+}
+inline void EventSynchronize(deviceEvent_t event) { ROCM_CALL(hipEventSynchronize(event)); }
+inline void MemcpyAsync(void* dst, const void* src, size_t size, bool to_host,
+                        deviceStream_t stream) {
+  hipMemcpyKind kind = to_host ? hipMemcpyDeviceToHost : hipMemcpyHostToDevice;
+  ROCM_CALL(hipMemcpyAsync(dst, src, size, kind, stream));
+}
 
 #endif
 
@@ -138,6 +179,19 @@ struct CCLThreadLocalContext {
   DiscoWorker* worker;
   int device_id;
   deviceStream_t default_stream = nullptr;
+  /*!
+   * \brief The stream of the asynchronous collectives. It does not synchronize with the legacy
+   * default stream, so that the collectives overlap with the kernels.
+   */
+  deviceStream_t comm_stream = nullptr;
+  /*! \brief The event making the communication stream wait for the compute stream. */
+  deviceEvent_t ready_event = nullptr;
+  /*! \brief The completion events of the asynchronous allreduces, keyed by the receive buffer. */
+  std::unordered_map<void*, deviceEvent_t> pending_events;
+  /*! \brief The completion events that can be reused. */
+  std::vector<deviceEvent_t> free_events;
+  /*! \brief The event waited by the host for the buffers received to the host. */
+  deviceEvent_t host_event = nullptr;
   ncclComm_t comm;
 
   void Clear() {
@@ -145,13 +199,46 @@ struct CCLThreadLocalContext {
     if (default_stream != nullptr) {
       StreamDestroy(default_stream);
     }
+    if (comm_stream != nullptr) {
+      StreamDestroy(comm_stream);
+    }
+    if (ready_event != nullptr) {
+      EventDestroy(ready_event);
+    }
+    for (const auto& [buffer, event] : pending_events) {
+      EventDestroy(event);
+    }
+    pending_events.clear();
+    for (deviceEvent_t event : free_events) {
+      EventDestroy(event);
+    }
+    free_events.clear();
+    if (host_event != nullptr) {
+      EventDestroy(host_event);
+    }
   }
 
   deviceStream_t GetDefaultStream() {
+    deviceStream_t stream = GetComputeStream();
+    return stream == nullptr ? default_stream : stream;
+  }
+
+  /*!
+   * \brief The stream that the kernels of the worker are launched on, where nullptr stands for
+   * the legacy default stream.
+   */
+  deviceStream_t GetComputeStream() {
     const auto* func = tvm::runtime::Registry::Get("runtime.get_" TVM_DISCO_DEVICE_NAME "_stream");
     ICHECK(func != nullptr);
-    deviceStream_t stream = static_cast<deviceStream_t>((*func)().operator void*());
-    return stream == nullptr ? default_stream : stream;
+    return static_cast<deviceStream_t>((*func)().operator void*());
+  }
+
+  deviceStream_t GetCommStream() {
+    if (comm_stream == nullptr) {
+      StreamCreateNonBlocking(&comm_stream);
+      EventCreate(&ready_event);
+    }
+    return comm_stream;
   }
 
   static CCLThreadLocalContext* Get() {
@@ -205,6 +292,40 @@ void AllReduce(NDArray send, ReduceKind reduce_kind, NDArray recv) {
                           /*op=*/AsNCCLRedOp(reduce_kind), ctx->comm, stream));
 }
 
+void AllReduceStart(NDArray send, ReduceKind reduce_kind, NDArray recv) {
+  CCLThreadLocalContext* ctx = CCLThreadLocalContext::Get();
+  CHECK(!ctx->pending_events.count(recv->data))
+      << "ValueError: An allreduce into the receive buffer is already in flight";
+  deviceStream_t stream = ctx->GetComputeStream();
+  deviceStream_t comm_stream = ctx->GetCommStream();
+  // The collective starts once the producer of `send` on the compute stream is done.
+  EventRecord(ctx->ready_event, stream);
+  StreamWaitEvent(comm_stream, ctx->ready_event);
+  NCCL_CALL(ncclAllReduce(send->data, recv->data, send.Shape()->Product(),
+                          /*datatype=*/AsNCCLDataType(DataType(send->dtype)),
+                          /*op=*/AsNCCLRedOp(reduce_kind), ctx->comm, comm_stream));
+  deviceEvent_t done;
+  if (ctx->free_events.empty()) {
+    EventCreate(&done);
+  } else {
+    done = ctx->free_events.back();
+    ctx->free_events.pop_back();
+  }
+  EventRecord(done, comm_stream);
+  ctx->pending_events.emplace(recv->data, done);
+}
+
+NDArray AllReduceWait(NDArray recv) {
+  CCLThreadLocalContext* ctx = CCLThreadLocalContext::Get();
+  auto it = ctx->pending_events.find(recv->data);
+  CHECK(it != ctx->pending_events.end())
+      << "ValueError: No allreduce into the receive buffer is in flight";
+  StreamWaitEvent(ctx->GetComputeStream(), it->second);
+  ctx->free_events.push_back(it->second);
+  ctx->pending_events.erase(it);
+  return recv;
+}
+
 void AllGather(NDArray send, NDArray recv) {
   CCLThreadLocalContext* ctx = CCLThreadLocalContext::Get();
   ShapeTuple shape = send.Shape();
@@ -320,6 +441,50 @@ void RecvFromWorker0(NDArray buffer) {
   NCCL_CALL(ncclGroupEnd());
 }
 
+void SendToWorker(NDArray buffer, int receiver_id) {
+  CCLThreadLocalContext* ctx = CCLThreadLocalContext::Get();
+  deviceStream_t stream = ctx->GetDefaultStream();
+  CHECK(0 <= receiver_id && receiver_id < ctx->worker->num_workers)
+      << "ValueError: Invalid receiver id " << receiver_id;
+  CHECK_NE(receiver_id, ctx->worker->worker_id)
+      << "ValueError: A worker is not allowed to send to itself.";
+  NCCL_CALL(ncclSend(buffer->data, buffer.Shape()->Product(), AsNCCLDataType(buffer.DataType()),
+                     receiver_id, ctx->comm, stream));
+}
+
+void RecvFromWorker(NDArray buffer, int sender_id) {
+  CCLThreadLocalContext* ctx = CCLThreadLocalContext::Get();
+  deviceStream_t stream = ctx->GetDefaultStream();
+  CHECK(0 <= sender_id && sender_id < ctx->worker->num_workers)
+      << "ValueError: Invalid sender id " << sender_id;
+  CHECK_NE(sender_id, ctx->worker->worker_id)
+      << "ValueError: A worker is not allowed to receive from itself.";
+  NCCL_CALL(ncclRecv(buffer->data, buffer.Shape()->Product(), AsNCCLDataType(buffer.DataType()),
+                     sender_id, ctx->comm, stream));
+}
+
+void SendToWorkerFromHost(NDArray host_buffer, NDArray buffer, int receiver_id) {
+  CCLThreadLocalContext* ctx = CCLThreadLocalContext::Get();
+  // The copy is ordered after the previous send of the buffer on the same stream.
+  MemcpyAsync(buffer->data, host_buffer->data, GetDataSize(*buffer.operator->()),
+              /*to_host=*/false, ctx->GetDefaultStream());
+  SendToWorker(buffer, receiver_id);
+}
+
+void RecvFromWorkerToHost(NDArray buffer, int sender_id, NDArray host_buffer) {
+  CCLThreadLocalContext* ctx = CCLThreadLocalContext::Get();
+  deviceStream_t stream = ctx->GetDefaultStream();
+  RecvFromWorker(buffer, sender_id);
+  MemcpyAsync(host_buffer->data, buffer->data, GetDataSize(*buffer.operator->()),
+              /*to_host=*/true, stream);
+  // Only wait for the receive, instead of all the work on the stream.
+  if (ctx->host_event == nullptr) {
+    EventCreate(&ctx->host_event);
+  }
+  EventRecord(ctx->host_event, stream);
+  EventSynchronize(ctx->host_event);
+}
+
 void SyncWorker() {
   CCLThreadLocalContext* ctx = CCLThreadLocalContext::Get();
   ICHECK(ctx->worker != nullptr);
@@ -338,6 +503,13 @@ TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".allreduce")
       CHECK(0 <= kind && kind <= 4) << "ValueError: Unknown ReduceKind: " << kind;
       AllReduce(send, static_cast<ReduceKind>(kind), recv);
     });
+TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".allreduce_start")
+    .set_body_typed([](NDArray send, int kind, NDArray recv) {
+      CHECK(0 <= kind && kind <= 4) << "ValueError: Unknown ReduceKind: " << kind;
+      AllReduceStart(send, static_cast<ReduceKind>(kind), recv);
+    });
+TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".allreduce_wait")
+    .set_body_typed(AllReduceWait);
 TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".allgather")
     .set_body_typed([](NDArray send, NDArray recv) { AllGather(send, recv); });
 TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".broadcast_from_worker0")
@@ -348,6 +520,14 @@ TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".gather_to_worker0")
     .set_body_typed(GatherToWorker0);
 TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".recv_from_worker0")
     .set_body_typed(RecvFromWorker0);
+TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".send_to_worker")
+    .set_body_typed(SendToWorker);
+TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".recv_from_worker")
+    .set_body_typed(RecvFromWorker);
+TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".send_to_worker_from_host")
+    .set_body_typed(SendToWorkerFromHost);
+TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".recv_from_worker_to_host")
+    .set_body_typed(RecvFromWorkerToHost);
 TVM_REGISTER_GLOBAL("runtime.disco." TVM_DISCO_CCL_NAME ".sync_worker").set_body_typed(SyncWorker);
 
 }  // namespace nccl
@@ -0,0 +1,175 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file pipeline.cc
+ * \brief Pipeline-parallel execution of the stages produced by PartitionPipelineStages.
+ *
+ * Each worker runs one stage. For every micro-batch, a worker receives the activations from the
+ * previous worker, runs its stage, and sends the results to the next worker. The communication is
+ * asynchronous on the stream of the communication library, so that the stages of consecutive
+ * micro-batches overlap across the workers.
+ */
+#include <tvm/runtime/container/array.h>
+#include <tvm/runtime/disco/session.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+#include <vector>
+
+#include "./builtin.h"
+#include "./utils.h"
+#include "./worker.h"
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief The header sent before the tensors of each micro-batch, so that the receiver can
+ * allocate the buffers. It holds the number of tensors, followed by the dtype code, bits, lanes,
+ * ndim and shape of each tensor.
+ */
+constexpr int kPipelineHeaderSize = 64;
+
+/*! \brief The header buffers of a worker, reused across the micro-batches and the calls. */
+struct PipelineHeaderBuffers {
+  /*! \brief The buffer on the device of the worker, which the header is communicated with. */
+  NDArray device_buffer;
+  /*! \brief The buffer on the host, which the header is written to or read from. */
+  NDArray host_buffer;
+
+  static PipelineHeaderBuffers* Get(Device device) {
+    thread_local PipelineHeaderBuffers buffers;
+    if (!buffers.device_buffer.defined() ||
+        buffers.device_buffer->device.device_type != device.device_type ||
+        buffers.device_buffer->device.device_id != device.device_id) {
+      buffers.device_buffer = NDArray::Empty({kPipelineHeaderSize}, DataType::Int(64), device);
+      buffers.host_buffer =
+          NDArray::Empty({kPipelineHeaderSize}, DataType::Int(64), Device{kDLCPU, 0});
+    }
+    return &buffers;
+  }
+};
+
+void SendTensorsToWorker(const Array<ObjectRef>& tensors, int receiver_id, Device device) {
+  CHECK(!tensors.empty()) << "ValueError: A pipeline stage must send at least one tensor";
+  PipelineHeaderBuffers* buffers = PipelineHeaderBuffers::Get(device);
+  int64_t* header = static_cast<int64_t*>(buffers->host_buffer->data);
+  std::vector<NDArray> arrays;
+  arrays.reserve(tensors.size());
+  int pos = 0;
+  header[pos++] = static_cast<int64_t>(tensors.size());
+  for (const ObjectRef& tensor : tensors) {
+    const auto* container = tensor.as<NDArray::Container>();
+    CHECK(container != nullptr) << "TypeError: A pipeline stage can only send tensors, but got "
+                                << tensor->GetTypeKey();
+    NDArray array = GetRef<NDArray>(container);
+    int ndim = array->ndim;
+    CHECK_LE(pos + 4 + ndim, kPipelineHeaderSize)
+        << "ValueError: The tensors sent by a pipeline stage have too many dimensions in total";
+    header[pos++] = array->dtype.code;
+    header[pos++] = array->dtype.bits;
+    header[pos++] = array->dtype.lanes;
+    header[pos++] = ndim;
+    for (int j = 0; j < ndim; ++j) {
+      header[pos++] = array->shape[j];
+    }
+    arrays.push_back(array);
+  }
+  SendToWorkerFromHost(buffers->host_buffer, buffers->device_buffer, receiver_id);
+  for (const NDArray& array : arrays) {
+    SendToWorker(array, receiver_id);
+  }
+}
+
+Array<ObjectRef> RecvTensorsFromWorker(int sender_id, Device device) {
+  PipelineHeaderBuffers* buffers = PipelineHeaderBuffers::Get(device);
+  RecvFromWorkerToHost(buffers->device_buffer, sender_id, buffers->host_buffer);
+  const int64_t* header = static_cast<const int64_t*>(buffers->host_buffer->data);
+  int64_t num_tensors = header[0];
+  Array<ObjectRef> tensors;
+  int pos = 1;
+  for (int64_t i = 0; i < num_tensors; ++i) {
+    DLDataType dtype{static_cast<uint8_t>(header[pos]), static_cast<uint8_t>(header[pos + 1]),
+                     static_cast<uint16_t>(header[pos + 2])};
+    int ndim = header[pos + 3];
+    pos += 4;
+    ShapeTuple shape(header + pos, header + pos + ndim);
+    pos += ndim;
+    NDArray buffer = NDArray::Empty(shape, dtype, device);
+    RecvFromWorker(buffer, sender_id);
+    tensors.push_back(buffer);
+  }
+  return tensors;
+}
+
+Array<ObjectRef> RunPipeline(Module vm_module, String func_name,
+                             Optional<Array<ObjectRef>> microbatches, Array<ObjectRef> params,
+                             int num_microbatches) {
+  DiscoWorker* worker = DiscoWorker::ThreadLocal();
+  int stage = worker->worker_id;
+  int num_stages = worker->num_workers;
+  Device device = worker->default_device;
+  std::string stage_name = func_name + "_stage" + std::to_string(stage);
+  PackedFunc stage_func = vm_module->GetFunction(stage_name);
+  CHECK(stage_func != nullptr) << "ValueError: Cannot find the pipeline stage `" << stage_name
+                               << "` of worker " << stage << " in the VM module";
+  if (stage == 0) {
+    CHECK(microbatches.defined()) << "ValueError: The micro-batches must be provided to worker-0";
+    CHECK_EQ(static_cast<int>(microbatches.value().size()), num_microbatches)
+        << "ValueError: The number of micro-batches mismatches";
+  }
+
+  Array<ObjectRef> outputs;
+  for (int i = 0; i < num_microbatches; ++i) {
+    Array<ObjectRef> inputs = stage == 0 ? Downcast<Array<ObjectRef>>(microbatches.value()[i])
+                                         : RecvTensorsFromWorker(stage - 1, device);
+    int num_args = inputs.size() + params.size();
+    std::vector<TVMValue> tvm_args(num_args);
+    std::vector<int> type_codes(num_args);
+    TVMArgsSetter setter(tvm_args.data(), type_codes.data());
+    for (size_t j = 0; j < inputs.size(); ++j) {
+      setter(j, inputs[j]);
+    }
+    for (size_t j = 0; j < params.size(); ++j) {
+      setter(inputs.size() + j, params[j]);
+    }
+    TVMRetValue rv;
+    stage_func.CallPacked(TVMArgs(tvm_args.data(), type_codes.data(), num_args), &rv);
+    if (stage + 1 < num_stages) {
+      Array<ObjectRef> results = rv;
+      SendTensorsToWorker(results, stage + 1, device);
+    } else {
+      ObjectRef result = rv;
+      outputs.push_back(result);
+    }
+  }
+  return outputs;
+}
+
+TVM_REGISTER_GLOBAL("runtime.disco.run_pipeline")
+    .set_body_typed([](Module vm_module, String func_name,
+                       Optional<Array<ObjectRef>> microbatches, Array<ObjectRef> params,
+                       ShapeTuple num_microbatches) {
+      return RunPipeline(vm_module, func_name, microbatches, params,
+                         IntegerFromShapeTuple(num_microbatches));
+    });
+
+}  // namespace runtime
+}  // namespace tvm
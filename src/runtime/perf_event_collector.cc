@@ -0,0 +1,296 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/runtime/perf_event_collector.cc
+ * \brief MetricCollector reading the Linux perf_event performance counters.
+ */
+#include <tvm/runtime/profiling.h>
+#include <tvm/runtime/registry.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+namespace profiling {
+
+#if defined(__linux__)
+
+/*! \brief A perf event that can be collected, named after the `perf` tool. */
+struct PerfEventType {
+  /*! \brief The perf_event type, e.g. PERF_TYPE_HARDWARE. */
+  uint32_t type;
+  /*! \brief The perf_event config within the type. */
+  uint64_t config;
+};
+
+static const std::unordered_map<std::string, PerfEventType>& SupportedPerfEvents() {
+  static const std::unordered_map<std::string, PerfEventType> events = {
+      {"cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+      {"instructions", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+      {"cache-references", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES}},
+      {"cache-misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}},
+      {"branch-instructions", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS}},
+      {"branch-misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}},
+      {"stalled-cycles-frontend", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND}},
+      {"stalled-cycles-backend", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND}},
+      {"task-clock", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}},
+      {"context-switches", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}},
+      {"cpu-migrations", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS}},
+      {"page-faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}},
+  };
+  return events;
+}
+
+/*! \brief The events collected when none is specified. */
+static const std::vector<std::string> kDefaultPerfEvents = {
+    "cycles", "instructions", "cache-misses", "branch-misses", "context-switches"};
+
+/*! \brief The software events replacing the hardware events that cannot be opened. */
+static const std::vector<std::string> kFallbackPerfEvents = {"task-clock", "page-faults"};
+
+/*!
+ * \brief Open a counter of the event for a thread.
+ * \return The file descriptor of the counter, or -1 with errno set on failure.
+ */
+static int OpenPerfEvent(const PerfEventType& event, pid_t tid) {
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.exclude_hv = 1;
+  // Scale the counts when the kernel multiplexes more events than hardware counters.
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0));
+  if (fd < 0 && errno == EACCES) {
+    // perf_event_paranoid >= 2 only allows counting the user space.
+    attr.exclude_kernel = 1;
+    fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0));
+  }
+  return fd;
+}
+
+/*! \brief The ids of the threads of the current process. */
+static std::vector<pid_t> ListThreads() {
+  std::vector<pid_t> tids;
+  if (DIR* dir = opendir("/proc/self/task")) {
+    while (struct dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        tids.push_back(static_cast<pid_t>(std::atoi(entry->d_name)));
+      }
+    }
+    closedir(dir);
+  }
+  if (tids.empty()) {
+    tids.push_back(static_cast<pid_t>(syscall(SYS_gettid)));
+  }
+  return tids;
+}
+
+/*! \brief Counter values of all the events at the start of a call. */
+struct PerfEventStartNode : public Object {
+  /*! \brief The value of each event, summed over the threads. */
+  std::vector<double> start_values;
+
+  explicit PerfEventStartNode(std::vector<double> start_values)
+      : start_values(std::move(start_values)) {}
+
+  static constexpr const char* _type_key = "PerfEventStartNode";
+  TVM_DECLARE_FINAL_OBJECT_INFO(PerfEventStartNode, Object);
+};
+
+/*! \brief MetricCollectorNode for the Linux perf_event counters of the CPU.
+ *
+ * One counter is opened per event and per thread of the process when `Init`
+ * is called, so the work of the runtime thread pool is included as long as
+ * the pool has been started at that point. Threads created afterwards are not
+ * counted. Hardware events that are unavailable (e.g. in a virtual machine or
+ * under a restrictive `perf_event_paranoid`) are replaced by software events.
+ */
+struct PerfEventMetricCollectorNode final : public MetricCollectorNode {
+  explicit PerfEventMetricCollectorNode(Array<String> metrics) {
+    for (const String& metric : metrics) {
+      requested_names_.push_back(metric);
+    }
+  }
+
+  void Init(Array<DeviceWrapper> devs) final {
+    // The collector is initialized by each profiling run. Reopen the counters, so that the
+    // threads started since the previous run are counted too.
+    CloseAll();
+    std::vector<std::string> requested =
+        requested_names_.empty() ? kDefaultPerfEvents : requested_names_;
+
+    std::vector<pid_t> tids = ListThreads();
+    bool hardware_unavailable = false;
+    auto try_open = [&](const std::string& name) {
+      auto it = SupportedPerfEvents().find(name);
+      if (it == SupportedPerfEvents().end()) {
+        std::string supported;
+        for (const auto& kv : SupportedPerfEvents()) {
+          supported += " " + kv.first;
+        }
+        LOG(FATAL) << "Unknown perf event \"" << name << "\". Supported events are:" << supported;
+      }
+      std::vector<int> fds;
+      for (pid_t tid : tids) {
+        int fd = OpenPerfEvent(it->second, tid);
+        if (fd < 0) {
+          // The thread may have exited since the listing.
+          if (errno == ESRCH) continue;
+          int error = errno;
+          for (int opened : fds) close(opened);
+          if (it->second.type == PERF_TYPE_HARDWARE) {
+            hardware_unavailable = true;
+          }
+          LOG(WARNING) << "Cannot open perf event \"" << name << "\": " << std::strerror(error)
+                       << ". Try setting "
+                       << "`sudo sh -c 'echo 1 >/proc/sys/kernel/perf_event_paranoid'`";
+          return;
+        }
+        fds.push_back(fd);
+      }
+      event_names_.push_back(name);
+      event_fds_.push_back(std::move(fds));
+    };
+    for (const std::string& name : requested) {
+      try_open(name);
+    }
+    if (hardware_unavailable) {
+      for (const std::string& name : kFallbackPerfEvents) {
+        if (std::find(event_names_.begin(), event_names_.end(), name) == event_names_.end()) {
+          try_open(name);
+        }
+      }
+    }
+    for (const auto& fds : event_fds_) {
+      for (int fd : fds) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  ObjectRef Start(Device dev) final {
+    if (dev.device_type != kDLCPU || event_names_.empty()) {
+      return ObjectRef(nullptr);
+    }
+    return ObjectRef(make_object<PerfEventStartNode>(ReadAll()));
+  }
+
+  Map<String, ObjectRef> Stop(ObjectRef obj) final {
+    const PerfEventStartNode* start = obj.as<PerfEventStartNode>();
+    std::vector<double> end_values = ReadAll();
+    Map<String, ObjectRef> reported_metrics;
+    for (size_t i = 0; i < end_values.size(); ++i) {
+      double delta = end_values[i] - start->start_values[i];
+      if (delta < 0) {
+        LOG(WARNING) << "Detected overflow when reading performance counter, setting value to -1.";
+        delta = -1;
+      }
+      if (event_names_[i] == "task-clock" && delta >= 0) {
+        // The task clock is counted in nanoseconds.
+        reported_metrics.Set(event_names_[i], ObjectRef(make_object<DurationNode>(delta / 1e3)));
+      } else {
+        reported_metrics.Set(event_names_[i],
+                             ObjectRef(make_object<CountNode>(static_cast<int64_t>(delta))));
+      }
+    }
+    return reported_metrics;
+  }
+
+  ~PerfEventMetricCollectorNode() final { CloseAll(); }
+
+  static constexpr const char* _type_key = "runtime.profiling.PerfEventMetricCollector";
+  TVM_DECLARE_FINAL_OBJECT_INFO(PerfEventMetricCollectorNode, MetricCollectorNode);
+
+ private:
+  /*! \brief Read the value of each event, summed over the threads. */
+  std::vector<double> ReadAll() const {
+    std::vector<double> values(event_fds_.size(), 0);
+    for (size_t i = 0; i < event_fds_.size(); ++i) {
+      for (int fd : event_fds_[i]) {
+        // value, time enabled, time running
+        uint64_t data[3] = {0, 0, 0};
+        if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+          continue;
+        }
+        values[i] += static_cast<double>(data[0]) * data[1] / data[2];
+      }
+    }
+    return values;
+  }
+
+  /*! \brief Close the counters opened by Init. */
+  void CloseAll() {
+    for (const auto& fds : event_fds_) {
+      for (int fd : fds) {
+        close(fd);
+      }
+    }
+    event_fds_.clear();
+    event_names_.clear();
+  }
+
+  /*! \brief The names of the requested events, or empty for the default events. */
+  std::vector<std::string> requested_names_;
+  /*! \brief The names of the collected events. */
+  std::vector<std::string> event_names_;
+  /*! \brief The counter of each event for each thread, in the order of event_names_. */
+  std::vector<std::vector<int>> event_fds_;
+};
+
+MetricCollector CreatePerfEventMetricCollector(Array<String> metrics) {
+  return MetricCollector(make_object<PerfEventMetricCollectorNode>(metrics));
+}
+
+TVM_REGISTER_OBJECT_TYPE(PerfEventStartNode);
+TVM_REGISTER_OBJECT_TYPE(PerfEventMetricCollectorNode);
+
+TVM_REGISTER_GLOBAL("runtime.profiling.PerfEventMetricCollector")
+    .set_body_typed(CreatePerfEventMetricCollector);
+
+#else
+
+MetricCollector CreatePerfEventMetricCollector(Array<String> metrics) {
+  LOG(FATAL) << "The perf_event metric collector is only available on Linux";
+  return MetricCollector();
+}
+
+#endif
+
+}  // namespace profiling
+}  // namespace runtime
+}  // namespace tvm
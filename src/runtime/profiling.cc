@@ -31,8 +31,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <numeric>
 #include <thread>
@@ -932,6 +934,200 @@ PackedFunc WrapTimeEvaluator(PackedFunc pf, Device dev, int number, int repeat,
   return PackedFunc(ftimer);
 }
 
+namespace {
+
+/*! \brief The statistics of the benchmark samples. */
+struct BenchmarkStats {
+  size_t num_outliers{0};
+  double mean{0}, median{0}, p90{0}, p99{0}, min{0}, max{0}, std{0};
+  double ci95{0}, rel_ci95{0}, noise{0};
+};
+
+/*! \brief Get the q-th quantile of sorted values with linear interpolation, as numpy does. */
+double Quantile(const std::vector<double>& sorted, double q) {
+  double pos = q * (sorted.size() - 1);
+  size_t lo = static_cast<size_t>(pos);
+  size_t hi = std::min(lo + 1, sorted.size() - 1);
+  return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+/*! \brief The two-sided 95% quantile of the Student's t-distribution. */
+double StudentT95(size_t dof) {
+  static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                 2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                                 2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                                 2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+  if (dof == 0) return std::numeric_limits<double>::infinity();
+  if (dof <= sizeof(table) / sizeof(table[0])) return table[dof - 1];
+  return 1.96;
+}
+
+/*!
+ * \brief Compute the statistics of the samples.
+ * The samples further than 3 scaled median absolute deviations from the median are treated as
+ * outliers, e.g. caused by preemption, and excluded from the mean and its confidence interval.
+ */
+BenchmarkStats ComputeBenchmarkStats(const std::vector<double>& samples) {
+  BenchmarkStats stats;
+  std::vector<double> sorted = samples;
+  std::sort(sorted.begin(), sorted.end());
+  stats.median = Quantile(sorted, 0.5);
+  stats.p90 = Quantile(sorted, 0.9);
+  stats.p99 = Quantile(sorted, 0.99);
+  stats.min = sorted.front();
+  stats.max = sorted.back();
+
+  std::vector<double> deviations;
+  for (double x : sorted) deviations.push_back(std::abs(x - stats.median));
+  std::sort(deviations.begin(), deviations.end());
+  // 1.4826 scales the MAD into an estimate of the standard deviation of a normal distribution.
+  double scaled_mad = 1.4826 * Quantile(deviations, 0.5);
+  stats.noise = stats.median > 0 ? scaled_mad / stats.median : 0;
+
+  std::vector<double> inliers;
+  for (double x : samples) {
+    if (scaled_mad == 0 || std::abs(x - stats.median) <= 3 * scaled_mad) {
+      inliers.push_back(x);
+    }
+  }
+  stats.num_outliers = samples.size() - inliers.size();
+  stats.mean = std::accumulate(inliers.begin(), inliers.end(), 0.0) / inliers.size();
+  double sq_sum = 0;
+  for (double x : inliers) sq_sum += (x - stats.mean) * (x - stats.mean);
+  size_t n = inliers.size();
+  stats.std = n > 1 ? std::sqrt(sq_sum / (n - 1)) : 0;
+  stats.ci95 = n > 1 ? StudentT95(n - 1) * stats.std / std::sqrt(static_cast<double>(n))
+                     : std::numeric_limits<double>::infinity();
+  stats.rel_ci95 = stats.mean > 0 ? stats.ci95 / stats.mean : 0;
+  return stats;
+}
+
+}  // namespace
+
+PackedFunc WrapBenchmarkEvaluator(PackedFunc pf, Device dev, int min_repeat_ms, int warmup_ms,
+                                  int min_repeat, int max_repeat, int max_time_ms,
+                                  double target_rel_ci, bool pin_threads, int cache_flush_bytes,
+                                  PackedFunc f_preproc) {
+  ICHECK(pf != nullptr);
+  ICHECK_GE(min_repeat, 2) << "ValueError: At least 2 samples are needed to estimate the noise";
+  ICHECK_GE(max_repeat, min_repeat) << "ValueError: max_repeat must be at least min_repeat";
+
+  auto fbenchmark = [pf, dev, min_repeat_ms, warmup_ms, min_repeat, max_repeat, max_time_ms,
+                     target_rel_ci, pin_threads, cache_flush_bytes,
+                     f_preproc](TVMArgs args, TVMRetValue* rv) {
+    using Clock = std::chrono::steady_clock;
+    TVMRetValue temp;
+    if (pin_threads && dev.device_type == kDLCPU) {
+      threading::Configure(threading::ThreadGroup::kBig, 0, {});
+    }
+    Clock::time_point begin = Clock::now();
+    auto elapsed_ms = [&begin]() {
+      return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    };
+
+    // Warm up, and estimate the time per call to choose the number of calls per sample.
+    pf.CallPacked(args, &temp);
+    DeviceAPI::Get(dev)->StreamSync(dev, nullptr);
+    int64_t warmup_calls = 0;
+    Timer warmup_timer = Timer::Start(dev);
+    do {
+      pf.CallPacked(args, &temp);
+      ++warmup_calls;
+    } while (elapsed_ms() < warmup_ms);
+    warmup_timer->Stop();
+    double ms_per_call = warmup_timer->SyncAndGetElapsedNanos() / 1e6 / warmup_calls;
+    int number = 1;
+    if (ms_per_call > 0) {
+      number = static_cast<int>(std::max(1.0, std::ceil(min_repeat_ms / ms_per_call)));
+    }
+
+    NDArray arr1, arr2;
+    if (cache_flush_bytes > 0) {
+      arr1 = NDArray::Empty({cache_flush_bytes / 4}, {kDLInt, 32, 1}, dev);
+      arr2 = NDArray::Empty({cache_flush_bytes / 4}, {kDLInt, 32, 1}, dev);
+    }
+
+    std::vector<double> samples;
+    BenchmarkStats stats;
+    bool converged = false;
+    while (true) {
+      if (f_preproc != nullptr) {
+        f_preproc.CallPacked(args, &temp);
+      }
+      if (cache_flush_bytes > 0) {
+        arr1.CopyFrom(arr2);
+      }
+      DeviceAPI::Get(dev)->StreamSync(dev, nullptr);
+      Timer t = Timer::Start(dev);
+      for (int j = 0; j < number; ++j) {
+        pf.CallPacked(args, &temp);
+      }
+      t->Stop();
+      samples.push_back(t->SyncAndGetElapsedNanos() / 1e9 / number);
+
+      if (static_cast<int>(samples.size()) < min_repeat) continue;
+      stats = ComputeBenchmarkStats(samples);
+      if (stats.rel_ci95 <= target_rel_ci) {
+        converged = true;
+        break;
+      }
+      if (static_cast<int>(samples.size()) >= max_repeat ||
+          (max_time_ms > 0 && elapsed_ms() >= max_time_ms)) {
+        break;
+      }
+    }
+
+    // The keys are part of a stable schema compared across builds, bump the version on change.
+    std::ostringstream os;
+    os << std::setprecision(9);
+    os << "{\"schema_version\":1,\"unit\":\"s\""
+       << ",\"device\":{\"device_type\":" << static_cast<int>(dev.device_type)
+       << ",\"device_id\":" << dev.device_id << "}"
+       << ",\"config\":{\"min_repeat_ms\":" << min_repeat_ms << ",\"warmup_ms\":" << warmup_ms
+       << ",\"min_repeat\":" << min_repeat << ",\"max_repeat\":" << max_repeat
+       << ",\"max_time_ms\":" << max_time_ms << ",\"target_rel_ci\":" << target_rel_ci
+       << ",\"pin_threads\":" << (pin_threads ? "true" : "false") << "}"
+       << ",\"number\":" << number << ",\"num_samples\":" << samples.size()
+       << ",\"num_outliers\":" << stats.num_outliers
+       << ",\"converged\":" << (converged ? "true" : "false") << ",\"mean\":" << stats.mean
+       << ",\"median\":" << stats.median << ",\"p90\":" << stats.p90 << ",\"p99\":" << stats.p99
+       << ",\"min\":" << stats.min << ",\"max\":" << stats.max << ",\"std\":" << stats.std
+       << ",\"ci95\":" << stats.ci95 << ",\"rel_ci95\":" << stats.rel_ci95
+       << ",\"noise\":" << stats.noise << ",\"samples\":[";
+    for (size_t i = 0; i < samples.size(); ++i) {
+      if (i != 0) os << ",";
+      os << samples[i];
+    }
+    os << "]}";
+    *rv = os.str();
+  };
+  return PackedFunc(fbenchmark);
+}
+
+TVM_REGISTER_GLOBAL("runtime.BenchmarkEvaluator")
+    .set_body_typed([](Module mod, String name, int device_type, int device_id, int min_repeat_ms,
+                       int warmup_ms, int min_repeat, int max_repeat, int max_time_ms,
+                       double target_rel_ci, bool pin_threads, int cache_flush_bytes,
+                       String f_preproc_name) {
+      ICHECK_NE(mod->type_key(), std::string("rpc"))
+          << "Benchmarking a module over RPC is not yet supported";
+      Device dev;
+      dev.device_type = static_cast<DLDeviceType>(device_type);
+      dev.device_id = device_id;
+      PackedFunc f_preproc;
+      if (!f_preproc_name.empty()) {
+        auto* pf_preproc = runtime::Registry::Get(f_preproc_name);
+        ICHECK(pf_preproc != nullptr)
+            << "Cannot find " << f_preproc_name << " in the global function";
+        f_preproc = *pf_preproc;
+      }
+      PackedFunc pf = mod.GetFunction(name, true);
+      CHECK(pf != nullptr) << "Cannot find " << name << " in the module";
+      return WrapBenchmarkEvaluator(pf, dev, min_repeat_ms, warmup_ms, min_repeat, max_repeat,
+                                    max_time_ms, target_rel_ci, pin_threads, cache_flush_bytes,
+                                    f_preproc);
+    });
+
 TVM_REGISTER_GLOBAL("runtime.profiling.Report")
     .set_body_typed([](Array<Map<String, ObjectRef>> calls,
                        Map<String, Map<String, ObjectRef>> device_metrics,
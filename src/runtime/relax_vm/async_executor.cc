@@ -0,0 +1,191 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/runtime/relax_vm/async_executor.cc
+ */
+#include "async_executor.h"
+
+#include <tvm/runtime/registry.h>
+
+#include <chrono>
+#include <optional>
+#include <utility>
+
+namespace tvm {
+namespace runtime {
+namespace relax_vm {
+
+//-------------------------------------------------
+// InvokeFuture
+//-------------------------------------------------
+bool InvokeFutureObj::Poll() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return done_;
+}
+
+bool InvokeFutureObj::Wait(int64_t timeout_ms) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (timeout_ms < 0) {
+    cv_.wait(lock, [this] { return done_; });
+    return true;
+  }
+  return cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return done_; });
+}
+
+TVMRetValue InvokeFutureObj::Get() {
+  Wait(-1);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+  return result_;
+}
+
+void InvokeFutureObj::SetResult(TVMRetValue result) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result_ = std::move(result);
+    done_ = true;
+  }
+  cv_.notify_all();
+}
+
+void InvokeFutureObj::SetError(std::exception_ptr error) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = std::move(error);
+    done_ = true;
+  }
+  cv_.notify_all();
+}
+
+TVM_REGISTER_OBJECT_TYPE(InvokeFutureObj);
+
+//-------------------------------------------------
+// AsyncExecutor
+//-------------------------------------------------
+AsyncExecutor::AsyncExecutor(Device device, int64_t max_in_flight)
+    : device_(device), max_in_flight_(max_in_flight) {
+  CHECK_GT(max_in_flight, 0) << "ValueError: The in-flight bound must be positive";
+  worker_ = std::thread([this] { this->WorkerLoop(); });
+}
+
+AsyncExecutor::~AsyncExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+  worker_.join();
+}
+
+InvokeFuture AsyncExecutor::Submit(std::function<TVMRetValue()> task) {
+  InvokeFuture future(make_object<InvokeFutureObj>());
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return num_in_flight_ < max_in_flight_; });
+    ++num_in_flight_;
+    queue_.push_back(Task{std::move(task), future});
+  }
+  cv_.notify_all();
+  return future;
+}
+
+void AsyncExecutor::WorkerLoop() {
+  std::vector<std::pair<InvokeFuture, TVMRetValue>> launched;
+  while (true) {
+    std::optional<Task> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (queue_.empty() && !launched.empty()) {
+        // Nothing left to overlap with the launched invocations.
+        lock.unlock();
+        Complete(&launched);
+        lock.lock();
+      }
+      cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        break;
+      }
+      task = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    try {
+      TVMRetValue result = task->func();
+      launched.emplace_back(task->future, std::move(result));
+    } catch (...) {
+      std::exception_ptr error = std::current_exception();
+      Complete(&launched);
+      task->future->SetError(error);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --num_in_flight_;
+      }
+      cv_.notify_all();
+      continue;
+    }
+    if (static_cast<int64_t>(launched.size()) >= max_in_flight_) {
+      Complete(&launched);
+    }
+  }
+}
+
+void AsyncExecutor::Complete(std::vector<std::pair<InvokeFuture, TVMRetValue>>* launched) {
+  if (launched->empty()) {
+    return;
+  }
+  std::exception_ptr error;
+  try {
+    DeviceAPI::Get(device_)->StreamSync(device_, nullptr);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  for (auto& [future, result] : *launched) {
+    if (error) {
+      future->SetError(error);
+    } else {
+      future->SetResult(std::move(result));
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_in_flight_ -= launched->size();
+  }
+  launched->clear();
+  cv_.notify_all();
+}
+
+TVM_REGISTER_GLOBAL("vm.builtin.invoke_future_poll").set_body_typed([](InvokeFuture future) {
+  return future->Poll();
+});
+
+TVM_REGISTER_GLOBAL("vm.builtin.invoke_future_wait")
+    .set_body_typed([](InvokeFuture future, int64_t timeout_ms) {
+      return future->Wait(timeout_ms);
+    });
+
+TVM_REGISTER_GLOBAL("vm.builtin.invoke_future_get").set_body([](TVMArgs args, TVMRetValue* rv) {
+  InvokeFuture future = args[0];
+  *rv = future->Get();
+});
+
+}  // namespace relax_vm
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/runtime/relax_vm/async_executor.h
+ * \brief The executor running the asynchronous invocations of a Relax VM.
+ *
+ * The invocations are queued and run in order by a worker thread owned by the VM, so that the
+ * calling thread can prepare the next request while the current one runs. Each invocation
+ * returns an `InvokeFuture` that completes once the device has finished its computation. To
+ * pipeline the invocations on the device, the worker does not synchronize the device after each
+ * invocation, but only when the queue is empty or the number of launched but unsynchronized
+ * invocations reaches the in-flight bound.
+ */
+#ifndef TVM_RUNTIME_RELAX_VM_ASYNC_EXECUTOR_H_
+#define TVM_RUNTIME_RELAX_VM_ASYNC_EXECUTOR_H_
+
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/object.h>
+#include <tvm/runtime/packed_func.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+namespace relax_vm {
+
+/*! \brief The result of an asynchronous invocation. */
+class InvokeFutureObj : public Object {
+ public:
+  /*! \return Whether the invocation has completed. */
+  bool Poll();
+
+  /*!
+   * \brief Wait for the invocation to complete.
+   * \param timeout_ms The maximum time to wait in milliseconds, or a negative value to wait
+   * without limit.
+   * \return Whether the invocation has completed.
+   */
+  bool Wait(int64_t timeout_ms);
+
+  /*!
+   * \brief Wait for the invocation to complete and get its result.
+   * \return The result. Rethrows the error raised by the invocation, if any.
+   */
+  TVMRetValue Get();
+
+  /*! \brief Complete the invocation with a result. */
+  void SetResult(TVMRetValue result);
+
+  /*! \brief Complete the invocation with an error. */
+  void SetError(std::exception_ptr error);
+
+  static constexpr const uint32_t _type_index = TypeIndex::kDynamic;
+  static constexpr const char* _type_key = "relax.vm.InvokeFuture";
+  TVM_DECLARE_FINAL_OBJECT_INFO(InvokeFutureObj, Object);
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool done_{false};
+  TVMRetValue result_;
+  std::exception_ptr error_;
+};
+
+/*! \brief Managed reference to InvokeFutureObj. */
+class InvokeFuture : public ObjectRef {
+ public:
+  TVM_DEFINE_MUTABLE_NOTNULLABLE_OBJECT_REF_METHODS(InvokeFuture, ObjectRef, InvokeFutureObj);
+};
+
+class AsyncExecutor {
+ public:
+  /*!
+   * \brief Create the executor and start its worker thread.
+   * \param device The device the invocations run on, synchronized before completing them.
+   * \param max_in_flight The maximum number of invocations that are queued or not completed.
+   */
+  AsyncExecutor(Device device, int64_t max_in_flight);
+
+  /*! \brief Run the remaining invocations and stop the worker thread. */
+  ~AsyncExecutor();
+
+  /*!
+   * \brief Queue an invocation. Blocks while `max_in_flight` invocations are in flight.
+   * \param task The invocation, run on the worker thread.
+   * \return The future of the invocation.
+   */
+  InvokeFuture Submit(std::function<TVMRetValue()> task);
+
+ private:
+  struct Task {
+    std::function<TVMRetValue()> func;
+    InvokeFuture future;
+  };
+
+  void WorkerLoop();
+  /*! \brief Synchronize the device and complete the launched invocations. */
+  void Complete(std::vector<std::pair<InvokeFuture, TVMRetValue>>* launched);
+
+  Device device_;
+  int64_t max_in_flight_;
+  std::mutex mutex_;
+  /*! \brief Notifies the worker of new tasks, and the submitters of completed ones. */
+  std::condition_variable cv_;
+  std::deque<Task> queue_;
+  /*! \brief The number of invocations submitted and not completed yet. */
+  int64_t num_in_flight_{0};
+  bool shutdown_{false};
+  std::thread worker_;
+};
+
+}  // namespace relax_vm
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_RELAX_VM_ASYNC_EXECUTOR_H_
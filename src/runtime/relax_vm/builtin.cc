@@ -356,6 +356,22 @@ TVM_REGISTER_GLOBAL("vm.builtin.alloc_storage").set_body_typed(VMAllocStorage);
 
 TVM_REGISTER_GLOBAL("vm.builtin.alloc_tensor").set_body_method<Storage>(&StorageObj::AllocNDArray);
 
+/*!
+ * \brief Get a storage of the persistent workspace of the VM.
+ * \param ctx_ptr The VM context.
+ * \param slot The index of the storage in the workspace.
+ * \return The storage.
+ */
+ObjectRef VMGetPersistentWorkspace(void* ctx_ptr, int64_t slot) {
+  VirtualMachine* vm = static_cast<VirtualMachine*>(ctx_ptr);
+  ICHECK_LT(slot, static_cast<int64_t>(vm->persistent_workspace.size()))
+      << "The persistent workspace slot is out of range. Did the VM initialize the workspace?";
+  return vm->persistent_workspace[slot];
+}
+
+TVM_REGISTER_GLOBAL("vm.builtin.get_persistent_workspace")
+    .set_body_typed(VMGetPersistentWorkspace);
+
 //-------------------------------------------------
 //  Closure function handling, calling convention
 //-------------------------------------------------
@@ -174,6 +174,16 @@ void MemoryManager::Clear() {
   m->allocators_.clear();
 }
 
+size_t MemoryManager::UsedMemory(Device dev) {
+  MemoryManager* m = MemoryManager::Global();
+  std::lock_guard<std::mutex> lock(m->mutex_);
+  auto it = m->allocators_.find(dev);
+  if (it == m->allocators_.end()) {
+    return 0;
+  }
+  return it->second->UsedMemory();
+}
+
 Buffer Allocator::Alloc(ShapeTuple shape, DLDataType dtype, String mem_scope) {
   ICHECK_EQ(shape.size(), 1) << "Allocator of type (" << type_
                              << ") does not support nD allocation. Please use allocator type ("
@@ -209,6 +219,10 @@ runtime::NDArray Allocator::Empty(ShapeTuple shape, DLDataType dtype, DLDevice d
 
 TVM_REGISTER_GLOBAL("vm.builtin.memory_manager.clear").set_body_typed(MemoryManager::Clear);
 
+TVM_REGISTER_GLOBAL("vm.builtin.memory_manager.used_memory").set_body_typed([](Device dev) {
+  return static_cast<int64_t>(MemoryManager::UsedMemory(dev));
+});
+
 }  // namespace relax_vm
 }  // namespace runtime
 }  // namespace tvm
@@ -74,6 +74,8 @@ class NaiveAllocator final : public Allocator {
     DLOG(INFO) << "free " << buffer.size << " B, used memory " << used_memory_ << " B";
   }
 
+  size_t UsedMemory() const override { return used_memory_.load(std::memory_order_relaxed); }
+
  private:
   std::atomic<size_t> used_memory_;
   Device device_;
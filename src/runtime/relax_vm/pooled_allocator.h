@@ -82,6 +82,8 @@ class PooledAllocator final : public Allocator {
     DLOG(INFO) << "reclaim buffer " << buffer.size;
   }
 
+  size_t UsedMemory() const override { return used_memory_.load(std::memory_order_relaxed); }
+
  private:
   void ReleaseAll() {
     std::lock_guard<std::recursive_mutex> lock(mu_);
@@ -0,0 +1,403 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/runtime/relax_vm/request_batcher.cc
+ * \brief Dynamic batching of the requests to a Relax VM function.
+ *
+ * The batcher queues the incoming requests of a VM function. A worker thread takes up to the
+ * largest batch bucket of compatible requests from the queue, once the queue holds a full batch
+ * or the oldest request has waited for the maximum latency. The batched inputs are concatenated
+ * along their declared batch axis and padded to the smallest bucket that fits, by repeating the
+ * last sample. After one invocation of the function, the outputs are split along their batch axis
+ * and returned to each request through its future.
+ */
+#include <tvm/runtime/data_type.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_executor.h"
+
+namespace tvm {
+namespace runtime {
+namespace relax_vm {
+
+/*!
+ * \brief Copy `rows` slices along `axis`, from position `src_row` of `src` to position `dst_row`
+ * of `dst`. The two arrays must be contiguous and agree on all the other dimensions.
+ */
+void CopyRows(const NDArray& src, int64_t src_row, const NDArray& dst, int64_t dst_row,
+              int64_t rows, int axis) {
+  int64_t outer = 1;
+  for (int i = 0; i < axis; ++i) {
+    outer *= src->shape[i];
+  }
+  int64_t inner_bytes = (src->dtype.bits * src->dtype.lanes + 7) / 8;
+  for (int i = axis + 1; i < src->ndim; ++i) {
+    inner_bytes *= src->shape[i];
+  }
+  int64_t src_extent = src->shape[axis];
+  int64_t dst_extent = dst->shape[axis];
+  int64_t nbytes = rows * inner_bytes;
+  DLDataType byte_type{kDLUInt, 8, 1};
+  for (int64_t o = 0; o < outer; ++o) {
+    uint64_t src_offset = src->byte_offset + (o * src_extent + src_row) * inner_bytes;
+    uint64_t dst_offset = dst->byte_offset + (o * dst_extent + dst_row) * inner_bytes;
+    DLTensor from{src->data, src->device, 1, byte_type, &nbytes, nullptr, src_offset};
+    DLTensor to{dst->data, dst->device, 1, byte_type, &nbytes, nullptr, dst_offset};
+    NDArray::CopyFromTo(&from, &to);
+  }
+}
+
+/*! \brief Slice `rows` entries along `axis` of `src`, starting at `begin`, into a new array. */
+NDArray SliceRows(const NDArray& src, int64_t begin, int64_t rows, int axis) {
+  std::vector<int64_t> shape = src.Shape();
+  shape[axis] = rows;
+  NDArray dst = NDArray::Empty(shape, src->dtype, src->device);
+  CopyRows(src, begin, dst, 0, rows, axis);
+  return dst;
+}
+
+class RequestBatcherObj : public Object {
+ public:
+  /*!
+   * \brief Create the batcher and start its worker thread.
+   * \param func The VM function to batch the requests of.
+   * \param batch_buckets The batch sizes the function is compiled for, in increasing order.
+   * \param input_axes The batch axis of each input, or -1 for the inputs shared by all requests.
+   * Only the requests passing the same arrays as the shared inputs are batched together.
+   * \param output_axes The batch axis of each output, or -1 for the outputs returned to every
+   * request as is.
+   * \param max_latency_us The maximum time a request waits for the batch to fill, in
+   * microseconds.
+   */
+  RequestBatcherObj(PackedFunc func, std::vector<int64_t> batch_buckets,
+                    std::vector<int64_t> input_axes, std::vector<int64_t> output_axes,
+                    int64_t max_latency_us)
+      : func_(std::move(func)),
+        batch_buckets_(std::move(batch_buckets)),
+        input_axes_(std::move(input_axes)),
+        output_axes_(std::move(output_axes)),
+        max_latency_(std::chrono::microseconds(max_latency_us)) {
+    CHECK(!batch_buckets_.empty()) << "ValueError: At least one batch bucket is required";
+    CHECK(std::is_sorted(batch_buckets_.begin(), batch_buckets_.end()) &&
+          batch_buckets_.front() > 0)
+        << "ValueError: The batch buckets must be positive and in increasing order";
+    CHECK(std::any_of(input_axes_.begin(), input_axes_.end(), [](int64_t a) { return a >= 0; }))
+        << "ValueError: At least one input must have a batch axis";
+    worker_ = std::thread([this] { this->WorkerLoop(); });
+  }
+
+  ~RequestBatcherObj() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+  }
+
+  /*!
+   * \brief Queue a request.
+   * \param args The inputs of the request.
+   * \return The future of the outputs of the request.
+   */
+  InvokeFuture Submit(TVMArgs args) {
+    CHECK_EQ(static_cast<size_t>(args.size()), input_axes_.size())
+        << "ValueError: The batched function takes " << input_axes_.size() << " inputs, but "
+        << args.size() << " are provided";
+    Request request{{}, -1, InvokeFuture(make_object<InvokeFutureObj>()),
+                    std::chrono::steady_clock::now()};
+    for (int i = 0; i < args.size(); ++i) {
+      TVMRetValue arg;
+      if (args[i].type_code() == kTVMDLTensorHandle) {
+        // The DLTensor is only valid during this call.
+        DLTensor* tensor = args[i];
+        arg = NDArray::NewFromDLTensor(tensor, tensor->device);
+      } else {
+        arg = args[i];
+      }
+      if (input_axes_[i] >= 0) {
+        NDArray tensor = arg;
+        CHECK(tensor.IsContiguous()) << "ValueError: The batched inputs must be contiguous";
+        CHECK_LT(input_axes_[i], tensor->ndim)
+            << "ValueError: Input " << i << " has no batch axis " << input_axes_[i];
+        int64_t batch = tensor->shape[input_axes_[i]];
+        CHECK(request.batch == -1 || request.batch == batch)
+            << "ValueError: The batched inputs of a request disagree on the batch size";
+        request.batch = batch;
+      }
+      request.args.push_back(std::move(arg));
+    }
+    CHECK_GT(request.batch, 0) << "ValueError: The request batch size must be positive, but got "
+                               << request.batch;
+    CHECK_LE(request.batch, batch_buckets_.back())
+        << "ValueError: The request batch size " << request.batch
+        << " exceeds the largest bucket " << batch_buckets_.back();
+    InvokeFuture future = request.future;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queued_batch_ += request.batch;
+      queue_.push_back(std::move(request));
+    }
+    cv_.notify_all();
+    return future;
+  }
+
+  static constexpr const uint32_t _type_index = TypeIndex::kDynamic;
+  static constexpr const char* _type_key = "relax.vm.RequestBatcher";
+  TVM_DECLARE_FINAL_OBJECT_INFO(RequestBatcherObj, Object);
+
+ private:
+  struct Request {
+    std::vector<TVMRetValue> args;
+    int64_t batch;
+    InvokeFuture future;
+    std::chrono::steady_clock::time_point arrival;
+  };
+
+  /*! \brief Whether two requests share the same value of a shared input. */
+  static bool SameSharedInput(const TVMRetValue& lhs, const TVMRetValue& rhs) {
+    if (lhs.type_code() != rhs.type_code()) {
+      return false;
+    }
+    if (lhs.type_code() == kTVMNDArrayHandle) {
+      NDArray a = lhs;
+      NDArray b = rhs;
+      return a.same_as(b) || (a->data == b->data && a->byte_offset == b->byte_offset &&
+                              a.Shape() == b.Shape() && DataType(a->dtype) == DataType(b->dtype));
+    }
+    if (lhs.IsObjectRef<ObjectRef>()) {
+      return lhs.AsObjectRef<ObjectRef>().same_as(rhs.AsObjectRef<ObjectRef>());
+    }
+    if (lhs.type_code() == kDLInt) {
+      return lhs.operator int64_t() == rhs.operator int64_t();
+    }
+    if (lhs.type_code() == kDLFloat) {
+      return lhs.operator double() == rhs.operator double();
+    }
+    if (lhs.type_code() == kTVMStr) {
+      return lhs.operator std::string() == rhs.operator std::string();
+    }
+    return lhs.value().v_handle == rhs.value().v_handle;
+  }
+
+  /*! \brief Whether two requests can be batched together. */
+  bool Compatible(const Request& lhs, const Request& rhs) const {
+    for (size_t i = 0; i < input_axes_.size(); ++i) {
+      if (input_axes_[i] < 0) {
+        // The shared inputs are taken from the first request of the batch.
+        if (!SameSharedInput(lhs.args[i], rhs.args[i])) {
+          return false;
+        }
+        continue;
+      }
+      NDArray a = lhs.args[i];
+      NDArray b = rhs.args[i];
+      if (a->ndim != b->ndim || DataType(a->dtype) != DataType(b->dtype) ||
+          a->device.device_type != b->device.device_type ||
+          a->device.device_id != b->device.device_id) {
+        return false;
+      }
+      for (int d = 0; d < a->ndim; ++d) {
+        if (d != input_axes_[i] && a->shape[d] != b->shape[d]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void WorkerLoop() {
+    int64_t max_batch = batch_buckets_.back();
+    while (true) {
+      std::vector<Request> batch;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          break;
+        }
+        auto deadline = queue_.front().arrival + max_latency_;
+        cv_.wait_until(lock, deadline,
+                       [this, max_batch] { return shutdown_ || queued_batch_ >= max_batch; });
+        // Take the oldest request, and the compatible requests that fit in the largest bucket.
+        int64_t total = 0;
+        for (auto it = queue_.begin(); it != queue_.end() && total < max_batch;) {
+          if (total + it->batch <= max_batch && (batch.empty() || Compatible(batch[0], *it))) {
+            total += it->batch;
+            queued_batch_ -= it->batch;
+            batch.push_back(std::move(*it));
+            it = queue_.erase(it);
+          } else {
+            ++it;
+          }
+        }
+      }
+      RunBatch(&batch);
+    }
+  }
+
+  void RunBatch(std::vector<Request>* batch) {
+    const std::vector<Request>& requests = *batch;
+    try {
+      int64_t total = 0;
+      for (const Request& request : requests) {
+        total += request.batch;
+      }
+      int64_t bucket = *std::lower_bound(batch_buckets_.begin(), batch_buckets_.end(), total);
+
+      // Concatenate the batched inputs, padded to the bucket size.
+      size_t num_inputs = input_axes_.size();
+      std::vector<TVMRetValue> inputs(num_inputs);
+      std::vector<TVMValue> values(num_inputs);
+      std::vector<int> tcodes(num_inputs);
+      TVMArgsSetter setter(values.data(), tcodes.data());
+      for (size_t i = 0; i < num_inputs; ++i) {
+        int axis = input_axes_[i];
+        if (axis < 0) {
+          inputs[i] = requests[0].args[i];
+        } else if (requests.size() == 1 && total == bucket) {
+          inputs[i] = requests[0].args[i];
+        } else {
+          NDArray first = requests[0].args[i];
+          std::vector<int64_t> shape = first.Shape();
+          shape[axis] = bucket;
+          NDArray batched = NDArray::Empty(shape, first->dtype, first->device);
+          int64_t offset = 0;
+          for (const Request& request : requests) {
+            CopyRows(request.args[i], 0, batched, offset, request.batch, axis);
+            offset += request.batch;
+          }
+          const Request& last = requests.back();
+          for (; offset < bucket; ++offset) {
+            CopyRows(last.args[i], last.batch - 1, batched, offset, 1, axis);
+          }
+          inputs[i] = batched;
+        }
+        setter(i, inputs[i]);
+      }
+      TVMRetValue rv;
+      func_.CallPacked(TVMArgs(values.data(), tcodes.data(), num_inputs), &rv);
+
+      // Split the outputs along their batch axis.
+      ObjectRef output = rv.AsObjectRef<ObjectRef>();
+      const auto* tuple = output.as<ArrayNode>();
+      size_t num_outputs = tuple != nullptr ? tuple->size() : 1;
+      CHECK_EQ(num_outputs, output_axes_.size())
+          << "ValueError: The batched function returns " << num_outputs << " outputs, but "
+          << output_axes_.size() << " output batch axes are declared";
+      std::vector<ObjectRef> outputs;
+      for (size_t j = 0; j < num_outputs; ++j) {
+        outputs.push_back(tuple != nullptr ? tuple->at(j) : output);
+      }
+      int64_t offset = 0;
+      for (const Request& request : requests) {
+        std::vector<ObjectRef> results;
+        for (size_t j = 0; j < num_outputs; ++j) {
+          int axis = output_axes_[j];
+          if (axis < 0) {
+            results.push_back(outputs[j]);
+          } else {
+            NDArray out = Downcast<NDArray>(outputs[j]);
+            CHECK_LT(axis, out->ndim)
+                << "ValueError: Output " << j << " has no batch axis " << axis;
+            CHECK_EQ(out->shape[axis], bucket)
+                << "ValueError: Output " << j << " has a batch size of " << out->shape[axis]
+                << " while the inputs are batched to " << bucket;
+            results.push_back(SliceRows(out, offset, request.batch, axis));
+          }
+        }
+        offset += request.batch;
+        TVMRetValue result;
+        if (tuple != nullptr) {
+          result = Array<ObjectRef>(results.begin(), results.end());
+        } else {
+          result = results[0];
+        }
+        request.future->SetResult(std::move(result));
+      }
+    } catch (...) {
+      std::exception_ptr error = std::current_exception();
+      for (const Request& request : requests) {
+        if (!request.future->Poll()) {
+          request.future->SetError(error);
+        }
+      }
+    }
+  }
+
+  /*! \brief The VM function to batch the requests of. */
+  PackedFunc func_;
+  /*! \brief The batch sizes the function is compiled for, in increasing order. */
+  std::vector<int64_t> batch_buckets_;
+  /*! \brief The batch axis of each input, or -1 if the input is shared. */
+  std::vector<int64_t> input_axes_;
+  /*! \brief The batch axis of each output, or -1 if the output is shared. */
+  std::vector<int64_t> output_axes_;
+  /*! \brief The maximum time a request waits for the batch to fill. */
+  std::chrono::steady_clock::duration max_latency_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  /*! \brief The queued requests, in arrival order. */
+  std::list<Request> queue_;
+  /*! \brief The total batch size of the queued requests. */
+  int64_t queued_batch_{0};
+  bool shutdown_{false};
+  std::thread worker_;
+};
+
+class RequestBatcher : public ObjectRef {
+ public:
+  TVM_DEFINE_MUTABLE_NOTNULLABLE_OBJECT_REF_METHODS(RequestBatcher, ObjectRef, RequestBatcherObj);
+};
+
+TVM_REGISTER_OBJECT_TYPE(RequestBatcherObj);
+
+TVM_REGISTER_GLOBAL("vm.builtin.request_batcher_create")
+    .set_body_typed([](Module vm, String func_name, ShapeTuple batch_buckets,
+                       ShapeTuple input_axes, ShapeTuple output_axes, int64_t max_latency_us) {
+      PackedFunc func = vm->GetFunction(func_name, true);
+      CHECK(func != nullptr) << "ValueError: Unknown function: " << func_name;
+      return RequestBatcher(make_object<RequestBatcherObj>(
+          func, std::vector<int64_t>(batch_buckets.begin(), batch_buckets.end()),
+          std::vector<int64_t>(input_axes.begin(), input_axes.end()),
+          std::vector<int64_t>(output_axes.begin(), output_axes.end()), max_latency_us));
+    });
+
+TVM_REGISTER_GLOBAL("vm.builtin.request_batcher_submit")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      RequestBatcher batcher = args[0];
+      *rv = batcher->Submit(TVMArgs(args.values + 1, args.type_codes + 1, args.size() - 1));
+    });
+
+}  // namespace relax_vm
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,361 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/runtime/relax_vm/sampling_profiler.cc
+ */
+#include "sampling_profiler.h"
+
+#include <tvm/runtime/ndarray.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tvm {
+namespace runtime {
+namespace relax_vm {
+
+namespace {
+
+/*! \brief Get the histogram bucket of a latency. */
+int BucketIndex(uint64_t ns) {
+  if (ns < 4) return static_cast<int>(ns);
+  int msb = 0;
+  for (uint64_t v = ns; v > 1; v >>= 1) ++msb;
+  int sub = static_cast<int>((ns >> (msb - 2)) & 3);
+  return std::min(msb * 4 + sub, SamplingProfiler::kNumBuckets - 1);
+}
+
+/*! \brief Get the lower bound, inclusive, of a histogram bucket. */
+uint64_t BucketLowerBound(int index) {
+  if (index < 8) return static_cast<uint64_t>(std::min(index, 4));
+  return static_cast<uint64_t>(4 + index % 4) << (index / 4 - 2);
+}
+
+/*! \brief Get the upper bound, exclusive, of a histogram bucket. */
+uint64_t BucketUpperBound(int index) {
+  if (index < 8) return static_cast<uint64_t>(std::min(index + 1, 4));
+  return static_cast<uint64_t>(5 + index % 4) << (index / 4 - 2);
+}
+
+std::atomic<uint64_t> next_profiler_id{0};
+
+/*! \brief The ids of the profilers alive, used to drop the stale thread-local entries. */
+struct LiveProfilers {
+  std::mutex mutex;
+  std::unordered_set<uint64_t> ids;
+
+  static LiveProfilers* Global() {
+    static LiveProfilers* inst = new LiveProfilers();
+    return inst;
+  }
+};
+
+}  // namespace
+
+/*! \brief The latency statistics of one function. */
+struct KernelStats {
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> total_ns{0};
+  std::atomic<uint64_t> max_ns{0};
+  std::atomic<uint64_t> buckets[SamplingProfiler::kNumBuckets] = {};
+};
+
+/*!
+ * \brief A trace event in the ring buffer.
+ * The fields are guarded by a sequence lock, so that the readers can skip the event being
+ * overwritten by the owner thread.
+ */
+struct TraceEvent {
+  std::atomic<uint64_t> seq{0};
+  std::atomic<int64_t> func_idx{-1};
+  std::atomic<uint64_t> begin_ns{0};
+  std::atomic<uint64_t> dur_ns{0};
+  std::atomic<bool> invocation{false};
+};
+
+struct SamplingProfiler::ThreadBuffer {
+  ThreadBuffer(size_t num_funcs, size_t trace_capacity, int tid)
+      : stats(new KernelStats[num_funcs]),
+        trace(new TraceEvent[trace_capacity]),
+        trace_capacity(trace_capacity),
+        tid(tid) {}
+
+  /*! \brief The number of calls or invocations left before the next sample, owner only. */
+  int64_t countdown{0};
+  /*! \brief Whether the current top-level invocation is sampled, owner only. */
+  bool invocation_sampled{false};
+  /*! \brief The per-function statistics, indexed by the function index. */
+  std::unique_ptr<KernelStats[]> stats;
+  /*! \brief The ring buffer of trace events. */
+  std::unique_ptr<TraceEvent[]> trace;
+  size_t trace_capacity;
+  /*! \brief The total number of events written to the ring buffer. */
+  std::atomic<uint64_t> trace_head{0};
+  /*! \brief The id of the thread in the exported trace. */
+  int tid;
+
+  /*! \brief Decrease the countdown, and return whether the next call is sampled. */
+  bool Tick(int64_t interval) {
+    if (--countdown > 0) return false;
+    countdown = interval;
+    return true;
+  }
+};
+
+SamplingProfiler::SamplingProfiler(std::vector<std::string> func_names, int64_t sample_interval,
+                                   bool sample_invocations, int64_t trace_capacity)
+    : func_names_(std::move(func_names)),
+      sample_interval_(sample_interval),
+      sample_invocations_(sample_invocations),
+      trace_capacity_(trace_capacity),
+      id_(next_profiler_id.fetch_add(1) + 1),
+      epoch_(std::chrono::steady_clock::now()) {
+  ICHECK_GT(sample_interval_, 0) << "ValueError: The sample interval must be positive";
+  ICHECK_GE(trace_capacity_, 0) << "ValueError: The trace capacity must be non-negative";
+  LiveProfilers* live = LiveProfilers::Global();
+  std::lock_guard<std::mutex> lock(live->mutex);
+  live->ids.insert(id_);
+}
+
+SamplingProfiler::~SamplingProfiler() {
+  LiveProfilers* live = LiveProfilers::Global();
+  std::lock_guard<std::mutex> lock(live->mutex);
+  live->ids.erase(id_);
+}
+
+SamplingProfiler::ThreadBuffer* SamplingProfiler::GetThreadBuffer() {
+  // The ids are never reused, so that a stale entry of a destroyed profiler is never matched.
+  thread_local uint64_t cached_id = 0;
+  thread_local ThreadBuffer* cached_buffer = nullptr;
+  thread_local std::unordered_map<uint64_t, ThreadBuffer*> buffers;
+  if (cached_id == id_) return cached_buffer;
+  {
+    // Drop the entries of the destroyed profilers, so that enabling and disabling the profiler
+    // repeatedly does not grow the map.
+    LiveProfilers* live = LiveProfilers::Global();
+    std::lock_guard<std::mutex> lock(live->mutex);
+    for (auto it = buffers.begin(); it != buffers.end();) {
+      it = live->ids.count(it->first) ? std::next(it) : buffers.erase(it);
+    }
+  }
+  ThreadBuffer*& buffer = buffers[id_];
+  if (buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.emplace_back(std::make_unique<ThreadBuffer>(
+        func_names_.size(), static_cast<size_t>(trace_capacity_), buffers_.size()));
+    buffer = buffers_.back().get();
+  }
+  cached_id = id_;
+  cached_buffer = buffer;
+  return buffer;
+}
+
+uint64_t SamplingProfiler::Now(const Sample& sample) const {
+  if (sample.sync) {
+    DeviceAPI::Get(sample.device)->StreamSync(sample.device, nullptr);
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                              epoch_)
+      .count();
+}
+
+SamplingProfiler::Sample SamplingProfiler::BeginInvocation(int64_t func_idx, Device device) {
+  Sample sample;
+  if (!sample_invocations_) return sample;
+  ThreadBuffer* buffer = GetThreadBuffer();
+  buffer->invocation_sampled = buffer->Tick(sample_interval_);
+  if (!buffer->invocation_sampled) return sample;
+  sample.active = true;
+  sample.invocation = true;
+  sample.func_idx = func_idx;
+  sample.device = device;
+  sample.sync = device.device_type != kDLCPU;
+  sample.begin_ns = Now(sample);
+  return sample;
+}
+
+SamplingProfiler::Sample SamplingProfiler::BeginCall(int64_t func_idx, const TVMArgs& args) {
+  Sample sample;
+  ThreadBuffer* buffer = GetThreadBuffer();
+  bool sampled =
+      sample_invocations_ ? buffer->invocation_sampled : buffer->Tick(sample_interval_);
+  if (!sampled) return sample;
+  sample.active = true;
+  sample.func_idx = func_idx;
+  // Use the device of the first tensor argument, if any.
+  for (int i = 0; i < args.size(); ++i) {
+    if (args.type_codes[i] == kTVMNDArrayHandle || args.type_codes[i] == kTVMDLTensorHandle) {
+      DLTensor* tensor = args[i];
+      sample.device = tensor->device;
+      sample.sync = tensor->device.device_type != kDLCPU;
+      break;
+    }
+  }
+  sample.begin_ns = Now(sample);
+  return sample;
+}
+
+void SamplingProfiler::End(const Sample& sample) {
+  if (!sample.active) return;
+  uint64_t end_ns = Now(sample);
+  uint64_t dur_ns = end_ns - sample.begin_ns;
+  ThreadBuffer* buffer = GetThreadBuffer();
+  if (sample.invocation) {
+    buffer->invocation_sampled = false;
+  }
+
+  // The counters only have one writer. The atomic increments are uncontended, and allow the
+  // readers to reset them without losing concurrent updates.
+  KernelStats& stats = buffer->stats[sample.func_idx];
+  stats.count.fetch_add(1, std::memory_order_relaxed);
+  stats.total_ns.fetch_add(dur_ns, std::memory_order_relaxed);
+  stats.buckets[BucketIndex(dur_ns)].fetch_add(1, std::memory_order_relaxed);
+  uint64_t max_ns = stats.max_ns.load(std::memory_order_relaxed);
+  while (dur_ns > max_ns &&
+         !stats.max_ns.compare_exchange_weak(max_ns, dur_ns, std::memory_order_relaxed)) {
+  }
+
+  if (buffer->trace_capacity == 0) return;
+  uint64_t head = buffer->trace_head.load(std::memory_order_relaxed);
+  TraceEvent& event = buffer->trace[head % buffer->trace_capacity];
+  uint64_t seq = event.seq.load(std::memory_order_relaxed);
+  event.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event.func_idx.store(sample.func_idx, std::memory_order_relaxed);
+  event.begin_ns.store(sample.begin_ns, std::memory_order_relaxed);
+  event.dur_ns.store(dur_ns, std::memory_order_relaxed);
+  event.invocation.store(sample.invocation, std::memory_order_relaxed);
+  event.seq.store(seq + 2, std::memory_order_release);
+  buffer->trace_head.store(head + 1, std::memory_order_release);
+}
+
+std::string SamplingProfiler::Snapshot(bool reset) {
+  struct Aggregate {
+    uint64_t count{0};
+    uint64_t total_ns{0};
+    uint64_t max_ns{0};
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(kNumBuckets, 0);
+  };
+  std::vector<Aggregate> aggregates(func_names_.size());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto read = [reset](std::atomic<uint64_t>& value) {
+      return reset ? value.exchange(0, std::memory_order_relaxed)
+                   : value.load(std::memory_order_relaxed);
+    };
+    for (const auto& buffer : buffers_) {
+      for (size_t i = 0; i < func_names_.size(); ++i) {
+        KernelStats& stats = buffer->stats[i];
+        Aggregate& agg = aggregates[i];
+        agg.count += read(stats.count);
+        agg.total_ns += read(stats.total_ns);
+        agg.max_ns = std::max(agg.max_ns, read(stats.max_ns));
+        for (int b = 0; b < kNumBuckets; ++b) {
+          agg.buckets[b] += read(stats.buckets[b]);
+        }
+      }
+    }
+  }
+
+  // The percentiles are estimated by the midpoint of the bucket, capped by the maximum.
+  auto percentile = [](const Aggregate& agg, double q) {
+    uint64_t total = 0;
+    for (uint64_t c : agg.buckets) total += c;
+    if (total == 0) return 0.0;
+    uint64_t rank = static_cast<uint64_t>(q * (total - 1));
+    uint64_t seen = 0;
+    for (int b = 0; b < kNumBuckets; ++b) {
+      seen += agg.buckets[b];
+      if (seen > rank) {
+        uint64_t mid = BucketLowerBound(b) + (BucketUpperBound(b) - BucketLowerBound(b)) / 2;
+        return static_cast<double>(std::min(mid, agg.max_ns)) / 1e3;
+      }
+    }
+    return static_cast<double>(agg.max_ns) / 1e3;
+  };
+
+  std::ostringstream os;
+  os << std::setprecision(6) << std::fixed;
+  os << "{\"sample_interval\":" << sample_interval_
+     << ",\"sample_invocations\":" << (sample_invocations_ ? "true" : "false")
+     << ",\"functions\":{";
+  bool first = true;
+  for (size_t i = 0; i < func_names_.size(); ++i) {
+    const Aggregate& agg = aggregates[i];
+    if (agg.count == 0) continue;
+    if (!first) os << ",";
+    first = false;
+    os << "\"" << func_names_[i] << "\":{\"count\":" << agg.count
+       << ",\"mean_us\":" << static_cast<double>(agg.total_ns) / agg.count / 1e3
+       << ",\"p50_us\":" << percentile(agg, 0.5) << ",\"p90_us\":" << percentile(agg, 0.9)
+       << ",\"p99_us\":" << percentile(agg, 0.99)
+       << ",\"max_us\":" << static_cast<double>(agg.max_ns) / 1e3 << ",\"histogram\":[";
+    bool first_bucket = true;
+    for (int b = 0; b < kNumBuckets; ++b) {
+      if (agg.buckets[b] == 0) continue;
+      if (!first_bucket) os << ",";
+      first_bucket = false;
+      os << "[" << BucketLowerBound(b) << "," << BucketUpperBound(b) << "," << agg.buckets[b]
+         << "]";
+    }
+    os << "]}";
+  }
+  os << "}}";
+  return os.str();
+}
+
+std::string SamplingProfiler::ExportChromeTrace() {
+  std::ostringstream os;
+  os << std::setprecision(3) << std::fixed;
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& buffer : buffers_) {
+    uint64_t head = buffer->trace_head.load(std::memory_order_acquire);
+    uint64_t begin = head > buffer->trace_capacity ? head - buffer->trace_capacity : 0;
+    for (uint64_t i = begin; i < head; ++i) {
+      TraceEvent& event = buffer->trace[i % buffer->trace_capacity];
+      uint64_t seq = event.seq.load(std::memory_order_acquire);
+      if (seq % 2 != 0) continue;
+      int64_t func_idx = event.func_idx.load(std::memory_order_relaxed);
+      uint64_t begin_ns = event.begin_ns.load(std::memory_order_relaxed);
+      uint64_t dur_ns = event.dur_ns.load(std::memory_order_relaxed);
+      bool invocation = event.invocation.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // Skip the event if it has been overwritten while being read.
+      if (event.seq.load(std::memory_order_relaxed) != seq || func_idx < 0) continue;
+      if (!first) os << ",";
+      first = false;
+      os << "{\"name\":\"" << func_names_[func_idx] << "\",\"cat\":\""
+         << (invocation ? "invocation" : "call") << "\",\"ph\":\"X\",\"ts\":" << begin_ns / 1e3
+         << ",\"dur\":" << dur_ns / 1e3 << ",\"pid\":0,\"tid\":" << buffer->tid << "}";
+    }
+  }
+  os << "]}";
+  return os.str();
+}
+
+}  // namespace relax_vm
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,152 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/runtime/relax_vm/sampling_profiler.h
+ * \brief A low-overhead sampling profiler that can stay enabled in production.
+ *
+ * Unlike the per-op profiler created by `VirtualMachine::CreateProfiler`, which times every call
+ * of a single invocation, the sampling profiler only times one in every N calls (or one in every
+ * N top-level invocations), so that its cost is amortized over the unsampled calls. The
+ * measurements of each thread go into a buffer owned by that thread, made of per-kernel latency
+ * histograms and a ring buffer of the most recent trace events. The buffers are only written by
+ * their owner thread and can be read concurrently by `Snapshot` and `ExportChromeTrace` without
+ * stopping the execution.
+ */
+#ifndef TVM_RUNTIME_RELAX_VM_SAMPLING_PROFILER_H_
+#define TVM_RUNTIME_RELAX_VM_SAMPLING_PROFILER_H_
+
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/packed_func.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+namespace relax_vm {
+
+class SamplingProfiler {
+ public:
+  /*!
+   * \brief The number of histogram buckets. Bucket boundaries are spaced by a quarter of an
+   * octave, covering latencies up to 2^40 ns.
+   */
+  static constexpr int kNumBuckets = 164;
+
+  /*! \brief The in-flight state of one sampled call. */
+  struct Sample {
+    /*! \brief Whether the call is sampled. */
+    bool active{false};
+    /*! \brief Whether the sample covers a whole top-level invocation. */
+    bool invocation{false};
+    /*! \brief The index of the function in the executable function table. */
+    int64_t func_idx{-1};
+    /*! \brief The device to synchronize, if any. */
+    Device device{kDLCPU, 0};
+    /*! \brief Whether the device needs to be synchronized before reading the clock. */
+    bool sync{false};
+    /*! \brief The start timestamp in nanoseconds since the creation of the profiler. */
+    uint64_t begin_ns{0};
+  };
+
+  /*!
+   * \brief Create a sampling profiler.
+   * \param func_names The names of the functions in the executable function table.
+   * \param sample_interval Sample one in every `sample_interval` calls or invocations.
+   * \param sample_invocations If true, sample whole top-level invocations, timing every call
+   * inside a sampled invocation. Otherwise, sample individual calls.
+   * \param trace_capacity The number of trace events kept per thread.
+   */
+  SamplingProfiler(std::vector<std::string> func_names, int64_t sample_interval,
+                   bool sample_invocations, int64_t trace_capacity);
+
+  ~SamplingProfiler();
+
+  /*!
+   * \brief Start a top-level invocation of a VM function.
+   * \param func_idx The index of the invoked function.
+   * \param device The device the function runs on.
+   * \return The sample of the invocation, active if the invocation is sampled.
+   */
+  Sample BeginInvocation(int64_t func_idx, Device device);
+
+  /*!
+   * \brief Start a call instruction.
+   * \param func_idx The index of the callee.
+   * \param args The arguments of the call, used to find the device to synchronize.
+   * \return The sample of the call, active if the call is sampled.
+   */
+  Sample BeginCall(int64_t func_idx, const TVMArgs& args);
+
+  /*!
+   * \brief Finish a sample and record its latency.
+   * \param sample The sample returned by `BeginInvocation` or `BeginCall`.
+   */
+  void End(const Sample& sample);
+
+  /*!
+   * \brief Aggregate the histograms of all threads.
+   * \param reset Whether to clear the histograms after reading them.
+   * \return The per-function statistics in JSON.
+   */
+  std::string Snapshot(bool reset);
+
+  /*!
+   * \brief Export the trace events of all threads.
+   * \return The events in the Chrome trace event format, which can be loaded by Perfetto.
+   */
+  std::string ExportChromeTrace();
+
+ private:
+  struct ThreadBuffer;
+
+  /*! \brief Get the buffer of the calling thread, creating it on the first use. */
+  ThreadBuffer* GetThreadBuffer();
+  /*! \brief Read the clock and synchronize the device if needed. */
+  uint64_t Now(const Sample& sample) const;
+
+  /*! \brief The names of the functions in the executable function table. */
+  std::vector<std::string> func_names_;
+  /*! \brief Sample one in every `sample_interval_` calls or invocations. */
+  int64_t sample_interval_;
+  /*! \brief Whether to sample whole top-level invocations. */
+  bool sample_invocations_;
+  /*! \brief The number of trace events kept per thread. */
+  int64_t trace_capacity_;
+  /*! \brief The unique id of this profiler, used as the key of the thread-local lookup. */
+  uint64_t id_;
+  /*! \brief The time origin of the timestamps. */
+  std::chrono::steady_clock::time_point epoch_;
+  /*! \brief Protects the registration of new thread buffers. */
+  std::mutex mutex_;
+  /*! \brief The buffers of all threads that have used the profiler. */
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+}  // namespace relax_vm
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_RELAX_VM_SAMPLING_PROFILER_H_
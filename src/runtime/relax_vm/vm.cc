@@ -25,9 +25,13 @@
 #include <tvm/runtime/profiling.h>
 #include <tvm/runtime/relax_vm/vm.h>
 
+#include <memory>
 #include <optional>
 #include <thread>
 
+#include "async_executor.h"
+#include "sampling_profiler.h"
+
 namespace tvm {
 namespace runtime {
 namespace relax_vm {
@@ -143,6 +147,21 @@ TVMRetValue ConvertRegToDevice(TVMRetValue input, Device dev, Allocator* alloc)
   return ret;
 }
 
+/*!
+ * \brief Create a non-owning NDArray view of a caller-owned buffer.
+ * \note Unlike NDArray::FromExternalDLTensor, the buffer is not required to be aligned. The view
+ * is only passed to kernels when it is aligned, and is otherwise used as a copy source.
+ */
+NDArray ViewExternalBuffer(const DLTensor& tensor) {
+  CHECK(IsContiguous(tensor)) << "ValueError: A bound buffer must be contiguous";
+  auto* container =
+      new NDArray::Container(tensor.data, ShapeTuple(tensor.shape, tensor.shape + tensor.ndim),
+                             tensor.dtype, tensor.device);
+  container->dl_tensor.byte_offset = tensor.byte_offset;
+  container->SetDeleter([](Object* obj) { delete static_cast<NDArray::Container*>(obj); });
+  return NDArray(GetObjectPtr<Object>(container));
+}
+
 //-----------------------------------------------------------
 // VM implementations.
 //-----------------------------------------------------------
@@ -209,6 +228,21 @@ class VirtualMachineImpl : public VirtualMachine {
    */
   Optional<VMClosure> GetClosureInternal(const String& func_name, bool allow_missing);
 
+  /*!
+   * \brief Make the closure of a function of the executable.
+   * \param gf_idx The index of the function in the function table.
+   * \return The closure.
+   */
+  VMClosure MakeClosure(Index gf_idx);
+
+  /*!
+   * \brief Whether the function is only invoked by the VM itself, and hidden from the users.
+   * \param func_name The name of the function.
+   */
+  static bool IsInternalFunction(const std::string& func_name) {
+    return func_name == kPersistentWorkspaceAllocFunc;
+  }
+
   /*!
    * \brief Set inputs to a function.
    * \param func_name The function name.
@@ -223,6 +257,28 @@ class VirtualMachineImpl : public VirtualMachine {
    */
   void SetInput(std::string func_name, TVMArgs args, int offset, bool with_param_module = false);
 
+  /*!
+   * \brief Bind a caller-owned buffer to an input of a function for `invoke_stateful`.
+   * \param func_name The function name.
+   * \param index The index of the input.
+   * \param external The caller-owned buffer. It is passed to the function without copy if it is
+   * on the VM device and suitably aligned. Otherwise, it is copied to a staging buffer allocated
+   * once here, before each call. The caller must keep the buffer alive while it is bound.
+   */
+  void BindInput(const std::string& func_name, int index, NDArray external);
+
+  /*!
+   * \brief Bind a caller-owned buffer that an output of a function is copied to after each
+   * `invoke_stateful` call.
+   * \param func_name The function name.
+   * \param index The index of the output in the returned tuple, or 0 if a single tensor is
+   * returned.
+   * \param external The caller-owned buffer the output is copied to.
+   * \note The output is still allocated by the function, so this saves the caller a separate
+   * copy call, but not the copy itself.
+   */
+  void BindOutputCopy(const std::string& func_name, int index, NDArray external);
+
   /*!
    * \brief Look up whether the VM has a function by the given name.
    * \param func_name the function's name
@@ -389,6 +445,17 @@ class VirtualMachineImpl : public VirtualMachine {
   std::unordered_map<std::string, std::vector<RegType>> inputs_;
   /*! \brief The function name to output register. */
   std::unordered_map<std::string, RegType> outputs_;
+  /*! \brief A caller-owned buffer bound to an input. */
+  struct InputBinding {
+    /*! \brief The caller-owned buffer. */
+    NDArray external;
+    /*! \brief The buffer on the VM device, undefined if `external` is passed directly. */
+    NDArray staging;
+  };
+  /*! \brief The function name to the input bindings, keyed by input index. */
+  std::unordered_map<std::string, std::unordered_map<int, InputBinding>> input_bindings_;
+  /*! \brief The function name to the buffers the outputs are copied to, keyed by output index. */
+  std::unordered_map<std::string, std::unordered_map<int, NDArray>> output_copies_;
   /*! \brief A store of closures created by `save_function`. */
   std::unordered_map<std::string, VMClosure> saved_closures_;
   //------------------------------------------------------------
@@ -405,6 +472,21 @@ class VirtualMachineImpl : public VirtualMachine {
   RegType return_value_;
   /*!\ brief instrument function. */
   PackedFunc instrument_ = nullptr;
+  /*!
+   * \brief The sampling profiler, null when disabled. It is accessed atomically, as it can be
+   * replaced while the async executor runs an invocation.
+   */
+  std::shared_ptr<SamplingProfiler> sampling_profiler_;
+  /*!
+   * \brief The sampling profiler of the running top-level invocation, copied when the invocation
+   * begins so that disabling the profiler meanwhile does not destroy it.
+   */
+  std::shared_ptr<SamplingProfiler> active_profiler_;
+  /*!
+   * \brief The executor of `invoke_async`, created on first use.
+   * \note Declared last so that the pending invocations finish before the VM state is destroyed.
+   */
+  std::unique_ptr<AsyncExecutor> async_executor_;
 };
 
 void VirtualMachineImpl::LoadExecutable(ObjectPtr<Executable> exec) {
@@ -437,12 +519,22 @@ void VirtualMachineImpl::Init(const std::vector<Device>& devices,
   }
   // Setup function sections.
   this->InitFuncPool();
+  // Allocate the persistent workspace shared by the entry functions, if any.
+  auto alloc_it = exec_->func_map.find(kPersistentWorkspaceAllocFunc);
+  if (alloc_it != exec_->func_map.end()) {
+    TVMRetValue rv;
+    this->InvokeClosurePacked(this->MakeClosure(alloc_it->second), TVMArgs(nullptr, nullptr, 0),
+                              &rv);
+    ObjectRef workspace = rv;
+    this->persistent_workspace = Downcast<Array<ObjectRef>>(workspace);
+  }
 }
 
 VMFuncInfo VirtualMachineImpl::LookupVMFuncInfo(const std::string& func_name) {
   ICHECK(exec_) << "The executable is not created yet.";
   auto it = this->exec_->func_map.find(func_name);
-  CHECK(it != this->exec_->func_map.end()) << "ValueError: Unknown function: " << func_name;
+  CHECK(it != this->exec_->func_map.end() && !IsInternalFunction(func_name))
+      << "ValueError: Unknown function: " << func_name;
 
   return exec_->func_table[it->second];
 }
@@ -503,6 +595,36 @@ PackedFunc VirtualMachineImpl::GetFunction(const String& name,
       }
       this->SetInstrument(func);
     });
+  } else if (name == "enable_sampling_profiler") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int64_t sample_interval = args[0];
+      bool sample_invocations = args[1];
+      int64_t trace_capacity = args[2];
+      std::vector<std::string> func_names;
+      for (const VMFuncInfo& info : exec_->func_table) {
+        func_names.push_back(info.name);
+      }
+      std::atomic_store(&sampling_profiler_,
+                        std::make_shared<SamplingProfiler>(std::move(func_names), sample_interval,
+                                                           sample_invocations, trace_capacity));
+    });
+  } else if (name == "disable_sampling_profiler") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::atomic_store(&sampling_profiler_, std::shared_ptr<SamplingProfiler>());
+    });
+  } else if (name == "sampling_profiler_snapshot") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::shared_ptr<SamplingProfiler> profiler = std::atomic_load(&sampling_profiler_);
+      ICHECK(profiler != nullptr) << "The sampling profiler is not enabled";
+      bool reset = args[0];
+      *rv = profiler->Snapshot(reset);
+    });
+  } else if (name == "sampling_profiler_export_chrome_trace") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::shared_ptr<SamplingProfiler> profiler = std::atomic_load(&sampling_profiler_);
+      ICHECK(profiler != nullptr) << "The sampling profiler is not enabled";
+      *rv = profiler->ExportChromeTrace();
+    });
   } else if (name == "invoke_stateful") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       std::string func_name = args[0];
@@ -516,7 +638,106 @@ PackedFunc VirtualMachineImpl::GetFunction(const String& name,
                    << "; use `set_input` first.";
         return;
       }
-      outputs_[func_name] = this->InvokeClosureInternal(func_pool_[gf_idx], inputs_[func_name]);
+      auto in_it = input_bindings_.find(func_name);
+      if (in_it != input_bindings_.end()) {
+        const std::vector<RegType>& inputs = inputs_[func_name];
+        for (size_t i = 0; i < inputs.size(); ++i) {
+          CHECK(inputs[i].type_code() != kTVMNullptr)
+              << "ValueError: Input " << i << " of " << func_name
+              << " is neither bound nor set; use `bind_input` for all the inputs first.";
+        }
+        for (auto& [index, binding] : in_it->second) {
+          if (binding.staging.defined()) {
+            binding.staging.CopyFrom(binding.external);
+          }
+        }
+      }
+      RegType out = this->InvokeClosureInternal(func_pool_[gf_idx], inputs_[func_name]);
+      auto out_it = output_copies_.find(func_name);
+      if (out_it != output_copies_.end()) {
+        ObjectRef out_obj = out.AsObjectRef<ObjectRef>();
+        for (const auto& [index, external] : out_it->second) {
+          NDArray result;
+          if (const auto* arr = out_obj.as<ArrayNode>()) {
+            CHECK_LT(static_cast<size_t>(index), arr->size())
+                << "ValueError: Output " << index << " is bound, but " << func_name
+                << " only returns " << arr->size() << " outputs";
+            result = Downcast<NDArray>(arr->at(index));
+          } else {
+            CHECK_EQ(index, 0) << "ValueError: Output " << index << " is bound, but "
+                               << func_name << " returns a single output";
+            result = Downcast<NDArray>(out_obj);
+          }
+          result.CopyTo(external);
+        }
+      }
+      outputs_[func_name] = std::move(out);
+    });
+  } else if (name == "init_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int64_t max_in_flight = args[0];
+      // Finish the invocations queued on the previous executor first.
+      async_executor_.reset();
+      async_executor_ = std::make_unique<AsyncExecutor>(devices[0], max_in_flight);
+    });
+  } else if (name == "invoke_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::string func_name = args[0];
+      VMClosure clo = this->GetClosure(func_name);
+      // Convert the arguments on the calling thread, as DLTensor handles are only valid during
+      // this call. NDArray arguments are shared with the caller until the invocation completes.
+      std::vector<RegType> inputs(args.size() - 1);
+      for (int i = 1; i < args.size(); ++i) {
+        inputs[i - 1] = ConvertArgToDevice(args[i], devices[0], allocators[0]);
+      }
+      if (async_executor_ == nullptr) {
+        async_executor_ = std::make_unique<AsyncExecutor>(devices[0], /*max_in_flight=*/4);
+      }
+      *rv = async_executor_->Submit([this, clo, inputs = std::move(inputs)]() {
+        return this->InvokeClosureInternal(clo, inputs);
+      });
+    });
+  } else if (name == "bind_input") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::string func_name = args[0];
+      int index = args[1];
+      NDArray external;
+      if (args.size() == 6) {
+        // A raw pointer with its shape, dtype and device.
+        ShapeTuple shape = args[3];
+        DLTensor tensor{args[2].operator void*(), args[5].operator Device(),
+                        static_cast<int32_t>(shape.size()), args[4].operator DLDataType(),
+                        const_cast<int64_t*>(shape.data()), nullptr, 0};
+        external = ViewExternalBuffer(tensor);
+      } else {
+        ICHECK_EQ(args.size(), 3);
+        if (args[2].type_code() == kTVMDLTensorHandle) {
+          external = ViewExternalBuffer(*args[2].operator DLTensor*());
+        } else {
+          external = args[2];
+        }
+      }
+      this->BindInput(func_name, index, external);
+    });
+  } else if (name == "bind_output_copy") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::string func_name = args[0];
+      int index = args[1];
+      NDArray external;
+      if (args[2].type_code() == kTVMDLTensorHandle) {
+        external = ViewExternalBuffer(*args[2].operator DLTensor*());
+      } else {
+        external = args[2];
+      }
+      this->BindOutputCopy(func_name, index, external);
+    });
+  } else if (name == "clear_bindings") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::string func_name = args[0];
+      if (input_bindings_.erase(func_name)) {
+        inputs_.erase(func_name);
+      }
+      output_copies_.erase(func_name);
     });
   } else if (name == "get_output_arity") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
@@ -583,7 +804,7 @@ PackedFunc VirtualMachineImpl::GetFunction(const String& name,
 void VirtualMachineImpl::SetInput(std::string func_name, TVMArgs args, int offset,
                                   bool with_param_module) {
   const auto& m = exec_->func_map;
-  if (m.find(func_name) != m.end()) {
+  if (m.find(func_name) != m.end() && !IsInternalFunction(func_name)) {
     Index gf_idx = m.at(func_name);
     const VMFuncInfo& vm_func = exec_->func_table[gf_idx];
     size_t params_num = vm_func.num_args;
@@ -601,11 +822,38 @@ void VirtualMachineImpl::SetInput(std::string func_name, TVMArgs args, int offse
       }
     }
     inputs_[func_name] = func_args;
+    // The inputs set here replace the bound inputs.
+    input_bindings_.erase(func_name);
   } else {
     LOG(FATAL) << "ValueError: Unknown function: " << func_name;
   }
 }
 
+void VirtualMachineImpl::BindInput(const std::string& func_name, int index, NDArray external) {
+  const VMFuncInfo& vm_func = LookupVMFuncInfo(func_name);
+  CHECK(index >= 0 && index < vm_func.num_args)
+      << "ValueError: Invalid input index for " << func_name << " (" << index << " out of "
+      << vm_func.num_args << ")";
+  InputBinding binding;
+  binding.external = external;
+  DLTensor* tensor = const_cast<DLTensor*>(external.operator->());
+  if (!NDArray::AbilityOfZeroCopyForDLTensor(tensor, devices[0])) {
+    binding.staging = allocators[0]->Empty(external.Shape(), external->dtype, devices[0]);
+  }
+  std::vector<RegType>& inputs = inputs_[func_name];
+  inputs.resize(vm_func.num_args);
+  inputs[index] = binding.staging.defined() ? binding.staging : binding.external;
+  input_bindings_[func_name][index] = std::move(binding);
+}
+
+void VirtualMachineImpl::BindOutputCopy(const std::string& func_name, int index,
+                                        NDArray external) {
+  LookupVMFuncInfo(func_name);
+  CHECK_GE(index, 0) << "ValueError: Invalid output index for " << func_name << " (" << index
+                     << ")";
+  output_copies_[func_name][index] = external;
+}
+
 //------------------------------------------
 // Closure handling
 //------------------------------------------
@@ -687,12 +935,14 @@ Optional<VMClosure> VirtualMachineImpl::GetClosureInternal(const String& func_na
     return saved_it->second;
   }
   auto it = exec_->func_map.find(func_name);
-  if (it == exec_->func_map.end()) {
+  if (it == exec_->func_map.end() || IsInternalFunction(func_name)) {
     if (allow_missing) return NullOpt;
     LOG(FATAL) << "ValueError: Unknown function: " << func_name;
   }
+  return MakeClosure(it->second);
+}
 
-  Index gf_idx = it->second;
+VMClosure VirtualMachineImpl::MakeClosure(Index gf_idx) {
   const VMFuncInfo& finfo = exec_->func_table[gf_idx];
 
   if (finfo.kind == VMFuncInfo::FuncKind::kVMFunc) {
@@ -707,7 +957,7 @@ Optional<VMClosure> VirtualMachineImpl::GetClosureInternal(const String& func_na
       }
       *rv = static_cast<VirtualMachineImpl*>(ctx_ptr)->InvokeBytecode(gf_idx, inputs);
     });
-    return VMClosure(func_name, impl);
+    return VMClosure(finfo.name, impl);
   } else {
     ICHECK(finfo.kind == VMFuncInfo::FuncKind::kVMTIRFunc)
         << "Cannot support closure with function kind " << static_cast<int>(finfo.kind);
@@ -733,7 +983,7 @@ Optional<VMClosure> VirtualMachineImpl::GetClosureInternal(const String& func_na
       // Return value always stored after inputs.
       *rv = reg_file[finfo.num_args];
     });
-    return VMClosure(func_name, impl);
+    return VMClosure(finfo.name, impl);
   }
 }
 
@@ -746,6 +996,14 @@ RegType VirtualMachineImpl::InvokeBytecode(Index gf_idx, const std::vector<RegTy
 
   // Get the curr instr which might be a potential caller.
   Instruction curr_instr = exec_->GetInstruction(pc_);
+  SamplingProfiler::Sample sample;
+  bool top_level = frames_.empty();
+  if (top_level) {
+    active_profiler_ = std::atomic_load(&sampling_profiler_);
+    if (active_profiler_ != nullptr) {
+      sample = active_profiler_->BeginInvocation(gf_idx, devices[0]);
+    }
+  }
   auto guard = PushFrame(this->pc_, gfunc);
   // Get new frame and set the caller info.
   VMFrame* curr_frame = frames_.back().get();
@@ -763,6 +1021,12 @@ RegType VirtualMachineImpl::InvokeBytecode(Index gf_idx, const std::vector<RegTy
   // set program counter
   pc_ = gfunc.start_instr;
   RunLoop();
+  if (sample.active) {
+    active_profiler_->End(sample);
+  }
+  if (top_level) {
+    active_profiler_.reset();
+  }
   return return_value_;
 }
 
@@ -787,8 +1051,7 @@ void VirtualMachineImpl::InitFuncPool() {
     } else {
       ICHECK(info.kind == VMFuncInfo::FuncKind::kVMFunc ||
              info.kind == VMFuncInfo::FuncKind::kVMTIRFunc);
-      auto clo = this->GetClosure(info.name);
-      func_pool_[func_index] = clo;
+      func_pool_[func_index] = this->MakeClosure(func_index);
     }
   }
 }
@@ -839,8 +1102,14 @@ void VirtualMachineImpl::RunInstrCall(VMFrame* curr_frame, Instruction instr) {
 
   ICHECK_LT(static_cast<size_t>(instr.func_idx), this->func_pool_.size());
 
+  SamplingProfiler::Sample sample;
+  if (active_profiler_ != nullptr) {
+    sample = active_profiler_->BeginCall(instr.func_idx, args);
+  }
+
   if (instrument_ == nullptr) {
     this->InvokeClosurePacked(func_pool_[instr.func_idx], args, &ret);
+    if (sample.active) active_profiler_->End(sample);
   } else {
     // insert light-weight instrument callback
     setter(0, func_pool_[instr.func_idx]);
@@ -864,6 +1133,7 @@ void VirtualMachineImpl::RunInstrCall(VMFrame* curr_frame, Instruction instr) {
     }
     if (ret_kind != static_cast<int>(VMInstrumentReturnKind::kSkipRun)) {
       this->InvokeClosurePacked(func_pool_[instr.func_idx], args, &ret);
+      if (sample.active) active_profiler_->End(sample);
       setter(2, false);
       setter(3, ret);
       instrument_.CallPacked(TVMArgs(values.data(), tcodes.data(), values.size()), &rv);
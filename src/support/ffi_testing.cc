@@ -26,8 +26,10 @@
 #include <tvm/runtime/container/variant.h>
 #include <tvm/runtime/module.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
 #include <tvm/te/tensor.h>
 #include <tvm/tir/expr.h>
+#include <tvm/tir/transform.h>
 
 #include <chrono>
 #include <thread>
@@ -125,6 +127,23 @@ void ErrorTest(int x, int y) {
 
 TVM_REGISTER_GLOBAL("testing.ErrorTest").set_body_typed(ErrorTest);
 
+// A thread-safe PrimFunc pass annotating each function with a config of the current pass
+// context and with the current target, as seen by the thread running the pass function.
+TVM_REGISTER_GLOBAL("testing.AnnotateCurrentContextPass").set_body_typed([](String config_key) {
+  auto pass_func = [config_key](tir::PrimFunc func, IRModule mod, transform::PassContext ctx) {
+    transform::PassContext current = transform::PassContext::Current();
+    if (Optional<ObjectRef> value = current->GetConfig<ObjectRef>(config_key)) {
+      func = WithAttr(std::move(func), "current_config", value.value());
+    }
+    if (Optional<Target> target = Target::Current(/*allow_not_defined=*/true)) {
+      func = WithAttr(std::move(func), "current_target", target.value());
+    }
+    return func;
+  };
+  return tir::transform::CreatePrimFuncPass(pass_func, 0, "AnnotateCurrentContext", {},
+                                            /*traceable=*/false, /*thread_safe=*/true);
+});
+
 // internal function used for debug and testing purposes
 TVM_REGISTER_GLOBAL("testing.object_use_count").set_body([](TVMArgs args, TVMRetValue* ret) {
   runtime::ObjectRef obj = args[0];
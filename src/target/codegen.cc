@@ -23,6 +23,9 @@
  */
 #include <dmlc/memory_io.h>
 #include <tvm/ir/module.h>
+#include <tvm/ir/transform.h>
+#include <tvm/node/serialization.h>
+#include <tvm/node/structural_hash.h>
 #include <tvm/runtime/c_runtime_api.h>
 #include <tvm/runtime/module.h>
 #include <tvm/runtime/registry.h>
@@ -31,14 +34,31 @@
 #include <tvm/tir/function.h>
 #include <tvm/tir/transform.h>
 
+#include <cerrno>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <random>
 #include <sstream>
 #include <unordered_set>
 #include <vector>
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../runtime/file_utils.h"
 #include "../runtime/library_module.h"
 #include "../support/base64.h"
+#include "../support/process_id.h"
+#include "../support/sha256.h"
+#include "../support/utils.h"
 
 namespace tvm {
 namespace codegen {
@@ -55,12 +75,173 @@ namespace codegen {
  */
 using FTVMTIRToRuntime = tvm::runtime::TypedPackedFunc<runtime::Module(IRModule, Target)>;
 
-runtime::Module Build(IRModule mod, Target target) {
-  if (transform::PassContext::Current()
-          ->GetConfig<Bool>("tir.disable_assert", Bool(false))
-          .value()) {
-    mod = tir::transform::SkipAssert()(mod);
+TVM_REGISTER_PASS_CONFIG_OPTION("tir.build_cache_dir", String);
+
+/*!
+ * \brief On-disk cache of the runtime modules generated by Build.
+ *
+ * An entry is keyed by the SHA-256 digest of the serialized lowered IRModule, together with the
+ * target, the pass config and the versions of TVM and LLVM, so that rebuilding an unchanged module
+ * skips the codegen. Unlike the 64-bit structural hash, the digest makes it practically impossible
+ * for two different modules to share an entry. Each entry is a directory named by a hash of its key, holding the full key, which
+ * is compared on lookup so that a collision of the names is a miss, and the module. LLVM modules
+ * are stored as optimized bitcode, and the other binary serializable modules (e.g. CUDA) in their
+ * binary format. Other modules are never cached. A failure to read or write the cache only falls
+ * back to the regular build.
+ */
+class BuildCache {
+ public:
+  explicit BuildCache(std::string cache_dir) : cache_dir_(std::move(cache_dir)) {}
+
+  /*! \brief Get the key of the module built for the target under the pass context. */
+  static std::string GetKey(const IRModule& mod, const Target& target,
+                            const transform::PassContext& pass_ctx) {
+    std::ostringstream os;
+    os << TVM_VERSION;
+#ifdef TVM_LLVM_VERSION
+    os << ";llvm=" << TVM_LLVM_VERSION;
+#endif
+    os << ";" << target->str();
+    if (target->host.defined()) {
+      os << ";host=" << target->host.value()->str();
+    }
+    os << ";opt_level=" << pass_ctx->opt_level;
+    uint64_t config_hash = 0;
+    // Sort the config to make the key independent of the insertion order.
+    std::map<std::string, ObjectRef> config(pass_ctx->config.begin(), pass_ctx->config.end());
+    for (const auto& [name, value] : config) {
+      // Skip the entries holding opaque objects (e.g. "tir.add_lower_pass"), whose
+      // effect is already part of the lowered module.
+      if (name == "tir.build_cache_dir" ||
+          !(value->IsInstance<IntImmNode>() || value->IsInstance<FloatImmNode>() ||
+            value->IsInstance<runtime::StringObj>() || value->IsInstance<BaseAttrsNode>())) {
+        continue;
+      }
+      config_hash = support::HashCombine(config_hash, name);
+      config_hash = support::HashCombine(config_hash, StructuralHash()(value));
+    }
+    os << ";config=" << config_hash;
+    os << ";mod=" << support::SHA256Hex(SaveJSON(mod));
+    return os.str();
+  }
+
+  /*! \brief Look up the module of the key, return NullOpt on a miss. */
+  Optional<runtime::Module> Load(const std::string& key) const {
+    std::string entry = GetEntryDir(key);
+    try {
+      if (!std::ifstream(entry + "/key").good()) {
+        return NullOpt;
+      }
+      std::string stored_key;
+      runtime::LoadBinaryFromFile(entry + "/key", &stored_key);
+      if (stored_key != key) {
+        return NullOpt;
+      }
+      if (std::ifstream(entry + "/module.bc").good()) {
+        return runtime::Module::LoadFromFile(entry + "/module.bc", "bc");
+      }
+      if (std::ifstream(entry + "/module.bin").good()) {
+        std::string data;
+        runtime::LoadBinaryFromFile(entry + "/module.bin", &data);
+        dmlc::MemoryStringStream stream(&data);
+        std::string type_key;
+        ICHECK(stream.Read(&type_key));
+        const PackedFunc* f_load = runtime::Registry::Get("runtime.module.loadbinary_" + type_key);
+        ICHECK(f_load != nullptr) << "Loader for `" << type_key << "` is not enabled";
+        dmlc::Stream* strm = &stream;
+        return (*f_load)(static_cast<void*>(strm)).operator runtime::Module();
+      }
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "Ignore the build cache entry " << entry << " that fails to load: "
+                   << e.what();
+    }
+    return NullOpt;
+  }
+
+  /*! \brief Save the module of the key, if it can be cached. */
+  void Save(const std::string& key, const runtime::Module& mod) const {
+    if (!mod.defined() || !mod->imports().empty()) {
+      return;
+    }
+    bool is_llvm = std::string(mod->type_key()) == "llvm";
+    if (!is_llvm && !(mod->IsBinarySerializable() && !mod->IsDSOExportable())) {
+      return;
+    }
+    if (!CreateDirectories(cache_dir_)) {
+      LOG(WARNING) << "Cannot create the build cache directory " << cache_dir_;
+      return;
+    }
+    // Write to a temporary directory first, and rename it to the entry, so that a concurrent
+    // build never sees a partial entry. The suffix is unique across the processes sharing the
+    // cache directory.
+    std::string entry = GetEntryDir(key);
+    std::ostringstream tmp_entry;
+    tmp_entry << entry << ".tmp" << support::GetProcessId() << "_" << std::hex
+              << std::random_device()();
+    if (!MakeDirectory(tmp_entry.str())) {
+      LOG(WARNING) << "Cannot write the build cache entry " << entry;
+      return;
+    }
+    try {
+      runtime::SaveBinaryToFile(tmp_entry.str() + "/key", key);
+      if (is_llvm) {
+        mod->SaveToFile(tmp_entry.str() + "/module.bc", "bc");
+      } else {
+        std::string data;
+        dmlc::MemoryStringStream stream(&data);
+        stream.Write(std::string(mod->type_key()));
+        mod->SaveToBinary(&stream);
+        runtime::SaveBinaryToFile(tmp_entry.str() + "/module.bin", data);
+      }
+      if (std::rename(tmp_entry.str().c_str(), entry.c_str()) == 0) {
+        return;
+      }
+      // Another build has written the entry meanwhile.
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "Cannot write the build cache entry " << entry << ": " << e.what();
+    }
+    RemoveEntry(tmp_entry.str());
   }
+
+ private:
+  /*! \brief Get the directory of the entry of the key. */
+  std::string GetEntryDir(const std::string& key) const {
+    std::ostringstream name;
+    name << std::hex << std::setfill('0') << std::setw(16) << std::hash<std::string>()(key);
+    return cache_dir_ + "/" + name.str();
+  }
+
+  /*! \brief Create the directory and its missing parents, return whether it exists. */
+  static bool CreateDirectories(const std::string& dir) {
+    for (size_t pos = dir.find('/', 1); pos != std::string::npos; pos = dir.find('/', pos + 1)) {
+      MakeDirectory(dir.substr(0, pos));
+    }
+    return MakeDirectory(dir);
+  }
+
+  static bool MakeDirectory(const std::string& dir) {
+#ifdef _WIN32
+    return _mkdir(dir.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+  }
+
+  static void RemoveEntry(const std::string& dir) {
+    for (const char* file : {"/key", "/module.bc", "/module.bin"}) {
+      std::remove((dir + file).c_str());
+    }
+#ifdef _WIN32
+    _rmdir(dir.c_str());
+#else
+    rmdir(dir.c_str());
+#endif
+  }
+
+  std::string cache_dir_;
+};
+
+runtime::Module BuildWithoutCache(IRModule mod, Target target) {
   auto target_attr_map = tvm::TargetKind::GetAttrMap<FTVMTIRToRuntime>("TIRToRuntime");
   if (target_attr_map.count(target->kind)) {
     return target_attr_map[target->kind](mod, target);
@@ -73,6 +254,26 @@ runtime::Module Build(IRModule mod, Target target) {
   return (*bf)(mod, target);
 }
 
+runtime::Module Build(IRModule mod, Target target) {
+  transform::PassContext pass_ctx = transform::PassContext::Current();
+  if (pass_ctx->GetConfig<Bool>("tir.disable_assert", Bool(false)).value()) {
+    mod = tir::transform::SkipAssert()(mod);
+  }
+
+  Optional<String> cache_dir = pass_ctx->GetConfig<String>("tir.build_cache_dir");
+  if (!cache_dir.defined()) {
+    return BuildWithoutCache(mod, target);
+  }
+  BuildCache cache(cache_dir.value());
+  std::string key = BuildCache::GetKey(mod, target, pass_ctx);
+  if (Optional<runtime::Module> cached = cache.Load(key)) {
+    return cached.value();
+  }
+  runtime::Module result = BuildWithoutCache(mod, target);
+  cache.Save(key, result);
+  return result;
+}
+
 /*! \brief Helper class to serialize module */
 class ModuleSerializer {
  public:
@@ -375,6 +375,12 @@ void LLVMModuleNode::LoadIR(const std::string& file_name) {
   auto llvm_instance = std::make_unique<LLVMInstance>();
   std::unique_ptr<llvm::Module> module = llvm_instance->LoadIR(file_name);
   Init(std::move(module), std::move(llvm_instance));
+  // The functions exposed by the loaded module are the externally visible definitions.
+  for (const llvm::Function& f : module_->functions()) {
+    if (!f.isDeclaration() && f.hasExternalLinkage()) {
+      function_names_.push_back(f.getName().str());
+    }
+  }
 }
 
 bool LLVMModuleNode::ImplementsFunction(const String& name, bool query_imports) {
@@ -596,6 +602,13 @@ TVM_REGISTER_GLOBAL("runtime.module.loadfile_ll")
       return runtime::Module(n);
     });
 
+TVM_REGISTER_GLOBAL("runtime.module.loadfile_bc")
+    .set_body_typed([](std::string filename, std::string fmt) -> runtime::Module {
+      auto n = make_object<LLVMModuleNode>();
+      n->LoadIR(filename);
+      return runtime::Module(n);
+    });
+
 TVM_REGISTER_GLOBAL("codegen.llvm_target_enabled")
     .set_body_typed([](std::string target_str) -> bool {
       LLVMInstance llvm_instance;
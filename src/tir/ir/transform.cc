@@ -23,12 +23,22 @@
  */
 #include <tvm/node/repr_printer.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
+#include <tvm/target/target.h>
 #include <tvm/tir/transform.h>
 
+#include <algorithm>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <vector>
+
 namespace tvm {
 namespace tir {
 namespace transform {
 
+TVM_REGISTER_PASS_CONFIG_OPTION("tir.num_prim_func_pass_threads", Integer);
+
 /*!
  * \brief Function level pass that applies transformations to all
  *        TIR functions within the module.
@@ -41,7 +51,18 @@ class PrimFuncPassNode : public PassNode {
   /*! \brief The pass function called on each. */
   runtime::TypedPackedFunc<PrimFunc(PrimFunc, IRModule, PassContext)> pass_func;
 
-  void VisitAttrs(tvm::AttrVisitor* v) { v->Visit("pass_info", &pass_info); }
+  /*!
+   * \brief Whether pass_func can be invoked on different PrimFuncs concurrently.
+   *
+   * A thread-safe pass function must only read the IRModule and must not touch
+   * any global mutable state (including calling back into Python).
+   */
+  bool thread_safe{false};
+
+  void VisitAttrs(tvm::AttrVisitor* v) {
+    v->Visit("pass_info", &pass_info);
+    v->Visit("thread_safe", &thread_safe);
+  }
 
   /*!
    * \brief Run a function pass on given pass context.
@@ -58,6 +79,15 @@ class PrimFuncPassNode : public PassNode {
    */
   PassInfo Info() const override { return pass_info; }
 
+  /*!
+   * \brief Run the pass over the PrimFuncs of the module with a pool of threads.
+   *
+   * The functions are processed in an arbitrary order, while the results are written
+   * back in the iteration order of the module, so the output is identical to the
+   * sequential execution.
+   */
+  IRModule RunParallel(IRModule mod, const PassContext& pass_ctx, int num_threads) const;
+
   static constexpr const char* _type_key = "tir.PrimFuncPass";
   TVM_DECLARE_FINAL_OBJECT_INFO(PrimFuncPassNode, PassNode);
 };
@@ -68,26 +98,39 @@ class PrimFuncPass : public Pass {
    * \brief The constructor
    * \param pass_func The packed function which implements a pass.
    * \param pass_info The pass info.
+   * \param thread_safe Whether the pass function can run on several PrimFuncs concurrently.
    */
   TVM_DLL PrimFuncPass(
       runtime::TypedPackedFunc<PrimFunc(PrimFunc, IRModule, PassContext)> pass_func,
-      PassInfo pass_info);
+      PassInfo pass_info, bool thread_safe = false);
 
   TVM_DEFINE_OBJECT_REF_METHODS(PrimFuncPass, Pass, PrimFuncPassNode);
 };
 
 PrimFuncPass::PrimFuncPass(
     runtime::TypedPackedFunc<PrimFunc(PrimFunc, IRModule, PassContext)> pass_func,
-    PassInfo pass_info) {
+    PassInfo pass_info, bool thread_safe) {
   auto n = make_object<PrimFuncPassNode>();
   n->pass_func = std::move(pass_func);
   n->pass_info = std::move(pass_info);
+  n->thread_safe = thread_safe;
   data_ = std::move(n);
 }
 
 // Perform Module -> Module optimizations at the PrimFunc level.
 IRModule PrimFuncPassNode::operator()(IRModule mod, const PassContext& pass_ctx) const {
   ICHECK(mod.defined());
+  if (thread_safe) {
+    int num_threads =
+        pass_ctx->GetConfig<Integer>("tir.num_prim_func_pass_threads", Integer(1)).value()->value;
+    if (num_threads <= 0) {
+      num_threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    }
+    if (num_threads > 1) {
+      return RunParallel(std::move(mod), pass_ctx, num_threads);
+    }
+  }
+
   std::vector<GlobalVar> deleted_list;
 
   IRModuleNode* mod_ptr = mod.CopyOnWrite();
@@ -116,11 +159,73 @@ IRModule PrimFuncPassNode::operator()(IRModule mod, const PassContext& pass_ctx)
   return mod;
 }
 
+IRModule PrimFuncPassNode::RunParallel(IRModule mod, const PassContext& pass_ctx,
+                                       int num_threads) const {
+  std::vector<GlobalVar> gvars;
+  std::vector<PrimFunc> funcs;
+  for (const auto& kv : mod->functions) {
+    if (const auto* func = kv.second.as<PrimFuncNode>()) {
+      gvars.push_back(kv.first);
+      funcs.push_back(GetRef<PrimFunc>(func));
+    }
+  }
+  int num_funcs = static_cast<int>(funcs.size());
+  if (num_funcs == 0) {
+    return mod;
+  }
+
+  // The scopes are thread-local, so the workers enter the pass context and the target of the
+  // caller themselves. The instruments are dropped from the pass context of the workers, as they
+  // have already seen the caller enter it.
+  auto worker_ctx_node = make_object<PassContextNode>(*pass_ctx.operator->());
+  worker_ctx_node->instruments = {};
+  PassContext worker_ctx(worker_ctx_node);
+  Optional<Target> target = Target::Current(/*allow_not_defined=*/true);
+
+  // The module stays untouched while the workers run, so that a pass function
+  // can safely look up the other functions of the module.
+  std::vector<PrimFunc> results(num_funcs);
+  std::vector<std::exception_ptr> errors(num_funcs);
+  support::parallel_for_dynamic(
+      0, num_funcs, std::min(num_threads, num_funcs), [&](int thread_id, int task_id) {
+        try {
+          With<PassContext> ctx_scope(worker_ctx);
+          std::optional<With<Target>> target_scope;
+          if (target.defined()) {
+            target_scope.emplace(target.value());
+          }
+          results[task_id] = pass_func(std::move(funcs[task_id]), mod, pass_ctx);
+        } catch (...) {
+          errors[task_id] = std::current_exception();
+        }
+      });
+  // Report the error of the first failing function, regardless of the scheduling.
+  for (const std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  IRModuleNode* mod_ptr = mod.CopyOnWrite();
+  std::vector<GlobalVar> deleted_list;
+  for (int i = 0; i < num_funcs; ++i) {
+    if (results[i].defined()) {
+      mod_ptr->functions.Set(gvars[i], std::move(results[i]));
+    } else {
+      deleted_list.push_back(gvars[i]);
+    }
+  }
+  for (const auto& gv : deleted_list) {
+    mod_ptr->Remove(gv);
+  }
+  return mod;
+}
+
 Pass CreatePrimFuncPass(
     const runtime::TypedPackedFunc<PrimFunc(PrimFunc, IRModule, PassContext)>& pass_func,
-    int opt_level, String name, tvm::Array<String> required, bool traceable) {
+    int opt_level, String name, tvm::Array<String> required, bool traceable, bool thread_safe) {
   PassInfo pass_info = PassInfo(opt_level, name, required, traceable);
-  return PrimFuncPass(pass_func, pass_info);
+  return PrimFuncPass(pass_func, pass_info, thread_safe);
 }
 
 TVM_REGISTER_NODE_TYPE(PrimFuncPassNode);
@@ -734,7 +734,8 @@ Pass CompactBufferAllocation(bool is_strict) {
   auto pass_func = [=](PrimFunc f, IRModule m, PassContext ctx) {
     return CompactBufferAllocation(std::move(f), is_strict);
   };
-  return CreatePrimFuncPass(pass_func, 0, "tir.CompactBufferAllocation", {});
+  return CreatePrimFuncPass(pass_func, 0, "tir.CompactBufferAllocation", {}, /*traceable=*/false,
+                            /*thread_safe=*/true);
 }
 
 TVM_REGISTER_GLOBAL("tir.transform.CompactBufferAllocation")
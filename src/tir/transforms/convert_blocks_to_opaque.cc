@@ -124,7 +124,8 @@ Pass ConvertBlocksToOpaque() {
   auto pass_func = [=](PrimFunc f, IRModule m, PassContext ctx) {
     return ConvertBlocksToOpaque(std::move(f));
   };
-  return CreatePrimFuncPass(pass_func, 0, "tir.ConvertBlocksToOpaque", {});
+  return CreatePrimFuncPass(pass_func, 0, "tir.ConvertBlocksToOpaque", {}, /*traceable=*/false,
+                            /*thread_safe=*/true);
 }
 
 TVM_REGISTER_GLOBAL("tir.transform.ConvertBlocksToOpaque").set_body_typed(ConvertBlocksToOpaque);
@@ -0,0 +1,245 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file horizontal_fuse_kernels.cc
+ * \brief Merge the independent kernels of a horizontally fused PrimFunc into a single kernel.
+ */
+#include <tvm/runtime/registry.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/function.h>
+#include <tvm/tir/op.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/tir/transform.h>
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "ir_utils.h"
+
+namespace tvm {
+namespace tir {
+
+/*! \brief A kernel launched over exactly one blockIdx.x and one threadIdx.x dimension. */
+struct KernelInfo {
+  IterVar block_idx;
+  IterVar thread_idx;
+  int64_t num_blocks;
+  int64_t num_threads;
+  Stmt body;
+};
+
+class HorizontalKernelFuser {
+ public:
+  /*!
+   * \brief Merge the kernels of the function body into one kernel.
+   * \param body The body of the function.
+   * \param num_kernels The number of independent kernels the body is expected to launch.
+   * \return The merged body, or NullOpt if the body does not consist of the expected kernels.
+   */
+  static Optional<Stmt> Fuse(const Stmt& body, int64_t num_kernels) {
+    return HorizontalKernelFuser(num_kernels).Rewrite(body);
+  }
+
+ private:
+  explicit HorizontalKernelFuser(int64_t num_kernels) : num_kernels_(num_kernels) {}
+
+  Optional<Stmt> Rewrite(const Stmt& stmt) {
+    // The buffers allocated at the top of the function are shared by the host and the kernels.
+    if (const auto* alloc = stmt.as<AllocateNode>()) {
+      Optional<Stmt> body = Rewrite(alloc->body);
+      if (!body.defined()) return NullOpt;
+      Allocate new_alloc = GetRef<Allocate>(alloc);
+      new_alloc.CopyOnWrite()->body = body.value();
+      return std::move(new_alloc);
+    } else if (const auto* decl = stmt.as<DeclBufferNode>()) {
+      Optional<Stmt> body = Rewrite(decl->body);
+      if (!body.defined()) return NullOpt;
+      DeclBuffer new_decl = GetRef<DeclBuffer>(decl);
+      new_decl.CopyOnWrite()->body = body.value();
+      return std::move(new_decl);
+    } else if (const auto* let = stmt.as<LetStmtNode>()) {
+      Optional<Stmt> body = Rewrite(let->body);
+      if (!body.defined()) return NullOpt;
+      LetStmt new_let = GetRef<LetStmt>(let);
+      new_let.CopyOnWrite()->body = body.value();
+      return std::move(new_let);
+    }
+
+    const auto* seq = stmt.as<SeqStmtNode>();
+    if (seq == nullptr || static_cast<int64_t>(seq->size()) != num_kernels_) {
+      return NullOpt;
+    }
+    std::vector<KernelInfo> kernels;
+    for (const Stmt& kernel : seq->seq) {
+      std::optional<KernelInfo> info = MatchKernel(kernel);
+      if (!info.has_value()) return NullOpt;
+      kernels.push_back(std::move(info.value()));
+    }
+    return Merge(kernels);
+  }
+
+  /*! \brief Match a kernel of the form `blockIdx.x { threadIdx.x { body } }`. */
+  static std::optional<KernelInfo> MatchKernel(const Stmt& stmt) {
+    const auto* outer = stmt.as<AttrStmtNode>();
+    if (outer == nullptr || outer->attr_key != attr::thread_extent) return std::nullopt;
+    const auto* inner = outer->body.as<AttrStmtNode>();
+    if (inner == nullptr || inner->attr_key != attr::thread_extent) return std::nullopt;
+
+    KernelInfo info;
+    for (const AttrStmtNode* launch : {outer, inner}) {
+      IterVar iv = Downcast<IterVar>(launch->node);
+      const auto* extent = launch->value.as<IntImmNode>();
+      if (extent == nullptr) return std::nullopt;
+      if (iv->thread_tag == "blockIdx.x" && !info.block_idx.defined()) {
+        info.block_idx = iv;
+        info.num_blocks = extent->value;
+      } else if (iv->thread_tag == "threadIdx.x" && !info.thread_idx.defined()) {
+        info.thread_idx = iv;
+        info.num_threads = extent->value;
+      } else {
+        return std::nullopt;
+      }
+    }
+    info.body = inner->body;
+
+    // The kernel must not launch over any other thread axis.
+    bool other_axis = false;
+    PostOrderVisit(info.body, [&other_axis](const ObjectRef& node) {
+      if (const auto* attr = node.as<AttrStmtNode>()) {
+        if (attr->attr_key == attr::thread_extent || attr->attr_key == attr::virtual_thread) {
+          other_axis = true;
+        }
+      }
+    });
+    if (other_axis) return std::nullopt;
+    return info;
+  }
+
+  /*!
+   * \brief Whether the threads of the kernel cooperate, so that the kernel cannot run on a subset
+   * of the threads of a block.
+   */
+  static bool HasThreadCooperation(const Stmt& body) {
+    bool cooperation = false;
+    PostOrderVisit(body, [&cooperation](const ObjectRef& node) {
+      if (const auto* call = node.as<CallNode>()) {
+        if (call->op.same_as(builtin::tvm_storage_sync()) ||
+            call->op.same_as(builtin::tvm_thread_allreduce()) ||
+            call->op.same_as(builtin::tvm_warp_shuffle()) ||
+            call->op.same_as(builtin::tvm_warp_shuffle_up()) ||
+            call->op.same_as(builtin::tvm_warp_shuffle_down()) ||
+            call->op.same_as(builtin::tvm_warp_activemask())) {
+          cooperation = true;
+        }
+      } else if (const auto* alloc = node.as<AllocateNode>()) {
+        String scope = GetPtrStorageScope(alloc->buffer_var);
+        if (scope != "local" && scope != "global") {
+          cooperation = true;
+        }
+      }
+    });
+    return cooperation;
+  }
+
+  /*!
+   * \brief Dispatch the kernels over a shared blockIdx.x dimension, where kernel i runs on the
+   * blocks [offset_i, offset_i + num_blocks_i) and on the first num_threads_i threads of a block.
+   */
+  static Optional<Stmt> Merge(const std::vector<KernelInfo>& kernels) {
+    DataType dtype = kernels[0].block_idx->var.dtype();
+    int64_t num_blocks = 0;
+    int64_t num_threads = 0;
+    std::vector<int64_t> offsets;
+    for (const KernelInfo& kernel : kernels) {
+      if (kernel.block_idx->var.dtype() != dtype || kernel.thread_idx->var.dtype() != dtype) {
+        return NullOpt;
+      }
+      offsets.push_back(num_blocks);
+      num_blocks += kernel.num_blocks;
+      num_threads = std::max(num_threads, kernel.num_threads);
+    }
+    if (dtype.bits() < 64 && num_blocks > std::numeric_limits<int32_t>::max()) {
+      return NullOpt;
+    }
+    for (const KernelInfo& kernel : kernels) {
+      // The threads beyond the extent of the kernel are idle, so they must not be required to
+      // take part in a synchronization or a reduction of the block.
+      if (kernel.num_threads < num_threads && HasThreadCooperation(kernel.body)) {
+        return NullOpt;
+      }
+    }
+
+    Var block_idx("blockIdx.x", dtype);
+    Var thread_idx("threadIdx.x", dtype);
+    Optional<Stmt> dispatch = NullOpt;
+    for (int i = static_cast<int>(kernels.size()) - 1; i >= 0; --i) {
+      const KernelInfo& kernel = kernels[i];
+      PrimExpr local_block_idx =
+          offsets[i] == 0 ? PrimExpr(block_idx) : block_idx - make_const(dtype, offsets[i]);
+      Map<Var, PrimExpr> vmap{
+          {kernel.block_idx->var, local_block_idx},
+          {kernel.thread_idx->var, thread_idx},
+      };
+      Stmt body = Substitute(kernel.body, vmap);
+      if (kernel.num_threads < num_threads) {
+        body = IfThenElse(thread_idx < make_const(dtype, kernel.num_threads), body);
+      }
+      if (dispatch.defined()) {
+        PrimExpr end = make_const(dtype, offsets[i] + kernel.num_blocks);
+        dispatch = IfThenElse(block_idx < end, body, dispatch.value());
+      } else {
+        dispatch = body;
+      }
+    }
+
+    IterVar block_iv(Range::FromMinExtent(make_zero(dtype), make_const(dtype, num_blocks)),
+                     block_idx, IterVarType::kThreadIndex, "blockIdx.x");
+    IterVar thread_iv(Range::FromMinExtent(make_zero(dtype), make_const(dtype, num_threads)),
+                      thread_idx, IterVarType::kThreadIndex, "threadIdx.x");
+    Stmt body = AttrStmt(thread_iv, attr::thread_extent, thread_iv->dom->extent, dispatch.value());
+    return AttrStmt(block_iv, attr::thread_extent, block_iv->dom->extent, body);
+  }
+
+  int64_t num_kernels_;
+};
+
+namespace transform {
+
+Pass HorizontalFuseKernels() {
+  auto pass_func = [](PrimFunc func, IRModule mod, PassContext ctx) -> PrimFunc {
+    Optional<Integer> num_kernels = func->GetAttr<Integer>(attr::kHorizontalFusion);
+    if (!num_kernels.defined() || num_kernels.value()->value < 2) {
+      return func;
+    }
+    if (Optional<Stmt> body = HorizontalKernelFuser::Fuse(func->body, num_kernels.value()->value)) {
+      func.CopyOnWrite()->body = body.value();
+    }
+    return func;
+  };
+  return CreatePrimFuncPass(pass_func, 0, "tir.HorizontalFuseKernels", {});
+}
+
+TVM_REGISTER_GLOBAL("tir.transform.HorizontalFuseKernels").set_body_typed(HorizontalFuseKernels);
+
+}  // namespace transform
+}  // namespace tir
+}  // namespace tvm
@@ -265,7 +265,8 @@ Pass PlanAndUpdateBufferAllocationLocation() {
   auto pass_func = [=](PrimFunc f, IRModule m, PassContext ctx) {
     return PlanAndUpdateBufferAllocationLocation(std::move(f));
   };
-  return CreatePrimFuncPass(pass_func, 0, "tir.PlanAndUpdateBufferAllocationLocation", {});
+  return CreatePrimFuncPass(pass_func, 0, "tir.PlanAndUpdateBufferAllocationLocation", {},
+                            /*traceable=*/false, /*thread_safe=*/true);
 }
 
 TVM_REGISTER_GLOBAL("tir.transform.PlanAndUpdateBufferAllocationLocation")
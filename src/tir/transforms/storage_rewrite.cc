@@ -1663,7 +1663,8 @@ Pass StorageRewrite() {
     // handle vectorized constants.
     return PointerValueTypeRewrite(std::move(f), true, false, false, true, true, true, false);
   };
-  return CreatePrimFuncPass(pass_func, 0, "tir.StorageRewrite", {});
+  return CreatePrimFuncPass(pass_func, 0, "tir.StorageRewrite", {}, /*traceable=*/false,
+                            /*thread_safe=*/true);
 }
 
 TVM_REGISTER_GLOBAL("tir.transform.StorageRewrite").set_body_typed(StorageRewrite);
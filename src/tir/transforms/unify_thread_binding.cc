@@ -200,7 +200,8 @@ Pass UnifyThreadBinding() {
   auto pass_func = [=](PrimFunc f, IRModule m, PassContext ctx) {
     return UnifyThreadBinding(std::move(f));
   };
-  return CreatePrimFuncPass(pass_func, 0, "tir.UnifyThreadBinding", {});
+  return CreatePrimFuncPass(pass_func, 0, "tir.UnifyThreadBinding", {}, /*traceable=*/false,
+                            /*thread_safe=*/true);
 }
 
 TVM_REGISTER_GLOBAL("tir.transform.UnifyThreadBinding").set_body_typed(UnifyThreadBinding);
@@ -182,9 +182,49 @@ def test_random_fill_mt():
     assert no_exception_happened
 
 
+def test_reproducible_across_threads():
+    if not tvm.get_global_func("tvm.contrib.random.seed", True):
+        print("skip because extern function is not available")
+        return
+    shape = (1024, 1024)
+    samplers = {
+        "uniform": lambda out: tvm.get_global_func("tvm.contrib.random.uniform")(0.0, 1.0, out),
+        "normal": lambda out: tvm.get_global_func("tvm.contrib.random.normal")(3.0, 4.0, out),
+        "bernoulli": lambda out: tvm.get_global_func("tvm.contrib.random.bernoulli")(0.3, out),
+    }
+    results = {}
+
+    def test_body(num_threads):
+        configure_threads = tvm.get_global_func("runtime.config_threadpool")
+        configure_threads(1, num_threads)
+        for name, sampler in samplers.items():
+            random.seed(42)
+            first = tvm.nd.empty(shape, "float32")
+            sampler(first)
+            second = tvm.nd.empty(shape, "float32")
+            sampler(second)
+            results[(name, num_threads)] = (first.numpy(), second.numpy())
+
+    # ThreadPool object is thread local. To eliminate effect on other test cases put it into thread
+    for num_threads in [1, 4]:
+        x = threading.Thread(target=test_body, args=(num_threads,))
+        x.start()
+        x.join()
+
+    for name in samplers:
+        first, second = results[(name, 1)]
+        # The generator moves forward after each call.
+        assert not np.array_equal(first, second)
+        tvm.testing.assert_allclose(results[(name, 4)][0], first)
+        tvm.testing.assert_allclose(results[(name, 4)][1], second)
+    assert abs(np.mean(results[("bernoulli", 1)][0]) - 0.3) < 1e-2
+    assert abs(np.std(results[("normal", 1)][0]) - 4) < 1e-1
+
+
 if __name__ == "__main__":
     test_randint()
     test_uniform()
     test_normal()
     test_random_fill()
     test_random_fill_mt()
+    test_reproducible_across_threads()
@@ -123,7 +123,46 @@ def test_sort_by_key_gpu():
             tvm.testing.assert_allclose(values_out.numpy(), ref_values_out, rtol=1e-5)
 
 
+def test_argsort_topk_large():
+    # Large enough to run on the thread pool and to use radix sort.
+    argsort = tvm.get_global_func("tvm.contrib.sort.argsort")
+    sort = tvm.get_global_func("tvm.contrib.sort.sort")
+    topk = tvm.get_global_func("tvm.contrib.sort.topk")
+    dev = tvm.cpu(0)
+    for dtype in ["int32", "int64", "float32", "float64"]:
+        # Few distinct values to check the stability on ties.
+        np_data = np.random.randint(-50, 50, size=(64, 1000)).astype(dtype)
+        for axis in [1, 0]:
+            data = tvm.nd.array(np_data, dev)
+            for is_ascend in [True, False]:
+                keys = np_data if is_ascend else -np_data
+                ref_indices = np.argsort(keys, axis=axis, kind="stable")
+
+                indices = tvm.nd.empty(np_data.shape, "int32", dev)
+                argsort(data, indices, axis, is_ascend)
+                tvm.testing.assert_allclose(indices.numpy(), ref_indices)
+
+                values = tvm.nd.empty(np_data.shape, dtype, dev)
+                sort(data, values, axis, is_ascend)
+                tvm.testing.assert_allclose(
+                    values.numpy(), np.take_along_axis(np_data, ref_indices, axis)
+                )
+
+                for k in [5, 300]:
+                    topk_shape = list(np_data.shape)
+                    topk_shape[axis] = k
+                    values = tvm.nd.empty(topk_shape, dtype, dev)
+                    indices = tvm.nd.empty(topk_shape, "int64", dev)
+                    topk(data, values, indices, k, axis, "both", is_ascend)
+                    ref_topk = np.take(ref_indices, np.arange(k), axis=axis)
+                    tvm.testing.assert_allclose(indices.numpy(), ref_topk)
+                    tvm.testing.assert_allclose(
+                        values.numpy(), np.take_along_axis(np_data, ref_topk, axis)
+                    )
+
+
 if __name__ == "__main__":
     test_sort()
     test_sort_np()
+    test_argsort_topk_large()
     test_sort_by_key_gpu()
@@ -17,6 +17,7 @@
 # pylint: disable=missing-docstring
 """Tests for NCCL/RCCL"""
 import tempfile
+import time
 
 import numpy as np
 import pytest
@@ -25,6 +26,7 @@ import tvm
 import tvm.testing
 from tvm import dlight as dl
 from tvm import relax as rx
+from tvm.runtime import ShapeTuple
 from tvm.runtime import disco as di
 from tvm.runtime.relax_vm import VirtualMachine
 from tvm.script import relax as R
@@ -77,6 +79,66 @@ def test_allreduce(session_kind, ccl):
         np.testing.assert_equal(result, expected)
 
 
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+@pytest.mark.parametrize("ccl", _ccl)
+def test_allreduce_async(session_kind, ccl):
+    devices = [0, 1]
+    sess = session_kind(num_workers=len(devices))
+    sess.init_ccl(ccl, *devices)
+
+    array_1 = np.arange(12, dtype="float32").reshape(3, 4)
+    array_2 = np.arange(start=1, stop=-11, step=-1, dtype="float32").reshape(3, 4)
+    d_array = sess.empty((3, 4), "float32")
+    d_array.debug_copy_from(0, array_1)
+    d_array.debug_copy_from(1, array_2)
+    d_recv = sess.empty((3, 4), "float32")
+    start = sess.get_global_func("runtime.disco.allreduce_start")
+    wait = sess.get_global_func("runtime.disco.allreduce_wait")
+    start(d_array, ShapeTuple([0]), d_recv)
+    result = wait(d_recv, d_array).debug_get_from_remote(1).numpy()
+    np.testing.assert_equal(result, array_1 + array_2)
+
+
+# The workers call back into this process, which only a threaded session does.
+@pytest.mark.parametrize("ccl", _ccl)
+def test_allreduce_async_overlap(ccl):
+    devices = [0, 1]
+    sess = di.ThreadedSession(num_workers=len(devices))
+    sess.init_ccl(ccl, *devices)
+
+    # Worker 1 joins the allreduce late, so that the allreduce of worker 0 stays in flight for
+    # `delay` seconds. The copies of worker 0 on the default stream only finish early when they
+    # are not serialized after the allreduce.
+    delay = 2.0
+    elapsed = {}
+
+    def _start_late_and_copy(send, recv, probe):
+        worker_id = get_global_func("runtime.disco.worker_id")()[0]
+        if worker_id == 1:
+            time.sleep(delay)
+        get_global_func("runtime.disco.allreduce_start")(send, ShapeTuple([0]), recv)
+        tic = time.time()
+        probe.copyfrom(np.ones((1024,), "float32"))
+        probe.numpy()
+        elapsed[worker_id] = time.time() - tic
+        get_global_func("runtime.disco.allreduce_wait")(recv, send)
+
+    tvm.register_func("tests.disco.start_late_and_copy", _start_late_and_copy, override=True)
+    d_send = sess.empty((1024,), "float32")
+    d_recv = sess.empty((1024,), "float32")
+    d_probe = sess.empty((1024,), "float32")
+    d_send.debug_copy_from(0, np.ones((1024,), "float32"))
+    d_send.debug_copy_from(1, np.ones((1024,), "float32"))
+    # Set up the connections of the communicator before measuring.
+    sess.allreduce(d_send, d_recv)
+    func = sess.get_global_func("tests.disco.start_late_and_copy")
+    func(d_send, d_recv, d_probe)
+    sess._sync_worker(0)  # pylint: disable=protected-access
+    sess._sync_worker(1)  # pylint: disable=protected-access
+    assert elapsed[0] < delay / 2
+    np.testing.assert_equal(d_recv.debug_get_from_remote(0).numpy(), np.full((1024,), 2.0))
+
+
 @pytest.mark.parametrize("session_kind", _all_session_kinds)
 @pytest.mark.parametrize("ccl", _ccl)
 def test_allgather(session_kind, ccl):
@@ -399,5 +461,81 @@ def test_attention(session_kind, ccl):  # pylint: disable=too-many-locals,too-ma
     np.testing.assert_allclose(Y_result, Y_expected, rtol=1e-3, atol=1e-3)
 
 
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+@pytest.mark.parametrize("ccl", _ccl)
+def test_pipeline(session_kind, ccl):  # pylint: disable=too-many-locals
+    devices = [0, 1]
+    sess = session_kind(num_workers=len(devices))
+    sess.init_ccl(ccl, *devices)
+
+    # pylint: disable=invalid-name
+    @tvm.script.ir_module
+    class MLP:  # pylint: disable=too-few-public-methods
+        @R.function
+        def main(
+            x: R.Tensor((64, 128), "float32"),
+            W1: R.Tensor((128, 128), "float32"),
+            W2: R.Tensor((128, 128), "float32"),
+        ) -> R.Tensor((64, 128), "float32"):
+            R.func_attr({"global_symbol": "main", "num_input": 1})
+            with R.dataflow():
+                lv0: R.Tensor((64, 128), "float32") = R.matmul(x, W1)
+                lv1: R.Tensor((64, 128), "float32") = R.nn.gelu(lv0)
+                lv2: R.Tensor((64, 128), "float32") = R.matmul(lv1, W2)
+                # The residual makes the input be sent to the last stage along with the activation.
+                lv3: R.Tensor((64, 128), "float32") = R.add(lv2, x)
+                R.output(lv3)
+            return lv3
+
+    # pylint: enable=invalid-name
+    dev, target = create_device_target(ccl)
+
+    def relax_build(mod, target):
+        with target:
+            mod = rx.get_pipeline("zero")(mod)  # pylint: disable=no-value-for-parameter
+            mod = dl.ApplyDefaultSchedule(  # pylint: disable=not-callable
+                dl.gpu.Matmul(),
+                dl.gpu.GEMV(),
+                dl.gpu.Reduction(),
+                dl.gpu.GeneralReduction(),
+                dl.gpu.Fallback(),
+            )(mod)
+            return rx.build(mod, target=target)
+
+    # pylint: disable=invalid-name
+    Xs = [np.random.randn(64, 128).astype("float32") for _ in range(3)]
+    W1 = np.random.randn(128, 128).astype("float32")
+    W2 = np.random.randn(128, 128).astype("float32")
+    vm = VirtualMachine(relax_build(MLP, target), device=dev)
+    W1_nd, W2_nd = tvm.nd.array(W1, device=dev), tvm.nd.array(W2, device=dev)
+    Y_expected = [vm["main"](tvm.nd.array(X, device=dev), W1_nd, W2_nd).numpy() for X in Xs]
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        path = tmpdir + "/test.so"
+        # The first stage runs the first matmul and gelu, and the second stage runs the rest.
+        staged = rx.distributed.transform.PartitionPipelineStages(2)(MLP)
+        relax_build(staged, target).export_library(path)
+
+        mod = sess.load_vm_module(path)
+        make_array = sess.get_global_func("runtime.Array")
+
+        d_W = sess.empty((128, 128), "float32")
+        d_W.debug_copy_from(0, W1)
+        d_W.debug_copy_from(1, W2)
+        d_microbatches = []
+        for X in Xs:
+            d_X = sess.empty((64, 128), "float32")
+            d_X.debug_copy_from(0, X)
+            d_microbatches.append(make_array(d_X))
+        d_Ys = sess.run_pipeline(
+            mod, "main", make_array(*d_microbatches), make_array(d_W), len(Xs)
+        )
+        get_item = sess.get_global_func("runtime.ArrayGetItem")
+        Y_results = [get_item(d_Ys, i).debug_get_from_remote(1).numpy() for i in range(len(Xs))]
+    # pylint: enable=invalid-name
+    for Y_result, Y in zip(Y_results, Y_expected):
+        np.testing.assert_allclose(Y_result, Y, rtol=1e-4, atol=1e-4)
+
+
 if __name__ == "__main__":
     tvm.testing.main()
@@ -0,0 +1,67 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+#  type: ignore
+
+from tvm.script.parser import ir as I
+from tvm.script.parser import relax as R
+import tvm
+from tvm import relax
+from tvm.ir import assert_structural_equal
+import tvm.testing
+
+
+@I.ir_module
+class MLP:
+    I.module_attrs({"device_num": 2})
+    I.module_global_infos({"mesh": [R.device_mesh((2,), I.Range(0, 2))]})
+
+    @R.function
+    def foo(
+        x: R.Tensor((16, 128), "float32"),
+        weight1: R.Tensor((128, 512), "float32"),
+        weight2: R.Tensor((512, 128), "float32"),
+    ) -> R.Tensor((16, 128), "float32"):
+        lv0 = R.matmul(x, weight1)
+        lv1 = R.nn.gelu(lv0)
+        lv2 = R.matmul(lv1, weight2)
+        return lv2
+
+
+def _check_placements(memory_cap, expected):
+    mesh = relax.distributed.DeviceMesh((2,), tvm.ir.Range(0, 2))
+    after = relax.distributed.transform.AutoSharding(mesh, memory_cap)(MLP)
+    for param, placement in zip(after["foo"].params, expected):
+        assert isinstance(param.struct_info, relax.distributed.DTensorStructInfo)
+        assert_structural_equal(
+            param.struct_info.placement, relax.distributed.Placement.from_text(placement)
+        )
+
+
+def test_data_parallel():
+    # Without a memory limit, sharding the batch only needs the output to be gathered.
+    _check_placements(1 << 30, ["S[0]", "R", "R"])
+
+
+def test_tensor_parallel():
+    # The replicated weights take 512KB, so they are sharded on the hidden axis, which needs the
+    # output of the second matmul to be allreduced.
+    _check_placements(400000, ["R", "S[1]", "S[0]"])
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
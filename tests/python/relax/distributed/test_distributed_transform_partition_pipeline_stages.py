@@ -0,0 +1,127 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+#  type: ignore
+
+import numpy as np
+import pytest
+
+from tvm.script.parser import ir as I
+from tvm.script.parser import relax as R
+import tvm
+from tvm import relax
+import tvm.testing
+
+
+@I.ir_module
+class MLP:
+    @R.function
+    def main(
+        x: R.Tensor((8, 64), "float32"),
+        w0: R.Tensor((64, 64), "float32"),
+        w1: R.Tensor((64, 64), "float32"),
+        w2: R.Tensor((64, 64), "float32"),
+        w3: R.Tensor((64, 64), "float32"),
+    ) -> R.Tensor((8, 64), "float32"):
+        R.func_attr({"num_input": 1})
+        with R.dataflow():
+            lv0 = R.matmul(x, w0)
+            lv1 = R.nn.relu(lv0)
+            lv2 = R.matmul(lv1, w1)
+            lv3 = R.nn.relu(lv2)
+            lv4 = R.matmul(lv3, w2)
+            lv5 = R.nn.relu(lv4)
+            lv6 = R.matmul(lv5, w3)
+            gv = R.add(lv6, x)
+            R.output(gv)
+        return gv
+
+
+def test_two_stages():
+    mod = relax.distributed.transform.PartitionPipelineStages(2)(MLP)
+    stage0 = mod["main_stage0"]
+    stage1 = mod["main_stage1"]
+    # Each stage takes two of the matmuls, and `x` is forwarded to the residual add.
+    assert [p.name_hint for p in stage0.params] == ["x", "w0", "w1"]
+    assert [p.name_hint for p in stage1.params] == ["x", "lv3", "w2", "w3"]
+    assert int(stage0.attrs["num_input"]) == 1
+    assert int(stage1.attrs["num_input"]) == 2
+    assert isinstance(stage0.ret_struct_info, relax.TupleStructInfo)
+    tvm.ir.assert_structural_equal(mod["main"], MLP["main"])
+
+    mod = relax.pipeline.get_pipeline()(mod)
+    vm = relax.VirtualMachine(relax.build(mod, "llvm"), tvm.cpu())
+    x = np.random.uniform(-1, 1, (8, 64)).astype("float32")
+    ws = [np.random.uniform(-1, 1, (64, 64)).astype("float32") for _ in range(4)]
+    x, ws = tvm.nd.array(x), [tvm.nd.array(w) for w in ws]
+    activations = vm["main_stage0"](x, ws[0], ws[1])
+    res = vm["main_stage1"](*activations, ws[2], ws[3])
+    expected = vm["main"](x, *ws)
+    tvm.testing.assert_allclose(res.numpy(), expected.numpy(), rtol=1e-5, atol=1e-5)
+
+
+@I.ir_module
+class SplitConcat:
+    @R.function
+    def main(
+        x: R.Tensor((8, 64), "float32"),
+        w0: R.Tensor((64, 64), "float32"),
+        w1: R.Tensor((64, 64), "float32"),
+    ) -> R.Tensor((8, 64), "float32"):
+        R.func_attr({"num_input": 1})
+        with R.dataflow():
+            lv0 = R.split(x, 2, axis=1)
+            lv1 = R.matmul(x, w0)
+            lv2 = R.matmul(x, w1)
+            lv3 = lv0[0]
+            lv4 = lv0[1]
+            lv5 = R.concat((lv3, lv4), axis=1)
+            lv6 = R.add(lv5, lv1)
+            gv = R.add(lv6, lv2)
+            R.output(gv)
+        return gv
+
+
+def test_tuple_not_live_across_stages():
+    mod = relax.distributed.transform.PartitionPipelineStages(2)(SplitConcat)
+    stage0 = mod["main_stage0"]
+    stage1 = mod["main_stage1"]
+    # The balanced split between the matmuls would send the tuple of `split`, so the stages are
+    # split after its items are extracted instead.
+    for param in stage1.params:
+        assert isinstance(param.struct_info, relax.TensorStructInfo)
+    for field in stage0.ret_struct_info.fields:
+        assert isinstance(field, relax.TensorStructInfo)
+
+    mod = relax.pipeline.get_pipeline()(mod)
+    vm = relax.VirtualMachine(relax.build(mod, "llvm"), tvm.cpu())
+    x = np.random.uniform(-1, 1, (8, 64)).astype("float32")
+    ws = [np.random.uniform(-1, 1, (64, 64)).astype("float32") for _ in range(2)]
+    x, ws = tvm.nd.array(x), [tvm.nd.array(w) for w in ws]
+    activations = vm["main_stage0"](x, *ws)
+    res = vm["main_stage1"](*activations)
+    expected = vm["main"](x, *ws)
+    tvm.testing.assert_allclose(res.numpy(), expected.numpy(), rtol=1e-5, atol=1e-5)
+
+
+def test_too_many_stages():
+    with pytest.raises(tvm.TVMError):
+        relax.distributed.transform.PartitionPipelineStages(9)(MLP)
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
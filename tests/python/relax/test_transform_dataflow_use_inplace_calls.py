@@ -0,0 +1,195 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I, relax as R, tir as T
+
+
+def _inplace_calls(func):
+    calls = []
+
+    def fvisit(expr):
+        if isinstance(expr, relax.Call) and expr.op == tvm.ir.Op.get("relax.call_tir_inplace"):
+            calls.append(expr)
+
+    relax.analysis.post_order_visit(func, fvisit)
+    return calls
+
+
+@I.ir_module
+class Module:
+    @T.prim_func(private=True)
+    def add(
+        A: T.Buffer((T.int64(4), T.int64(8)), "float32"),
+        B: T.Buffer((T.int64(4), T.int64(8)), "float32"),
+        C: T.Buffer((T.int64(4), T.int64(8)), "float32"),
+    ):
+        for i, j in T.grid(T.int64(4), T.int64(8)):
+            with T.block("add"):
+                vi, vj = T.axis.remap("SS", [i, j])
+                C[vi, vj] = A[vi, vj] + B[vi, vj]
+
+    @T.prim_func(private=True)
+    def relu(
+        A: T.Buffer((T.int64(4), T.int64(8)), "float32"),
+        B: T.Buffer((T.int64(4), T.int64(8)), "float32"),
+    ):
+        for i, j in T.grid(T.int64(4), T.int64(8)):
+            with T.block("relu"):
+                vi, vj = T.axis.remap("SS", [i, j])
+                B[vi, vj] = T.max(A[vi, vj], T.float32(0))
+
+    @R.function
+    def main(
+        x: R.Tensor((4, 8), "float32"), y: R.Tensor((4, 8), "float32")
+    ) -> R.Tensor((4, 8), "float32"):
+        cls = Module
+        with R.dataflow():
+            lv = R.call_tir(cls.add, (x, y), out_sinfo=R.Tensor((4, 8), "float32"))
+            lv1 = R.call_tir(cls.relu, (lv,), out_sinfo=R.Tensor((4, 8), "float32"))
+            gv = R.call_tir(cls.add, (lv1, y), out_sinfo=R.Tensor((4, 8), "float32"))
+            R.output(gv)
+        return gv
+
+
+def test_elementwise_chain():
+    mod = relax.transform.DataflowUseInplaceCalls()(Module)
+    calls = _inplace_calls(mod["main"])
+    # The parameters are never overwritten, but the intermediate results are.
+    assert len(calls) == 2
+    assert [int(i) for i in calls[0].attrs.inplace_indices] == [0]
+    relu_inplace = mod[calls[0].args[0]]
+    assert len(relu_inplace.params) == 1
+    add_inplace = mod[calls[1].args[0]]
+    assert len(add_inplace.params) == 2
+
+    x = np.random.uniform(-1, 1, (4, 8)).astype("float32")
+    y = np.random.uniform(-1, 1, (4, 8)).astype("float32")
+    ex = relax.build(mod, "llvm")
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    res = vm["main"](tvm.nd.array(x), tvm.nd.array(y))
+    tvm.testing.assert_allclose(res.numpy(), np.maximum(x + y, 0) + y, rtol=1e-6)
+
+
+def test_live_input():
+    @I.ir_module
+    class LiveInput:
+        @T.prim_func(private=True)
+        def relu(
+            A: T.Buffer((T.int64(4), T.int64(8)), "float32"),
+            B: T.Buffer((T.int64(4), T.int64(8)), "float32"),
+        ):
+            for i, j in T.grid(T.int64(4), T.int64(8)):
+                with T.block("relu"):
+                    vi, vj = T.axis.remap("SS", [i, j])
+                    B[vi, vj] = T.max(A[vi, vj], T.float32(0))
+
+        @R.function
+        def main(x: R.Tensor((4, 8), "float32")):
+            cls = LiveInput
+            with R.dataflow():
+                lv = R.call_tir(cls.relu, (x,), out_sinfo=R.Tensor((4, 8), "float32"))
+                lv1 = R.call_tir(cls.relu, (lv,), out_sinfo=R.Tensor((4, 8), "float32"))
+                gv = (lv, lv1)
+                R.output(gv)
+            return gv
+
+    # `lv` is used after the call, and `x` is owned by the caller.
+    mod = relax.transform.DataflowUseInplaceCalls()(LiveInput)
+    assert len(_inplace_calls(mod["main"])) == 0
+
+
+def test_non_elementwise():
+    @I.ir_module
+    class Transpose:
+        @T.prim_func(private=True)
+        def relu(
+            A: T.Buffer((T.int64(8), T.int64(8)), "float32"),
+            B: T.Buffer((T.int64(8), T.int64(8)), "float32"),
+        ):
+            for i, j in T.grid(T.int64(8), T.int64(8)):
+                with T.block("relu"):
+                    vi, vj = T.axis.remap("SS", [i, j])
+                    B[vi, vj] = T.max(A[vi, vj], T.float32(0))
+
+        @T.prim_func(private=True)
+        def transpose(
+            A: T.Buffer((T.int64(8), T.int64(8)), "float32"),
+            B: T.Buffer((T.int64(8), T.int64(8)), "float32"),
+        ):
+            for i, j in T.grid(T.int64(8), T.int64(8)):
+                with T.block("transpose"):
+                    vi, vj = T.axis.remap("SS", [i, j])
+                    B[vi, vj] = A[vj, vi]
+
+        @R.function
+        def main(x: R.Tensor((8, 8), "float32")) -> R.Tensor((8, 8), "float32"):
+            cls = Transpose
+            with R.dataflow():
+                lv = R.call_tir(cls.relu, (x,), out_sinfo=R.Tensor((8, 8), "float32"))
+                gv = R.call_tir(cls.transpose, (lv,), out_sinfo=R.Tensor((8, 8), "float32"))
+                R.output(gv)
+            return gv
+
+    mod = relax.transform.DataflowUseInplaceCalls()(Transpose)
+    assert len(_inplace_calls(mod["main"])) == 0
+
+
+def test_non_bijective_binding():
+    @I.ir_module
+    class RepeatedInstances:
+        @T.prim_func(private=True)
+        def relu(
+            A: T.Buffer((T.int64(8), T.int64(8)), "float32"),
+            B: T.Buffer((T.int64(8), T.int64(8)), "float32"),
+        ):
+            for i, j in T.grid(T.int64(8), T.int64(8)):
+                with T.block("relu"):
+                    vi, vj = T.axis.remap("SS", [i, j])
+                    B[vi, vj] = T.max(A[vi, vj], T.float32(0))
+
+        @T.prim_func(private=True)
+        def add_one(
+            A: T.Buffer((T.int64(8), T.int64(8)), "float32"),
+            B: T.Buffer((T.int64(8), T.int64(8)), "float32"),
+        ):
+            # Each instance of the block runs twice, which reads its own output when in-place.
+            for i, j in T.grid(T.int64(16), T.int64(8)):
+                with T.block("add_one"):
+                    vi = T.axis.spatial(T.int64(8), i // T.int64(2))
+                    vj = T.axis.spatial(T.int64(8), j)
+                    B[vi, vj] = A[vi, vj] + T.float32(1)
+
+        @R.function
+        def main(x: R.Tensor((8, 8), "float32")) -> R.Tensor((8, 8), "float32"):
+            cls = RepeatedInstances
+            with R.dataflow():
+                lv = R.call_tir(cls.relu, (x,), out_sinfo=R.Tensor((8, 8), "float32"))
+                gv = R.call_tir(cls.add_one, (lv,), out_sinfo=R.Tensor((8, 8), "float32"))
+                R.output(gv)
+            return gv
+
+    mod = relax.transform.DataflowUseInplaceCalls()(RepeatedInstances)
+    assert len(_inplace_calls(mod["main"])) == 0
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -0,0 +1,87 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import relax as R
+
+
+def _collect_constants(mod):
+    constants = []
+    for func in mod.functions.values():
+        if isinstance(func, relax.Function):
+            relax.analysis.post_order_visit(
+                func,
+                lambda e: constants.append(e) if isinstance(e, relax.Constant) else None,
+            )
+    return constants
+
+
+def _make_module(data, other_data):
+    bb = relax.BlockBuilder()
+    x = relax.Var("x", R.Tensor((4, 4), "float32"))
+    with bb.function("main", [x]):
+        with bb.dataflow():
+            lv0 = bb.emit(relax.op.add(x, relax.const(data.copy())))
+            lv1 = bb.emit(relax.op.multiply(lv0, relax.const(data.copy())))
+            gv = bb.emit_output(relax.op.subtract(lv1, relax.const(other_data)))
+        bb.emit_func_output(gv)
+    x = relax.Var("x", R.Tensor((4, 4), "float32"))
+    with bb.function("variant", [x]):
+        with bb.dataflow():
+            gv = bb.emit_output(relax.op.add(x, relax.const(data.copy())))
+        bb.emit_func_output(gv)
+    return bb.get()
+
+
+def test_share_constants_across_functions():
+    data = np.random.uniform(size=(4, 4)).astype("float32")
+    other_data = np.random.uniform(size=(4, 4)).astype("float32")
+    before = _make_module(data, other_data)
+    assert len({c.handle.value for c in _collect_constants(before)}) == 4
+
+    after = relax.transform.DeduplicateConstants()(before)
+    tvm.ir.assert_structural_equal(after, before)
+    constants = _collect_constants(after)
+    shared = [c for c in constants if np.array_equal(c.data.numpy(), data)]
+    assert len(shared) == 3
+    assert all(c.same_as(shared[0]) for c in shared)
+    assert len({c.handle.value for c in constants}) == 2
+
+
+def test_keep_different_dtypes():
+    bb = relax.BlockBuilder()
+    x = relax.Var("x", R.Tensor((2,), "int32"))
+    y = relax.Var("y", R.Tensor((2,), "uint32"))
+    with bb.function("main", [x, y]):
+        with bb.dataflow():
+            lv0 = bb.emit(relax.op.add(x, relax.const(np.zeros(2, "int32"))))
+            lv1 = bb.emit(relax.op.add(y, relax.const(np.zeros(2, "uint32"))))
+            gv = bb.emit_output(relax.Tuple([lv0, lv1]))
+        bb.emit_func_output(gv)
+    before = bb.get()
+    after = relax.transform.DeduplicateConstants()(before)
+    constants = _collect_constants(after)
+    assert len(constants) == 2
+    assert not constants[0].same_as(constants[1])
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -1501,5 +1501,52 @@ def test_partially_used_tuple_param():
     _check(Module, Expected)
 
 
+def _fused_group_sizes(mod):
+    return sorted(
+        len(func.body.blocks[0].bindings)
+        for func in mod.functions.values()
+        if isinstance(func, relax.Function) and func.attrs and "Primitive" in func.attrs
+    )
+
+
+def test_cost_model_broadcast():
+    """The cost model refuses to recompute an elementwise chain for every row it is broadcast to,
+    unless the FLOPs are cheap enough relative to the bytes saved."""
+    bb = relax.BlockBuilder()
+    x = relax.Var("x", R.Tensor([1024, 4096], "float32"))
+    v = relax.Var("v", R.Tensor([4096], "float32"))
+    with bb.function("main", [x, v]):
+        with bb.dataflow():
+            lv0 = bb.emit_te(topi.multiply, v, v)
+            lv1 = bb.emit_te(topi.add, lv0, v)
+            gv = bb.emit_output(bb.call_te(topi.add, x, lv1))
+        bb.emit_func_output(gv)
+    mod = relax.transform.AnnotateTIROpPattern()(bb.get())
+
+    assert _fused_group_sizes(relax.transform.FuseOps()(mod)) == [3]
+    with tvm.transform.PassContext(config={"relax.FuseOps.cost_model": True}):
+        assert _fused_group_sizes(relax.transform.FuseOps()(mod)) == [2]
+    with tvm.transform.PassContext(
+        config={"relax.FuseOps.cost_model": True, "relax.FuseOps.flops_per_byte": 1000}
+    ):
+        assert _fused_group_sizes(relax.transform.FuseOps()(mod)) == [3]
+
+
+def test_cost_model_elemwise():
+    """Elementwise chains are always fused, since nothing is recomputed."""
+    bb = relax.BlockBuilder()
+    x = relax.Var("x", R.Tensor([1024, 4096], "float32"))
+    with bb.function("main", [x]):
+        with bb.dataflow():
+            lv0 = bb.emit_te(topi.multiply, x, x)
+            lv1 = bb.emit_te(topi.add, lv0, x)
+            gv = bb.emit_output(bb.call_te(topi.exp, lv1))
+        bb.emit_func_output(gv)
+    mod = relax.transform.AnnotateTIROpPattern()(bb.get())
+
+    with tvm.transform.PassContext(config={"relax.FuseOps.cost_model": True}):
+        assert _fused_group_sizes(relax.transform.FuseOps()(mod)) == [3]
+
+
 if __name__ == "__main__":
     tvm.testing.main()
@@ -685,5 +685,71 @@ def test_checkpoint_sequential_checkpoint_last():
     assert_structural_equal(bb.get(), Expected)
 
 
+@I.ir_module
+class PowerChain:
+    @R.function
+    def main(x: R.Tensor((3, 3), "float32")):
+        with R.dataflow():
+            lv1 = R.power(x, R.const(3, "float32"))
+            lv2 = R.power(lv1, R.const(3, "float32"))
+            lv3 = R.power(lv2, R.const(3, "float32"))
+            lv4 = R.power(lv3, R.const(3, "float32"))
+            gv = R.sum(lv4)
+            R.output(gv)
+        return gv
+
+
+def test_auto_checkpoint():
+    """lv1, lv2 and lv3 are used by the backward pass, 36 bytes each"""
+    # fmt: off
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((3, 3), "float32")):
+            with R.dataflow():
+                x_scp = R.grad.start_checkpoint(x)
+                lv1 = R.power(x_scp, R.const(3, "float32"))
+                lv1_ecp = R.grad.end_checkpoint(lv1)
+                lv2 = R.power(lv1_ecp, R.const(3, "float32"))
+                lv3 = R.power(lv2, R.const(3, "float32"))
+                lv4 = R.power(lv3, R.const(3, "float32"))
+                gv = R.sum(lv4)
+                R.output(gv)
+            return gv
+    # fmt: on
+
+    After = relax.transform.AutoCheckpoint("main", memory_budget=72)(PowerChain)
+    assert_structural_equal(After, Expected)
+    adjoint = relax.transform.Gradient("main")(After)["main_adjoint"]
+    assert "lv1_cp" in adjoint.script()
+
+
+def test_auto_checkpoint_zero_budget():
+    # fmt: off
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((3, 3), "float32")):
+            with R.dataflow():
+                x_scp = R.grad.start_checkpoint(x)
+                lv1 = R.power(x_scp, R.const(3, "float32"))
+                lv2 = R.power(lv1, R.const(3, "float32"))
+                lv3 = R.power(lv2, R.const(3, "float32"))
+                lv3_ecp = R.grad.end_checkpoint(lv3)
+                lv4 = R.power(lv3_ecp, R.const(3, "float32"))
+                gv = R.sum(lv4)
+                R.output(gv)
+            return gv
+    # fmt: on
+
+    After = relax.transform.AutoCheckpoint("main", memory_budget=0)(PowerChain)
+    assert_structural_equal(After, Expected)
+
+
+def test_auto_checkpoint_within_budget():
+    After = relax.transform.AutoCheckpoint("main", memory_budget=108)(PowerChain)
+    assert_structural_equal(After, PowerChain)
+
+
 if __name__ == "__main__":
     tvm.testing.main()
@@ -0,0 +1,117 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+
+import tvm
+import tvm.testing
+from tvm import relax, topi
+from tvm.script import relax as R
+
+
+def _grouped_functions(mod):
+    return [
+        func
+        for func in mod.functions.values()
+        if isinstance(func, relax.Function) and func.attrs and "Primitive" in func.attrs
+    ]
+
+
+def _before(shape):
+    bb = relax.BlockBuilder()
+    x = relax.Var("x", R.Tensor(shape, "float32"))
+    y = relax.Var("y", R.Tensor(shape, "float32"))
+    z = relax.Var("z", R.Tensor(shape, "float32"))
+    with bb.function("main", [x, y, z]):
+        with bb.dataflow():
+            lv0 = bb.emit_te(topi.exp, x)
+            lv1 = bb.emit_te(topi.negative, y)
+            lv2 = bb.emit_te(topi.sum, z, axis=1, keepdims=True)
+            lv3 = bb.emit_te(topi.add, lv0, lv1)
+            gv = bb.emit_output(bb.call_te(topi.add, lv3, lv2))
+        bb.emit_func_output(gv)
+    return relax.transform.AnnotateTIROpPattern()(bb.get())
+
+
+def test_fuse_independent_elemwise():
+    mod = relax.transform.HorizontalFuseOps()(_before((4, 8)))
+    grouped = _grouped_functions(mod)
+    # Only the two independent elementwise ops are fused, the reduction has another pattern.
+    assert len(grouped) == 1
+    assert len(grouped[0].body.blocks[0].bindings) == 2
+    assert isinstance(grouped[0].ret_struct_info, relax.TupleStructInfo)
+    assert grouped[0].attrs["relax.horizontal_fusion"] == 2
+
+    mod = relax.transform.FuseTIR()(mod)
+    assert not _grouped_functions(mod)
+    num_kernels = [
+        func.attrs["tir.horizontal_fusion"]
+        for func in mod.functions.values()
+        if isinstance(func, tvm.tir.PrimFunc) and "tir.horizontal_fusion" in (func.attrs or {})
+    ]
+    assert num_kernels == [2]
+    inputs = [np.random.uniform(-1, 1, (4, 8)).astype("float32") for _ in range(3)]
+    x, y, z = inputs
+    expected = np.exp(x) - y + z.sum(axis=1, keepdims=True)
+    vm = relax.VirtualMachine(relax.build(mod, "llvm"), tvm.cpu())
+    res = vm["main"](*[tvm.nd.array(data) for data in inputs])
+    tvm.testing.assert_allclose(res.numpy(), expected, rtol=1e-5, atol=1e-5)
+
+
+@tvm.testing.requires_cuda
+def test_fuse_independent_elemwise_single_kernel():
+    target = tvm.target.Target("cuda")
+    mod = relax.transform.HorizontalFuseOps()(_before((4, 8)))
+    mod = relax.transform.FuseTIR()(mod)
+    with target:
+        mod = tvm.tir.transform.DefaultGPUSchedule()(mod)
+    ex = relax.build(mod, target)
+    # The two exp and negative kernels are launched as one, next to the sum and the two adds.
+    source = ex.mod.imported_modules[0].imported_modules[0].get_source()
+    assert source.count("__global__") == 4
+
+    inputs = [np.random.uniform(-1, 1, (4, 8)).astype("float32") for _ in range(3)]
+    x, y, z = inputs
+    expected = np.exp(x) - y + z.sum(axis=1, keepdims=True)
+    dev = tvm.cuda()
+    vm = relax.VirtualMachine(ex, dev)
+    res = vm["main"](*[tvm.nd.array(data, dev) for data in inputs])
+    tvm.testing.assert_allclose(res.numpy(), expected, rtol=1e-5, atol=1e-5)
+
+
+def test_skip_large_kernels():
+    before = _before((4, 8))
+    after = relax.transform.HorizontalFuseOps(max_num_elements=16)(before)
+    tvm.ir.assert_structural_equal(after, before)
+
+
+def test_skip_dependent_kernels():
+    bb = relax.BlockBuilder()
+    x = relax.Var("x", R.Tensor((4, 8), "float32"))
+    with bb.function("main", [x]):
+        with bb.dataflow():
+            lv0 = bb.emit_te(topi.exp, x)
+            lv1 = bb.emit_te(topi.negative, lv0)
+            gv = bb.emit_output(bb.call_te(topi.add, lv0, lv1))
+        bb.emit_func_output(gv)
+    before = relax.transform.AnnotateTIROpPattern()(bb.get())
+    after = relax.transform.HorizontalFuseOps()(before)
+    tvm.ir.assert_structural_equal(after, before)
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -0,0 +1,158 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I, relax as R
+
+
+def test_overlap_independent_computation():
+    @I.ir_module
+    class Before:
+        @R.function
+        def main(x: R.Tensor((4, 8), "float32"), y: R.Tensor((4, 8), "float32")):
+            with R.dataflow():
+                lv0 = R.ccl.allreduce(x, "sum")
+                lv1 = R.add(lv0, x)
+                lv2 = R.multiply(y, y)
+                gv = R.add(lv1, lv2)
+                R.output(gv)
+            return gv
+
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((4, 8), "float32"), y: R.Tensor((4, 8), "float32")):
+            with R.dataflow():
+                lv0_recv = R.call_dps_packed(
+                    "runtime.disco.allreduce_start",
+                    (x, R.shape([0])),
+                    out_sinfo=R.Tensor((4, 8), "float32"),
+                )
+                lv2 = R.multiply(y, y)
+                lv0 = R.call_pure_packed(
+                    "runtime.disco.allreduce_wait",
+                    lv0_recv,
+                    x,
+                    sinfo_args=R.Tensor((4, 8), "float32"),
+                )
+                lv1 = R.add(lv0, x)
+                gv = R.add(lv1, lv2)
+                R.output(gv)
+            return gv
+
+    After = relax.transform.OverlapAllReduce()(Before)
+    tvm.ir.assert_structural_equal(After, Expected)
+
+
+def test_consecutive_allreduces():
+    @I.ir_module
+    class Before:
+        @R.function
+        def main(x: R.Tensor((4, 8), "float32"), y: R.Tensor((4, 8), "float32")):
+            with R.dataflow():
+                lv0 = R.ccl.allreduce(x, "sum")
+                lv1 = R.ccl.allreduce(y, "max")
+                gv = R.add(lv0, lv1)
+                R.output(gv)
+            return gv
+
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((4, 8), "float32"), y: R.Tensor((4, 8), "float32")):
+            with R.dataflow():
+                # Both allreduces are started before waiting for the first one.
+                lv0_recv = R.call_dps_packed(
+                    "runtime.disco.allreduce_start",
+                    (x, R.shape([0])),
+                    out_sinfo=R.Tensor((4, 8), "float32"),
+                )
+                lv1_recv = R.call_dps_packed(
+                    "runtime.disco.allreduce_start",
+                    (y, R.shape([3])),
+                    out_sinfo=R.Tensor((4, 8), "float32"),
+                )
+                lv0 = R.call_pure_packed(
+                    "runtime.disco.allreduce_wait",
+                    lv0_recv,
+                    x,
+                    sinfo_args=R.Tensor((4, 8), "float32"),
+                )
+                lv1 = R.call_pure_packed(
+                    "runtime.disco.allreduce_wait",
+                    lv1_recv,
+                    y,
+                    sinfo_args=R.Tensor((4, 8), "float32"),
+                )
+                gv = R.add(lv0, lv1)
+                R.output(gv)
+            return gv
+
+    After = relax.transform.OverlapAllReduce()(Before)
+    tvm.ir.assert_structural_equal(After, Expected)
+
+
+def test_plan_receive_buffer():
+    @I.ir_module
+    class Before:
+        @R.function
+        def main(x: R.Tensor((4, 8), "float32")):
+            with R.dataflow():
+                lv0 = R.ccl.allreduce(x, "sum")
+                lv1 = R.add(lv0, x)
+                lv2 = R.add(lv1, lv1)
+                gv = R.add(lv2, lv0)
+                R.output(gv)
+            return gv
+
+    mod = relax.transform.OverlapAllReduce()(Before)
+    mod = relax.transform.LegalizeOps()(mod)
+    mod = relax.transform.RemovePurityChecking()(mod)
+    mod = relax.transform.CallTIRRewrite()(mod)
+    mod = relax.transform.StaticPlanBlockMemory()(mod)
+
+    alloc_tensor_op = tvm.ir.Op.get("relax.memory.alloc_tensor")
+    storages = [
+        binding.value.args[0]
+        for block in mod["main"].body.blocks
+        for binding in block.bindings
+        if isinstance(binding.value, relax.Call) and binding.value.op.same_as(alloc_tensor_op)
+    ]
+    # The receive buffer is planned, and its storage is not reused while the result of the wait
+    # is alive.
+    assert len(storages) == 3
+    assert len({storage.name_hint for storage in storages}) == 3
+
+
+def test_no_allreduce():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((4, 8), "float32")):
+            with R.dataflow():
+                gv = R.add(x, x)
+                R.output(gv)
+            return gv
+
+    After = relax.transform.OverlapAllReduce()(Module)
+    tvm.ir.assert_structural_equal(After, Module)
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -0,0 +1,244 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+import pytest
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I, relax as R, tir as T
+
+
+@pytest.fixture(autouse=True)
+def enable_persistent_workspace():
+    """Enable persistent workspace planning for all tests in this file"""
+    with tvm.transform.PassContext(config={"relax.backend.use_persistent_workspace": True}):
+        yield
+
+
+def test_share_workspace_across_functions():
+    # fmt: off
+    @I.ir_module
+    class Before:
+        @T.prim_func
+        def exp(A: T.handle, B: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def reduce(A: T.handle, B: T.handle):
+            T.evaluate(0)
+
+        @R.function
+        def decode(x: R.Tensor((2, 4), dtype="float32")) -> R.Tensor((2, 4), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Before
+            storage: R.Object = R.memory.alloc_storage(R.shape([32]), R.prim_value(0), R.str("global"), R.dtype("float32"))
+            alloc: R.Tensor((2, 4), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(0), R.shape([2, 4]), R.dtype("float32"))
+            _: R.Tuple = cls.exp(x, alloc)
+            alloc1: R.Tensor((2, 4), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 4]), R.dtype("float32"), R.prim_value(0))
+            _1: R.Tuple = cls.exp(alloc, alloc1)
+            return alloc1
+
+        @R.function
+        def prefill(x: R.Tensor((8, 4), dtype="float32")) -> R.Tensor((2, 2), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Before
+            storage: R.Object = R.memory.alloc_storage(R.shape([16]), R.prim_value(0), R.str("global"), R.dtype("float32"))
+            storage1: R.Object = R.memory.alloc_storage(R.shape([128]), R.prim_value(0), R.str("global"), R.dtype("float32"))
+            alloc: R.Tensor((8, 4), dtype="float32") = R.memory.alloc_tensor(storage1, R.prim_value(0), R.shape([8, 4]), R.dtype("float32"))
+            _: R.Tuple = cls.exp(x, alloc)
+            alloc1: R.Tensor((2, 2), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(0), R.shape([2, 2]), R.dtype("float32"))
+            _1: R.Tuple = cls.reduce(alloc, alloc1)
+            alloc2: R.Tensor((2, 2), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 2]), R.dtype("float32"), R.prim_value(0))
+            _2: R.Tuple = cls.exp(alloc1, alloc2)
+            return alloc2
+
+    @I.ir_module
+    class Expected:
+        @T.prim_func
+        def exp(A: T.handle, B: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def reduce(A: T.handle, B: T.handle):
+            T.evaluate(0)
+
+        @R.function
+        def decode(x: R.Tensor((2, 4), dtype="float32")) -> R.Tensor((2, 4), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Expected
+            storage: R.Object = R.call_builtin_with_ctx("vm.builtin.get_persistent_workspace", (R.prim_value(0),), sinfo_args=(R.Object,))
+            alloc: R.Tensor((2, 4), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(0), R.shape([2, 4]), R.dtype("float32"))
+            _: R.Tuple = cls.exp(x, alloc)
+            alloc1: R.Tensor((2, 4), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 4]), R.dtype("float32"), R.prim_value(0))
+            _1: R.Tuple = cls.exp(alloc, alloc1)
+            return alloc1
+
+        @R.function
+        def prefill(x: R.Tensor((8, 4), dtype="float32")) -> R.Tensor((2, 2), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Expected
+            storage: R.Object = R.call_builtin_with_ctx("vm.builtin.get_persistent_workspace", (R.prim_value(1),), sinfo_args=(R.Object,))
+            storage1: R.Object = R.call_builtin_with_ctx("vm.builtin.get_persistent_workspace", (R.prim_value(0),), sinfo_args=(R.Object,))
+            alloc: R.Tensor((8, 4), dtype="float32") = R.memory.alloc_tensor(storage1, R.prim_value(0), R.shape([8, 4]), R.dtype("float32"))
+            _: R.Tuple = cls.exp(x, alloc)
+            alloc1: R.Tensor((2, 2), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(0), R.shape([2, 2]), R.dtype("float32"))
+            _1: R.Tuple = cls.reduce(alloc, alloc1)
+            alloc2: R.Tensor((2, 2), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 2]), R.dtype("float32"), R.prim_value(0))
+            _2: R.Tuple = cls.exp(alloc1, alloc2)
+            return alloc2
+
+        @R.function(private=True)
+        def vm_persistent_workspace_alloc() -> R.Tuple(R.Object, R.Object):
+            R.func_attr({"relax.force_pure": True})
+            workspace: R.Object = R.memory.alloc_storage(R.shape([128]), R.prim_value(0), R.str("global"), R.dtype("uint8"))
+            workspace1: R.Object = R.memory.alloc_storage(R.shape([16]), R.prim_value(0), R.str("global"), R.dtype("uint8"))
+            gv: R.Tuple(R.Object, R.Object) = (workspace, workspace1)
+            return gv
+    # fmt: on
+
+    mod = relax.transform.PlanPersistentWorkspace()(Before)
+    tvm.ir.assert_structural_equal(mod, Expected)
+
+
+def test_skip_functions_calling_each_other():
+    # fmt: off
+    @I.ir_module
+    class Before:
+        @T.prim_func
+        def exp(A: T.handle, B: T.handle):
+            T.evaluate(0)
+
+        @R.function
+        def inner(x: R.Tensor((2, 4), dtype="float32")) -> R.Tensor((2, 4), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Before
+            storage: R.Object = R.memory.alloc_storage(R.shape([32]), R.prim_value(0), R.str("global"), R.dtype("float32"))
+            alloc: R.Tensor((2, 4), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(0), R.shape([2, 4]), R.dtype("float32"))
+            _: R.Tuple = cls.exp(x, alloc)
+            alloc1: R.Tensor((2, 4), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 4]), R.dtype("float32"), R.prim_value(0))
+            _1: R.Tuple = cls.exp(alloc, alloc1)
+            return alloc1
+
+        @R.function
+        def main(x: R.Tensor((2, 4), dtype="float32")) -> R.Tensor((2, 4), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Before
+            storage: R.Object = R.memory.alloc_storage(R.shape([32]), R.prim_value(0), R.str("global"), R.dtype("float32"))
+            alloc: R.Tensor((2, 4), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(0), R.shape([2, 4]), R.dtype("float32"))
+            _: R.Tuple = cls.exp(x, alloc)
+            gv: R.Tensor((2, 4), dtype="float32") = cls.inner(alloc)
+            return gv
+    # fmt: on
+
+    mod = relax.transform.PlanPersistentWorkspace()(Before)
+    tvm.ir.assert_structural_equal(mod, Before)
+
+
+def test_disabled_by_default():
+    @I.ir_module
+    class Before:
+        @R.function
+        def main(x: R.Tensor((2, 4), dtype="float32")) -> R.Object:
+            R.func_attr({"relax.force_pure": True})
+            storage: R.Object = R.memory.alloc_storage(
+                R.shape([32]), R.prim_value(0), R.str("global"), R.dtype("float32")
+            )
+            return storage
+
+    with tvm.transform.PassContext(config={"relax.backend.use_persistent_workspace": False}):
+        mod = relax.transform.PlanPersistentWorkspace()(Before)
+    tvm.ir.assert_structural_equal(mod, Before)
+
+
+def test_build_and_run():
+    @I.ir_module
+    class Module:
+        @R.function
+        def prefill(x: R.Tensor((8, 16), dtype="float32")) -> R.Tensor((8, 16), dtype="float32"):
+            y = R.exp(x)
+            z = R.add(y, y)
+            return R.multiply(z, y)
+
+        @R.function
+        def decode(x: R.Tensor((1, 16), dtype="float32")) -> R.Tensor((1, 16), dtype="float32"):
+            y = R.exp(x)
+            z = R.add(y, y)
+            return R.subtract(z, y)
+
+    ex = relax.build(Module, "llvm")
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    for _ in range(2):
+        x_np = np.random.uniform(size=(8, 16)).astype("float32")
+        res = vm["prefill"](tvm.nd.array(x_np))
+        tvm.testing.assert_allclose(res.numpy(), 2 * np.exp(x_np) * np.exp(x_np), rtol=1e-5)
+        x_np = np.random.uniform(size=(1, 16)).astype("float32")
+        res = vm["decode"](tvm.nd.array(x_np))
+        tvm.testing.assert_allclose(res.numpy(), np.exp(x_np), rtol=1e-5)
+
+
+def test_reuse_workspace_across_calls():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((8, 16), dtype="float32")) -> R.Tensor((8, 16), dtype="float32"):
+            y = R.exp(x)
+            z = R.add(y, y)
+            return R.multiply(z, y)
+
+    def run(use_persistent_workspace):
+        config = {"relax.backend.use_persistent_workspace": use_persistent_workspace}
+        with tvm.transform.PassContext(config=config):
+            ex = relax.build(Module, "llvm")
+        vm = relax.VirtualMachine(ex, tvm.cpu())
+        calls = []
+
+        def instrument(func, name, before_run, ret_val, *args):
+            if not before_run:
+                calls[-1].append((name, ret_val))
+
+        vm.set_instrument(instrument)
+        for _ in range(2):
+            calls.append([])
+            x_np = np.random.uniform(size=(8, 16)).astype("float32")
+            res = vm["main"](tvm.nd.array(x_np))
+            tvm.testing.assert_allclose(res.numpy(), 2 * np.exp(x_np) * np.exp(x_np), rtol=1e-5)
+        return vm, calls
+
+    def storages(call, name):
+        return [ret_val for func_name, ret_val in call if func_name == name]
+
+    # Without the workspace, each call allocates the planned storages besides the output.
+    _, calls = run(False)
+    assert len(storages(calls[0], "vm.builtin.alloc_storage")) > 1
+
+    vm, calls = run(True)
+    workspace = [storages(call, "vm.builtin.get_persistent_workspace") for call in calls]
+    assert len(workspace[0]) > 0
+    # Only the output is allocated by each call, the planned storages come from the workspace.
+    for call in calls:
+        assert len(storages(call, "vm.builtin.alloc_storage")) == 1
+    # The second call reuses the storages of the first one.
+    assert all(lhs.same_as(rhs) for lhs, rhs in zip(workspace[0], workspace[1]))
+    # The function allocating the workspace is internal to the VM.
+    with pytest.raises(AttributeError):
+        vm["vm_persistent_workspace_alloc"]
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -0,0 +1,112 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+import pytest
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I, relax as R
+
+
+@I.ir_module
+class Module:
+    @R.function
+    def main(
+        x: R.Tensor((2, 3, 8, 8), "float32"),
+        conv_w: R.Tensor((4, 3, 3, 3), "float32"),
+        w: R.Tensor((256, 16), "float32"),
+    ) -> R.Tensor((2, 16), "float32"):
+        R.func_attr({"num_input": 1})
+        with R.dataflow():
+            lv = R.nn.conv2d(x, conv_w, padding=[1, 1, 1, 1])
+            lv1 = R.nn.relu(lv)
+            lv2 = R.reshape(lv1, [2, 256])
+            gv = R.matmul(lv2, w)
+            R.output(gv)
+        return gv
+
+
+def _run(mod, args):
+    mod = relax.pipeline.get_pipeline()(mod)
+    vm = relax.VirtualMachine(relax.build(mod, "llvm"), tvm.cpu())
+    return vm["main"](*[tvm.nd.array(a) for a in args]).numpy()
+
+
+def _random_args():
+    return [
+        np.random.uniform(-1, 1, (2, 3, 8, 8)).astype("float32"),
+        np.random.uniform(-1, 1, (4, 3, 3, 3)).astype("float32"),
+        np.random.uniform(-1, 1, (256, 16)).astype("float32"),
+    ]
+
+
+def test_instrument():
+    mod = relax.transform.InstrumentActivations("main")(Module)
+    tvm.ir.assert_structural_equal(mod["main"], Module["main"])
+    calibrate = mod["main_calibrate"]
+    assert "num_input" not in calibrate.attrs
+    assert len(calibrate.ret_struct_info.fields[1].fields) == 2
+
+
+@pytest.mark.parametrize("observer", ["minmax", "histogram"])
+@pytest.mark.parametrize("fold", [True, False])
+def test_calibrate_and_quantize(observer, fold):
+    args = _random_args()
+    dataset = [[np.random.uniform(-1, 1, args[0].shape).astype("float32")] + args[1:]]
+    scales = relax.quantize.calibrate(Module, dataset, observer=observer)
+    assert len(scales) == 2
+    assert all(s > 0 for s in scales)
+
+    mod = relax.quantize.quantize(Module, scales, fold=fold)
+    ops = set()
+    relax.analysis.post_order_visit(
+        mod["main"], lambda e: ops.add(e.op.name) if isinstance(e, relax.Call) else None
+    )
+    assert "relax.quantize" in ops
+    assert ("relax.dequantize" in ops) != fold
+
+    expected = _run(Module, args)
+    res = _run(mod, args)
+    tvm.testing.assert_allclose(res, expected, rtol=0.05, atol=0.1 * np.abs(expected).max())
+
+
+def test_quantize_pass_arguments():
+    scales = [0.01, 0.02]
+    # The pass takes its arguments in the order of the C++ API.
+    mod = relax.transform.QuantizeActivations("main", scales, False)(Module)
+    tvm.ir.assert_structural_equal(mod, relax.quantize.quantize(Module, scales, "main", False))
+    # An operator with a scale not greater than zero is left in float.
+    def num_quantize(mod):
+        ops = []
+        relax.analysis.post_order_visit(
+            mod["main"], lambda e: ops.append(e.op.name) if isinstance(e, relax.Call) else None
+        )
+        return ops.count("relax.quantize")
+
+    partial = relax.transform.QuantizeActivations("main", [0.01, 0.0])(Module)
+    assert 0 < num_quantize(partial) < num_quantize(mod)
+
+
+def test_scale_count_mismatch():
+    with pytest.raises(tvm.TVMError):
+        relax.quantize.quantize(Module, [0.1])
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
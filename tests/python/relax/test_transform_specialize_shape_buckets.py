@@ -0,0 +1,86 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+import pytest
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I, relax as R, tir as T
+
+
+@I.ir_module
+class Module:
+    @R.function
+    def main(
+        x: R.Tensor(("n", 16), "float32"), w: R.Tensor((16, 8), "float32")
+    ) -> R.Tensor(("n", 8), "float32"):
+        y = R.matmul(x, w)
+        z = R.nn.relu(y)
+        return z
+
+
+def _run(mod, n):
+    ex = relax.build(mod, "llvm")
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    x = np.random.rand(n, 16).astype("float32")
+    w = np.random.rand(16, 8).astype("float32")
+    res = vm["main"](tvm.nd.array(x), tvm.nd.array(w))
+    tvm.testing.assert_allclose(res.numpy(), np.maximum(x @ w, 0), rtol=1e-5, atol=1e-5)
+
+
+def test_exact_dispatch():
+    mod = relax.transform.SpecializeShapeBuckets("main", "n", [8, 4])(Module)
+    names = {gv.name_hint for gv in mod.get_global_vars()}
+    assert {"main", "main_generic", "main_n4", "main_n8"} <= names
+    tvm.ir.assert_structural_equal(
+        mod["main_n8"].params[0].struct_info, R.Tensor((8, 16), "float32")
+    )
+    assert mod["main_n8"].attrs is None or "global_symbol" not in mod["main_n8"].attrs
+    for n in [4, 8, 5]:
+        _run(mod, n)
+
+
+def test_padded_dispatch():
+    mod = relax.transform.SpecializeShapeBuckets("main", "n", [4, 8], pad=True)(Module)
+    for n in [3, 4, 7, 9]:
+        _run(mod, n)
+
+
+def test_unknown_var():
+    with pytest.raises(tvm.TVMError):
+        relax.transform.SpecializeShapeBuckets("main", "m", [4])(Module)
+
+
+def test_unpaddable():
+    @I.ir_module
+    class Reshape:
+        @R.function
+        def main(x: R.Tensor(("n", 4), "float32")) -> R.Tensor(("n * 4",), "float32"):
+            n = T.int64()
+            y = R.reshape(x, R.shape([n * 4]))
+            return y
+
+    with pytest.raises(tvm.TVMError):
+        relax.transform.SpecializeShapeBuckets("main", "n", [4], pad=True)(Reshape)
+    # An exact match is always possible.
+    relax.transform.SpecializeShapeBuckets("main", "n", [4])(Reshape)
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -15,6 +15,8 @@
 # specific language governing permissions and limitations
 # under the License.
 
+import numpy as np
+
 import tvm
 import tvm.testing
 from tvm import relax
@@ -1105,5 +1107,131 @@ def test_call_tir_dyn():
     tvm.ir.assert_structural_equal(mod, Expected)
 
 
+def test_arena_planning():
+    # fmt: off
+    @I.ir_module
+    class Module:
+        @T.prim_func
+        def exp(rxplaceholder: T.handle, compute: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def pad(rxplaceholder: T.handle, PadInput: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def slice(rxplaceholder: T.handle, T_slice: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def add(rxplaceholder: T.handle, rxplaceholder_1: T.handle, T_add: T.handle):
+            T.evaluate(0)
+
+        @R.function
+        def main(x: R.Tensor((2, 3), dtype="float32")) -> R.Tensor((2, 3), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Module
+            alloc: R.Tensor((2, 3), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 3]), R.dtype("float32"), R.prim_value(0))
+            _: R.Tuple = cls.exp(x, alloc)
+            lv: R.Tensor((2, 3), dtype="float32") = alloc
+            alloc1: R.Tensor((4, 32), dtype="float32") = R.builtin.alloc_tensor(R.shape([4, 32]), R.dtype("float32"), R.prim_value(0))
+            _1: R.Tuple = cls.pad(lv, alloc1)
+            lv1: R.Tensor((4, 32), dtype="float32") = alloc1
+            alloc2: R.Tensor((2, 3), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 3]), R.dtype("float32"), R.prim_value(0))
+            _2: R.Tuple = cls.slice(lv1, alloc2)
+            lv2: R.Tensor((2, 3), dtype="float32") = alloc2
+            alloc3: R.Tensor((2, 3), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 3]), R.dtype("float32"), R.prim_value(0))
+            _3: R.Tuple = cls.add(lv, lv2, alloc3)
+            gv: R.Tensor((2, 3), dtype="float32") = alloc3
+            return gv
+
+    @I.ir_module
+    class Expected:
+        @T.prim_func
+        def exp(rxplaceholder: T.handle, compute: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def pad(rxplaceholder: T.handle, PadInput: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def slice(rxplaceholder: T.handle, T_slice: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def add(rxplaceholder: T.handle, rxplaceholder_1: T.handle, T_add: T.handle):
+            T.evaluate(0)
+
+        @R.function
+        def main(x: R.Tensor((2, 3), dtype="float32")) -> R.Tensor((2, 3), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Expected
+            storage: R.Object = R.memory.alloc_storage(R.shape([640]), R.prim_value(0), R.str("global"), R.dtype("uint8"))
+            alloc: R.Tensor((2, 3), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(512), R.shape([2, 3]), R.dtype("float32"))
+            _: R.Tuple = cls.exp(x, alloc)
+            lv: R.Tensor((2, 3), dtype="float32") = alloc
+            alloc1: R.Tensor((4, 32), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(0), R.shape([4, 32]), R.dtype("float32"))
+            _1: R.Tuple = cls.pad(lv, alloc1)
+            lv1: R.Tensor((4, 32), dtype="float32") = alloc1
+            alloc2: R.Tensor((2, 3), dtype="float32") = R.memory.alloc_tensor(storage, R.prim_value(576), R.shape([2, 3]), R.dtype("float32"))
+            _2: R.Tuple = cls.slice(lv1, alloc2)
+            lv2: R.Tensor((2, 3), dtype="float32") = alloc2
+            alloc3: R.Tensor((2, 3), dtype="float32") = R.builtin.alloc_tensor(R.shape([2, 3]), R.dtype("float32"), R.prim_value(0))
+            _3: R.Tuple = cls.add(lv, lv2, alloc3)
+            gv: R.Tensor((2, 3), dtype="float32") = alloc3
+            return gv
+    # fmt: on
+
+    with tvm.transform.PassContext(config={"relax.StaticPlanBlockMemory.arena_planning": True}):
+        mod = relax.transform.StaticPlanBlockMemory()(Module)
+    tvm.ir.assert_structural_equal(mod, Expected)
+
+
+def test_arena_planning_symbolic_shape():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((2, "n"), dtype="float32")) -> R.Tensor((2, "n"), dtype="float32"):
+            y = R.exp(x)
+            z = R.add(y, y)
+            w = R.multiply(z, y)
+            u = R.subtract(w, x)
+            return R.add(u, z)
+
+    lowering = tvm.transform.Sequential(
+        [
+            relax.transform.LegalizeOps(),
+            relax.transform.ToNonDataflow(),
+            relax.transform.RemovePurityChecking(),
+            relax.transform.CallTIRRewrite(),
+        ]
+    )
+    mod = lowering(Module)
+    with tvm.transform.PassContext(config={"relax.StaticPlanBlockMemory.arena_planning": True}):
+        mod = relax.transform.StaticPlanBlockMemory()(mod)
+
+    # All the intermediate tensors of dynamic size share a single arena.
+    alloc_storages = []
+
+    def fvisit(e):
+        if isinstance(e, relax.Call) and e.op == tvm.ir.Op.get("relax.memory.alloc_storage"):
+            alloc_storages.append(e)
+
+    relax.analysis.post_order_visit(mod["main"], fvisit)
+    assert len(alloc_storages) == 1
+
+    with tvm.transform.PassContext(config={"relax.StaticPlanBlockMemory.arena_planning": True}):
+        ex = relax.build(Module, "llvm")
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    for n in [3, 17]:
+        x_np = np.random.uniform(size=(2, n)).astype("float32")
+        y_np = np.exp(x_np)
+        z_np = y_np + y_np
+        expected = z_np * y_np - x_np + z_np
+        res = vm["main"](tvm.nd.array(x_np, tvm.cpu()))
+        tvm.testing.assert_allclose(res.numpy(), expected, rtol=1e-5, atol=1e-5)
+
+
 if __name__ == "__main__":
     tvm.testing.main()
@@ -0,0 +1,93 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+import pytest
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I, relax as R
+
+
+@I.ir_module
+class Module:
+    @R.function
+    def main(
+        ids: R.Tensor(("n",), "int32"),
+        embed: R.Tensor((16, 64), "float32"),
+        w: R.Tensor((32, 64), "float32"),
+    ) -> R.Tensor(("n", 32), "float32"):
+        R.func_attr({"num_input": 1})
+        with R.dataflow():
+            x = R.take(embed, ids, axis=0)
+            wt = R.permute_dims(w)
+            y = R.matmul(x, wt)
+            R.output(y)
+        return y
+
+
+def _fake_quantize(w, bits, group_size, axis):
+    """Quantize and dequantize a weight the same way as the pass."""
+    qmax = 2 ** (bits - 1) - 1
+    w = np.moveaxis(w, axis, -1)
+    groups = w.reshape(w.shape[:-1] + (-1, group_size))
+    scale = (np.abs(groups).max(axis=-1, keepdims=True) / qmax).astype("float32")
+    q = np.clip(np.round(groups / scale), -qmax, qmax)
+    return np.moveaxis((q * scale).reshape(w.shape), -1, axis)
+
+
+def _build(mod):
+    mod = relax.transform.LiftTransformParams()(mod)
+    mod = relax.pipeline.get_pipeline()(mod)
+    ex = relax.build(mod, "llvm")
+    return relax.VirtualMachine(ex, tvm.cpu())
+
+
+@pytest.mark.parametrize("bits", [4, 8])
+def test_quantize_matmul_and_embedding(bits):
+    mod = relax.transform.WeightOnlyQuantize(bits=bits, group_size=32)(Module)
+    names = {gv.name_hint for gv in mod.get_global_vars()}
+    assert "fused_dequantize_matmul" in names
+    assert "fused_dequantize_take" in names
+
+    ids = np.array([3, 0, 15], dtype="int32")
+    embed = np.random.uniform(-1, 1, (16, 64)).astype("float32")
+    w = np.random.uniform(-1, 1, (32, 64)).astype("float32")
+    vm = _build(mod)
+    params = vm["main_transform_params"]([tvm.nd.array(embed), tvm.nd.array(w)])
+    storage_dtype = "uint8" if bits == 4 else "int8"
+    assert all(p.dtype in [storage_dtype, "float32"] for p in params)
+    res = vm["main"](tvm.nd.array(ids), *params)
+
+    x = _fake_quantize(embed, bits, 32, axis=1)[ids]
+    expected = x @ _fake_quantize(w, bits, 32, axis=1).T
+    tvm.testing.assert_allclose(res.numpy(), expected, rtol=1e-5, atol=1e-5)
+
+
+def test_indivisible_group():
+    mod = relax.transform.WeightOnlyQuantize(bits=4, group_size=48)(Module)
+    tvm.ir.assert_structural_equal(mod, Module)
+
+
+def test_invalid_bits():
+    with pytest.raises(tvm.TVMError):
+        relax.transform.WeightOnlyQuantize(bits=3)(Module)
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
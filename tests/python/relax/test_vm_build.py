@@ -162,6 +162,26 @@ def test_vm_compile_e2e(exec_mode):
     tvm.testing.assert_allclose(res.numpy(), np.tile(inp.numpy(), (1, 2)), rtol=1e-7, atol=1e-7)
 
 
+def test_vm_memory_manager_used_memory():
+    @tvm.script.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((32, 16), "float32")) -> R.Tensor((32, 16), "float32"):
+            y = R.add(x, x)
+            z = R.multiply(y, y)
+            return z
+
+    used_memory = tvm.get_global_func("vm.builtin.memory_manager.used_memory")
+    tvm.get_global_func("vm.builtin.memory_manager.clear")()
+    dev = tvm.cpu()
+    assert used_memory(dev) == 0
+
+    ex = relax.build(Module, "llvm")
+    vm = relax.VirtualMachine(ex, dev)
+    vm["main"](tvm.nd.array(np.random.rand(32, 16).astype("float32")))
+    assert used_memory(dev) >= 32 * 16 * 4
+
+
 @pytest.mark.parametrize("exec_mode", EXEC_MODE)
 def test_vm_compile_e2e_func_param_with_shape(exec_mode):
     @tvm.script.ir_module
@@ -1175,6 +1195,151 @@ def test_set_input_tuple(exec_mode):
     vm.invoke_stateful("main")
 
 
+@pytest.mark.parametrize("exec_mode", EXEC_MODE)
+def test_bind_input_output(exec_mode):
+    temp = utils.tempdir()
+    vm, device = make_vm(TestVMSetInput, exec_mode, temp)
+    a = tvm.nd.array(np.random.rand(32, 32).astype("float32"), device)
+    # Bound numpy arrays are read through a raw pointer, whatever their alignment.
+    b_np = np.random.rand(32, 32).astype("float32")
+    out = tvm.nd.empty((32, 32), "float32", device)
+    vm.bind_input("main", 0, a)
+    vm.bind_input("main", 1, b_np)
+    vm.bind_output_copy("main", 0, out)
+    vm.invoke_stateful("main")
+    tvm.testing.assert_allclose(out.numpy(), a.numpy() * b_np, rtol=1e-7, atol=1e-7)
+
+    # Updating the bound buffers in place is visible to the next call.
+    a.copyfrom(np.random.rand(32, 32).astype("float32"))
+    b_np[:] = np.random.rand(32, 32).astype("float32")
+    vm.invoke_stateful("main")
+    expected = a.numpy() * b_np
+    tvm.testing.assert_allclose(out.numpy(), expected, rtol=1e-7, atol=1e-7)
+    tvm.testing.assert_allclose(vm.get_outputs("main").numpy(), expected, rtol=1e-7, atol=1e-7)
+
+    vm.clear_bindings("main")
+    with pytest.raises(ValueError, match=".*No inputs set.*"):
+        vm.invoke_stateful("main")
+
+
+def test_bind_input_dlpack_unaligned():
+    temp = utils.tempdir()
+    vm, device = make_vm(TestVMSetInput, "bytecode", temp)
+
+    class DLPackTensor:
+        """Only exposes the DLPack protocol of a numpy array."""
+
+        def __init__(self, array):
+            self.array = array
+
+        def __dlpack__(self, stream=None):
+            return self.array.__dlpack__()
+
+        def __dlpack_device__(self):
+            return self.array.__dlpack_device__()
+
+    a_np = np.random.rand(32, 32).astype("float32")
+    # A view starting one element into its buffer is not aligned for NDArray.
+    b_buffer = np.random.rand(32 * 32 + 1).astype("float32")
+    b_np = b_buffer[1:].reshape(32, 32)
+    vm.bind_input("main", 0, DLPackTensor(a_np))
+    # The inputs cannot be used until all of them are bound.
+    with pytest.raises(ValueError, match=".*neither bound nor set.*"):
+        vm.invoke_stateful("main")
+    vm.bind_input("main", 1, DLPackTensor(b_np))
+    vm.invoke_stateful("main")
+    tvm.testing.assert_allclose(vm.get_outputs("main").numpy(), a_np * b_np, rtol=1e-7, atol=1e-7)
+    # The unaligned buffer is copied before each call, so the updates are visible.
+    b_np[:] = np.random.rand(32, 32).astype("float32")
+    vm.invoke_stateful("main")
+    tvm.testing.assert_allclose(vm.get_outputs("main").numpy(), a_np * b_np, rtol=1e-7, atol=1e-7)
+
+
+def test_invoke_async():
+    temp = utils.tempdir()
+    vm, device = make_vm(TestVMSetInput, "bytecode", temp)
+    vm.enable_async(max_in_flight=2)
+    inputs = [
+        (
+            tvm.nd.array(np.random.rand(32, 32).astype("float32"), device),
+            tvm.nd.array(np.random.rand(32, 32).astype("float32"), device),
+        )
+        for _ in range(8)
+    ]
+    futures = [vm.invoke_async("main", a, b) for a, b in inputs]
+    for (a, b), future in zip(inputs, futures):
+        res = future.result()
+        assert future.poll()
+        tvm.testing.assert_allclose(res.numpy(), a.numpy() * b.numpy(), rtol=1e-7, atol=1e-7)
+
+    # The error of an invocation is raised by its future.
+    future = vm.invoke_async("main", inputs[0][0])
+    with pytest.raises((tvm.TVMError, ValueError)):
+        future.result()
+    # The VM still runs the invocations queued after a failure.
+    a, b = inputs[0]
+    res = vm.invoke_async("main", a, b).result(timeout=60)
+    tvm.testing.assert_allclose(res.numpy(), a.numpy() * b.numpy(), rtol=1e-7, atol=1e-7)
+
+
+def test_request_batcher():
+    @tvm.script.ir_module
+    class Module:
+        @R.function
+        def main(
+            x: R.Tensor(("n", 4), "float32"), w: R.Tensor((4,), "float32")
+        ) -> R.Tuple(R.Tensor(("n", 4), "float32"), R.Tensor((4,), "float32")):
+            y = R.multiply(x, w)
+            return (y, w)
+
+    ex = relax.build(Module, "llvm")
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    batcher = tvm.runtime.relax_vm.RequestBatcher(
+        vm,
+        "main",
+        batch_buckets=[2, 4],
+        input_batch_axes=[0, -1],
+        output_batch_axes=[0, -1],
+        max_latency_us=10000,
+    )
+    w = np.random.rand(4).astype("float32")
+    xs = [np.random.rand(batch, 4).astype("float32") for batch in [1, 2, 1, 3]]
+    futures = [batcher.submit(x, w) for x in xs]
+    for x, future in zip(xs, futures):
+        y, w_out = future.result(timeout=60)
+        tvm.testing.assert_allclose(y.numpy(), x * w, rtol=1e-7, atol=1e-7)
+        tvm.testing.assert_allclose(w_out.numpy(), w)
+
+    with pytest.raises(tvm.TVMError, match=".*exceeds the largest bucket.*"):
+        batcher.submit(np.random.rand(5, 4).astype("float32"), w)
+    with pytest.raises(tvm.TVMError, match=".*batch size must be positive.*"):
+        batcher.submit(np.random.rand(0, 4).astype("float32"), w)
+
+
+def test_request_batcher_different_shared_inputs():
+    @tvm.script.ir_module
+    class Module:
+        @R.function
+        def main(
+            x: R.Tensor(("n", 4), "float32"), w: R.Tensor((4,), "float32")
+        ) -> R.Tensor(("n", 4), "float32"):
+            y = R.multiply(x, w)
+            return y
+
+    ex = relax.build(Module, "llvm")
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    batcher = tvm.runtime.relax_vm.RequestBatcher(
+        vm, "main", batch_buckets=[2, 4], input_batch_axes=[0, -1], max_latency_us=10000
+    )
+    ws = [tvm.nd.array(np.random.rand(4).astype("float32")) for _ in range(2)]
+    xs = [np.random.rand(1, 4).astype("float32") for _ in range(4)]
+    # The requests using different weights must not be batched with each other.
+    futures = [batcher.submit(x, ws[i % 2]) for i, x in enumerate(xs)]
+    for i, (x, future) in enumerate(zip(xs, futures)):
+        y = future.result(timeout=60)
+        tvm.testing.assert_allclose(y.numpy(), x * ws[i % 2].numpy(), rtol=1e-7, atol=1e-7)
+
+
 def save_function_kwargs_trial(vm: relax.VirtualMachine, device: tvm.runtime.Device) -> None:
     # just checking that we can use kwargs for the args when saving a function
     a = tvm.nd.array(np.random.rand(32, 32).astype("float32"), device)
@@ -14,6 +14,8 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import json
+
 import numpy as np
 import tvm
 import tvm.testing
@@ -126,5 +128,59 @@ def test_tuple():
     with_rpc(ex, callback, data_np)
 
 
+def test_sampling_profiler():
+    data_np = np.random.randn(1, 64).astype("float32")
+    ex = get_exec(data_np.shape)
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    data = tvm.nd.array(data_np)
+
+    vm.enable_sampling_profiler(sample_interval=3)
+    for _ in range(10):
+        vm["main"](data)
+    snapshot = vm.sampling_profiler_snapshot()
+    assert snapshot["sample_interval"] == 3
+    funcs = snapshot["functions"]
+    assert any("matmul" in name for name in funcs)
+    for stats in funcs.values():
+        assert stats["count"] == sum(bucket[2] for bucket in stats["histogram"])
+        assert stats["p50_us"] <= stats["p90_us"] <= stats["p99_us"] <= stats["max_us"]
+
+    trace = json.loads(vm.export_chrome_trace())
+    events = trace["traceEvents"]
+    assert len(events) == sum(stats["count"] for stats in funcs.values())
+    assert all(event["ph"] == "X" and event["cat"] == "call" for event in events)
+
+    vm.sampling_profiler_snapshot(reset=True)
+    assert vm.sampling_profiler_snapshot()["functions"] == {}
+
+    # Sample every invocation, timing all the calls inside it.
+    vm.enable_sampling_profiler(sample_interval=1, sample_invocations=True, trace_capacity=2)
+    vm["main"](data)
+    funcs = vm.sampling_profiler_snapshot()["functions"]
+    assert funcs["main"]["count"] == 1
+    assert any("matmul" in name for name in funcs)
+    assert len(json.loads(vm.export_chrome_trace())["traceEvents"]) == 2
+
+    vm.disable_sampling_profiler()
+    np.testing.assert_allclose(vm["main"](data).numpy(), vm["main"](data).numpy())
+
+
+def test_sampling_profiler_toggle_during_async_invocations():
+    data_np = np.random.randn(1, 64).astype("float32")
+    ex = get_exec(data_np.shape)
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    data = tvm.nd.array(data_np)
+    expected = vm["main"](data).numpy()
+
+    # The profiler can be enabled and disabled while the async executor runs invocations.
+    futures = []
+    for _ in range(20):
+        vm.enable_sampling_profiler(sample_interval=1, sample_invocations=True)
+        futures.append(vm.invoke_async("main", data))
+        vm.disable_sampling_profiler()
+    for future in futures:
+        np.testing.assert_allclose(future.result(timeout=60).numpy(), expected)
+
+
 if __name__ == "__main__":
     tvm.testing.main()
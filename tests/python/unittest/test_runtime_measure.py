@@ -66,6 +66,37 @@ def test_benchmark_result():
     assert r.std == 1.5
 
 
+def test_benchmark_evaluator():
+    n = 1024
+    A = te.placeholder((n,), name="A")
+    B = te.compute((n,), lambda i: A[i] + 1.0, name="B")
+    s = te.create_schedule(B.op)
+    func = tvm.build(s, [A, B], "llvm")
+
+    dev = tvm.cpu()
+    a = tvm.nd.empty((n,), "float32", dev)
+    b = tvm.nd.empty((n,), "float32", dev)
+    fbenchmark = func.benchmark_evaluator(
+        func.entry_name, dev, warmup_ms=1, min_repeat=5, max_repeat=50, target_rel_ci=1.0
+    )
+    result = fbenchmark(a, b)
+    assert result["schema_version"] == 1
+    assert result["converged"]
+    assert 5 <= result["num_samples"] <= 50
+    assert len(result["samples"]) == result["num_samples"]
+    assert result["min"] <= result["median"] <= result["p90"] <= result["p99"] <= result["max"]
+    assert result["mean"] > 0 and result["ci95"] <= result["mean"]
+
+    # An unreachable target stops at the sample budget.
+    fbenchmark = func.benchmark_evaluator(
+        func.entry_name, dev, warmup_ms=0, min_repeat=2, max_repeat=8, target_rel_ci=0.0
+    )
+    result = fbenchmark(a, b)
+    assert not result["converged"]
+    assert result["num_samples"] == 8
+
+
 if __name__ == "__main__":
     test_min_repeat_ms()
     test_benchmark_result()
+    test_benchmark_evaluator()
@@ -263,5 +263,41 @@ def test_profile_function(target, dev):
     assert report[metric].value > 0
 
 
+def _perf_event_permitted():
+    """Whether the process can count the events of its own user space threads."""
+    try:
+        with open("/proc/sys/kernel/perf_event_paranoid") as f:
+            return int(f.read()) <= 2
+    except (OSError, ValueError):
+        return False
+
+
+@tvm.testing.requires_llvm
+@pytest.mark.skipif(
+    tvm.get_global_func("runtime.profiling.PerfEventMetricCollector", allow_missing=True) is None,
+    reason="perf_event profiling not available",
+)
+@pytest.mark.skipif(not _perf_event_permitted(), reason="perf_event_open is not permitted")
+def test_perf_event_collector():
+    dev = tvm.cpu()
+    f = tvm.build(axpy_cpu, target="llvm")
+    a = tvm.nd.array(np.ones(10), device=dev)
+    b = tvm.nd.array(np.ones(10), device=dev)
+    c = tvm.nd.array(np.zeros(10), device=dev)
+    collector = tvm.runtime.profiling.PerfEventMetricCollector(["context-switches", "task-clock"])
+    report = tvm.runtime.profiling.profile_function(f, dev, [collector])(a, b, c)
+    # The software events are available whenever perf_event_open is permitted.
+    assert len(report) > 0
+    assert "context-switches" in report.keys()
+    assert report["context-switches"].value >= 0
+    assert report["task-clock"].microseconds >= 0
+
+    # The collector is initialized again by each run, and reports the same metrics.
+    prof = tvm.runtime.profiling.profile_function(f, dev, [collector])
+    for _ in range(2):
+        report = prof(a, b, c)
+        assert sorted(report.keys()) == ["context-switches", "task-clock"]
+
+
 if __name__ == "__main__":
     tvm.testing.main()
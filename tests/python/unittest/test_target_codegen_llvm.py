@@ -1109,5 +1109,43 @@ def test_call_extern_returning_void():
     built = tvm.build(func, target="llvm")
 
 
+@tvm.testing.requires_llvm
+def test_build_cache(tmp_path):
+    @T.prim_func
+    def func(A: T.Buffer(16, "float32"), B: T.Buffer(16, "float32")):
+        T.func_attr({"global_symbol": "main"})
+        for i in range(16):
+            B[i] = A[i] * T.float32(2)
+
+    # The missing cache directory is created by the first build.
+    cache_dir = tmp_path / "build" / "cache"
+
+    def build_and_check():
+        with tvm.transform.PassContext(config={"tir.build_cache_dir": str(cache_dir)}):
+            built = tvm.build(func, target="llvm")
+        a = tvm.nd.array(np.arange(16, dtype="float32"))
+        b = tvm.nd.empty((16,), "float32")
+        built(a, b)
+        tvm.testing.assert_allclose(b.numpy(), a.numpy() * 2)
+
+    build_and_check()
+    entries = list(cache_dir.iterdir())
+    assert len(entries) == 1
+    assert sorted(p.name for p in entries[0].iterdir()) == ["key", "module.bc"]
+    # The second build loads the cached bitcode instead of adding a new entry.
+    build_and_check()
+    assert list(cache_dir.iterdir()) == entries
+
+    # An entry whose full key differs is a miss, and is not loaded.
+    key_file = entries[0] / "key"
+    key = key_file.read_text()
+    assert "llvm=" in key
+    # The module is keyed by the SHA-256 digest of its serialized form.
+    assert re.search(";mod=[0-9a-f]{64}$", key)
+    key_file.write_text(key + "mismatch")
+    (entries[0] / "module.bc").write_bytes(b"invalid")
+    build_and_check()
+
+
 if __name__ == "__main__":
     tvm.testing.main()
@@ -181,6 +181,25 @@ def test_array():
     assert not consistent_equal(nx, nz)
 
 
+def test_array_hash_cache():
+    x = np.random.uniform(size=(64, 64)).astype("float32")
+    nx = tvm.nd.array(x)
+    ny = tvm.nd.array(x)
+    expected = tvm.ir.structural_hash(nx)
+    with tvm.ir.NDArrayHashCache():
+        assert tvm.ir.structural_hash(nx) == expected
+        assert tvm.ir.structural_hash(nx) == expected
+        assert tvm.ir.structural_hash(ny) == expected
+        with tvm.ir.NDArrayHashCache():
+            assert tvm.ir.structural_hash(nx) == expected
+        # the contents are not hashed again within the scope, so a mutation is not seen
+        nx.copyfrom(x + 1)
+        assert tvm.ir.structural_hash(nx) == expected
+    # the cache is dropped once the outermost scope exits
+    assert tvm.ir.structural_hash(nx) != expected
+    assert tvm.ir.structural_hash(nx) == tvm.ir.structural_hash(tvm.nd.array(x + 1))
+
+
 def test_env_func():
     @tvm.register_func("test.sequal.env_func")
     def test(x):
@@ -0,0 +1,113 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import tvm
+import tvm.testing
+from tvm.script import tir as T
+
+
+class BaseCompare(tvm.testing.CompareBeforeAfter):
+    transform = tvm.tir.transform.HorizontalFuseKernels()
+
+
+class TestMergeKernels(BaseCompare):
+    """The kernels are dispatched over a shared blockIdx.x dimension"""
+
+    def before(A: T.Buffer(64, "float32"), B: T.Buffer(16, "float32")):
+        T.func_attr({"tir.horizontal_fusion": 2})
+        bx0 = T.env_thread("blockIdx.x")
+        tx0 = T.env_thread("threadIdx.x")
+        bx1 = T.env_thread("blockIdx.x")
+        tx1 = T.env_thread("threadIdx.x")
+        with T.launch_thread(bx0, 2):
+            T.launch_thread(tx0, 32)
+            A[bx0 * 32 + tx0] = T.float32(0)
+        with T.launch_thread(bx1, 1):
+            T.launch_thread(tx1, 16)
+            B[bx1 * 16 + tx1] = T.float32(1)
+
+    def expected(A: T.Buffer(64, "float32"), B: T.Buffer(16, "float32")):
+        T.func_attr({"tir.horizontal_fusion": 2})
+        bx = T.launch_thread("blockIdx.x", 3)
+        tx = T.launch_thread("threadIdx.x", 32)
+        if bx < 2:
+            A[bx * 32 + tx] = T.float32(0)
+        else:
+            if tx < 16:
+                B[(bx - 2) * 16 + tx] = T.float32(1)
+
+
+class TestSkipUnmarkedFunction(BaseCompare):
+    """The kernels of an ordinary PrimFunc may depend on each other"""
+
+    def before(A: T.Buffer(64, "float32"), B: T.Buffer(64, "float32")):
+        bx0 = T.env_thread("blockIdx.x")
+        tx0 = T.env_thread("threadIdx.x")
+        bx1 = T.env_thread("blockIdx.x")
+        tx1 = T.env_thread("threadIdx.x")
+        with T.launch_thread(bx0, 2):
+            T.launch_thread(tx0, 32)
+            A[bx0 * 32 + tx0] = T.float32(0)
+        with T.launch_thread(bx1, 2):
+            T.launch_thread(tx1, 32)
+            B[bx1 * 32 + tx1] = A[63 - bx1 * 32 - tx1]
+
+    expected = before
+
+
+class TestSkipUnexpectedKernelCount(BaseCompare):
+    """A member lowered to several kernels keeps the kernels separate"""
+
+    def before(A: T.Buffer(64, "float32"), B: T.Buffer(64, "float32")):
+        T.func_attr({"tir.horizontal_fusion": 1})
+        bx0 = T.env_thread("blockIdx.x")
+        tx0 = T.env_thread("threadIdx.x")
+        bx1 = T.env_thread("blockIdx.x")
+        tx1 = T.env_thread("threadIdx.x")
+        with T.launch_thread(bx0, 2):
+            T.launch_thread(tx0, 32)
+            A[bx0 * 32 + tx0] = T.float32(0)
+        with T.launch_thread(bx1, 2):
+            T.launch_thread(tx1, 32)
+            B[bx1 * 32 + tx1] = A[63 - bx1 * 32 - tx1]
+
+    expected = before
+
+
+class TestSkipSynchronizedKernel(BaseCompare):
+    """A kernel that synchronizes its block cannot run on a subset of the threads"""
+
+    def before(A: T.Buffer(64, "float32"), B: T.Buffer(16, "float32")):
+        T.func_attr({"tir.horizontal_fusion": 2})
+        bx0 = T.env_thread("blockIdx.x")
+        tx0 = T.env_thread("threadIdx.x")
+        bx1 = T.env_thread("blockIdx.x")
+        tx1 = T.env_thread("threadIdx.x")
+        with T.launch_thread(bx0, 2):
+            T.launch_thread(tx0, 32)
+            A[bx0 * 32 + tx0] = T.float32(0)
+        with T.launch_thread(bx1, 1):
+            T.launch_thread(tx1, 16)
+            B_shared = T.decl_buffer(16, "float32", scope="shared")
+            B_shared[tx1] = B[tx1]
+            T.tvm_storage_sync("shared")
+            B[tx1] = B_shared[15 - tx1]
+
+    expected = before
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
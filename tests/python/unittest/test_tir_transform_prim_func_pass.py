@@ -63,6 +63,46 @@ def test_cow_pass():
     assert func_hash == mod["main"].__hash__()
 
 
+def test_parallel_prim_func_pass():
+    funcs = {}
+    for i in range(16):
+        n = te.var("n")
+        x = te.var("x")
+        body = tvm.tir.Evaluate(x * (i + 1) + 0 * n + tvm.tir.const(i, "int32") - i)
+        funcs["func%d" % i] = tvm.tir.PrimFunc([x, n], body)
+    mod = tvm.IRModule(funcs)
+    seq = tvm.transform.Sequential([tvm.tir.transform.Simplify(), tvm.tir.transform.RemoveNoOp()])
+
+    expected = seq(mod)
+    with tvm.transform.PassContext(config={"tir.num_prim_func_pass_threads": 4}):
+        after = seq(mod)
+    # The functions are merged back in the original order.
+    assert [gv.name_hint for gv in after.functions.keys()] == [
+        gv.name_hint for gv in expected.functions.keys()
+    ]
+    tvm.ir.assert_structural_equal(after, expected)
+
+
+def test_parallel_prim_func_pass_context():
+    funcs = {}
+    for i in range(8):
+        x = te.var("x")
+        funcs["func%d" % i] = tvm.tir.PrimFunc([x], tvm.tir.Evaluate(x))
+    mod = tvm.IRModule(funcs)
+    annotate = tvm.get_global_func("testing.AnnotateCurrentContextPass")(
+        "tir.num_prim_func_pass_threads"
+    )
+    target = tvm.target.Target("llvm")
+    with target, tvm.transform.PassContext(config={"tir.num_prim_func_pass_threads": 4}):
+        after = annotate(mod)
+    # Each worker sees the pass context and the target of the caller.
+    for func in after.functions.values():
+        assert func.attrs["current_config"] == 4
+        assert func.attrs["current_target"].same_as(target)
+
+
 if __name__ == "__main__":
+    test_parallel_prim_func_pass()
+    test_parallel_prim_func_pass_context()
     test_cow_pass()
     test_prim_func_pass()